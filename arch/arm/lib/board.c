@@ -41,6 +41,7 @@
 #include <common.h>
 #include <command.h>
 #include <environment.h>
+#include <init_job.h>
 #include <malloc.h>
 #include <stdio_dev.h>
 #include <version.h>
@@ -525,6 +526,11 @@ void board_init_r(gd_t *id, ulong dest_addr)
 
 	gd->flags |= GD_FLG_RELOC;	/* tell others: relocation done */
 	bootstage_mark_name(BOOTSTAGE_ID_START_UBOOT_R, "board_init_r");
+#ifdef CONFIG_SPL_BOOTSTAGE
+	/* Add the records SPL left behind, see board_init_r() in SPL */
+	bootstage_unstash((void *)CONFIG_SPL_BOOTSTAGE_STASH_ADDR,
+			  CONFIG_SPL_BOOTSTAGE_STASH_SIZE);
+#endif
 
 	monitor_flash_len = _end_ofs;
 
@@ -698,6 +704,15 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	}
 #endif
 
+#ifdef CONFIG_INIT_JOBS
+	/*
+	 * Don't wait for the devices still starting up in the background:
+	 * they go on during the autoboot delay, and a driver waits for its
+	 * own device when it is used.
+	 */
+	init_job_poll();
+#endif
+
 	/* main_loop() can return to retry autoboot, if so just run it again. */
 	for (;;) {
 		main_loop();
@@ -281,10 +281,12 @@ static void boot_prep_linux(bootm_headers_t *images)
 #ifdef CONFIG_OF_LIBFDT
 	if (images->ft_len) {
 		debug("using: FDT\n");
+		bootstage_span_start(BOOTSTAGE_ID_ACCUM_FDT, "fdt_fixup");
 		if (create_fdt(images)) {
 			printf("FDT creation failed! hanging...");
 			hang();
 		}
+		bootstage_span_end(BOOTSTAGE_ID_ACCUM_FDT);
 	} else
 #endif
 	{
@@ -55,6 +55,18 @@ void	flush_dcache_all(void)
 	__attribute__((weak, alias("__flush_dcache_all")));
 
 
+/*
+ * Default implementation: invalidate the whole I-cache, which is the
+ * same operation from ARMv4 to ARMv7. ARMv7 also clears the branch
+ * predictor, in cache_v7.c.
+ */
+void __invalidate_icache_all(void)
+{
+	asm volatile ("mcr p15, 0, %0, c7, c5, 0" : : "r" (0));
+}
+void	invalidate_icache_all(void)
+	__attribute__((weak, alias("__invalidate_icache_all")));
+
 /*
  * Default implementation of enable_caches()
  * Real implementation should be in platform code
@@ -27,6 +27,7 @@
 #include <config.h>
 #include <spl.h>
 #include <image.h>
+#include <malloc.h>
 #include <linux/compiler.h>
 
 /* Pointer to as well as the global data structure for SPL */
@@ -53,6 +54,48 @@ void __weak board_init_f(ulong dummy)
 	board_init_r(NULL, 0);
 }
 
+#ifdef CONFIG_SPL_CACHE_SUPPORT
+/*
+ * Turn on the MMU and caches for loading the next image. This uses the
+ * same flat page table as U-Boot (see mmu_setup()): DRAM is cached and
+ * everything else, including SPL's own SRAM, is strongly-ordered device
+ * memory. DRAM must be up, and gd->ram_size set unless it can be probed.
+ */
+void spl_enable_caches(void)
+{
+	ulong tlb_size = 4096 * 4;
+	ulong tlb_addr;
+
+	if (!gd->ram_size) {
+#ifdef CONFIG_MAX_RAM_BANK_SIZE
+		gd->ram_size = get_ram_size((long *)CONFIG_SYS_SDRAM_BASE,
+					    CONFIG_MAX_RAM_BANK_SIZE);
+#else
+		debug("SPL: DRAM size unknown, caches left off\n");
+		return;
+#endif
+	}
+
+#ifdef CONFIG_SYS_SPL_TLB_ADDR
+	tlb_addr = CONFIG_SYS_SPL_TLB_ADDR;
+#else
+	/* The page table must be aligned to its size */
+	tlb_addr = (ulong)memalign(tlb_size, tlb_size);
+	if (!tlb_addr) {
+		debug("SPL: No memory for page table, caches left off\n");
+		return;
+	}
+#endif
+	gd->arch.tlb_addr = tlb_addr;
+	gd->arch.tlb_size = tlb_size;
+	gd->bd->bi_dram[0].start = CONFIG_SYS_SDRAM_BASE;
+	gd->bd->bi_dram[0].size = gd->ram_size;
+
+	icache_enable();
+	dcache_enable();
+}
+#endif
+
 /*
  * This function jumps to an image with argument. Normally an FDT or ATAGS
  * image.
@@ -104,6 +104,7 @@ void doc_init(void);
 #endif
 #include <spi.h>
 #include <nand.h>
+#include <init_job.h>
 
 static char *failed = "*** failed ***\n";
 
@@ -1045,6 +1046,15 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	}
 #endif
 
+#ifdef CONFIG_INIT_JOBS
+	/*
+	 * Don't wait for the devices still starting up in the background:
+	 * they go on during the autoboot delay, and a driver waits for its
+	 * own device when it is used.
+	 */
+	init_job_poll();
+#endif
+
 	/* Initialization complete - start the monitor */
 
 	/* main_loop() can return to retry autoboot, if so just run it again. */
@@ -21,6 +21,9 @@
 
 #include <common.h>
 #include <os.h>
+#include <prof.h>
+#include <worker.h>
+#include <asm/cfi_flash.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -42,6 +45,63 @@ unsigned long timer_get_us(void)
 	return os_get_nsec() / 1000;
 }
 
+#ifdef CONFIG_PROF
+int prof_timer_start(unsigned int hz)
+{
+	return os_prof_start(hz, prof_sample);
+}
+
+void prof_timer_stop(void)
+{
+	os_prof_stop();
+}
+#endif
+
+#ifdef CONFIG_WORKERS
+/*
+ * Host threads stand in for the secondary cores. Once started, a thread
+ * waits in a spin loop of its own until it is given a worker to run.
+ */
+static void (*volatile sandbox_worker_entry[CONFIG_WORKER_MAX])(int nr);
+static int sandbox_worker_threads;
+
+static void *sandbox_worker(void *arg)
+{
+	int nr = (long)arg;
+	void (*entry)(int nr);
+
+	for (;;) {
+		entry = sandbox_worker_entry[nr];
+		if (!entry) {
+			os_usleep(100);
+			continue;
+		}
+		sandbox_worker_entry[nr] = NULL;
+		entry(nr);
+	}
+
+	return NULL;
+}
+
+int worker_cpu_start(int nr, void (*entry)(int nr))
+{
+	if (nr >= sandbox_worker_threads) {
+		if (os_thread_start(sandbox_worker, (void *)(long)nr))
+			return -1;
+		sandbox_worker_threads++;
+	}
+	__sync_synchronize();
+	sandbox_worker_entry[nr] = entry;
+
+	return 0;
+}
+
+void worker_cpu_relax(void)
+{
+	os_usleep(10);
+}
+#endif
+
 int do_bootm_linux(int flag, int argc, char *argv[], bootm_headers_t *images)
 {
 	return -1;
@@ -54,9 +114,23 @@ int cleanup_before_linux(void)
 
 void *map_physmem(phys_addr_t paddr, unsigned long len, unsigned long flags)
 {
+#ifdef CONFIG_FLASH_CFI_SANDBOX
+	void *flash = sandbox_cfi_map(paddr);
+
+	if (flash)
+		return flash;
+#endif
 	return (void *)(gd->arch.ram_buf + paddr);
 }
 
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
 }
+
+void invalidate_dcache_range(unsigned long start, unsigned long stop)
+{
+}
+
+void flush_dcache_all(void)
+{
+}
@@ -19,10 +19,15 @@
  * MA 02111-1307 USA
  */
 
+#define _GNU_SOURCE		/* for the registers in ucontext_t */
+
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <termios.h>
 #include <time.h>
 #include <unistd.h>
@@ -160,6 +165,77 @@ u64 os_get_nsec(void)
 #endif
 }
 
+/* Start of the program, from the host linker */
+extern char __executable_start[], etext[];
+
+static void (*os_prof_handler)(unsigned long pc);
+
+static void os_prof_signal(int sig, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+	unsigned long start = (unsigned long)__executable_start;
+	unsigned long pc = 0;
+
+#if defined(__x86_64__)
+	pc = uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+	pc = uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+	pc = uc->uc_mcontext.pc;
+#endif
+	if (pc < start || pc >= (unsigned long)etext)
+		pc = 0;
+#ifdef __PIE__
+	/* The symbols are at link addresses, which start at 0 */
+	else
+		pc -= start;
+#endif
+	os_prof_handler(pc);
+}
+
+int os_prof_start(unsigned int hz, void (*handler)(unsigned long pc))
+{
+	struct sigaction sa;
+	struct itimerval it;
+
+	os_prof_handler = handler;
+	memset(&sa, '\0', sizeof(sa));
+	sa.sa_sigaction = os_prof_signal;
+	sa.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGPROF, &sa, NULL))
+		return -errno;
+
+	it.it_interval.tv_sec = 0;
+	it.it_interval.tv_usec = 1000000 / hz;
+	it.it_value = it.it_interval;
+	if (setitimer(ITIMER_PROF, &it, NULL))
+		return -errno;
+
+	return 1000000 / it.it_interval.tv_usec;
+}
+
+void os_prof_stop(void)
+{
+	struct itimerval it;
+
+	memset(&it, '\0', sizeof(it));
+	setitimer(ITIMER_PROF, &it, NULL);
+	signal(SIGPROF, SIG_IGN);
+}
+
+int os_thread_start(void *(*fn)(void *arg), void *arg)
+{
+	pthread_t thread;
+	int ret;
+
+	ret = pthread_create(&thread, NULL, fn, arg);
+	if (ret)
+		return -ret;
+
+	return -pthread_detach(thread);
+}
+
 static char *short_opts;
 static struct option *long_opts;
 
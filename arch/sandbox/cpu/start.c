@@ -23,6 +23,7 @@
 #include <asm/getopt.h>
 #include <asm/sections.h>
 #include <asm/state.h>
+#include <hush.h>
 
 #include <os.h>
 
@@ -90,6 +91,10 @@ int sandbox_main_loop_init(void)
 
 	/* Execute command if required */
 	if (state->cmd) {
+#ifdef CONFIG_SYS_HUSH_PARSER
+		/* main_loop() has not started the shell yet */
+		u_boot_hush_start();
+#endif
 		run_command(state->cmd, 0);
 		os_exit(state->exit_type);
 	}
@@ -0,0 +1,54 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __ASM_SANDBOX_CFI_FLASH_H
+#define __ASM_SANDBOX_CFI_FLASH_H
+
+/**
+ * Find the simulated flash at a physical address, for map_physmem()
+ *
+ * @param paddr	Physical address
+ * @return pointer to the flash contents there, or NULL if none
+ */
+void *sandbox_cfi_map(phys_addr_t paddr);
+
+/*
+ * NOTE: DO NOT use the functions below except in test code!
+ */
+
+/* Operation counters of the simulated chips */
+struct sandbox_cfi_stats {
+	unsigned int erases[CONFIG_SYS_MAX_FLASH_BANKS];  /* blocks erased */
+	unsigned int overlaps;	/* operations started while another was busy */
+};
+
+/**
+ * Get the operation counters (used only in sandbox test code)
+ *
+ * @param stats	Returns the counters
+ */
+void sandbox_cfi_get_stats(struct sandbox_cfi_stats *stats);
+
+/**
+ * Clear the operation counters (used only in sandbox test code)
+ */
+void sandbox_cfi_reset_stats(void);
+
+#endif
@@ -20,6 +20,10 @@
  * MA 02111-1307 USA
  */
 
+static inline void sync(void)
+{
+}
+
 /*
  * Given a physical address and a length, return a virtual address
  * that can be used to access the memory range with the caching
@@ -39,3 +43,24 @@ static inline void unmap_physmem(void *vaddr, unsigned long flags)
 {
 
 }
+
+/*
+ * Sandbox has no I/O space: these are plain accesses to host memory. A
+ * simulated device either keeps its state in memory where they reach it,
+ * or gives the driver accessors of its own.
+ */
+#define __raw_writeb(v, a)	(*(volatile unsigned char *)(a) = (v))
+#define __raw_writew(v, a)	(*(volatile unsigned short *)(a) = (v))
+#define __raw_writel(v, a)	(*(volatile unsigned int *)(a) = (v))
+
+#define __raw_readb(a)		(*(volatile unsigned char *)(a))
+#define __raw_readw(a)		(*(volatile unsigned short *)(a))
+#define __raw_readl(a)		(*(volatile unsigned int *)(a))
+
+#define readb(a)		__raw_readb(a)
+#define readw(a)		__raw_readw(a)
+#define readl(a)		__raw_readl(a)
+
+#define writeb(v, a)		__raw_writeb(v, a)
+#define writew(v, a)		__raw_writew(v, a)
+#define writel(v, a)		__raw_writel(v, a)
@@ -0,0 +1,49 @@
+/*
+ * This is the interface to the sandbox NAND driver for test code which
+ * wants to see what the simulated chip was asked to do.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __ASM_SANDBOX_NAND_H
+#define __ASM_SANDBOX_NAND_H
+
+/*
+ * NOTE: DO NOT use the functions in this file except in test code!
+ */
+
+/* Operation counters of the simulated chip */
+struct sandbox_nand_stats {
+	unsigned int array_loads;	/* pages moved from the array */
+	unsigned int cache_reads;	/* READ CACHE SEQUENTIAL / END */
+};
+
+/**
+ * Get the operation counters (used only in sandbox test code)
+ *
+ * @param stats	Returns the counters
+ */
+void sandbox_nand_get_stats(struct sandbox_nand_stats *stats);
+
+/**
+ * Clear the operation counters (used only in sandbox test code)
+ */
+void sandbox_nand_reset_stats(void);
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * This is the interface between the sandbox SPI controller and the
+ * simulated SPI flash behind it, and to the flash for test code which
+ * wants to see what it was asked to do.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __ASM_SANDBOX_SPI_H
+#define __ASM_SANDBOX_SPI_H
+
+/**
+ * Open the host file backing the simulated SPI flash
+ *
+ * @return 0 if ok, -1 if there is no flash
+ */
+int sandbox_sf_attach(void);
+
+/**
+ * Clock a transfer through the simulated SPI flash
+ *
+ * This takes the same arguments as spi_xfer(). The lines used for each
+ * phase of a command are checked against what the command expects.
+ *
+ * @return 0 if ok, -1 on error
+ */
+int sandbox_sf_xfer(unsigned int bitlen, const void *dout, void *din,
+		    unsigned long flags);
+
+/*
+ * NOTE: DO NOT use the functions below except in test code!
+ */
+
+/* Operation counters of the simulated flash */
+struct sandbox_sf_stats {
+	unsigned long cycles;		/* SCK cycles */
+	unsigned int commands;		/* chip selects */
+	unsigned int errors;		/* protocol errors */
+	unsigned int programs;		/* page programs */
+	unsigned int erases;		/* erase commands */
+	u8 last_read_cmd;		/* opcode of the last array read */
+	int addr4;			/* in 4-byte address mode now */
+};
+
+/**
+ * Get the operation counters (used only in sandbox test code)
+ *
+ * @param stats	Returns the counters
+ */
+void sandbox_sf_get_stats(struct sandbox_sf_stats *stats);
+
+/**
+ * Clear the operation counters (used only in sandbox test code)
+ */
+void sandbox_sf_reset_stats(void);
+
+#endif
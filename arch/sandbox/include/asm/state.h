@@ -36,6 +36,8 @@ struct sandbox_state {
 	const char *cmd;		/* Command to execute */
 	enum exit_type_id exit_type;	/* How we exited U-Boot */
 	const char *parse_err;		/* Error to report from parsing */
+	const char *nand_file;		/* File backing the simulated NAND */
+	const char *spi_sf_file;	/* File backing the simulated SPI flash */
 	int argc;			/* Program arguments */
 	char **argv;
 };
@@ -39,7 +39,9 @@
 
 #include <common.h>
 #include <command.h>
+#include <init_job.h>
 #include <malloc.h>
+#include <nand.h>
 #include <stdio_dev.h>
 #include <timestamp.h>
 #include <version.h>
@@ -230,6 +232,16 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	mem_malloc_init((ulong)gd->arch.ram_buf + gd->ram_size -
 			TOTAL_MALLOC_LEN, TOTAL_MALLOC_LEN);
 
+#if !defined(CONFIG_SYS_NO_FLASH)
+	puts("Flash: ");
+	print_size(flash_init(), "\n");
+#endif
+
+#if defined(CONFIG_CMD_NAND)
+	puts("NAND:  ");
+	nand_init();		/* go init the NAND */
+#endif
+
 	/* initialize environment */
 	env_relocate();
 
@@ -265,6 +277,15 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	post_run(NULL, POST_RAM | post_bootmode_get(0));
 #endif
 
+#ifdef CONFIG_INIT_JOBS
+	/*
+	 * Don't wait for the devices still starting up in the background:
+	 * they go on during the autoboot delay, and a driver waits for its
+	 * own device when it is used.
+	 */
+	init_job_poll();
+#endif
+
 	sandbox_main_loop_init();
 
 	/*
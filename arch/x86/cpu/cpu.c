@@ -40,6 +40,8 @@
 #include <asm/interrupt.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*
  * Constructor for a conventional segment GDT (or LDT) entry
  * This is a macro so it can be used in initialisers
@@ -123,6 +125,24 @@ int __weak x86_cleanup_before_linux(void)
 	return 0;
 }
 
+/*
+ * Enhanced REP MOVSB/STOSB: the CPU copies and fills whole cache lines
+ * for a plain byte-wise rep movsb or rep stosb, see memcpy()
+ */
+int x86_has_erms(void)
+{
+	u32 max, ebx, ecx, edx;
+
+	asm ("cpuid" : "=a" (max), "=b" (ebx), "=c" (ecx), "=d" (edx)
+	     : "0" (0));
+	if (max < 7)
+		return 0;
+	asm ("cpuid" : "=a" (max), "=b" (ebx), "=c" (ecx), "=d" (edx)
+	     : "0" (7), "2" (0));
+
+	return (ebx >> 9) & 1;
+}
+
 int x86_cpu_init_f(void)
 {
 	const u32 em_rst = ~X86_CR0_EM;
@@ -28,6 +28,7 @@
  */
 
 #include <common.h>
+#include <prof.h>
 #include <asm/cache.h>
 #include <asm/control_regs.h>
 #include <asm/interrupt.h>
@@ -302,6 +303,11 @@ void irq_llsr(struct irq_regs *regs)
 
 	default:
 		/* Hardware or User IRQ */
+#ifdef CONFIG_PROF
+		/* The PIT tick (IRQ 0) also drives the profiler */
+		if (regs->irq_id == 0x20)
+			prof_sample(regs->eip);
+#endif
 		do_irq(regs->irq_id);
 	}
 }
@@ -29,6 +29,7 @@
 /* Architecture-specific global data */
 struct arch_global_data {
 	struct global_data *gd_addr;		/* Location of Global Data */
+	int has_erms;				/* Fast rep movsb/stosb */
 };
 
 #endif
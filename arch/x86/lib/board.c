@@ -33,6 +33,7 @@
 
 #include <common.h>
 #include <watchdog.h>
+#include <init_job.h>
 #include <stdio_dev.h>
 #include <asm/u-boot-x86.h>
 #include <asm/relocate.h>
@@ -217,6 +218,12 @@ static void do_init_loop(init_fnc_t **init_fnc_ptr)
 
 void board_init_f(ulong boot_flags)
 {
+	/*
+	 * Global data is not cleared, and memcpy() and memset() look at
+	 * this, so set it before anything can call them. Boards with their
+	 * own cpu_init_f() get it too.
+	 */
+	gd->arch.has_erms = x86_has_erms();
 	gd->flags = boot_flags;
 
 	do_init_loop(init_sequence_f);
@@ -254,6 +261,15 @@ void board_init_r(gd_t *id, ulong dest_addr)
 {
 	do_init_loop(init_sequence_r);
 
+#ifdef CONFIG_INIT_JOBS
+	/*
+	 * Don't wait for the devices still starting up in the background:
+	 * they go on during the autoboot delay, and a driver waits for its
+	 * own device when it is used.
+	 */
+	init_job_poll();
+#endif
+
 	/* main_loop() can return to retry autoboot, if so just run it again. */
 	for (;;)
 		main_loop();
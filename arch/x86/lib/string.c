@@ -24,12 +24,20 @@
 
 /* From glibc-2.14, sysdeps/i386/memset.c */
 
-#include <compiler.h>
+#include <common.h>
 #include <asm/string.h>
-#include <linux/types.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 typedef uint32_t op_t;
 
+/*
+ * On a CPU with ERMS (see board_init_f()) a plain rep movsb or rep stosb
+ * is the fastest way to copy or fill more than a few cache lines; below
+ * this it is not worth the start-up cost.
+ */
+#define ERMS_THRES	128
+
 void *memset(void *dstpp, int c, size_t len)
 {
 	int d0;
@@ -43,8 +51,10 @@ void *memset(void *dstpp, int c, size_t len)
 	/* Clear the direction flag, so filling will move forward.  */
 	asm volatile("cld");
 
-	/* This threshold value is optimal.  */
-	if (len >= 12) {
+	if (len >= ERMS_THRES && gd->arch.has_erms) {
+		/* The whole lot in one go, any alignment */
+	} else if (len >= 12) {
+		/* This threshold value is optimal.  */
 		/* Fill X with four copies of the char we want to fill with. */
 		x |= (x << 8);
 		x |= (x << 16);
@@ -118,6 +128,44 @@ do {									  \
 	(nbytes_left) = (nbytes) % 4;					  \
 } while (0)
 
+/* Copy backwards from just below the end pointers, which are updated */
+#define BYTE_COPY_BWD(dst_ep, src_ep, nbytes)				  \
+do {									  \
+	int __d0;							  \
+	asm volatile(							  \
+		/* Set the direction flag, so copying goes backwards.  */ \
+		"std\n"							  \
+		/* Copy bytes.  */					  \
+		"rep\n"							  \
+		"movsb\n"						  \
+		/* Clear the dir flag.  Convention says it should be 0. */ \
+		"cld" :							  \
+		"=D" (dst_ep), "=S" (src_ep), "=c" (__d0) :		  \
+		"0" (dst_ep - 1), "1" (src_ep - 1), "2" (nbytes) :	  \
+		"memory");						  \
+	dst_ep += 1;							  \
+	src_ep += 1;							  \
+} while (0)
+
+#define WORD_COPY_BWD(dst_ep, src_ep, nbytes_left, nbytes)		  \
+do {									  \
+	int __d0;							  \
+	asm volatile(							  \
+		/* Set the direction flag, so copying goes backwards.  */ \
+		"std\n"							  \
+		/* Copy longwords.  */					  \
+		"rep\n"							  \
+		"movsl\n"						  \
+		/* Clear the dir flag.  Convention says it should be 0. */ \
+		"cld" :							  \
+		"=D" (dst_ep), "=S" (src_ep), "=c" (__d0) :		  \
+		"0" (dst_ep - 4), "1" (src_ep - 4), "2" ((nbytes) / 4) :  \
+		"memory");						  \
+	dst_ep += 4;							  \
+	src_ep += 4;							  \
+	(nbytes_left) = (nbytes) % 4;					  \
+} while (0)
+
 void *memcpy(void *dstpp, const void *srcpp, size_t len)
 {
 	unsigned long int dstp = (long int)dstpp;
@@ -125,8 +173,10 @@ void *memcpy(void *dstpp, const void *srcpp, size_t len)
 
 	/* Copy from the beginning to the end.  */
 
-	/* If there not too few bytes to copy, use word copy.  */
-	if (len >= OP_T_THRES) {
+	if (len >= ERMS_THRES && gd->arch.has_erms) {
+		/* The byte copy below does it all */
+	} else if (len >= OP_T_THRES) {
+		/* If there not too few bytes to copy, use word copy.  */
 		/* Copy just a few bytes to make DSTP aligned.  */
 		len -= (-dstp) % OPSIZ;
 		BYTE_COPY_FWD(dstp, srcp, (-dstp) % OPSIZ);
@@ -146,3 +196,40 @@ void *memcpy(void *dstpp, const void *srcpp, size_t len)
 
 	return dstpp;
 }
+
+/* From glibc-2.14, string/memmove.c */
+void *memmove(void *dest, const void *src, size_t len)
+{
+	unsigned long int dstp = (long int)dest;
+	unsigned long int srcp = (long int)src;
+
+	/* This test makes the forward copying code be used whenever possible.
+	   Reduces the working set.  */
+	if (dstp - srcp >= len)		/* *Unsigned* compare!  */
+		return memcpy(dest, src, len);
+
+	/* Copy from the end to the beginning.  */
+	srcp += len;
+	dstp += len;
+
+	/* If there not too few bytes to copy, use word copy.  */
+	if (len >= OP_T_THRES) {
+		/* Copy just a few bytes to make DSTP aligned.  */
+		len -= dstp % OPSIZ;
+		BYTE_COPY_BWD(dstp, srcp, dstp % OPSIZ);
+
+		/* Copy from SRCP to DSTP taking advantage of the known
+		 * alignment of DSTP.  Number of bytes remaining is put
+		 * in the third argument, i.e. in LEN.  This number may
+		 * vary from machine to machine.
+		 */
+		WORD_COPY_BWD(dstp, srcp, len, len);
+
+		/* Fall out and copy the tail.  */
+	}
+
+	/* There are just a few bytes to copy. Use byte memory operations. */
+	BYTE_COPY_BWD(dstp, srcp, len);
+
+	return dest;
+}
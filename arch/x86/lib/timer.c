@@ -26,6 +26,7 @@
 
 #include <common.h>
 #include <malloc.h>
+#include <prof.h>
 #include <asm/io.h>
 #include <asm/i8254.h>
 #include <asm/ibmpc.h>
@@ -95,6 +96,18 @@ void timer_isr(void *unused)
 	}
 }
 
+#ifdef CONFIG_PROF
+/* Samples are taken on the PIT tick, so the rate is fixed */
+int prof_timer_start(unsigned int hz)
+{
+	return CONFIG_SYS_HZ;
+}
+
+void prof_timer_stop(void)
+{
+}
+#endif
+
 ulong get_timer(ulong base)
 {
 	return system_ticks - base;
@@ -0,0 +1,199 @@
+/*
+ * Scoped arena for short-lived allocations
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <malloc.h>
+
+#ifndef CONFIG_SYS_ARENA_LEN
+#define CONFIG_SYS_ARENA_LEN	(64 << 10)
+#endif
+
+#define ARENA_ALIGN	(2 * sizeof(ulong))	/* as malloc() */
+#define ARENA_FREED	1UL
+
+/* Just below each allocation */
+struct arena_hdr {
+	struct arena_hdr *prev;	/* the allocation before, or NULL */
+	ulong start;		/* top of the arena before this allocation */
+	ulong size;		/* rounded up to ARENA_ALIGN, | ARENA_FREED */
+};
+
+static ulong arena_base, arena_end;
+static ulong arena_top;			/* next free byte */
+static ulong arena_floor;		/* where the current scope started */
+static struct arena_hdr *arena_last;	/* most recent allocation */
+static int arena_depth;
+
+static ulong arena_peak;
+static ulong arena_fallbacks, arena_fallback_bytes;
+
+static int arena_owns(const void *ptr)
+{
+	return (ulong)ptr >= arena_base && (ulong)ptr < arena_end;
+}
+
+static void arena_note_peak(void)
+{
+	if (arena_top - arena_base > arena_peak)
+		arena_peak = arena_top - arena_base;
+}
+
+void arena_enter(struct arena_scope *scope)
+{
+	if (!arena_base) {
+		arena_base = (ulong)memalign(ARENA_ALIGN, CONFIG_SYS_ARENA_LEN);
+		if (arena_base) {
+			arena_end = arena_base +
+				(CONFIG_SYS_ARENA_LEN & ~(ARENA_ALIGN - 1));
+			arena_top = arena_base;
+			arena_floor = arena_base;
+		}
+	}
+
+	scope->top = arena_top;
+	scope->floor = arena_floor;
+	scope->last = arena_last;
+	arena_floor = arena_top;
+	arena_depth++;
+}
+
+void arena_leave(struct arena_scope *scope)
+{
+	arena_top = scope->top;
+	arena_floor = scope->floor;
+	arena_last = scope->last;
+	arena_depth--;
+}
+
+/* Carve an allocation out of the arena, or return NULL if it won't fit */
+static void *arena_get(size_t align, size_t size)
+{
+	struct arena_hdr *hdr;
+	ulong ptr;
+
+	if (!arena_depth || !arena_base)
+		return NULL;
+
+	ptr = ALIGN(arena_top + sizeof(*hdr), align);
+	if (ptr >= arena_end || size > arena_end - ptr) {
+		arena_fallbacks++;
+		arena_fallback_bytes += size;
+		return NULL;
+	}
+
+	hdr = (struct arena_hdr *)ptr - 1;
+	hdr->prev = arena_last;
+	hdr->start = arena_top;
+	hdr->size = ALIGN(size, ARENA_ALIGN);
+	arena_last = hdr;
+	arena_top = ptr + hdr->size;
+	arena_note_peak();
+
+	return (void *)ptr;
+}
+
+void *arena_alloc(size_t size)
+{
+	void *ptr = arena_get(ARENA_ALIGN, size);
+
+	return ptr ? ptr : malloc(size);
+}
+
+void *arena_memalign(size_t align, size_t size)
+{
+	void *ptr = arena_get(max(align, ARENA_ALIGN), size);
+
+	return ptr ? ptr : memalign(align, size);
+}
+
+void *arena_realloc(void *ptr, size_t size)
+{
+	struct arena_hdr *hdr;
+	void *new;
+
+	if (!ptr)
+		return arena_alloc(size);
+	if (!arena_owns(ptr))
+		return realloc(ptr, size);
+
+	/*
+	 * The most recent allocation in this scope can change in place.
+	 * One from an outer scope must outlive this one, so goes to malloc().
+	 */
+	hdr = (struct arena_hdr *)ptr - 1;
+	if (hdr->start < arena_floor) {
+		new = malloc(size);
+	} else if (hdr == arena_last && size <= arena_end - (ulong)ptr) {
+		hdr->size = ALIGN(size, ARENA_ALIGN);
+		arena_top = (ulong)ptr + hdr->size;
+		arena_note_peak();
+		return ptr;
+	} else {
+		new = arena_alloc(size);
+	}
+	if (!new)
+		return NULL;
+	memcpy(new, ptr, min(size, hdr->size & ~ARENA_FREED));
+	arena_free(ptr);
+
+	return new;
+}
+
+void arena_free(void *ptr)
+{
+	struct arena_hdr *hdr;
+
+	if (!arena_owns(ptr)) {
+		free(ptr);
+		return;
+	}
+
+	hdr = (struct arena_hdr *)ptr - 1;
+	hdr->size |= ARENA_FREED;
+
+	/* Give back whatever is now free at the top, down to this scope */
+	while (arena_last && (arena_last->size & ARENA_FREED) &&
+	       arena_last->start >= arena_floor) {
+		arena_top = arena_last->start;
+		arena_last = arena_last->prev;
+	}
+}
+
+void arena_get_info(struct arena_info *info)
+{
+	info->size = arena_end - arena_base;
+	info->used = arena_top - arena_base;
+	info->peak = arena_peak;
+	info->fallbacks = arena_fallbacks;
+	info->fallback_bytes = arena_fallback_bytes;
+	info->malloc_size = mem_malloc_end - mem_malloc_start;
+	info->malloc_peak = mem_malloc_peak - mem_malloc_start;
+}
+
+void arena_reset_info(void)
+{
+	arena_peak = arena_top - arena_base;
+	arena_fallbacks = 0;
+	arena_fallback_bytes = 0;
+	mem_malloc_peak = mem_malloc_brk;
+}
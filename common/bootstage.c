@@ -29,6 +29,7 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <libfdt.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -44,9 +45,32 @@ struct bootstage_record {
 static struct bootstage_record record[BOOTSTAGE_ID_COUNT] = { {1} };
 static int next_id = BOOTSTAGE_ID_USER;
 
+/*
+ * What we know about spans (see bootstage_span_start()) beyond their
+ * record. This is kept apart so that the records, and so the stash
+ * format, stay the same.
+ */
+struct bootstage_span {
+	enum bootstage_id parent;	/* Enclosing span, 0 if none */
+	uint32_t count;			/* Number of times it was run */
+	uint64_t bytes;			/* Bytes transferred in it */
+};
+
+/* Like record[], these are used before relocation so cannot be in BSS */
+static struct bootstage_span span[BOOTSTAGE_ID_COUNT]
+	__attribute__((section(".data")));
+
+/* Spans now running, innermost last */
+#define BOOTSTAGE_SPAN_DEPTH	16
+
+static enum bootstage_id span_stack[BOOTSTAGE_SPAN_DEPTH]
+	__attribute__((section(".data")));
+static int span_depth __attribute__((section(".data")));
+
 enum {
 	BOOTSTAGE_VERSION	= 0,
 	BOOTSTAGE_MAGIC		= 0xb00757a3,
+	BOOTSTAGE_SPAN_MAGIC	= 0xb0075a4e,
 };
 
 struct bootstage_hdr {
@@ -56,6 +80,22 @@ struct bootstage_hdr {
 	uint32_t magic;		/* Unused */
 };
 
+/*
+ * Span information can follow the name strings in a stash, aligned to 4
+ * bytes and included in bootstage_hdr.size. Older readers ignore it.
+ */
+struct bootstage_span_hdr {
+	uint32_t magic;		/* BOOTSTAGE_SPAN_MAGIC */
+	uint32_t count;		/* Number of entries, one per record */
+};
+
+struct bootstage_span_entry {
+	uint32_t parent;	/* Index of parent record + 1, 0 if none */
+	uint32_t count;		/* Number of times it was run */
+	uint32_t bytes_lo;	/* Bytes transferred in it */
+	uint32_t bytes_hi;
+};
+
 ulong bootstage_add_record(enum bootstage_id id, const char *name,
 			   int flags, ulong mark)
 {
@@ -108,9 +148,18 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 
 	rec->start_us = timer_get_boot_us();
 	rec->name = name;
+	rec->id = id;
 	return rec->start_us;
 }
 
+enum bootstage_id bootstage_alloc_id(void)
+{
+	if (next_id >= BOOTSTAGE_ID_COUNT)
+		return BOOTSTAGE_ID_COUNT;
+
+	return next_id++;
+}
+
 uint32_t bootstage_accum(enum bootstage_id id)
 {
 	struct bootstage_record *rec = &record[id];
@@ -121,6 +170,95 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+uint32_t bootstage_span_start(enum bootstage_id id, const char *name)
+{
+	int i;
+
+	if (id >= BOOTSTAGE_ID_COUNT)
+		return 0;
+
+	/* A span left running (after an error, say) is ended first */
+	for (i = 0; i < span_depth; i++) {
+		if (span_stack[i] == id) {
+			bootstage_span_end(id);
+			break;
+		}
+	}
+
+	if (span_depth == BOOTSTAGE_SPAN_DEPTH) {
+		debug("%s: Spans nested too deeply for %s\n", __func__, name);
+		return 0;
+	}
+
+	if (!span[id].count && span_depth)
+		span[id].parent = span_stack[span_depth - 1];
+	span[id].count++;
+	span_stack[span_depth++] = id;
+
+	return bootstage_start(id, name);
+}
+
+uint32_t bootstage_span_end(enum bootstage_id id)
+{
+	int i;
+
+	for (i = span_depth - 1; i >= 0; i--) {
+		if (span_stack[i] == id)
+			break;
+	}
+	if (i < 0)
+		return 0;
+
+	/* End any spans still running inside this one */
+	while (span_depth > i + 1)
+		bootstage_accum(span_stack[--span_depth]);
+	span_depth = i;
+
+	return bootstage_accum(id);
+}
+
+void bootstage_add_bytes(enum bootstage_id id, ulong bytes)
+{
+	if (id < BOOTSTAGE_ID_COUNT)
+		span[id].bytes += bytes;
+}
+
+/* Check whether a record times an activity, rather than marking a time */
+static int is_span(enum bootstage_id id)
+{
+	return record[id].start_us || span[id].count;
+}
+
+/* Get the time of a span so far, including any run not yet ended */
+static ulong get_span_time(enum bootstage_id id)
+{
+	struct bootstage_record *rec = &record[id];
+	int i;
+
+	for (i = 0; i < span_depth; i++) {
+		if (span_stack[i] == id)
+			return rec->time_us + (uint32_t)timer_get_boot_us() -
+				rec->start_us;
+	}
+
+	return rec->time_us;
+}
+
+/* Get the time spent in a span outside the spans within it */
+static ulong get_span_self_time(enum bootstage_id id)
+{
+	ulong time = get_span_time(id);
+	ulong inner = 0;
+	int i;
+
+	for (i = 0; i < BOOTSTAGE_ID_COUNT; i++) {
+		if (span[i].parent == id && is_span(i))
+			inner += get_span_time(i);
+	}
+
+	return time > inner ? time - inner : 0;
+}
+
 static void print_time(unsigned long us_time)
 {
 	char str[15], *s;
@@ -176,11 +314,41 @@ static uint32_t print_time_record(enum bootstage_id id,
 
 static int h_compare_record(const void *r1, const void *r2)
 {
-	const struct bootstage_record *rec1 = r1, *rec2 = r2;
+	const struct bootstage_record *rec1 = *(struct bootstage_record **)r1;
+	const struct bootstage_record *rec2 = *(struct bootstage_record **)r2;
 
 	return rec1->time_us > rec2->time_us ? 1 : -1;
 }
 
+/* Print a span and the spans within it, indented by depth */
+static void print_span_tree(enum bootstage_id id, int depth)
+{
+	struct bootstage_record *rec = &record[id];
+	ulong time = get_span_time(id);
+	uint64_t bytes = span[id].bytes;
+	char buf[20];
+	int i;
+
+	print_time(time);
+	print_time(span[id].count);
+	if (bytes) {
+		print_time(bytes);
+		/* Bytes per second, without overflowing 32 bits */
+		print_time(time ? lldiv(bytes * 1000, time) * 1000 : 0);
+	} else {
+		printf("%22s", "");
+	}
+	printf("  %*s%s\n", depth * 2, "",
+	       get_record_name(buf, sizeof(buf), rec));
+
+	if (depth >= BOOTSTAGE_SPAN_DEPTH)
+		return;
+	for (i = 0; i < BOOTSTAGE_ID_COUNT; i++) {
+		if (span[i].parent == id && is_span(i) && i != id)
+			print_span_tree(i, depth + 1);
+	}
+}
+
 #ifdef CONFIG_OF_LIBFDT
 /**
  * Add all bootstage timings to a device tree.
@@ -247,6 +415,7 @@ int bootstage_fdt_add_report(void)
 
 void bootstage_report(void)
 {
+	struct bootstage_record *sorted[BOOTSTAGE_ID_COUNT];
 	struct bootstage_record *rec = record;
 	int id;
 	uint32_t prev;
@@ -259,11 +428,14 @@ void bootstage_report(void)
 	rec->time_us = 0;
 	prev = print_time_record(BOOTSTAGE_ID_AWAKE, rec, 0);
 
-	/* Sort records by increasing time */
-	qsort(record, ARRAY_SIZE(record), sizeof(*rec), h_compare_record);
+	/* Sort records by increasing time, leaving them indexed by id */
+	for (id = 0; id < BOOTSTAGE_ID_COUNT; id++)
+		sorted[id] = &record[id];
+	qsort(sorted, ARRAY_SIZE(sorted), sizeof(*sorted), h_compare_record);
 
-	for (id = 0; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
-		if (rec->time_us != 0 && !rec->start_us)
+	for (id = 0; id < BOOTSTAGE_ID_COUNT; id++) {
+		rec = sorted[id];
+		if (rec->time_us != 0 && !is_span(rec - record))
 			prev = print_time_record(rec->id, rec, prev);
 	}
 	if (next_id > BOOTSTAGE_ID_COUNT)
@@ -272,10 +444,71 @@ void bootstage_report(void)
 		       next_id - BOOTSTAGE_ID_COUNT);
 
 	puts("\nAccumulated time:\n");
+	printf("%11s%11s%11s%11s  %s\n", "Time", "Count", "Bytes",
+	       "Bytes/s", "Stage");
+	for (id = 0, rec = record; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+		if (is_span(id) && !span[id].parent)
+			print_span_tree(id, 0);
+	}
+}
+
+/* Append the names of a span and those enclosing it, outermost first */
+static char *append_span_stack(char *ptr, char *end, enum bootstage_id id,
+			       int depth)
+{
+	char buf[20];
+	const char *name;
+	int len;
+
+	if (span[id].parent && span[id].parent != id &&
+	    depth < BOOTSTAGE_SPAN_DEPTH) {
+		ptr = append_span_stack(ptr, end, span[id].parent, depth + 1);
+		if (ptr < end)
+			*ptr++ = ';';
+	}
+	name = get_record_name(buf, sizeof(buf), &record[id]);
+	len = min(strlen(name), (size_t)(end - ptr));
+	memcpy(ptr, name, len);
+
+	return ptr + len;
+}
+
+int bootstage_export_csv(char *buf, int size)
+{
+	struct bootstage_record *rec;
+	char *ptr = buf, *end = buf + size;
+	char name[20];
+	int id;
+
+	snprintf(ptr, end - ptr, "id,parent,type,name,time_us,self_us,count,"
+		 "bytes,stack\n");
+	ptr += strlen(ptr);
 	for (id = 0, rec = record; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
-		if (rec->start_us)
-			prev = print_time_record(id, rec, -1);
+		if (!rec->time_us && !is_span(id))
+			continue;
+		if (end - ptr < 200)
+			return -1;
+		if (!is_span(id)) {
+			snprintf(ptr, end - ptr, "%d,,%s,%s,%lu,,,,\n", id,
+				 rec->flags & BOOTSTAGEF_ERROR ? "error" :
+				 "mark", get_record_name(name, sizeof(name),
+							 rec), rec->time_us);
+			ptr += strlen(ptr);
+			continue;
+		}
+		snprintf(ptr, end - ptr, "%d,%d,span,%s,%lu,%lu,%u,%llu,", id,
+			 span[id].parent,
+			 get_record_name(name, sizeof(name), rec),
+			 get_span_time(id), get_span_self_time(id),
+			 span[id].count, span[id].bytes);
+		ptr += strlen(ptr);
+		/* Leave room for the newline and terminator */
+		ptr = append_span_stack(ptr, end - 2, id, 0);
+		*ptr++ = '\n';
 	}
+	*ptr = '\0';
+
+	return ptr - buf;
 }
 
 ulong __timer_get_boot_us(void)
@@ -320,9 +553,12 @@ static void append_data(char **ptrp, char *end, const void *data, int size)
 int bootstage_stash(void *base, int size)
 {
 	struct bootstage_hdr *hdr = (struct bootstage_hdr *)base;
+	struct bootstage_span_hdr span_hdr;
+	struct bootstage_span_entry entry;
 	struct bootstage_record *rec;
 	char buf[20];
 	char *ptr = base, *end = ptr + size;
+	char *spans;
 	uint32_t count;
 	int id;
 
@@ -367,6 +603,46 @@ int bootstage_stash(void *base, int size)
 		return -1;
 	}
 
+	/*
+	 * Write the span information, with parents as record indexes. It is
+	 * optional, so give as much as fits rather than fail a stash which
+	 * had room before spans were added.
+	 */
+	spans = (char *)base + ALIGN(ptr - (char *)base, 4);
+	if (spans + sizeof(span_hdr) <= end) {
+		ptr = spans;
+		span_hdr.magic = BOOTSTAGE_SPAN_MAGIC;
+		span_hdr.count = min((ulong)count, (ulong)(end - ptr -
+					sizeof(span_hdr)) / sizeof(entry));
+		if (span_hdr.count < count)
+			debug("%s: Only room for %d of %d spans\n", __func__,
+			      span_hdr.count, count);
+		append_data(&ptr, end, &span_hdr, sizeof(span_hdr));
+	} else {
+		span_hdr.count = 0;
+	}
+	for (rec = record, id = 0; id < BOOTSTAGE_ID_COUNT && span_hdr.count;
+	     id++, rec++) {
+		if (rec->time_us != 0) {
+			struct bootstage_span *sp = &span[id];
+			int parent_id;
+
+			entry.parent = 0;
+			if (sp->parent && record[sp->parent].time_us) {
+				for (parent_id = 0; parent_id <= sp->parent;
+				     parent_id++) {
+					if (record[parent_id].time_us)
+						entry.parent++;
+				}
+			}
+			entry.count = sp->count;
+			entry.bytes_lo = sp->bytes;
+			entry.bytes_hi = sp->bytes >> 32;
+			append_data(&ptr, end, &entry, sizeof(entry));
+			span_hdr.count--;
+		}
+	}
+
 	/* Update total data size */
 	hdr->size = ptr - (char *)base;
 	printf("Stashed %d records\n", hdr->count);
@@ -377,6 +653,8 @@ int bootstage_stash(void *base, int size)
 int bootstage_unstash(void *base, int size)
 {
 	struct bootstage_hdr *hdr = (struct bootstage_hdr *)base;
+	struct bootstage_span_hdr span_hdr;
+	struct bootstage_span_entry entry;
 	struct bootstage_record *rec;
 	char *ptr = base, *end = ptr + size;
 	uint rec_size;
@@ -403,7 +681,7 @@ int bootstage_unstash(void *base, int size)
 	if (hdr->count * sizeof(*rec) > hdr->size) {
 		debug("%s: Bootstage has %d records needing %d bytes, but "
 			"only %d bytes is available\n", __func__, hdr->count,
-		      hdr->count * sizeof(*rec), hdr->size);
+		      (int)(hdr->count * sizeof(*rec)), hdr->size);
 		return -1;
 	}
 
@@ -430,11 +708,35 @@ int bootstage_unstash(void *base, int size)
 	ptr += rec_size;
 	for (rec = record + next_id, id = 0; id < hdr->count; id++, rec++) {
 		rec->name = ptr;
+		rec->id = next_id + id;
 
 		/* Assume no data corruption here */
 		ptr += strlen(ptr) + 1;
 	}
 
+	/* Read the span information, if there is any */
+	ptr = (char *)base + ALIGN(ptr - (char *)base, 4);
+	end = (char *)base + hdr->size;
+	span_hdr.magic = 0;
+	if (ptr + sizeof(span_hdr) <= end)
+		memcpy(&span_hdr, ptr, sizeof(span_hdr));
+	if (span_hdr.magic == BOOTSTAGE_SPAN_MAGIC &&
+	    span_hdr.count <= hdr->count &&
+	    ptr + sizeof(span_hdr) + span_hdr.count * sizeof(entry) <= end) {
+		/* Any records past a truncated list have no span details */
+		ptr += sizeof(span_hdr);
+		for (id = 0; id < span_hdr.count; id++, ptr += sizeof(entry)) {
+			struct bootstage_span *sp = &span[next_id + id];
+
+			memcpy(&entry, ptr, sizeof(entry));
+			sp->parent = entry.parent && entry.parent <= hdr->count ?
+				next_id + entry.parent - 1 : 0;
+			sp->count = entry.count;
+			sp->bytes = (uint64_t)entry.bytes_hi << 32 |
+				entry.bytes_lo;
+		}
+	}
+
 	/* Mark the records as read */
 	next_id += hdr->count;
 	printf("Unstashed %d records\n", hdr->count);
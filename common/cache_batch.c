@@ -0,0 +1,182 @@
+/*
+ * Batched data cache maintenance for DMA
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <cache_batch.h>
+
+/*
+ * Flushing a line at a time costs in proportion to the size, while
+ * flushing the whole cache by set/way costs about the same as flushing
+ * a few times its size.
+ */
+#ifndef CONFIG_CACHE_BATCH_FLUSH_ALL
+#define CONFIG_CACHE_BATCH_FLUSH_ALL	(256 << 10)
+#endif
+
+#define CACHE_LINE	ARCH_DMA_MINALIGN
+
+/*
+ * Add a range to a list sorted by address, merging it with any that it
+ * overlaps or touches
+ *
+ * @return 0 if ok, -1 if the list is full
+ */
+static int range_add(struct cache_range *list, int *countp, ulong start,
+		     ulong end)
+{
+	int count = *countp;
+	int i, j;
+
+	/* Find the first range which does not end before this one starts */
+	for (i = 0; i < count && list[i].end < start; i++)
+		;
+
+	if (i < count && list[i].start <= end) {
+		list[i].start = min(list[i].start, start);
+		list[i].end = max(list[i].end, end);
+
+		/* It may now reach the ranges after it */
+		for (j = i + 1; j < count && list[j].start <= list[i].end; j++)
+			list[i].end = max(list[i].end, list[j].end);
+		memmove(&list[i + 1], &list[j], (count - j) * sizeof(*list));
+		*countp = count - (j - i - 1);
+		return 0;
+	}
+
+	if (count == CONFIG_CACHE_BATCH_RANGES)
+		return -1;
+	memmove(&list[i + 1], &list[i], (count - i) * sizeof(*list));
+	list[i].start = start;
+	list[i].end = end;
+	*countp = count + 1;
+
+	return 0;
+}
+
+static int range_covered(const struct cache_range *list, int count,
+			 ulong start, ulong end)
+{
+	int i;
+
+	for (i = 0; i < count && list[i].start <= start; i++) {
+		if (end <= list[i].end)
+			return 1;
+	}
+
+	return 0;
+}
+
+void cache_batch_init(struct cache_batch *batch, int flags)
+{
+	batch->flags = flags;
+	batch->count = 0;
+	batch->clean_count = 0;
+}
+
+void cache_batch_add(struct cache_batch *batch, ulong start, ulong end)
+{
+	if (start >= end)
+		return;
+
+	if (!(batch->flags & CACHE_BATCH_INVALIDATE)) {
+		start &= ~(CACHE_LINE - 1);
+		end = ALIGN(end, CACHE_LINE);
+		if ((batch->flags & CACHE_BATCH_TRACK) &&
+		    range_covered(batch->clean, batch->clean_count, start, end))
+			return;
+	}
+
+	if (range_add(batch->range, &batch->count, start, end)) {
+		cache_batch_run(batch);
+		range_add(batch->range, &batch->count, start, end);
+	}
+}
+
+void cache_batch_run(struct cache_batch *batch)
+{
+	struct cache_range *range;
+	ulong size = 0;
+	int i;
+
+	for (i = 0, range = batch->range; i < batch->count; i++, range++)
+		size += range->end - range->start;
+
+	/*
+	 * Invalidating the whole cache would lose other dirty data, and
+	 * flushing it instead would write back anything the CPU left in
+	 * the areas over what the device put there. So only a flush goes
+	 * for the whole cache.
+	 */
+	if (batch->flags & CACHE_BATCH_INVALIDATE) {
+		for (i = 0, range = batch->range; i < batch->count;
+		     i++, range++)
+			invalidate_dcache_range(range->start, range->end);
+	} else if (size >= CONFIG_CACHE_BATCH_FLUSH_ALL) {
+		flush_dcache_all();
+	} else {
+		for (i = 0, range = batch->range; i < batch->count;
+		     i++, range++)
+			flush_dcache_range(range->start, range->end);
+	}
+
+	/* Not knowing that something is clean is always safe */
+	if (batch->flags & CACHE_BATCH_TRACK) {
+		for (i = 0, range = batch->range; i < batch->count;
+		     i++, range++)
+			range_add(batch->clean, &batch->clean_count,
+				  range->start, range->end);
+	}
+	batch->count = 0;
+}
+
+void cache_batch_dirty(struct cache_batch *batch, ulong start, ulong end)
+{
+	struct cache_range *list = batch->clean;
+	int count = batch->clean_count;
+	int i;
+
+	start &= ~(CACHE_LINE - 1);
+	end = ALIGN(end, CACHE_LINE);
+	for (i = 0; i < count; i++) {
+		if (list[i].end <= start || list[i].start >= end)
+			continue;
+		if (list[i].start < start && list[i].end > end &&
+		    count < CONFIG_CACHE_BATCH_RANGES) {
+			/* Split around the dirty part */
+			memmove(&list[i + 1], &list[i],
+				(count - i) * sizeof(*list));
+			count++;
+			list[i].end = start;
+			list[++i].start = end;
+		} else if (list[i].start < start) {
+			list[i].end = start;
+		} else if (list[i].end > end) {
+			list[i].start = end;
+		} else {
+			memmove(&list[i], &list[i + 1],
+				(count - i - 1) * sizeof(*list));
+			count--;
+			i--;
+		}
+	}
+	batch->clean_count = count;
+}
@@ -0,0 +1,64 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Show how much of the arena and the malloc() pool has been used
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <command.h>
+
+static int do_arena(cmd_tbl_t *cmdtp, int flag, int argc,
+		    char * const argv[])
+{
+	struct arena_info info;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+	if (argc == 2) {
+		if (strcmp(argv[1], "reset"))
+			return CMD_RET_USAGE;
+		arena_reset_info();
+		return 0;
+	}
+
+	/* This command is itself in a scope, so it sees the arena set up */
+	arena_get_info(&info);
+	printf("arena:  %8lu bytes, %lu in use, peak %lu\n", info.size,
+	       info.used, info.peak);
+	if (info.fallbacks)
+		printf("        %lu allocations (%lu bytes) went to malloc\n",
+		       info.fallbacks, info.fallback_bytes);
+	printf("malloc: %8lu bytes, peak %lu\n", info.malloc_size,
+	       info.malloc_peak);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	arena,	2,	1,	do_arena,
+	"show arena and malloc pool usage",
+	"\n"
+	"    - show the size of the arena and of the malloc pool and\n"
+	"      the most of each used so far\n"
+	"arena reset\n"
+	"    - count the peaks from now on"
+);
@@ -37,6 +37,7 @@
 #include <linux/ctype.h>
 #include <asm/byteorder.h>
 #include <linux/compiler.h>
+#include <worker.h>
 
 #if defined(CONFIG_CMD_USB)
 #include <usb.h>
@@ -61,6 +62,14 @@
 #include <linux/lzo.h>
 #endif /* CONFIG_LZO */
 
+#ifdef CONFIG_LZ4
+#include <lz4.h>
+#endif /* CONFIG_LZ4 */
+
+#ifdef CONFIG_ZSTD
+#include <zstd.h>
+#endif /* CONFIG_ZSTD */
+
 DECLARE_GLOBAL_DATA_PTR;
 
 #ifndef CONFIG_SYS_BOOTM_LEN
@@ -323,12 +332,14 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	ulong image_len = os.image_len;
 	__maybe_unused uint unc_len = CONFIG_SYS_BOOTM_LEN;
 	int no_overlap = 0;
-#if defined(CONFIG_LZMA) || defined(CONFIG_LZO)
+#if defined(CONFIG_LZMA) || defined(CONFIG_LZO) || defined(CONFIG_LZ4) || \
+	defined(CONFIG_ZSTD)
 	int ret;
-#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) */
+#endif
 
 	const char *type_name = genimg_get_type_name(os.type);
 
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
 	switch (comp) {
 	case IH_COMP_NONE:
 		if (load == blob_start || load == image_start) {
@@ -416,11 +427,54 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 		*load_end = load + unc_len;
 		break;
 #endif /* CONFIG_LZO */
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t lz4_len = unc_len;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = lz4_decompress((const void *)image_start, image_len,
+				     (void *)load, &lz4_len);
+		if (ret) {
+			printf("LZ4: uncompress or overwrite error %d "
+			       "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + lz4_len;
+		break;
+	}
+#endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t zstd_len = unc_len;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = zstd_decompress((const void *)image_start, image_len,
+				      (void *)load, &zstd_len);
+		if (ret) {
+			printf("ZSTD: uncompress or overwrite error %d "
+			       "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + zstd_len;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
 	}
 
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_DECOMP, *load_end - load);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_DECOMP);
+
 	flush_cache(load, (*load_end - load) * sizeof(ulong));
 
 	puts("OK\n");
@@ -583,7 +637,8 @@ static int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 /* bootm - boot application image from image in memory */
 /*******************************************************************/
 
-int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+static int bootm_run(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
 {
 	ulong		iflag;
 	ulong		load_end = 0;
@@ -653,7 +708,9 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	usb_stop();
 #endif
 
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_LOAD_OS, "load_os");
 	ret = bootm_load_os(images.os, &load_end, 1);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_LOAD_OS);
 
 	if (ret < 0) {
 		if (ret == BOOTM_ERR_RESET)
@@ -709,6 +766,10 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return 1;
 	}
 
+#ifdef CONFIG_WORKERS
+	/* The OS expects to find the secondary cores in their spin loop */
+	worker_stop();
+#endif
 	arch_preboot_os();
 
 	boot_fn(0, argc, argv, &images);
@@ -722,6 +783,18 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	return 1;
 }
 
+int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	/* This is only ended if bootm fails; the report shows it so far */
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_BOOTM, "bootm");
+	ret = bootm_run(cmdtp, flag, argc, argv);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_BOOTM);
+
+	return ret;
+}
+
 int bootm_maybe_autostart(cmd_tbl_t *cmdtp, const char *cmd)
 {
 	const char *ep = getenv("autostart");
@@ -27,6 +27,10 @@
 #define CONFIG_BOOTSTAGE_STASH_SIZE	-1
 #endif
 
+#ifndef CONFIG_BOOTSTAGE_EXPORT_SIZE
+#define CONFIG_BOOTSTAGE_EXPORT_SIZE	0x10000
+#endif
+
 static int do_bootstage_report(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
 {
@@ -79,10 +83,35 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_bootstage_export(cmd_tbl_t *cmdtp, int flag, int argc,
+			       char * const argv[])
+{
+	ulong base, size;
+	char buf[12];
+	int len;
+
+	if (argc < 2 || get_base_size(argc, argv, &base, &size))
+		return CMD_RET_USAGE;
+	if (size == -1UL)
+		size = CONFIG_BOOTSTAGE_EXPORT_SIZE;
+
+	len = bootstage_export_csv((char *)base, size);
+	if (len < 0) {
+		printf("Not enough space for bootstage export\n");
+		return 1;
+	}
+	printf("Exported %d bytes\n", len);
+	sprintf(buf, "%X", len);
+	setenv("filesize", buf);
+
+	return 0;
+}
+
 static cmd_tbl_t cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+	U_BOOT_CMD_MKENT(export, 4, 0, do_bootstage_export, "", ""),
 };
 
 /*
@@ -112,5 +141,6 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
-	"unstash [<start> [<size>]]  - Unstash data from memory"
+	"unstash [<start> [<size>]]  - Unstash data from memory\n"
+	"export <start> [<size>]     - Export data to memory as CSV"
 );
@@ -338,12 +338,31 @@ static int do_flerase(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return CMD_RET_USAGE;
 
 	if (strcmp(argv[1], "all") == 0) {
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+		int s_first[CONFIG_SYS_MAX_FLASH_BANKS];
+		int s_last[CONFIG_SYS_MAX_FLASH_BANKS];
+
+		/* erase all the banks at once, skipping unknown ones */
+		for (bank = 0; bank < CONFIG_SYS_MAX_FLASH_BANKS; ++bank) {
+			info = &flash_info[bank];
+			s_first[bank] = -1;
+			s_last[bank] = -1;
+			if (info->flash_id == FLASH_UNKNOWN)
+				continue;
+			s_first[bank] = 0;
+			s_last[bank] = info->sector_count - 1;
+		}
+		puts ("Erase all Flash Banks ");
+		return flash_erase_banks(CONFIG_SYS_MAX_FLASH_BANKS,
+					 s_first, s_last);
+#else
 		for (bank=1; bank<=CONFIG_SYS_MAX_FLASH_BANKS; ++bank) {
 			printf ("Erase Flash Bank # %ld ", bank);
 			info = &flash_info[bank-1];
 			rcode = flash_erase (info, 0, info->sector_count-1);
 		}
 		return rcode;
+#endif
 	}
 
 	if ((n = abbrev_spec(argv[1], &info, &sect_first, &sect_last)) != 0) {
@@ -440,9 +459,16 @@ int flash_sect_erase (ulong addr_first, ulong addr_last)
 						info->start[0] + info->size - 1:
 						info->start[s_last[bank]+1] - 1,
 					bank+1);
+#ifndef CONFIG_SYS_FLASH_PIPELINE
 				rcode = flash_erase (info, s_first[bank], s_last[bank]);
+#endif
 			}
 		}
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+		/* erase all the banks at once */
+		rcode = flash_erase_banks(CONFIG_SYS_MAX_FLASH_BANKS,
+					  s_first, s_last);
+#endif
 		if (rcode == 0)
 			printf("Erased %d sectors\n", erased);
 	} else if (rcode == 0) {
@@ -39,6 +39,27 @@ U_BOOT_CMD(
 	"      unless specified otherwise using a leading \"0x\"."
 );
 
+#if defined(CONFIG_FIT)
+int do_load_fit_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	return do_load_fit(cmdtp, flag, argc, argv, FS_TYPE_ANY);
+}
+
+U_BOOT_CMD(
+	loadfit,	6,	0,	do_load_fit_wrapper,
+	"load the parts of a FIT image used by one configuration",
+	"<interface> [<dev[:part]> [<addr> [<filename> [conf]]]]\n"
+	"    - Load the structure of FIT image 'filename' from partition\n"
+	"      'part' on device type 'interface' instance 'dev' to address\n"
+	"      'addr' (hex), then only the kernel, ramdisk and fdt data of\n"
+	"      configuration 'conf' (or of the default configuration).\n"
+	"      Image data must have been stored outside the FIT structure\n"
+	"      (mkimage -E) for it to be skipped; the result can be passed\n"
+	"      to bootm as is."
+);
+#endif
+
 int do_ls_wrapper(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	return do_ls(cmdtp, flag, argc, argv, FS_TYPE_ANY);
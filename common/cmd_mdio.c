@@ -192,6 +192,9 @@ static int do_mdio(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	int pos = argc - 1;
 	struct mii_dev *bus;
 
+	/* The buses are registered along with the ethernet devices */
+	eth_probe();
+
 	if (argc < 2)
 		return CMD_RET_USAGE;
 
@@ -33,6 +33,7 @@
 #include <dataflash.h>
 #endif
 #include <watchdog.h>
+#include <div64.h>
 #include <linux/compiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -360,15 +361,20 @@ static int do_mem_cp(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #endif
 	   ) {
 		int rc;
+		ulong start, delta;
 
 		puts ("Copy to Flash... ");
 
+		start = get_timer(0);
 		rc = flash_write ((char *)addr, dest, count*size);
 		if (rc != 0) {
 			flash_perror (rc);
 			return (1);
 		}
-		puts ("done\n");
+		delta = max(get_timer(start), 1UL);
+		printf("done\n%lu bytes in %lu.%03lus, %lu B/s\n", count * size,
+		       delta / 1000, delta % 1000,
+		       (ulong)lldiv((u64)count * size * 1000, delta));
 		return 0;
 	}
 #endif
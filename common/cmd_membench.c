@@ -0,0 +1,252 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Measure memcpy(), memmove() and memset() by size and alignment, and
+ * with CONFIG_CACHE_BATCH the cache maintenance for DMA
+ */
+
+#include <common.h>
+#include <cache_batch.h>
+#include <command.h>
+#include <div64.h>
+#include <malloc.h>
+
+#define MEMBENCH_MIN_SIZE	16
+#define MEMBENCH_MAX_SIZE	(1 << 20)
+#define MEMBENCH_MIN_MS		50	/* time each result for at least this */
+#define MEMBENCH_ALIGN		64	/* a cache line, on most CPUs */
+
+enum membench_test {
+	MEMBENCH_MEMCPY,
+	MEMBENCH_MEMCPY_UNALIGNED,
+	MEMBENCH_MEMMOVE,
+	MEMBENCH_MEMSET,
+	MEMBENCH_MEMSET_UNALIGNED,
+
+	MEMBENCH_COUNT,
+};
+
+static const char *const membench_title[MEMBENCH_COUNT] = {
+	"memcpy", "memcpy/u", "memmove", "memset", "memset/u",
+};
+
+/*
+ * The unaligned tests use a destination one byte in and a source three
+ * bytes in. memmove() moves up by a cache line, so that it overlaps.
+ */
+static void membench_run(enum membench_test test, char *buf, size_t size,
+			 ulong runs)
+{
+	char *dest = buf + size + 64;
+
+	for (; runs; runs--) {
+		switch (test) {
+		case MEMBENCH_MEMCPY:
+			memcpy(dest, buf, size);
+			break;
+		case MEMBENCH_MEMCPY_UNALIGNED:
+			memcpy(dest + 1, buf + 3, size);
+			break;
+		case MEMBENCH_MEMMOVE:
+			memmove(buf + 64, buf, size);
+			break;
+		case MEMBENCH_MEMSET:
+			memset(dest, runs, size);
+			break;
+		case MEMBENCH_MEMSET_UNALIGNED:
+			memset(dest + 1, runs, size);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/* Print the speed in GB/s, doubling the runs until it takes long enough */
+static void membench_one(enum membench_test test, char *buf, size_t size)
+{
+	ulong runs, start, taken;
+	u64 bytes;
+	uint mbps;
+
+	for (runs = 1; ; runs *= 2) {
+		start = get_timer(0);
+		membench_run(test, buf, size, runs);
+		taken = get_timer(start);
+		if (taken >= MEMBENCH_MIN_MS)
+			break;
+	}
+
+	bytes = (u64)size * runs * 1000;
+	mbps = lldiv(bytes, taken) >> 20;
+	printf(" %5u.%02u", mbps >> 10, (mbps & 1023) * 100 >> 10);
+}
+
+#ifdef CONFIG_CACHE_BATCH
+/* DMA set-ups to flush for, e.g. for a network driver and a block read */
+static const struct membench_dma {
+	const char *name;
+	size_t piece;		/* each area to flush */
+	size_t stride;		/* distance from one to the next */
+	int count;
+	int desc;		/* each area has a 16-byte descriptor too */
+} membench_dma[] = {
+	{ "16 x 1.5KB packets", 1536, 2048, 16, 1 },
+	{ "1MB in 20KB pieces", 20 << 10, 20 << 10, (1 << 20) / (20 << 10), 0 },
+};
+
+#define MEMBENCH_DMA_SIZE	((1 << 20) + (64 << 10))
+
+static void membench_flush(const struct membench_dma *dma, char *buf,
+			   int batched, ulong runs)
+{
+	struct cache_batch batch;
+	ulong addr, desc;
+	int i;
+
+	for (; runs; runs--) {
+		cache_batch_init(&batch, CACHE_BATCH_FLUSH);
+		addr = (ulong)buf;
+		desc = addr + dma->count * dma->stride;
+
+		/* The descriptors are one ring, so add it as one area */
+		if (batched && dma->desc)
+			cache_batch_add(&batch, desc, desc + dma->count * 16);
+		for (i = 0; i < dma->count; i++, addr += dma->stride) {
+			if (batched) {
+				cache_batch_add(&batch, addr, addr + dma->piece);
+				continue;
+			}
+			flush_dcache_range(addr, ALIGN(addr + dma->piece,
+						       ARCH_DMA_MINALIGN));
+			if (dma->desc) {
+				flush_dcache_range(desc,
+						   desc + ARCH_DMA_MINALIGN);
+				desc += 16;
+			}
+		}
+		cache_batch_run(&batch);
+	}
+}
+
+/* Print the time for one set-up in nanoseconds */
+static void membench_flush_one(const struct membench_dma *dma, char *buf,
+			       int batched)
+{
+	ulong runs, start, taken;
+
+	for (runs = 1; ; runs *= 2) {
+		start = get_timer(0);
+		membench_flush(dma, buf, batched, runs);
+		taken = get_timer(start);
+		if (taken >= MEMBENCH_MIN_MS)
+			break;
+	}
+	printf(" %10lu", (ulong)lldiv((u64)taken * 1000000, runs));
+}
+
+static int membench_cache(void)
+{
+	const struct membench_dma *dma;
+	char *buf;
+
+	buf = memalign(MEMBENCH_ALIGN, MEMBENCH_DMA_SIZE);
+	if (!buf) {
+		puts("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	memset(buf, '\0', MEMBENCH_DMA_SIZE);
+
+	printf("%-20s %10s %10s  (ns)\n", "flush", "each", "batched");
+	for (dma = membench_dma; dma < membench_dma + ARRAY_SIZE(membench_dma);
+	     dma++) {
+		printf("%-20s", dma->name);
+		membench_flush_one(dma, buf, 0);
+		membench_flush_one(dma, buf, 1);
+		puts("\n");
+	}
+	free(buf);
+
+	return 0;
+}
+#endif
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	size_t max = MEMBENCH_MAX_SIZE, size;
+	enum membench_test test;
+	char *buf;
+
+#ifdef CONFIG_CACHE_BATCH
+	if (argc > 1 && !strcmp(argv[1], "cache"))
+		return membench_cache();
+#endif
+	if (argc > 1)
+		max = simple_strtoul(argv[1], NULL, 0);
+	if (max < MEMBENCH_MIN_SIZE)
+		return CMD_RET_USAGE;
+
+	/* Make do with what malloc() can give */
+	for (; max >= MEMBENCH_MIN_SIZE; max /= 2) {
+		buf = memalign(MEMBENCH_ALIGN, max * 2 + 128);
+		if (buf)
+			break;
+	}
+	if (max < MEMBENCH_MIN_SIZE) {
+		puts("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	memset(buf, '\0', max * 2 + 128);
+
+	printf("%8s", "size");
+	for (test = 0; test < MEMBENCH_COUNT; test++)
+		printf(" %8s", membench_title[test]);
+	puts("  (GB/s)\n");
+
+	for (size = MEMBENCH_MIN_SIZE; size <= max; size *= 4) {
+		printf("%8zu", size);
+		for (test = 0; test < MEMBENCH_COUNT; test++) {
+			if (ctrlc()) {
+				puts("\n");
+				free(buf);
+				return CMD_RET_FAILURE;
+			}
+			membench_one(test, buf, size);
+		}
+		puts("\n");
+	}
+	free(buf);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	membench,	2,	0,	do_membench,
+	"measure memcpy, memmove and memset speed",
+	"[max_size]\n"
+	"    - time copies and fills from 16 bytes up to max_size\n"
+	"      (default 1MB), aligned and unaligned ('/u')"
+#ifdef CONFIG_CACHE_BATCH
+	"\nmembench cache\n"
+	"    - time cache flushes for DMA, area by area and batched"
+#endif
+);
@@ -299,6 +299,9 @@ static int do_mii(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	mii_init ();
 #endif
 
+	/* The PHYs are registered along with the ethernet devices */
+	eth_probe();
+
 	/*
 	 * We use the last specified parameters, unless new ones are
 	 * entered.
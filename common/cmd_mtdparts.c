@@ -875,7 +875,7 @@ static int device_parse(const char *const mtd_dev, const char **ret, struct mtd_
 	debug("dev type = %d (%s), dev num = %d, mtd-id = %s\n",
 			id->type, MTD_DEV_TYPE(id->type),
 			id->num, id->mtd_id);
-	debug("parsing partitions %.*s\n", (pend ? pend - p : strlen(p)), p);
+	debug("parsing partitions %.*s\n", (int)(pend ? pend - p : strlen(p)), p);
 
 
 	/* parse partitions */
@@ -1021,7 +1021,7 @@ static struct mtdids* id_find_by_mtd_id(const char *mtd_id, unsigned int mtd_id_
 		id = list_entry(entry, struct mtdids, link);
 
 		debug("entry: '%s' (len = %d)\n",
-				id->mtd_id, strlen(id->mtd_id));
+				id->mtd_id, (int)strlen(id->mtd_id));
 
 		if (mtd_id_len != strlen(id->mtd_id))
 			continue;
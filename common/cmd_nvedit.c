@@ -47,6 +47,9 @@
 #include <errno.h>
 #include <malloc.h>
 #include <watchdog.h>
+#ifdef CONFIG_HUSH_CACHE
+#include <hush.h>
+#endif
 #include <linux/stddef.h>
 #include <asm/byteorder.h>
 
@@ -229,6 +232,13 @@ static int _do_env_set(int flag, int argc, char * const argv[])
 
 	env_id++;
 
+#ifdef CONFIG_HUSH_CACHE
+	/* a script parsed from the old value is not wanted any more */
+	s = getenv(name);
+	if (s)
+		hush_cache_forget(s);
+#endif
+
 	/* Delete only ? */
 	if (argc < 3 || argv[2] == NULL) {
 		int rc = hdelete_r(name, &env_htab, env_flag);
@@ -0,0 +1,100 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <prof.h>
+
+#ifndef CONFIG_PROF_HZ
+#define CONFIG_PROF_HZ		1000
+#endif
+
+static int do_prof_start(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	ulong hz = CONFIG_PROF_HZ;
+	int ret;
+
+	if (argc > 1)
+		hz = simple_strtoul(argv[1], NULL, 10);
+	if (!hz || hz > 1000000)
+		return CMD_RET_USAGE;
+
+	ret = prof_start(hz);
+	if (ret) {
+		printf("Cannot start profiler: %d\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_prof_stop(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	prof_stop();
+
+	return 0;
+}
+
+static int do_prof_report(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	int lines = 20;
+
+	if (argc > 1)
+		lines = simple_strtoul(argv[1], NULL, 10);
+	prof_report(lines);
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_prof_sub[] = {
+	U_BOOT_CMD_MKENT(start, 2, 0, do_prof_start, "", ""),
+	U_BOOT_CMD_MKENT(stop, 1, 0, do_prof_stop, "", ""),
+	U_BOOT_CMD_MKENT(report, 2, 0, do_prof_report, "", ""),
+};
+
+static int do_prof(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading 'prof' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_prof_sub, ARRAY_SIZE(cmd_prof_sub));
+	if (!c)
+		return CMD_RET_USAGE;
+
+	return c->cmd(cmdtp, flag, argc, argv);
+}
+
+U_BOOT_CMD(
+	prof,	3,	1,	do_prof,
+	"sampling profiler",
+	"start [hz]   - clear the samples and start sampling\n"
+	"prof stop         - stop sampling\n"
+	"prof report [n]   - list the n (default 20, 0 for all) functions\n"
+	"                    with the most samples"
+);
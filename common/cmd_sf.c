@@ -78,11 +78,8 @@ static int sf_parse_len_arg(char *arg, ulong *len)
  */
 static ulong bytes_per_second(unsigned int len, ulong start_ms)
 {
-	/* less accurate but avoids overflow */
-	if (len >= ((unsigned int) -1) / 1024)
-		return len / (max(get_timer(start_ms) / 1024, 1));
-	else
-		return 1024 * len / max(get_timer(start_ms), 1);
+	/* 64-bit so that large, fast transfers neither overflow nor round */
+	return lldiv((u64)len * 1000, max(get_timer(start_ms), 1UL));
 }
 
 static int do_spi_flash_probe(int argc, char * const argv[])
@@ -133,37 +130,164 @@ static int do_spi_flash_probe(int argc, char * const argv[])
 	return 0;
 }
 
+/* Flash is read back for comparison this much at a time, at least */
+#define SF_UPDATE_CHUNK		(64 << 10)
+
+/* State of an update, see spi_flash_update() */
+struct sf_update {
+	u32 erase_start;	/* run of sectors waiting for erase+write */
+	size_t erase_len;
+	const char *erase_buf;	/* new data for that run */
+	size_t skipped;		/* bytes left alone */
+};
+
 /**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
+ * Erase and rewrite the pending run of sectors, if any. Erasing a run at
+ * once lets the flash driver use its largest erase commands.
  *
- * If the data being written is the same, then *skipped is incremented by len.
+ * @param flash		flash context pointer
+ * @param up		update state
+ * @return NULL if OK, else a string containing the stage which failed
+ */
+static const char *spi_flash_update_flush(struct spi_flash *flash,
+		struct sf_update *up)
+{
+	if (!up->erase_len)
+		return NULL;
+
+	debug("Erase region %x size %zx\n", up->erase_start, up->erase_len);
+	if (spi_flash_erase(flash, up->erase_start, up->erase_len))
+		return "erase";
+	if (spi_flash_write(flash, up->erase_start, up->erase_len,
+			    up->erase_buf))
+		return "write";
+	up->erase_len = 0;
+
+	return NULL;
+}
+
+/**
+ * Program the pages of a sector which differ from what is in flash, when
+ * no bit has to go from 0 to 1 so that no erase is needed.
  *
  * @param flash		flash context pointer
- * @param offset	flash offset to write
- * @param len		number of bytes to write
- * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
+ * @param offset	flash offset of the sector
+ * @param len		size of the sector
+ * @param buf		new data
+ * @param cmp_buf	data currently in flash
+ * @return NULL if OK, else a string containing the stage which failed
+ */
+static const char *spi_flash_update_program(struct spi_flash *flash,
+		u32 offset, size_t len, const char *buf, const char *cmp_buf)
+{
+	size_t pos, chunk, run_start = 0, run_len = 0;
+
+	/* Write each run of changed pages with one call */
+	for (pos = 0; pos < len; pos += chunk) {
+		chunk = min(len - pos,
+			    flash->page_size - (offset + pos) % flash->page_size);
+		if (memcmp(buf + pos, cmp_buf + pos, chunk)) {
+			if (!run_len)
+				run_start = pos;
+			run_len += chunk;
+			continue;
+		}
+		if (run_len && spi_flash_write(flash, offset + run_start,
+					       run_len, buf + run_start))
+			return "write";
+		run_len = 0;
+	}
+	if (run_len && spi_flash_write(flash, offset + run_start, run_len,
+				       buf + run_start))
+		return "write";
+
+	return NULL;
+}
+
+/**
+ * Check whether a sector can take the new data without an erase: no bit
+ * may go from 0 to 1, and on parts with ECC (SPI_FLASH_NO_REPROG) each
+ * page which changes must still be blank.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset of the sector
+ * @param len		size of the sector
+ * @param buf		new data
+ * @param cmp_buf	data currently in flash
+ * @return 1 if it can just be programmed, 0 if it needs an erase
+ */
+static int spi_flash_update_can_program(struct spi_flash *flash, u32 offset,
+		size_t len, const char *buf, const char *cmp_buf)
+{
+	size_t pos, chunk, i;
+
+	for (i = 0; i < len; i++)
+		if ((cmp_buf[i] & buf[i]) != buf[i])
+			return 0;
+	if (!(flash->flags & SPI_FLASH_NO_REPROG))
+		return 1;
+
+	for (pos = 0; pos < len; pos += chunk) {
+		chunk = min(len - pos,
+			    flash->page_size - (offset + pos) % flash->page_size);
+		if (!memcmp(buf + pos, cmp_buf + pos, chunk))
+			continue;
+		for (i = pos; i < pos + chunk; i++)
+			if (cmp_buf[i] != (char)0xff)
+				return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Work out what a sector of SPI flash needs: nothing if it already holds
+ * the data, programming of the changed pages if bits only have to be
+ * cleared, or else an erase, which is queued so that neighbouring
+ * sectors are erased together.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset of the sector
+ * @param len		size of the sector
+ * @param buf		new data
+ * @param cmp_buf	data currently in flash
+ * @param up		update state
  * @return NULL if OK, else a string containing the stage which failed
  */
 static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
+		size_t len, const char *buf, const char *cmp_buf,
+		struct sf_update *up)
 {
+	const char *err;
+
 	debug("offset=%#x, sector_size=%#x, len=%#zx\n",
 		offset, flash->sector_size, len);
-	if (spi_flash_read(flash, offset, len, cmp_buf))
-		return "read";
 	if (memcmp(cmp_buf, buf, len) == 0) {
 		debug("Skip region %x size %zx: no change\n",
 			offset, len);
-		*skipped += len;
-		return NULL;
+		up->skipped += len;
+		return spi_flash_update_flush(flash, up);
 	}
-	if (spi_flash_erase(flash, offset, len))
-		return "erase";
-	if (spi_flash_write(flash, offset, len, buf))
-		return "write";
+
+	if (spi_flash_update_can_program(flash, offset, len, buf, cmp_buf)) {
+		err = spi_flash_update_flush(flash, up);
+		if (!err)
+			err = spi_flash_update_program(flash, offset, len,
+						       buf, cmp_buf);
+		return err;
+	}
+
+	if (up->erase_len && up->erase_start + up->erase_len != offset) {
+		err = spi_flash_update_flush(flash, up);
+		if (err)
+			return err;
+	}
+	if (!up->erase_len) {
+		up->erase_start = offset;
+		up->erase_buf = buf;
+	}
+	up->erase_len += len;
+
 	return NULL;
 }
 
@@ -171,6 +295,10 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
  * Update an area of SPI flash by erasing and writing any blocks which need
  * to change. Existing blocks with the correct data are left unchanged.
  *
+ * Flash is read back in large chunks and compared sector by sector. Runs
+ * of sectors which need an erase are merged, and sectors which only need
+ * bits cleared are programmed without one.
+ *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
  * @param len		number of bytes to write
@@ -180,11 +308,12 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 static int spi_flash_update(struct spi_flash *flash, u32 offset,
 		size_t len, const char *buf)
 {
+	struct sf_update up = { .erase_len = 0, .skipped = 0 };
 	const char *err_oper = NULL;
 	char *cmp_buf;
 	const char *end = buf + len;
 	size_t todo;		/* number of bytes to do in this pass */
-	size_t skipped = 0;	/* statistics */
+	size_t chunk, pos;
 	const ulong start_time = get_timer(0);
 	size_t scale = 1;
 	const char *start_buf = buf;
@@ -192,12 +321,13 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 
 	if (end - buf >= 200)
 		scale = (end - buf) / 100;
-	cmp_buf = malloc(flash->sector_size);
+	chunk = roundup(SF_UPDATE_CHUNK, flash->sector_size);
+	cmp_buf = malloc(chunk);
 	if (cmp_buf) {
 		ulong last_update = get_timer(0);
 
 		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min(end - buf, flash->sector_size);
+			todo = min(end - buf, chunk);
 			if (get_timer(last_update) > 100) {
 				printf("   \rUpdating, %zu%% %lu B/s",
 					100 - (end - buf) / scale,
@@ -205,9 +335,19 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 							 start_time));
 				last_update = get_timer(0);
 			}
-			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
+			if (spi_flash_read(flash, offset, todo, cmp_buf)) {
+				err_oper = "read";
+				break;
+			}
+			for (pos = 0; pos < todo && !err_oper;
+			     pos += flash->sector_size)
+				err_oper = spi_flash_update_block(flash,
+					offset + pos,
+					min(todo - pos, flash->sector_size),
+					buf + pos, cmp_buf + pos, &up);
 		}
+		if (!err_oper)
+			err_oper = spi_flash_update_flush(flash, &up);
 	} else {
 		err_oper = "malloc";
 	}
@@ -219,9 +359,9 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	}
 
 	delta = get_timer(start_time);
-	printf("%zu bytes written, %zu bytes skipped", len - skipped,
-		skipped);
-	printf(" in %ld.%lds, speed %ld B/s\n",
+	printf("%zu bytes written, %zu bytes skipped", len - up.skipped,
+		up.skipped);
+	printf(" in %ld.%03lds, speed %ld B/s\n",
 		delta / 1000, delta % 1000, bytes_per_second(len, start_time));
 
 	return 0;
@@ -232,6 +372,7 @@ static int do_spi_flash_read_write(int argc, char * const argv[])
 	unsigned long addr;
 	unsigned long offset;
 	unsigned long len;
+	ulong start_time, delta;
 	void *buf;
 	char *endp;
 	int ret;
@@ -262,6 +403,7 @@ static int do_spi_flash_read_write(int argc, char * const argv[])
 		return 1;
 	}
 
+	start_time = get_timer(0);
 	if (strcmp(argv[0], "update") == 0)
 		ret = spi_flash_update(flash, offset, len, buf);
 	else if (strcmp(argv[0], "read") == 0)
@@ -276,6 +418,13 @@ static int do_spi_flash_read_write(int argc, char * const argv[])
 		return 1;
 	}
 
+	if (strcmp(argv[0], "read") == 0) {
+		delta = get_timer(start_time);
+		printf("%lu bytes read in %ld.%03lds, speed %ld B/s\n", len,
+		       delta / 1000, delta % 1000,
+		       bytes_per_second(len, start_time));
+	}
+
 	return 0;
 }
 
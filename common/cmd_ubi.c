@@ -308,7 +308,7 @@ static int ubi_volume_write(char *volume, void *buf, size_t size)
 		ubi_gluebi_updated(vol);
 	}
 
-	printf("%d bytes written to volume %s\n", size, volume);
+	printf("%zu bytes written to volume %s\n", size, volume);
 
 	return 0;
 }
@@ -325,7 +325,7 @@ static int ubi_volume_read(char *volume, char *buf, size_t size)
 	if (vol == NULL)
 		return ENODEV;
 
-	printf("Read %d bytes from volume %s to %p\n", size, volume, buf);
+	printf("Read %zu bytes from volume %s to %p\n", size, volume, buf);
 
 	if (vol->updating) {
 		printf("updating");
@@ -557,7 +557,7 @@ static int do_ubi(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		/* Use maximum available size */
 		if (!size) {
 			size = ubi->avail_pebs * ubi->leb_size;
-			printf("No size specified -> Using max size (%u)\n", size);
+			printf("No size specified -> Using max size (%zu)\n", size);
 		}
 		/* E.g., create volume */
 		if (argc == 3)
@@ -26,7 +26,9 @@
  */
 
 #include <common.h>
+#include <arena.h>
 #include <command.h>
+#include <malloc.h>
 #include <linux/ctype.h>
 
 /*
@@ -135,10 +137,84 @@ cmd_tbl_t *find_cmd_tbl (const char *cmd, cmd_tbl_t *table, int table_len)
 	return NULL;	/* not found or ambiguous command */
 }
 
+/*
+ * Index of the command table sorted by name, so that commands can be
+ * found by bisection. The linker sorts the table by symbol name, which
+ * is not always the command name ("?"), so it is sorted on first use.
+ */
+static cmd_tbl_t **cmd_index;
+
+static int cmd_index_cmp(const void *a, const void *b)
+{
+	cmd_tbl_t *cmd_a = *(cmd_tbl_t **)a;
+	cmd_tbl_t *cmd_b = *(cmd_tbl_t **)b;
+	int ret;
+
+	ret = strcmp(cmd_a->name, cmd_b->name);
+	if (!ret)	/* keep table order, so the same duplicate wins */
+		ret = (cmd_a > cmd_b) - (cmd_a < cmd_b);
+	return ret;
+}
+
+static cmd_tbl_t **cmd_index_build(cmd_tbl_t *table, int table_len)
+{
+	cmd_tbl_t **index;
+	int i;
+
+	index = malloc(table_len * sizeof(*index));
+	if (!index)
+		return NULL;
+	for (i = 0; i < table_len; i++)
+		index[i] = &table[i];
+	qsort(index, table_len, sizeof(*index), cmd_index_cmp);
+
+	return index;
+}
+
+/*
+ * As find_cmd_tbl(), using an index sorted by name. The commands starting
+ * with the name are next to each other, and a full match comes first.
+ */
+static cmd_tbl_t *find_cmd_index(const char *cmd, cmd_tbl_t **index,
+				 int table_len)
+{
+	const char *p;
+	int len, lo, hi, mid;
+
+	if (!cmd)
+		return NULL;
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen(cmd) : (p - cmd);
+
+	/* find the first command which does not sort before the name */
+	lo = 0;
+	hi = table_len;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strncmp(index[mid]->name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == table_len || strncmp(index[lo]->name, cmd, len))
+		return NULL;	/* not found */
+	if (index[lo]->name[len] == '\0')
+		return index[lo];	/* full match */
+	if (lo + 1 < table_len && !strncmp(index[lo + 1]->name, cmd, len))
+		return NULL;	/* ambiguous command */
+
+	return index[lo];	/* exactly one match */
+}
+
 cmd_tbl_t *find_cmd (const char *cmd)
 {
 	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
 	const int len = ll_entry_count(cmd_tbl_t, cmd);
+
+	if (!cmd_index)
+		cmd_index = cmd_index_build(start, len);
+	if (cmd_index)
+		return find_cmd_index(cmd, cmd_index, len);
 	return find_cmd_tbl(cmd, start, len);
 }
 
@@ -516,6 +592,7 @@ enum command_ret_t cmd_process(int flag, int argc, char * const argv[],
 			       int *repeatable, ulong *ticks)
 {
 	enum command_ret_t rc = CMD_RET_SUCCESS;
+	struct arena_scope scope;
 	cmd_tbl_t *cmdtp;
 
 	/* Look up command in command table */
@@ -545,7 +622,10 @@ enum command_ret_t cmd_process(int flag, int argc, char * const argv[],
 	if (!rc) {
 		if (ticks)
 			*ticks = get_timer(0);
+		/* What the command takes from the arena goes when it ends */
+		arena_enter(&scope);
 		rc = cmd_call(cmdtp, flag, argc, argv);
+		arena_leave(&scope);
 		if (ticks)
 			*ticks = get_timer(*ticks);
 		*repeatable &= cmdtp->repeatable;
@@ -1498,6 +1498,7 @@ void malloc_bin_reloc (void)
 ulong mem_malloc_start = 0;
 ulong mem_malloc_end = 0;
 ulong mem_malloc_brk = 0;
+ulong mem_malloc_peak = 0;
 
 void *sbrk(ptrdiff_t increment)
 {
@@ -1515,6 +1516,8 @@ void *sbrk(ptrdiff_t increment)
 		return (void *)MORECORE_FAILURE;
 
 	mem_malloc_brk = new;
+	if (new > mem_malloc_peak)
+		mem_malloc_peak = new;
 
 	return (void *)old;
 }
@@ -1524,6 +1527,7 @@ void mem_malloc_init(ulong start, ulong size)
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
+	mem_malloc_peak = start;
 
 	memset((void *)mem_malloc_start, 0, size);
 }
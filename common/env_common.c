@@ -140,6 +140,9 @@ void set_default_env(const char *s)
 			0, NULL) == 0)
 		error("Environment import failed: errno = %d\n", errno);
 
+#if defined(CONFIG_ENV_LOG) && !defined(CONFIG_SPL_BUILD)
+	env_log_forget();
+#endif
 	gd->flags |= GD_FLG_ENV_READY;
 }
 
@@ -0,0 +1,255 @@
+/*
+ * Log-structured environment: saveenv appends the variables changed
+ * since the last save instead of rewriting the whole environment.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <environment.h>
+#include <malloc.h>
+#include <search.h>
+#include <errno.h>
+
+/*
+ * The last CONFIG_ENV_LOG_SIZE bytes of an environment (env_t.log) hold
+ * change records, appended by saveenv since the environment was last
+ * written as a whole.  A record lists the variables that changed in the
+ * same "name=value\0" form as the environment data, with "name\0" for
+ * a deleted variable, so replaying it is just another import.
+ *
+ * Each saveenv writes a single record, which is checked by its CRC, so
+ * a save that was cut short is simply not replayed; the log then ends
+ * there and the next save writes the whole environment again.  The log
+ * also ends at a header that is still erased (all 0xff), which is what
+ * the backend writes to the log area along with a whole environment.
+ */
+struct env_log_rec {
+	uint32_t	crc;		/* CRC32 over len and data	*/
+	uint32_t	len;		/* length of data, a multiple of 4 */
+};
+
+#define ENV_LOG_ALIGN	4
+
+/*
+ * Records are padded to whole 16-byte units, so that appending one never
+ * programs a unit a second time. NOR parts with ECC over such units (see
+ * SPI_FLASH_NO_REPROG) lose it for a unit that is reprogrammed.
+ */
+#define ENV_LOG_UNIT	16
+
+static char *env_log_base;	/* environment as stored, exported */
+static char *env_log_next;	/* environment being saved, exported */
+static char *env_log_buf;	/* record being saved */
+static int env_log_end = -1;	/* end of the log, -1 if unknown */
+static int env_log_next_end;	/* end of the log once it is saved */
+
+static uint32_t env_log_crc(const struct env_log_rec *rec, const char *data)
+{
+	uint32_t crc;
+
+	crc = crc32(0, (const unsigned char *)&rec->len, sizeof(rec->len));
+	return crc32(crc, (const unsigned char *)data, rec->len);
+}
+
+/* Export the environment the way saveenv stores it */
+static int env_log_export(char **buf)
+{
+	if (!*buf) {
+		*buf = malloc(ENV_SIZE);
+		if (!*buf)
+			return -1;
+	}
+
+	return hexport_r(&env_htab, '\0', 0, buf, ENV_SIZE, 0, NULL) < 0;
+}
+
+/**
+ * env_log_replay() - replay the change records of an environment
+ *
+ * This is called by env_relocate_spec() after the environment has been
+ * imported, to apply the changes saved since it was written.
+ *
+ * @ep:		environment as read from the storage
+ */
+void env_log_replay(const env_t *ep)
+{
+	static const uint32_t erased[2] = { 0xffffffff, 0xffffffff };
+	const char *log = (const char *)ep->log;
+	struct env_log_rec rec;
+	int pos, count = 0;
+
+	env_log_end = -1;
+	for (pos = 0; pos + sizeof(rec) <= CONFIG_ENV_LOG_SIZE;
+	     pos += sizeof(rec) + rec.len) {
+		memcpy(&rec, log + pos, sizeof(rec));
+		if (!memcmp(&rec, erased, sizeof(rec)))
+			break;
+
+		if (rec.len > CONFIG_ENV_LOG_SIZE - sizeof(rec) - pos ||
+		    rec.len % ENV_LOG_ALIGN ||
+		    env_log_crc(&rec, log + pos + sizeof(rec)) != rec.crc) {
+			printf("*** Warning - damaged environment log, "
+				"dropping changes after %d\n\n", count);
+			return;
+		}
+
+		if (!himport_r(&env_htab, log + pos + sizeof(rec), rec.len,
+				'\0', H_NOCLEAR, 0, NULL)) {
+			error("Cannot replay environment log: errno = %d\n",
+				errno);
+			return;
+		}
+		count++;
+	}
+	debug("%s: %d records, %d bytes\n", __func__, count, pos);
+
+	if (!env_log_export(&env_log_base))
+		env_log_end = min(pos, CONFIG_ENV_LOG_SIZE);
+}
+
+/**
+ * env_log_forget() - forget about the stored environment
+ *
+ * This is called when the default environment is used, after which the
+ * next saveenv writes the whole environment.
+ */
+void env_log_forget(void)
+{
+	env_log_end = -1;
+}
+
+/* Add an entry of len bytes to the record, if there is room */
+static char *env_log_add(char *p, const char *end, const char *s, int len)
+{
+	if (!p || end - p < len + 1)
+		return NULL;
+	memcpy(p, s, len);
+	p[len] = '\0';
+
+	return p + len + 1;
+}
+
+/* Compare two "name=value" entries by name, the way hexport_r() sorts */
+static int env_log_cmp(const char *a, const char *b)
+{
+	int alen = strchr(a, '=') - a;
+	int blen = strchr(b, '=') - b;
+	int ret = memcmp(a, b, min(alen, blen));
+
+	return ret ? ret : alen - blen;
+}
+
+/**
+ * env_log_prepare() - build the change record for saveenv
+ *
+ * This compares the environment with what was last loaded or saved, and
+ * lists the differences in a change record.  Until env_log_saved() is
+ * called, the log is taken to be in an unknown state.
+ *
+ * @rec:	returns the record
+ * @offset:	returns where to write it, relative to the environment
+ * @return length of the record, 0 if nothing changed, or -1 if the whole
+ * environment has to be written (log full, damaged or not loaded)
+ */
+int env_log_prepare(const void **rec, ulong *offset)
+{
+	struct env_log_rec hdr;
+	const char *a, *b;
+	char *start, *p, *end;
+	int cmp;
+
+	if (env_log_end < 0 || env_log_export(&env_log_next))
+		return -1;
+	if (!env_log_buf) {
+		env_log_buf = malloc(CONFIG_ENV_LOG_SIZE);
+		if (!env_log_buf)
+			return -1;
+	}
+
+	start = env_log_buf + sizeof(hdr);
+	end = env_log_buf + CONFIG_ENV_LOG_SIZE - env_log_end;
+	p = start;
+
+	/* Both lists are sorted by name, so merge them */
+	for (a = env_log_base, b = env_log_next; p && (*a || *b); ) {
+		cmp = !*a ? 1 : !*b ? -1 : env_log_cmp(a, b);
+		if (cmp < 0) {
+			/* deleted */
+			p = env_log_add(p, end, a, strchr(a, '=') - a);
+			a += strlen(a) + 1;
+		} else if (cmp > 0) {
+			/* created */
+			p = env_log_add(p, end, b, strlen(b));
+			b += strlen(b) + 1;
+		} else {
+			if (strcmp(a, b))
+				p = env_log_add(p, end, b, strlen(b));
+			a += strlen(a) + 1;
+			b += strlen(b) + 1;
+		}
+	}
+
+	if (p == start)
+		return 0;
+
+	/* Terminate the list and pad the record */
+	do {
+		p = env_log_add(p, end, "", 0);
+	} while (p && (p - env_log_buf) % ENV_LOG_UNIT);
+	if (!p)
+		return -1;
+
+	hdr.len = p - start;
+	hdr.crc = env_log_crc(&hdr, start);
+	memcpy(env_log_buf, &hdr, sizeof(hdr));
+
+	*rec = env_log_buf;
+	*offset = offsetof(env_t, log) + env_log_end;
+	env_log_next_end = env_log_end + (p - env_log_buf);
+	env_log_end = -1;
+
+	return p - env_log_buf;
+}
+
+/**
+ * env_log_saved() - note what saveenv wrote
+ *
+ * @ep:		the whole environment that was written, with an empty log,
+ *		or NULL if the record from env_log_prepare() was written
+ */
+void env_log_saved(const env_t *ep)
+{
+	char *tmp;
+
+	if (ep) {
+		env_log_end = -1;
+		if (!env_log_base)
+			env_log_base = malloc(ENV_SIZE);
+		if (!env_log_base)
+			return;
+		memcpy(env_log_base, ep->data, ENV_SIZE);
+		env_log_end = 0;
+	} else {
+		tmp = env_log_base;
+		env_log_base = env_log_next;
+		env_log_next = tmp;
+		env_log_end = env_log_next_end;
+	}
+}
@@ -59,6 +59,36 @@ char *env_name_spec = "SPI Flash";
 
 static struct spi_flash *env_flash;
 
+#ifdef CONFIG_ENV_LOG
+/*
+ * Append the changes since the last save to the log of the environment
+ * at offset, which needs no erase.  Returns 0 if that was done, 1 if the
+ * whole environment has to be written instead, and -1 on error.
+ */
+static int env_sf_append(u32 offset)
+{
+	const void *rec;
+	ulong rec_offset;
+	int len;
+
+	len = env_log_prepare(&rec, &rec_offset);
+	if (len < 0)
+		return 1;
+	if (len == 0) {
+		puts("No changes\n");
+		return 0;
+	}
+
+	puts("Appending to SPI flash...");
+	if (spi_flash_write(env_flash, offset + rec_offset, len, rec))
+		return -1;
+	env_log_saved(NULL);
+	puts("done\n");
+
+	return 0;
+}
+#endif
+
 #if defined(CONFIG_ENV_OFFSET_REDUND)
 int saveenv(void)
 {
@@ -78,6 +108,14 @@ int saveenv(void)
 		}
 	}
 
+#ifdef CONFIG_ENV_LOG
+	ret = env_sf_append(gd->env_valid == 1 ? CONFIG_ENV_OFFSET :
+			    CONFIG_ENV_OFFSET_REDUND);
+	if (ret <= 0)
+		return -ret;
+	memset(env_new.log, 0xff, sizeof(env_new.log));
+#endif
+
 	res = (char *)&env_new.data;
 	len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
 	if (len < 0) {
@@ -144,6 +182,9 @@ int saveenv(void)
 	puts("done\n");
 
 	gd->env_valid = gd->env_valid == 2 ? 1 : 2;
+#ifdef CONFIG_ENV_LOG
+	env_log_saved(&env_new);
+#endif
 
 	printf("Valid environment: %d\n", (int)gd->env_valid);
 
@@ -229,6 +270,10 @@ void env_relocate_spec(void)
 		error("Cannot import environment: errno = %d\n", errno);
 		set_default_env("env_import failed");
 	}
+#ifdef CONFIG_ENV_LOG
+	else
+		env_log_replay(ep);
+#endif
 
 err_read:
 	spi_flash_free(env_flash);
@@ -256,6 +301,13 @@ int saveenv(void)
 		}
 	}
 
+#ifdef CONFIG_ENV_LOG
+	ret = env_sf_append(CONFIG_ENV_OFFSET);
+	if (ret <= 0)
+		return -ret;
+	ret = 1;
+#endif
+
 	/* Is the sector larger than the env (i.e. embedded) */
 	if (CONFIG_ENV_SECT_SIZE > CONFIG_ENV_SIZE) {
 		saved_size = CONFIG_ENV_SECT_SIZE - CONFIG_ENV_SIZE;
@@ -283,6 +335,9 @@ int saveenv(void)
 		goto done;
 	}
 	env_new.crc = crc32(0, env_new.data, ENV_SIZE);
+#ifdef CONFIG_ENV_LOG
+	memset(env_new.log, 0xff, sizeof(env_new.log));
+#endif
 
 	puts("Erasing SPI flash...");
 	ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
@@ -305,6 +360,9 @@ int saveenv(void)
 
 	ret = 0;
 	puts("done\n");
+#ifdef CONFIG_ENV_LOG
+	env_log_saved(&env_new);
+#endif
 
  done:
 	if (saved_buffer)
@@ -333,8 +391,12 @@ void env_relocate_spec(void)
 	}
 
 	ret = env_import(buf, 1);
-	if (ret)
+	if (ret) {
 		gd->env_valid = 1;
+#ifdef CONFIG_ENV_LOG
+		env_log_replay((env_t *)buf);
+#endif
+	}
 out:
 	spi_flash_free(env_flash);
 	env_flash = NULL;
@@ -458,6 +458,9 @@ void fdt_fixup_ethernet(void *fdt)
 	const char *path;
 	unsigned char mac_addr[6];
 
+	/* Probing the devices puts their MAC addresses in the environment */
+	eth_probe();
+
 	node = fdt_path_offset(fdt, "/aliases");
 	if (node < 0)
 		return;
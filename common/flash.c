@@ -172,6 +172,11 @@ flash_write (char *src, ulong addr, ulong cnt)
 	}
 
 	/* finally write data to flash */
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+	if (info_last != info_first)
+		return write_buff_banks(info_first, info_last, (uchar *)src,
+					addr, cnt);
+#endif
 	for (info = info_first; info <= info_last && cnt>0; ++info) {
 		ulong len;
 
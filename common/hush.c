@@ -90,6 +90,7 @@
 #include <malloc.h>         /* malloc, free, realloc*/
 #include <linux/ctype.h>    /* isalpha, isdigit */
 #include <common.h>        /* readline */
+#include <arena.h>          /* arena_realloc, arena_free */
 #include <hush.h>
 #include <command.h>        /* find_cmd */
 #ifndef CONFIG_SYS_PROMPT_HUSH_PS2
@@ -344,6 +345,9 @@ struct in_str {
 #endif
 	int (*get) (struct in_str *);
 	int (*peek) (struct in_str *);
+#ifdef CONFIG_HUSH_CACHE
+	struct hush_cache_entry *cache;	/* keeps the lists parsed, or NULL */
+#endif
 };
 #define b_getch(input) ((input)->get(input))
 #define b_peek(input) ((input)->peek(input))
@@ -395,6 +399,7 @@ static void __syntax(char *file, int line) {
 #ifdef __U_BOOT__
 static void *xmalloc(size_t size);
 static void *xrealloc(void *ptr, size_t size);
+static void *xrealloc_tmp(void *ptr, size_t size);
 #else
 /* Index of subroutines: */
 /*   function prototypes for builtins */
@@ -555,7 +560,7 @@ static int builtin_eval(struct child_prog *child)
 		str = make_string(child->argv + 1);
 		parse_string_outer(str, FLAG_EXIT_FROM_LOOP |
 					FLAG_PARSE_SEMICOLON);
-		free(str);
+		arena_free(str);
 		rcode = last_return_code;
 	}
 	return rcode;
@@ -1153,6 +1158,9 @@ static void setup_file_in_str(struct in_str *i)
 	i->file = f;
 #endif
 	i->p = NULL;
+#ifdef CONFIG_HUSH_CACHE
+	i->cache = NULL;
+#endif
 }
 
 static void setup_string_in_str(struct in_str *i, const char *s)
@@ -1162,6 +1170,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->__promptme=1;
 	i->promptmode=1;
 	i->p = s;
+#ifdef CONFIG_HUSH_CACHE
+	i->cache = NULL;
+#endif
 }
 
 #ifndef __U_BOOT__
@@ -1261,7 +1272,7 @@ static void pseudo_exec(struct child_prog *child)
 			debug_printf("pid %d environment modification: %s\n",getpid(),child->argv[i]);
 			p = insert_var_value(child->argv[i]);
 			putenv(strdup(p));
-			if (p != child->argv[i]) free(p);
+			if (p != child->argv[i]) arena_free(p);
 		}
 		child->argv+=i;  /* XXX this hack isn't so horrible, since we are about
 					to exit, and therefore don't need to keep data
@@ -1524,7 +1535,7 @@ shell_terminal_error:
  */
 static int run_pipe_real(struct pipe *pi)
 {
-	int i;
+	int i, sp;
 #ifndef __U_BOOT__
 	int nextin, nextout;
 	int pipefds[2];				/* pipefds[0] is for reading */
@@ -1605,10 +1616,12 @@ static int run_pipe_real(struct pipe *pi)
 				free(name);
 				p = insert_var_value(child->argv[i]);
 				set_local_var(p, export_me);
-				if (p != child->argv[i]) free(p);
+				if (p != child->argv[i]) arena_free(p);
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* count down a copy: the pipe may be run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1617,16 +1630,20 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
-				free(p);
+				sp--;
+				arena_free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
+			struct arena_scope scope;
 			char * str = NULL;
 
+			/* The expanded line is only needed until it has run */
+			arena_enter(&scope);
 			str = make_string((child->argv + i));
 			parse_string_outer(str, FLAG_EXIT_FROM_LOOP | FLAG_REPARSING);
-			free(str);
+			arena_free(str);
+			arena_leave(&scope);
 			return last_return_code;
 		}
 #ifndef __U_BOOT__
@@ -1753,6 +1770,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *for_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1792,7 +1810,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1821,6 +1840,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				for_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1828,6 +1848,7 @@ static int run_list_real(struct pipe *pi)
 			if (!(*list)) {
 				free(pi->progs->argv[0]);
 				free(save_list);
+				save_list = NULL;
 				list = NULL;
 				flag_rep = 0;
 				pi->progs->argv[0] = save_name;
@@ -1892,7 +1913,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1912,6 +1934,17 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+#ifdef __U_BOOT__
+out:
+	/* leaving a "for" early: put the pipe back as it was parsed */
+	if (save_list) {
+		free(for_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+	}
+#endif
 	return rcode;
 }
 
@@ -3156,6 +3189,235 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_CACHE
+/*
+ * Scripts run with run_command() or run_command_list() - 'run', 'source',
+ * bootcmd - are kept parsed, keyed by their text, once they have been
+ * parsed twice, so that running them again skips the parser. The lists are only run, never freed, while in
+ * the cache, so run_list_real() must leave them as it found them.
+ */
+#ifndef CONFIG_HUSH_CACHE_ENTRIES
+#define CONFIG_HUSH_CACHE_ENTRIES	16
+#endif
+
+struct hush_cache_entry {
+	char *script;		/* the text parsed */
+	uint hash;		/* crc32 of the text */
+	int flag;		/* parse flags it was parsed with */
+	struct pipe **lists;	/* one list for each line, in order */
+	int num_lists;
+	int complete;		/* parsed to the end, so it can be run */
+	int broken;		/* will not parse to the end, so cannot keep */
+	int busy;		/* runs in progress */
+	int stale;		/* dropped from the cache, free when not busy */
+	ulong last_used;
+	ulong hits;
+};
+
+static struct hush_cache_entry *hush_cache[CONFIG_HUSH_CACHE_ENTRIES];
+
+static struct hush_cache_stats {
+	ulong hits;		/* scripts run from the cache */
+	ulong misses;		/* scripts parsed */
+	ulong lists_parsed;	/* lines parsed */
+	ulong lists_reused;	/* lines run without parsing */
+	ulong not_kept;		/* parsed, but could not be kept */
+	ulong first_seen;	/* parsed, not kept until seen again */
+	ulong evictions;	/* dropped to make room */
+	ulong invalidations;	/* dropped when the variable changed */
+} hush_cache_stats;
+
+static ulong hush_cache_clock;
+
+/*
+ * Hashes of the scripts parsed once but not kept. A script is only kept
+ * when it is parsed the second time, so that command lines run just once
+ * do not push out the scripts which are run over and over.
+ */
+static uint hush_cache_seen[CONFIG_HUSH_CACHE_ENTRIES * 4];
+static int hush_cache_seen_next;
+
+/* Whether a script was parsed before, remembering it if not */
+static int hush_cache_seen_before(uint hash)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hush_cache_seen); i++) {
+		if (hush_cache_seen[i] == hash)
+			return 1;
+	}
+	hush_cache_stats.first_seen++;
+	hush_cache_seen[hush_cache_seen_next] = hash;
+	hush_cache_seen_next = (hush_cache_seen_next + 1) %
+			       ARRAY_SIZE(hush_cache_seen);
+
+	return 0;
+}
+
+static void hush_cache_free(struct hush_cache_entry *e)
+{
+	int i;
+
+	for (i = 0; i < e->num_lists; i++)
+		free_pipe_list(e->lists[i], 0);
+	free(e->lists);
+	free(e->script);
+	free(e);
+}
+
+/* Take an entry out of the cache, freeing it once nobody is running it */
+static void hush_cache_drop(int slot)
+{
+	struct hush_cache_entry *e = hush_cache[slot];
+
+	hush_cache[slot] = NULL;
+	if (e->busy)
+		e->stale = 1;
+	else
+		hush_cache_free(e);
+}
+
+static struct hush_cache_entry *hush_cache_find(const char *s, uint hash,
+						int flag)
+{
+	struct hush_cache_entry *e;
+	int i;
+
+	for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++) {
+		e = hush_cache[i];
+		if (e && e->hash == hash && e->flag == flag &&
+		    !strcmp(e->script, s))
+			return e;
+	}
+	return NULL;
+}
+
+/*
+ * Make an entry, in place of the oldest, to keep the lists of a script
+ * about to be parsed. It is in the cache while it is filled so that it
+ * can be dropped if the script changes.
+ */
+static struct hush_cache_entry *hush_cache_new(const char *s, uint hash,
+					       int flag)
+{
+	struct hush_cache_entry *e;
+	int i, slot = -1;
+
+	for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++) {
+		if (!hush_cache[i]) {
+			slot = i;
+			break;
+		}
+		if (!hush_cache[i]->busy && (slot == -1 ||
+		    hush_cache[i]->last_used < hush_cache[slot]->last_used))
+			slot = i;
+	}
+	if (slot == -1)
+		return NULL;	/* all busy */
+
+	e = malloc(sizeof(*e));
+	if (!e)
+		return NULL;
+	memset(e, '\0', sizeof(*e));
+	e->script = strdup(s);
+	if (!e->script) {
+		free(e);
+		return NULL;
+	}
+	e->hash = hash;
+	e->flag = flag;
+	e->busy = 1;
+	e->last_used = ++hush_cache_clock;
+
+	if (hush_cache[slot]) {
+		hush_cache_stats.evictions++;
+		hush_cache_drop(slot);
+	}
+	hush_cache[slot] = e;
+
+	return e;
+}
+
+/* Finish filling an entry, keeping it if the whole script was parsed */
+static void hush_cache_add(struct hush_cache_entry *e)
+{
+	int i;
+
+	e->busy--;
+	if (!e->broken && !e->stale) {
+		e->complete = 1;
+		return;
+	}
+
+	/* nothing else runs an entry before it is complete */
+	hush_cache_stats.not_kept++;
+	for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++) {
+		if (hush_cache[i] == e)
+			hush_cache[i] = NULL;
+	}
+	hush_cache_free(e);
+}
+
+/* Run a list just parsed, keeping it to be run again */
+static int hush_cache_run_list(struct hush_cache_entry *e, struct pipe *pi)
+{
+	struct pipe **lists;
+
+	hush_cache_stats.lists_parsed++;
+	lists = realloc(e->lists, (e->num_lists + 1) * sizeof(*lists));
+	if (!lists) {
+		e->broken = 1;
+		return run_list(pi);
+	}
+	e->lists = lists;
+	e->lists[e->num_lists++] = pi;
+
+	return run_list_real(pi);
+}
+
+/* Run a script from the cache, as parse_stream_outer() would have */
+static int hush_cache_run(struct hush_cache_entry *e)
+{
+	int code = 0;
+	int i;
+
+	hush_cache_stats.hits++;
+	e->hits++;
+	e->last_used = ++hush_cache_clock;
+	e->busy++;
+	for (i = 0; i < e->num_lists; i++) {
+		hush_cache_stats.lists_reused++;
+		code = run_list_real(e->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	if (!--e->busy && e->stale)
+		hush_cache_free(e);
+
+	return (code != 0) ? 1 : 0;
+}
+
+/* Drop a script from the cache, e.g. since its variable is changing */
+void hush_cache_forget(const char *s)
+{
+	uint hash = crc32(0, (const uchar *)s, strlen(s));
+	int i;
+
+	for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++) {
+		struct hush_cache_entry *e = hush_cache[i];
+
+		if (e && e->hash == hash && !strcmp(e->script, s)) {
+			hush_cache_stats.invalidations++;
+			hush_cache_drop(i);
+		}
+	}
+}
+#endif /* CONFIG_HUSH_CACHE */
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
 static int parse_stream_outer(struct in_str *inp, int flag)
@@ -3189,8 +3451,19 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#ifdef CONFIG_HUSH_CACHE
+			if (inp->cache)
+				code = hush_cache_run_list(inp->cache,
+							   ctx.list_head);
+			else
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
+#ifdef CONFIG_HUSH_CACHE
+				/* the rest was never parsed */
+				if (inp->cache)
+					inp->cache->broken = 1;
+#endif
 				b_free(&temp);
 				code = 0;
 				/* XXX hackish way to not allow exit from main loop */
@@ -3209,6 +3482,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 				b_reset(&temp);
 			}
 #ifdef __U_BOOT__
+#ifdef CONFIG_HUSH_CACHE
+			if (inp->cache)
+				inp->cache->broken = 1;
+#endif
 			if (inp->__promptme == 0) printf("<INTERRUPT>\n");
 			inp->__promptme = 1;
 #endif
@@ -3236,22 +3513,53 @@ int parse_string_outer(const char *s, int flag)
 #ifdef __U_BOOT__
 	char *p = NULL;
 	int rcode;
+#ifdef CONFIG_HUSH_CACHE
+	struct hush_cache_entry *e = NULL;
+	uint hash;
+#endif
 	if ( !s || !*s)
 		return 1;
+#ifdef CONFIG_HUSH_CACHE
+	/* a line made by substituting variables is seldom seen twice */
+	if (!(flag & FLAG_REPARSING)) {
+		hash = crc32(0, (const uchar *)s, strlen(s));
+		e = hush_cache_find(s, hash, flag);
+		if (e && !e->busy)
+			return hush_cache_run(e);
+		hush_cache_stats.misses++;
+		/*
+		 * A script which runs itself needs a parse of its own: the
+		 * lists of the outer run are in use, e.g. a for loop's
+		 * variable. That one is not kept.
+		 */
+		if (!e && hush_cache_seen_before(hash))
+			e = hush_cache_new(s, hash, flag);
+		else
+			e = NULL;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
-		rcode = parse_stream_outer(&input, flag);
-		free(p);
-		return rcode;
 	} else {
+		p = NULL;
+		setup_string_in_str(&input, s);
+	}
+#ifdef CONFIG_HUSH_CACHE
+	input.cache = e;
+#endif
+	rcode = parse_stream_outer(&input, flag);
+#ifdef CONFIG_HUSH_CACHE
+	if (e)
+		hush_cache_add(e);
 #endif
+	free(p);
+	return rcode;
+#else
 	setup_string_in_str(&input, s);
 	return parse_stream_outer(&input, flag);
-#ifdef __U_BOOT__
-	}
 #endif
 }
 
@@ -3323,6 +3631,18 @@ static void *xrealloc(void *ptr, size_t size)
 	}
 	return p;
 }
+
+/* For strings freed with arena_free() before the command line has run */
+static void *xrealloc_tmp(void *ptr, size_t size)
+{
+	void *p = NULL;
+
+	if (!(p = arena_realloc(ptr, size))) {
+	    printf("ERROR : memory not allocated\n");
+	    for(;;);
+	}
+	return p;
+}
 #endif /* __U_BOOT__ */
 
 #ifndef __U_BOOT__
@@ -3504,7 +3824,7 @@ static char *insert_var_value_sub(char *inp, int tag_subst)
 		if (p != inp) {
 			/* copy any charachters to the result string */
 			len = p - inp;
-			res_str = xrealloc(res_str, (res_str_len + len));
+			res_str = xrealloc_tmp(res_str, (res_str_len + len));
 			strncpy((res_str + res_str_len), inp, len);
 			res_str_len += len;
 		}
@@ -3518,7 +3838,7 @@ static char *insert_var_value_sub(char *inp, int tag_subst)
 				len = res_str_len + strlen(p1) + 2;
 			else
 				len = res_str_len + strlen(p1);
-			res_str = xrealloc(res_str, (1 + len));
+			res_str = xrealloc_tmp(res_str, (1 + len));
 			if (tag_subst) {
 				/*
 				 * copy the variable value to the result
@@ -3547,7 +3867,7 @@ static char *insert_var_value_sub(char *inp, int tag_subst)
 		done = 1;
 	}
 	if (done) {
-		res_str = xrealloc(res_str, (1 + res_str_len + strlen(inp)));
+		res_str = xrealloc_tmp(res_str, (1 + res_str_len + strlen(inp)));
 		strcpy((res_str + res_str_len), inp);
 		while ((p = strchr(res_str, '\n'))) {
 			*p = ' ';
@@ -3590,7 +3910,7 @@ static char **make_list_in(char **inp, char *name)
 			list[n++][name_len + len + 1] = '\0';
 			p1 = p2;
 		}
-		if (p3 != inp[i]) free(p3);
+		if (p3 != inp[i]) arena_free(p3);
 	}
 	list[n] = NULL;
 	return list;
@@ -3611,7 +3931,7 @@ static char * make_string(char ** inp)
 		noeval = 1;
 	for (n = 0; inp[n]; n++) {
 		p = insert_var_value_sub(inp[n], noeval);
-		str = xrealloc(str, (len + strlen(p)));
+		str = xrealloc_tmp(str, (len + strlen(p)));
 		if (n) {
 			strcat(str, " ");
 		} else {
@@ -3619,7 +3939,7 @@ static char * make_string(char ** inp)
 		}
 		strcat(str, p);
 		len = strlen(str) + 3;
-		if (p != inp[n]) free(p);
+		if (p != inp[n]) arena_free(p);
 	}
 	len = strlen(str);
 	*(str + len) = '\n';
@@ -3675,5 +3995,57 @@ U_BOOT_CMD(
 	"    - print value of hushshell variable 'name'"
 );
 
+#ifdef CONFIG_HUSH_CACHE
+static int do_hush(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct hush_cache_stats *st = &hush_cache_stats;
+	struct hush_cache_entry *e;
+	char *p;
+	int i, len, used = 0;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+	if (!strcmp(argv[1], "flush")) {
+		for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++) {
+			if (hush_cache[i])
+				hush_cache_drop(i);
+		}
+		return 0;
+	}
+	if (strcmp(argv[1], "stats"))
+		return CMD_RET_USAGE;
+
+	for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++)
+		used += hush_cache[i] != NULL;
+	printf("Scripts: %lu run from cache, %lu parsed (%lu first time), "
+	       "%lu not kept\n", st->hits, st->misses, st->first_seen,
+	       st->not_kept);
+	printf("Lines:   %lu run without parsing, %lu parsed\n",
+	       st->lists_reused, st->lists_parsed);
+	printf("Dropped: %lu to make room, %lu when changed\n",
+	       st->evictions, st->invalidations);
+	printf("Cached:  %d of %d\n", used, CONFIG_HUSH_CACHE_ENTRIES);
+	for (i = 0; i < CONFIG_HUSH_CACHE_ENTRIES; i++) {
+		e = hush_cache[i];
+		if (!e)
+			continue;
+		/* show the start of the first line */
+		p = strchr(e->script, '\n');
+		len = p ? p - e->script : strlen(e->script);
+		printf("%8lu hits, %3d lines: %.*s\n", e->hits, e->num_lists,
+		       min(len, 48), e->script);
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	hush, 2, 0, do_hush,
+	"hush shell script cache",
+	"stats - show how often scripts ran without being parsed\n"
+	"hush flush - drop all the parsed scripts"
+);
+#endif
+
 #endif
 /****************************************************************************/
@@ -157,6 +157,8 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_GZIP,	"gzip",		"gzip compressed",	},
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
+	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
+	{	IH_COMP_ZSTD,	"zstd",		"zstd compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -2422,6 +2424,63 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 	return 0;
 }
 
+/**
+ * fit_image_get_data_offset - get external data offset for a given component image node
+ * @fit: pointer to the FIT format image header
+ * @noffset: component image node offset
+ * @data_offset: pointer to int, will hold the data offset
+ *
+ * fit_image_get_data_offset() finds the data-offset property of an image
+ * whose data has been stored outside the FIT structure. The offset is
+ * relative to fit_get_ext_data().
+ *
+ * returns:
+ *     0, on success
+ *     -1, on failure
+ */
+int fit_image_get_data_offset(const void *fit, int noffset, int *data_offset)
+{
+	int len;
+	const fdt32_t *val;
+
+	val = fdt_getprop(fit, noffset, FIT_DATA_OFFSET_PROP, &len);
+	if (val == NULL) {
+		fit_get_debug(fit, noffset, FIT_DATA_OFFSET_PROP, len);
+		return -1;
+	}
+
+	*data_offset = fdt32_to_cpu(*val);
+	return 0;
+}
+
+/**
+ * fit_image_get_data_size - get external data size for a given component image node
+ * @fit: pointer to the FIT format image header
+ * @noffset: component image node offset
+ * @data_size: pointer to int, will hold the data size
+ *
+ * fit_image_get_data_size() finds the data-size property of an image whose
+ * data has been stored outside the FIT structure.
+ *
+ * returns:
+ *     0, on success
+ *     -1, on failure
+ */
+int fit_image_get_data_size(const void *fit, int noffset, int *data_size)
+{
+	int len;
+	const fdt32_t *val;
+
+	val = fdt_getprop(fit, noffset, FIT_DATA_SIZE_PROP, &len);
+	if (val == NULL) {
+		fit_get_debug(fit, noffset, FIT_DATA_SIZE_PROP, len);
+		return -1;
+	}
+
+	*data_size = fdt32_to_cpu(*val);
+	return 0;
+}
+
 /**
  * fit_image_get_data - get data property and its size for a given component image node
  * @fit: pointer to the FIT format image header
@@ -2431,7 +2490,8 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
  *
  * fit_image_get_data() finds data property in a given component image node.
  * If the property is found its data start address and size are returned to
- * the caller.
+ * the caller. Data stored outside the FIT structure (data-offset and
+ * data-size properties) is returned the same way.
  *
  * returns:
  *     0, on success
@@ -2440,11 +2500,19 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 int fit_image_get_data(const void *fit, int noffset,
 		const void **data, size_t *size)
 {
-	int len;
+	int offset, len;
 
 	*data = fdt_getprop(fit, noffset, FIT_DATA_PROP, &len);
 	if (*data == NULL) {
 		fit_get_debug(fit, noffset, FIT_DATA_PROP, len);
+		if (!fit_image_get_data_offset(fit, noffset, &offset) &&
+		    !fit_image_get_data_size(fit, noffset, &len) &&
+		    offset >= 0 && len >= 0) {
+			*data = (const char *)fit + fit_get_ext_data(fit) +
+				offset;
+			*size = len;
+			return 0;
+		}
 		*size = 0;
 		return -1;
 	}
@@ -2453,6 +2521,43 @@ int fit_image_get_data(const void *fit, int noffset,
 	return 0;
 }
 
+/**
+ * fit_get_end - get FIT image end
+ * @fit: pointer to the FIT format image header
+ *
+ * fit_get_end() returns the end of the FIT image, including the data of
+ * any component image stored outside the FIT structure. Checks that
+ * something loaded does not overwrite the image must use this end.
+ *
+ * returns:
+ *     end address of the FIT image in memory
+ */
+ulong fit_get_end(const void *fit)
+{
+	ulong end = fit_get_size(fit);
+	int images_noffset, noffset, ndepth;
+	int offset, size;
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return (ulong)fit + end;
+
+	for (ndepth = 0,
+		noffset = fdt_next_node(fit, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth != 1 ||
+		    fit_image_get_data_offset(fit, noffset, &offset) ||
+		    fit_image_get_data_size(fit, noffset, &size) ||
+		    offset < 0 || size < 0)
+			continue;
+		if (fit_get_ext_data(fit) + offset + size > end)
+			end = fit_get_ext_data(fit) + offset + size;
+	}
+
+	return (ulong)fit + end;
+}
+
 /**
  * fit_image_hash_get_algo - get hash algorithm name
  * @fit: pointer to the FIT format image header
@@ -3399,5 +3504,159 @@ static int fit_check_ramdisk(const void *fit, int rd_noffset, uint8_t arch,
 	bootstage_mark(BOOTSTAGE_ID_FIT_RD_CHECK_ALL_OK);
 	return 1;
 }
+
+/*
+ * Read the external data of one component image to its place after the FIT
+ * structure. Images with their data inside the structure are already loaded.
+ * The data must lie within the @size bytes of the FIT image, so that a bad
+ * data-offset or data-size cannot make it land outside the buffer.
+ */
+static int fit_load_image_data(void *fit, int noffset, fit_read_func read,
+			       void *priv, ulong size, ulong *loaded)
+{
+	ulong offset, ext_size;
+	int data_offset, data_size;
+
+	if (noffset < 0)
+		return 0;
+
+	if (fdt_getprop(fit, noffset, FIT_DATA_PROP, NULL) ||
+	    fit_image_get_data_offset(fit, noffset, &data_offset))
+		return 0;
+
+	if (fit_image_get_data_size(fit, noffset, &data_size)) {
+		printf("No data size for '%s' image\n",
+		       fit_get_name(fit, noffset, NULL));
+		return -1;
+	}
+
+	offset = fit_get_ext_data(fit);
+	ext_size = offset < size ? size - offset : 0;
+	if (data_offset < 0 || data_size < 0 || data_offset > ext_size ||
+	    data_size > ext_size - data_offset) {
+		printf("Bad data offset/size for '%s' image\n",
+		       fit_get_name(fit, noffset, NULL));
+		return -1;
+	}
+
+	offset += data_offset;
+	debug("Loading '%s' data: %d bytes at offset %lx\n",
+	      fit_get_name(fit, noffset, NULL), data_size, offset);
+	if (read(priv, fit + offset, offset, data_size))
+		return -1;
+	*loaded += data_size;
+
+	return 0;
+}
+
+#ifdef CONFIG_FIT_BEST_MATCH
+/*
+ * fit_conf_find_compat() looks into the fdt of every configuration, so they
+ * all have to be loaded before the best one can be picked.
+ */
+static int fit_load_conf_fdts(void *fit, fit_read_func read, void *priv,
+			      ulong size, ulong *loaded)
+{
+	int ndepth = 0;
+	int noffset, confs_noffset;
+
+	confs_noffset = fdt_path_offset(fit, FIT_CONFS_PATH);
+	if (confs_noffset < 0)
+		return 0;
+
+	for (noffset = fdt_next_node(fit, confs_noffset, &ndepth);
+			(noffset >= 0) && (ndepth > 0);
+			noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth > 1)
+			continue;
+
+		if (fit_load_image_data(fit,
+					fit_conf_get_fdt_node(fit, noffset),
+					read, priv, size, loaded))
+			return -1;
+	}
+
+	return 0;
+}
+#endif
+
+/**
+ * fit_load_conf - load only the parts of a FIT image a configuration uses
+ * @fit: address to load the FIT image to
+ * @conf_uname: configuration unit name, NULL for the default (or, with
+ *	CONFIG_FIT_BEST_MATCH, the one best matching the U-Boot fdt)
+ * @read: callback reading a byte range of the FIT image from storage
+ * @priv: private data passed to @read
+ * @size: size of the FIT image in storage; nothing is read beyond it
+ * @loaded: will hold the number of bytes read
+ *
+ * fit_load_conf() reads the FIT structure first, selects a configuration
+ * the same way bootm does, and then reads just the data of the kernel,
+ * ramdisk and fdt images that configuration refers to. Image data is only
+ * read separately if it was stored outside the FIT structure (mkimage -E);
+ * every piece lands at the same offset it has in the FIT image, so the
+ * result can be passed to bootm as is.
+ *
+ * returns:
+ *     configuration node offset, on success
+ *     negative number, on failure
+ */
+int fit_load_conf(void *fit, const char *conf_uname, fit_read_func read,
+		  void *priv, ulong size, ulong *loaded)
+{
+	ulong fit_size;
+	int cfg_noffset;
+
+	*loaded = 0;
+	if (size < sizeof(struct fdt_header) ||
+	    read(priv, fit, 0, sizeof(struct fdt_header)))
+		return -1;
+	fit_size = fdt_totalsize(fit);
+	if (fdt_check_header(fit) || fit_size < sizeof(struct fdt_header) ||
+	    fit_size > size) {
+		puts("Bad FIT image format!\n");
+		return -1;
+	}
+
+	if (read(priv, fit + sizeof(struct fdt_header),
+		 sizeof(struct fdt_header),
+		 fit_size - sizeof(struct fdt_header)))
+		return -1;
+	*loaded = fit_size;
+
+	if (!fit_check_format(fit)) {
+		puts("Bad FIT image format!\n");
+		return -1;
+	}
+
+#ifdef CONFIG_FIT_BEST_MATCH
+	if (conf_uname) {
+		cfg_noffset = fit_conf_get_node(fit, conf_uname);
+	} else {
+		if (fit_load_conf_fdts(fit, read, priv, size, loaded))
+			return -1;
+		cfg_noffset = fit_conf_find_compat(fit, gd->fdt_blob);
+	}
+#else
+	cfg_noffset = fit_conf_get_node(fit, conf_uname);
+#endif
+	if (cfg_noffset < 0) {
+		puts("Could not find configuration node\n");
+		return -1;
+	}
+	printf("   Using '%s' configuration\n",
+	       fit_get_name(fit, cfg_noffset, NULL));
+
+	if (fit_load_image_data(fit, fit_conf_get_kernel_node(fit, cfg_noffset),
+				read, priv, size, loaded) ||
+	    fit_load_image_data(fit,
+				fit_conf_get_ramdisk_node(fit, cfg_noffset),
+				read, priv, size, loaded) ||
+	    fit_load_image_data(fit, fit_conf_get_fdt_node(fit, cfg_noffset),
+				read, priv, size, loaded))
+		return -1;
+
+	return cfg_noffset;
+}
 #endif /* USE_HOSTCC */
 #endif /* CONFIG_FIT */
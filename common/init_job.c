@@ -0,0 +1,98 @@
+/*
+ * Init jobs: device initialization that runs in the background
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <init_job.h>
+#include <watchdog.h>
+
+static LIST_HEAD(init_jobs);	/* jobs still busy */
+static int init_job_error;	/* first error from any job */
+
+/* Note that a job is finished, with the given result */
+static void init_job_finish(struct init_job *job, int ret)
+{
+	list_del(&job->link);
+	job->ret = ret;
+#ifdef CONFIG_BOOTSTAGE
+	if (job->id < BOOTSTAGE_ID_COUNT)
+		bootstage_accum(job->id);
+#endif
+	if (ret < 0) {
+		printf("%s: init failed: %d\n", job->name, ret);
+		if (!init_job_error)
+			init_job_error = ret;
+	}
+	debug("%s: %s finished: %d\n", __func__, job->name, ret);
+}
+
+int init_job_add(struct init_job *job)
+{
+	int ret;
+
+#ifdef CONFIG_BOOTSTAGE
+	if (!job->id)
+		job->id = bootstage_alloc_id();
+	if (job->id < BOOTSTAGE_ID_COUNT)
+		bootstage_start(job->id, job->name);
+#endif
+	list_add_tail(&job->link, &init_jobs);
+	job->ret = INIT_JOB_BUSY;
+
+	ret = job->start(job);
+	if (ret != INIT_JOB_BUSY)
+		init_job_finish(job, ret);
+
+	return ret;
+}
+
+int init_job_poll(void)
+{
+	struct init_job *job, *next;
+	int busy = 0;
+	int ret;
+
+	list_for_each_entry_safe(job, next, &init_jobs, link) {
+		ret = job->poll(job);
+		if (ret == INIT_JOB_BUSY)
+			busy++;
+		else
+			init_job_finish(job, ret);
+	}
+
+	return busy;
+}
+
+int init_job_wait(struct init_job *job)
+{
+	if (job) {
+		while (job->ret == INIT_JOB_BUSY) {
+			init_job_poll();
+			WATCHDOG_RESET();
+		}
+		return job->ret;
+	}
+
+	while (init_job_poll())
+		WATCHDOG_RESET();
+
+	return init_job_error;
+}
@@ -52,6 +52,7 @@
 #include <post.h>
 #include <linux/ctype.h>
 #include <menu.h>
+#include <init_job.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -167,6 +168,9 @@ int abortboot(int bootdelay)
 	 * when catch up.
 	 */
 	do {
+#ifdef CONFIG_INIT_JOBS
+		init_job_poll();
+#endif
 		if (tstc()) {
 			if (presskey_len < presskey_max) {
 				presskey [presskey_len ++] = getc();
@@ -263,6 +267,9 @@ int abortboot(int bootdelay)
 # endif
 				break;
 			}
+#ifdef CONFIG_INIT_JOBS
+			init_job_poll();
+#endif
 			udelay(10000);
 		} while (!abort && get_timer(ts) < 1000);
 
@@ -0,0 +1,242 @@
+/*
+ * Sampling profiler
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <linux/ctype.h>
+#include <errno.h>
+#include <malloc.h>
+#include <prof.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifndef CONFIG_PROF_SAMPLES
+#define CONFIG_PROF_SAMPLES	4096
+#endif
+
+static ulong *prof_buf;			/* ring buffer of samples */
+static volatile uint prof_count;	/* samples taken since start */
+static volatile int prof_running;
+static int prof_rate;			/* samples per second */
+
+struct prof_func {
+	ulong addr;		/* start of function, or sample address */
+	const char *name;	/* function name, NULL if unknown */
+	uint count;		/* number of samples in it */
+};
+
+void prof_sample(ulong pc)
+{
+	if (!prof_running)
+		return;
+	prof_buf[prof_count % CONFIG_PROF_SAMPLES] = pc;
+	prof_count++;
+}
+
+static int __prof_timer_start(unsigned int hz)
+{
+	return -ENOSYS;
+}
+
+static void __prof_timer_stop(void)
+{
+}
+
+int prof_timer_start(unsigned int hz)
+	__attribute__((weak, alias("__prof_timer_start")));
+void prof_timer_stop(void)
+	__attribute__((weak, alias("__prof_timer_stop")));
+
+int prof_start(unsigned int hz)
+{
+	int ret;
+
+	if (!prof_buf) {
+		prof_buf = malloc(CONFIG_PROF_SAMPLES * sizeof(*prof_buf));
+		if (!prof_buf)
+			return -ENOMEM;
+	}
+
+	prof_stop();
+	prof_count = 0;
+	prof_running = 1;
+	ret = prof_timer_start(hz);
+	if (ret < 0) {
+		prof_running = 0;
+		return ret;
+	}
+	prof_rate = ret;
+
+	return 0;
+}
+
+void prof_stop(void)
+{
+	if (!prof_running)
+		return;
+	prof_timer_stop();
+	prof_running = 0;
+}
+
+static int prof_compare_addr(const void *a, const void *b)
+{
+	ulong pc1 = *(const ulong *)a, pc2 = *(const ulong *)b;
+
+	return pc1 < pc2 ? -1 : pc1 > pc2;
+}
+
+static int prof_compare_count(const void *a, const void *b)
+{
+	const struct prof_func *f1 = a, *f2 = b;
+
+	if (f1->count != f2->count)
+		return f1->count < f2->count ? 1 : -1;
+
+	return f1->addr < f2->addr ? -1 : f1->addr > f2->addr;
+}
+
+#ifdef CONFIG_KALLSYMS
+/* We need the weak marking as this symbol is provided specially */
+extern const char system_map[] __attribute__((weak));
+
+/*
+ * Parse the address of a system_map[] entry. nm pads it to the width of
+ * a long and the name follows directly, so stop there: names such as
+ * "add_..." would otherwise be taken as more hex digits.
+ */
+static ulong prof_sym_addr(const char *sym, const char **name)
+{
+	ulong addr = 0;
+	int i;
+
+	for (i = 0; i < sizeof(ulong) * 2 && isxdigit(sym[i]); i++)
+		addr = addr << 4 | (isdigit(sym[i]) ? sym[i] - '0' :
+				    tolower(sym[i]) - 'a' + 10);
+	*name = sym + i;
+
+	return addr;
+}
+
+/*
+ * Group samples sorted by address into functions. As system_map[] is
+ * sorted too, this walks it once rather than looking up every sample.
+ */
+static int prof_group(ulong *samples, int count, struct prof_func *funcs)
+{
+	const char *sym = system_map ? system_map : "", *next_sym;
+	const char *name = NULL;
+	ulong addr = 0, next_addr = ~0UL;
+	int nfuncs = 0;
+	int i;
+
+	next_sym = sym;
+	if (*sym)
+		next_addr = prof_sym_addr(sym, &next_sym);
+	for (i = 0; i < count; i++) {
+		while (*sym && next_addr <= samples[i]) {
+			addr = next_addr;
+			name = next_sym;
+			sym = next_sym + strlen(next_sym) + 1;
+			next_addr = *sym ? prof_sym_addr(sym, &next_sym) : ~0UL;
+		}
+		if (!nfuncs || funcs[nfuncs - 1].name != name ||
+		    (!name && funcs[nfuncs - 1].addr != samples[i])) {
+			funcs[nfuncs].addr = name ? addr : samples[i];
+			funcs[nfuncs].name = name;
+			funcs[nfuncs].count = 0;
+			nfuncs++;
+		}
+		funcs[nfuncs - 1].count++;
+	}
+
+	return nfuncs;
+}
+#else
+/* Without a symbol table, group samples by address */
+static int prof_group(ulong *samples, int count, struct prof_func *funcs)
+{
+	int nfuncs = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (!nfuncs || funcs[nfuncs - 1].addr != samples[i]) {
+			funcs[nfuncs].addr = samples[i];
+			funcs[nfuncs].name = NULL;
+			funcs[nfuncs].count = 0;
+			nfuncs++;
+		}
+		funcs[nfuncs - 1].count++;
+	}
+
+	return nfuncs;
+}
+#endif
+
+void prof_report(int max_lines)
+{
+	struct prof_func *funcs;
+	uint taken = prof_count;
+	int count, nfuncs;
+	int i;
+
+	prof_stop();
+	count = min(taken, CONFIG_PROF_SAMPLES);
+	if (!count) {
+		puts("No samples\n");
+		return;
+	}
+	funcs = malloc(count * sizeof(*funcs));
+	if (!funcs) {
+		puts("Out of memory\n");
+		return;
+	}
+
+	/* Samples are recorded as run, symbols are at link addresses */
+	for (i = 0; i < count; i++) {
+		if (prof_buf[i])
+			prof_buf[i] -= gd->reloc_off;
+	}
+	qsort(prof_buf, count, sizeof(*prof_buf), prof_compare_addr);
+	nfuncs = prof_group(prof_buf, count, funcs);
+	qsort(funcs, nfuncs, sizeof(*funcs), prof_compare_count);
+
+	printf("%u samples at %d Hz", taken, prof_rate);
+	if (taken > count)
+		printf(", latest %d kept", count);
+	puts("\n\n Samples      %  Function\n");
+	for (i = 0; i < nfuncs && (!max_lines || i < max_lines); i++) {
+		printf("%8u %3u.%u  ", funcs[i].count,
+		       funcs[i].count * 100 / count,
+		       funcs[i].count * 1000 / count % 10);
+		if (funcs[i].name)
+			printf("%s\n", funcs[i].name);
+		else if (!funcs[i].addr)
+			puts("(outside U-Boot)\n");
+		else
+			printf("%08lx\n", funcs[i].addr);
+	}
+	if (i < nfuncs)
+		printf("(%d more)\n", nfuncs - i);
+
+	/* The samples are reported once */
+	prof_count = 0;
+	free(funcs);
+}
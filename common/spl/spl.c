@@ -172,11 +172,18 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	 */
 	timer_init();
 #endif
+	bootstage_mark_name(BOOTSTAGE_ID_START_SPL, "spl");
 
 #ifdef CONFIG_SPL_BOARD_INIT
 	spl_board_init();
 #endif
 
+#ifdef CONFIG_SPL_CACHE_SUPPORT
+	gd->bd = &bdata;
+	spl_enable_caches();
+#endif
+
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_SPL_LOAD, "spl_load");
 	boot_device = spl_boot_device();
 	debug("boot device - %d\n", boot_device);
 	switch (boot_device) {
@@ -225,6 +232,24 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 		debug("SPL: Un-supported Boot Device\n");
 		hang();
 	}
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_SPL_LOAD, spl_image.size);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_SPL_LOAD);
+
+#ifdef CONFIG_SPL_BOOTSTAGE
+	/* For U-Boot to pick up and report along with its own */
+	bootstage_stash((void *)CONFIG_SPL_BOOTSTAGE_STASH_ADDR,
+			CONFIG_SPL_BOOTSTAGE_STASH_SIZE);
+#endif
+#ifdef CONFIG_SPL_CACHE_SUPPORT
+	/*
+	 * The image starts with the caches off, so write it all back. The
+	 * I-cache may still hold lines from before the image was loaded,
+	 * and a core may hit in it even while disabled, so drop them.
+	 */
+	dcache_disable();
+	icache_disable();
+	invalidate_icache_all();
+#endif
 
 	switch (spl_image.os) {
 	case IH_OS_U_BOOT:
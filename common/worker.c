@@ -0,0 +1,217 @@
+/*
+ * Workers: jobs run on the secondary cores
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <image.h>
+#include <watchdog.h>
+#include <worker.h>
+
+#ifndef CONFIG_WORKER_MAX
+#define CONFIG_WORKER_MAX	3
+#endif
+
+/* Below this, a copy is not worth splitting */
+#define WORKER_COPY_MIN		(64 << 10)
+#define WORKER_COPY_ALIGN	64
+
+/*
+ * Each worker has a mailbox holding the job it is to run, so that the
+ * boot CPU is the only one to fill it and the worker the only one to
+ * empty it, and no lock is needed. The barriers make sure that the job
+ * is seen complete before the pointer to it, and its result before the
+ * change of state.
+ */
+#define worker_barrier()	__sync_synchronize()
+
+struct worker {
+	struct worker_job *volatile job;	/* job to run, NULL if free */
+	volatile int running;
+};
+
+static struct worker workers[CONFIG_WORKER_MAX];
+static int worker_count = -1;		/* -1 until they are started */
+static volatile int worker_stopping;
+
+static int __worker_cpu_start(int nr, void (*entry)(int nr))
+{
+	return -ENOSYS;
+}
+
+static void __worker_cpu_relax(void)
+{
+}
+
+int worker_cpu_start(int nr, void (*entry)(int nr))
+	__attribute__((weak, alias("__worker_cpu_start")));
+void worker_cpu_relax(void)
+	__attribute__((weak, alias("__worker_cpu_relax")));
+
+/* This runs on the secondary core */
+static void worker_loop(int nr)
+{
+	struct worker *w = &workers[nr];
+	struct worker_job *job;
+
+	while (!worker_stopping) {
+		job = w->job;
+		if (!job) {
+			worker_cpu_relax();
+			continue;
+		}
+		worker_barrier();
+		job->ret = job->fn(job);
+		worker_barrier();
+		job->state = WORKER_JOB_DONE;
+		w->job = NULL;
+	}
+	worker_barrier();
+	w->running = 0;
+}
+
+static void worker_start(void)
+{
+	struct worker *w;
+
+	if (worker_count >= 0)
+		return;
+
+	worker_stopping = 0;
+	for (worker_count = 0; worker_count < CONFIG_WORKER_MAX;
+	     worker_count++) {
+		w = &workers[worker_count];
+		w->job = NULL;
+		w->running = 1;
+		worker_barrier();
+		if (worker_cpu_start(worker_count, worker_loop)) {
+			w->running = 0;
+			break;
+		}
+	}
+	debug("%s: %d workers\n", __func__, worker_count);
+}
+
+void worker_submit(struct worker_job *job)
+{
+	int i;
+
+	job->state = WORKER_JOB_BUSY;
+	worker_start();
+	for (i = 0; i < worker_count; i++) {
+		if (!workers[i].job) {
+			worker_barrier();
+			workers[i].job = job;
+			return;
+		}
+	}
+
+	/* Nobody is free: do it ourselves */
+	job->ret = job->fn(job);
+	job->state = WORKER_JOB_DONE;
+}
+
+int worker_wait(struct worker_job *job)
+{
+	while (job->state == WORKER_JOB_BUSY)
+		WATCHDOG_RESET();
+	worker_barrier();
+
+	return job->ret;
+}
+
+void worker_stop(void)
+{
+	int i;
+
+	if (worker_count <= 0)
+		return;
+
+	for (i = 0; i < worker_count; i++) {
+		while (workers[i].job)
+			WATCHDOG_RESET();
+	}
+	worker_stopping = 1;
+	worker_barrier();
+	for (i = 0; i < worker_count; i++) {
+		while (workers[i].running)
+			WATCHDOG_RESET();
+	}
+	debug("%s: %d workers stopped\n", __func__, worker_count);
+	worker_count = -1;
+}
+
+struct worker_copy {
+	struct worker_job job;
+	void *dest;
+	const void *src;
+	size_t len;
+};
+
+static int worker_copy(struct worker_job *job)
+{
+	struct worker_copy *copy = job->priv;
+
+	memcpy(copy->dest, copy->src, copy->len);
+
+	return 0;
+}
+
+void worker_memmove(void *dest, const void *src, size_t len)
+{
+	struct worker_copy copy[CONFIG_WORKER_MAX];
+	size_t chunk;
+	int count, i;
+
+	/* Our own share goes in CHUNKSZ pieces, to keep the watchdog happy */
+	if (len < WORKER_COPY_MIN || ((char *)dest < (char *)src + len &&
+				      (char *)src < (char *)dest + len)) {
+		memmove_wd(dest, (void *)src, len, CHUNKSZ);
+		return;
+	}
+
+	worker_start();
+	for (i = count = 0; i < worker_count; i++) {
+		if (!workers[i].job)
+			count++;
+	}
+	if (!count) {
+		memmove_wd(dest, (void *)src, len, CHUNKSZ);
+		return;
+	}
+	chunk = len / (count + 1) & ~(WORKER_COPY_ALIGN - 1);
+
+	/* Hand out the first parts and copy the last one here */
+	for (i = 0; i < count; i++) {
+		copy[i].job.fn = worker_copy;
+		copy[i].job.priv = &copy[i];
+		copy[i].dest = dest;
+		copy[i].src = src;
+		copy[i].len = chunk;
+		worker_submit(&copy[i].job);
+		dest += chunk;
+		src += chunk;
+		len -= chunk;
+	}
+	memmove_wd(dest, (void *)src, len, CHUNKSZ);
+	for (i = 0; i < count; i++)
+		worker_wait(&copy[i].job);
+}
@@ -238,10 +238,23 @@ void dev_print (block_dev_desc_t *dev_desc)
 }
 #endif
 
+/*
+ * Drivers call init_part() each time they (re)scan a device, e.g. for
+ * 'mmc rescan' or 'usb reset', after which any cached mount may be stale.
+ */
+static ulong part_scans;
+
+ulong part_scan_count(void)
+{
+	return part_scans;
+}
+
 #ifdef HAVE_BLOCK_DEVICE
 
 void init_part (block_dev_desc_t * dev_desc)
 {
+	part_scans++;
+
 #ifdef CONFIG_ISO_PARTITION
 	if (test_part_iso(dev_desc) == 0) {
 		dev_desc->part_type = PART_TYPE_ISO;
@@ -31,6 +31,7 @@
 #include <malloc.h>
 #include <linux/list.h>
 #include <div64.h>
+#include <init_job.h>
 
 /* Set block count limit because of 16 bit register limit on some hardware*/
 #ifndef CONFIG_SYS_MMC_MAX_BLK_COUNT
@@ -243,6 +244,10 @@ mmc_berase(int dev_num, unsigned long start, lbaint_t blkcnt)
 	if (!mmc)
 		return -1;
 
+	/* The card is brought up on first use */
+	if (!mmc->has_init && mmc_init(mmc))
+		return -1;
+
 	if ((start % mmc->erase_grp_size) || (blkcnt % mmc->erase_grp_size))
 		printf("\n\nCaution! Your devices Erase group is 0x%x\n"
 			"The erase range would be change to 0x%lx~0x%lx\n\n",
@@ -331,6 +336,9 @@ mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 	if (!mmc)
 		return 0;
 
+	if (!mmc->has_init && mmc_init(mmc))
+		return 0;
+
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
@@ -396,6 +404,9 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 	if (!mmc)
 		return 0;
 
+	if (!mmc->has_init && mmc_init(mmc))
+		return 0;
+
 	if ((start + blkcnt) > mmc->block_dev.lba) {
 		printf("MMC: block number 0x%lx exceeds max(0x%lx)\n",
 			start + blkcnt, mmc->block_dev.lba);
@@ -405,16 +416,20 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
 		return 0;
 
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_MMC_READ, "mmc_read");
 	do {
 		cur = (blocks_todo > mmc->b_max) ?  mmc->b_max : blocks_todo;
 		if(mmc_read_blocks(mmc, dst, start, cur) != cur)
-			return 0;
+			break;
 		blocks_todo -= cur;
 		start += cur;
 		dst += cur * mmc->read_bl_len;
 	} while (blocks_todo > 0);
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_MMC_READ,
+			    (blkcnt - blocks_todo) * mmc->read_bl_len);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_MMC_READ);
 
-	return blkcnt;
+	return blocks_todo ? 0 : blkcnt;
 }
 
 static int mmc_go_idle(struct mmc *mmc)
@@ -438,113 +453,110 @@ static int mmc_go_idle(struct mmc *mmc)
 	return 0;
 }
 
-static int sd_send_op_cond(struct mmc *mmc)
+/* How long cards may take to power up, in ms */
+#define SD_OP_COND_TIMEOUT	1000
+#define MMC_OP_COND_TIMEOUT	10000
+
+/*
+ * Ask an SD card for its operating condition once.  The card is still
+ * powering up as long as mmc->ocr does not have OCR_BUSY set.
+ */
+static int sd_send_op_cond_once(struct mmc *mmc)
 {
-	int timeout = 1000;
 	int err;
 	struct mmc_cmd cmd;
 
-	do {
-		cmd.cmdidx = MMC_CMD_APP_CMD;
-		cmd.resp_type = MMC_RSP_R1;
-		cmd.cmdarg = 0;
-
-		err = mmc_send_cmd(mmc, &cmd, NULL);
-
-		if (err)
-			return err;
-
-		cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
-		cmd.resp_type = MMC_RSP_R3;
-
-		/*
-		 * Most cards do not answer if some reserved bits
-		 * in the ocr are set. However, Some controller
-		 * can set bit 7 (reserved for low voltages), but
-		 * how to manage low voltages SD card is not yet
-		 * specified.
-		 */
-		cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
-			(mmc->voltages & 0xff8000);
-
-		if (mmc->version == SD_VERSION_2)
-			cmd.cmdarg |= OCR_HCS;
-
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	cmd.cmdidx = MMC_CMD_APP_CMD;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
 
-		if (err)
-			return err;
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		udelay(1000);
-	} while ((!(cmd.response[0] & OCR_BUSY)) && timeout--);
+	if (err)
+		return err;
 
-	if (timeout <= 0)
-		return UNUSABLE_ERR;
+	cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
 
-	if (mmc->version != SD_VERSION_2)
-		mmc->version = SD_VERSION_1_0;
+	/*
+	 * Most cards do not answer if some reserved bits
+	 * in the ocr are set. However, Some controller
+	 * can set bit 7 (reserved for low voltages), but
+	 * how to manage low voltages SD card is not yet
+	 * specified.
+	 */
+	cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
+		(mmc->voltages & 0xff8000);
 
-	if (mmc_host_is_spi(mmc)) { /* read OCR for spi */
-		cmd.cmdidx = MMC_CMD_SPI_READ_OCR;
-		cmd.resp_type = MMC_RSP_R3;
-		cmd.cmdarg = 0;
+	if (mmc->version == SD_VERSION_2)
+		cmd.cmdarg |= OCR_HCS;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		if (err)
-			return err;
-	}
+	if (err)
+		return err;
 
 	mmc->ocr = cmd.response[0];
 
-	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
-	mmc->rca = 0;
-
 	return 0;
 }
 
-static int mmc_send_op_cond(struct mmc *mmc)
+/* Reset an MMC card and ask it for its capabilities */
+static int mmc_start_op_cond(struct mmc *mmc)
 {
-	int timeout = 10000;
 	struct mmc_cmd cmd;
 	int err;
 
 	/* Some cards seem to need this */
 	mmc_go_idle(mmc);
 
- 	/* Asking to the card its capabilities */
- 	cmd.cmdidx = MMC_CMD_SEND_OP_COND;
- 	cmd.resp_type = MMC_RSP_R3;
- 	cmd.cmdarg = 0;
+	/* Asking to the card its capabilities */
+	cmd.cmdidx = MMC_CMD_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
+	cmd.cmdarg = 0;
 
- 	err = mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
- 	if (err)
- 		return err;
+	if (err)
+		return err;
 
- 	udelay(1000);
+	mmc->ocr = cmd.response[0];
+	udelay(1000);
 
-	do {
-		cmd.cmdidx = MMC_CMD_SEND_OP_COND;
-		cmd.resp_type = MMC_RSP_R3;
-		cmd.cmdarg = (mmc_host_is_spi(mmc) ? 0 :
-				(mmc->voltages &
-				(cmd.response[0] & OCR_VOLTAGE_MASK)) |
-				(cmd.response[0] & OCR_ACCESS_MODE));
+	return 0;
+}
 
-		if (mmc->host_caps & MMC_MODE_HC)
-			cmd.cmdarg |= OCR_HCS;
+/* Ask an MMC card for its operating condition once, as above */
+static int mmc_send_op_cond_once(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	cmd.cmdidx = MMC_CMD_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
+	cmd.cmdarg = (mmc_host_is_spi(mmc) ? 0 :
+			(mmc->voltages &
+			(mmc->ocr & OCR_VOLTAGE_MASK)) |
+			(mmc->ocr & OCR_ACCESS_MODE));
 
-		if (err)
-			return err;
+	if (mmc->host_caps & MMC_MODE_HC)
+		cmd.cmdarg |= OCR_HCS;
 
-		udelay(1000);
-	} while (!(cmd.response[0] & OCR_BUSY) && timeout--);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-	if (timeout <= 0)
-		return UNUSABLE_ERR;
+	if (err)
+		return err;
+
+	mmc->ocr = cmd.response[0];
+
+	return 0;
+}
+
+/* The card has powered up: take note of the conditions it agreed to */
+static int mmc_op_cond_ready(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
 
 	if (mmc_host_is_spi(mmc)) { /* read OCR for spi */
 		cmd.cmdidx = MMC_CMD_SPI_READ_OCR;
@@ -555,10 +567,14 @@ static int mmc_send_op_cond(struct mmc *mmc)
 
 		if (err)
 			return err;
+
+		mmc->ocr = cmd.response[0];
 	}
 
-	mmc->version = MMC_VERSION_UNKNOWN;
-	mmc->ocr = cmd.response[0];
+	if (!mmc->op_cond_sd)
+		mmc->version = MMC_VERSION_UNKNOWN;
+	else if (mmc->version != SD_VERSION_2)
+		mmc->version = SD_VERSION_1_0;
 
 	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
 	mmc->rca = 0;
@@ -566,7 +582,6 @@ static int mmc_send_op_cond(struct mmc *mmc)
 	return 0;
 }
 
-
 static int mmc_send_ext_csd(struct mmc *mmc, u8 *ext_csd)
 {
 	struct mmc_cmd cmd;
@@ -1208,6 +1223,7 @@ int mmc_register(struct mmc *mmc)
 	mmc->block_dev.block_erase = mmc_berase;
 	if (!mmc->b_max)
 		mmc->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
+	mmc->init_in_progress = 0;
 
 	INIT_LIST_HEAD (&mmc->link);
 
@@ -1227,7 +1243,7 @@ block_dev_desc_t *mmc_get_dev(int dev)
 }
 #endif
 
-int mmc_init(struct mmc *mmc)
+int mmc_start_init(struct mmc *mmc)
 {
 	int err;
 
@@ -1261,19 +1277,68 @@ int mmc_init(struct mmc *mmc)
 	err = mmc_send_if_cond(mmc);
 
 	/* Now try to get the SD card's operating condition */
-	err = sd_send_op_cond(mmc);
+	mmc->op_cond_sd = 1;
+	err = sd_send_op_cond_once(mmc);
 
 	/* If the command timed out, we check for an MMC card */
 	if (err == TIMEOUT) {
-		err = mmc_send_op_cond(mmc);
+		mmc->op_cond_sd = 0;
+		err = mmc_start_op_cond(mmc);
+		if (!err)
+			err = mmc_send_op_cond_once(mmc);
 
 		if (err) {
 			printf("Card did not respond to voltage select!\n");
 			return UNUSABLE_ERR;
 		}
+	} else if (err) {
+		/* Only a timeout means it is not SD; try the card anyway */
+		err = mmc_startup(mmc);
+		mmc->has_init = !err;
+		return err;
+	}
+
+	mmc->op_cond_start = get_timer(0);
+	mmc->init_in_progress = 1;
+
+	return 0;
+}
+
+int mmc_poll_init(struct mmc *mmc)
+{
+	ulong timeout = mmc->op_cond_sd ? SD_OP_COND_TIMEOUT :
+		MMC_OP_COND_TIMEOUT;
+	int err = 0;
+
+	if (!mmc->init_in_progress)
+		return mmc->has_init ? 0 : UNUSABLE_ERR;
+
+	/* Still powering up? */
+	if (!(mmc->ocr & OCR_BUSY)) {
+		if (mmc->op_cond_sd)
+			err = sd_send_op_cond_once(mmc);
+		else
+			err = mmc_send_op_cond_once(mmc);
+
+		if (!err && !(mmc->ocr & OCR_BUSY)) {
+			if (get_timer(mmc->op_cond_start) < timeout)
+				return IN_PROGRESS;
+			err = UNUSABLE_ERR;
+		}
+
+		if (err && !mmc->op_cond_sd) {
+			printf("Card did not respond to voltage select!\n");
+			err = UNUSABLE_ERR;
+		}
 	}
 
-	err = mmc_startup(mmc);
+	if (!err)
+		err = mmc_op_cond_ready(mmc);
+	/* As in mmc_start_init(), an SD card is tried whatever the error */
+	if (!err || mmc->op_cond_sd)
+		err = mmc_startup(mmc);
+
+	mmc->init_in_progress = 0;
 	if (err)
 		mmc->has_init = 0;
 	else
@@ -1281,6 +1346,67 @@ int mmc_init(struct mmc *mmc)
 	return err;
 }
 
+int mmc_init(struct mmc *mmc)
+{
+	int err;
+
+	if (!mmc->init_in_progress) {
+		err = mmc_start_init(mmc);
+		if (err || !mmc->init_in_progress)
+			return err;
+	}
+
+	while ((err = mmc_poll_init(mmc)) == IN_PROGRESS)
+		udelay(1000);
+
+	return err;
+}
+
+#ifdef CONFIG_MMC_INIT_JOB
+static ulong mmc_job_time;
+
+/* Ask the cards that are still powering up again, once per millisecond */
+static int mmc_job_poll(struct init_job *job)
+{
+	struct mmc *m;
+	int busy = 0;
+
+	if (get_timer(mmc_job_time) < 1)
+		return INIT_JOB_BUSY;
+	mmc_job_time = get_timer(0);
+
+	list_for_each_entry(m, &mmc_devices, link) {
+		if (m->init_in_progress && mmc_poll_init(m) == IN_PROGRESS)
+			busy = 1;
+	}
+
+	return busy ? INIT_JOB_BUSY : INIT_JOB_DONE;
+}
+
+/*
+ * Start initializing all cards.  A card which fails is left alone; the
+ * error shows again when it is used.
+ */
+static int mmc_job_start(struct init_job *job)
+{
+	struct mmc *m;
+
+	list_for_each_entry(m, &mmc_devices, link) {
+		if (mmc_getcd(m))
+			mmc_start_init(m);
+	}
+	mmc_job_time = get_timer(0);
+
+	return INIT_JOB_BUSY;
+}
+
+static struct init_job mmc_job = {
+	.name	= "mmc_init",
+	.start	= mmc_job_start,
+	.poll	= mmc_job_poll,
+};
+#endif
+
 /*
  * CPU and board-specific MMC initializations.  Aliased function
  * signals caller to move on
@@ -1325,5 +1451,13 @@ int mmc_initialize(bd_t *bis)
 
 	print_mmc_devices(',');
 
+#if defined(CONFIG_MMC_INIT_JOB) && defined(CONFIG_LAZY_INIT)
+	/* The cards are brought up on first use unless asked otherwise */
+	if (getenv_yesno("eagerinit") == 1)
+		init_job_add(&mmc_job);
+#elif defined(CONFIG_MMC_INIT_JOB)
+	init_job_add(&mmc_job);
+#endif
+
 	return 0;
 }
@@ -72,6 +72,11 @@ static uint flash_verbose = 1;
 
 flash_info_t flash_info[CFI_MAX_FLASH_BANKS];	/* FLASH chips info */
 
+#if defined(CONFIG_SYS_FLASH_PIPELINE) && \
+	!defined(CONFIG_SYS_FLASH_USE_BUFFER_WRITE)
+#error "CONFIG_SYS_FLASH_PIPELINE needs CONFIG_SYS_FLASH_USE_BUFFER_WRITE"
+#endif
+
 /*
  * Check if chip width is defined. If not, start detecting with 8bit.
  */
@@ -557,6 +562,18 @@ static int flash_is_busy (flash_info_t * info, flash_sect_t sect)
 	return retval;
 }
 
+/* Convert a timeout in ms to get_timer() ticks */
+static ulong flash_tout_ticks(ulong tout)
+{
+#if CONFIG_SYS_HZ != 1000
+	if ((ulong)CONFIG_SYS_HZ > 100000)
+		tout *= (ulong)CONFIG_SYS_HZ / 1000;  /* for a big HZ, avoid overflow */
+	else
+		tout = DIV_ROUND_UP(tout * (ulong)CONFIG_SYS_HZ, 1000);
+#endif
+	return tout;
+}
+
 /*-----------------------------------------------------------------------
  *  wait for XSR.7 to be set. Time out with an error if it does not.
  *  This routine does not set the flash to read-array mode.
@@ -566,12 +583,7 @@ static int flash_status_check (flash_info_t * info, flash_sect_t sector,
 {
 	ulong start;
 
-#if CONFIG_SYS_HZ != 1000
-	if ((ulong)CONFIG_SYS_HZ > 100000)
-		tout *= (ulong)CONFIG_SYS_HZ / 1000;  /* for a big HZ, avoid overflow */
-	else
-		tout = DIV_ROUND_UP(tout * (ulong)CONFIG_SYS_HZ, 1000);
-#endif
+	tout = flash_tout_ticks(tout);
 
 	/* Wait for command completion */
 #ifdef CONFIG_SYS_LOW_RES_TIMER
@@ -651,19 +663,33 @@ static int use_flash_status_poll(flash_info_t *info)
 	return 0;
 }
 
+#if defined(CONFIG_SYS_CFI_FLASH_STATUS_POLL) || \
+	defined(CONFIG_SYS_FLASH_PIPELINE)
+/* Data polling: the operation is done once dst reads back as src */
+static int flash_poll_ready(flash_info_t *info, void *src, void *dst)
+{
+	switch (info->portwidth) {
+	case FLASH_CFI_8BIT:
+		return flash_read8(dst) == flash_read8(src);
+	case FLASH_CFI_16BIT:
+		return flash_read16(dst) == flash_read16(src);
+	case FLASH_CFI_32BIT:
+		return flash_read32(dst) == flash_read32(src);
+	case FLASH_CFI_64BIT:
+		return flash_read64(dst) == flash_read64(src);
+	default:
+		return 0;
+	}
+}
+#endif
+
 static int flash_status_poll(flash_info_t *info, void *src, void *dst,
 			     ulong tout, char *prompt)
 {
 #ifdef CONFIG_SYS_CFI_FLASH_STATUS_POLL
 	ulong start;
-	int ready;
 
-#if CONFIG_SYS_HZ != 1000
-	if ((ulong)CONFIG_SYS_HZ > 100000)
-		tout *= (ulong)CONFIG_SYS_HZ / 1000;  /* for a big HZ, avoid overflow */
-	else
-		tout = DIV_ROUND_UP(tout * (ulong)CONFIG_SYS_HZ, 1000);
-#endif
+	tout = flash_tout_ticks(tout);
 
 	/* Wait for command completion */
 #ifdef CONFIG_SYS_LOW_RES_TIMER
@@ -672,24 +698,7 @@ static int flash_status_poll(flash_info_t *info, void *src, void *dst,
 	start = get_timer(0);
 	WATCHDOG_RESET();
 	while (1) {
-		switch (info->portwidth) {
-		case FLASH_CFI_8BIT:
-			ready = flash_read8(dst) == flash_read8(src);
-			break;
-		case FLASH_CFI_16BIT:
-			ready = flash_read16(dst) == flash_read16(src);
-			break;
-		case FLASH_CFI_32BIT:
-			ready = flash_read32(dst) == flash_read32(src);
-			break;
-		case FLASH_CFI_64BIT:
-			ready = flash_read64(dst) == flash_read64(src);
-			break;
-		default:
-			ready = 0;
-			break;
-		}
-		if (ready)
+		if (flash_poll_ready(info, src, dst))
 			break;
 		if (get_timer(start) > tout) {
 			printf("Flash %s timeout at address %lx data %lx\n",
@@ -864,8 +873,12 @@ static int flash_write_cfiword (flash_info_t * info, ulong dest,
 
 #ifdef CONFIG_SYS_FLASH_USE_BUFFER_WRITE
 
-static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
-				  int len)
+/*
+ * Load the write buffer and start programming it. The caller must wait
+ * with flash_write_cfibuffer_wait() when this returns ERR_OK.
+ */
+static int flash_write_cfibuffer_start(flash_info_t *info, ulong dest,
+				       uchar *cp, int len, flash_sect_t *psect)
 {
 	flash_sect_t sector;
 	int cnt;
@@ -929,6 +942,7 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 
 	src = cp;
 	sector = find_sector (info, dest);
+	*psect = sector;
 
 	switch (info->vendor) {
 	case CFI_CMDSET_INTEL_PROG_REGIONS:
@@ -972,9 +986,6 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 			}
 			flash_write_cmd (info, sector, 0,
 					 FLASH_CMD_WRITE_BUFFER_CONFIRM);
-			retcode = flash_full_status_check (
-				info, sector, info->buffer_write_tout,
-				"buffer write");
 		}
 
 		break;
@@ -1021,15 +1032,7 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 		}
 
 		flash_write_cmd (info, sector, 0, AMD_CMD_WRITE_BUFFER_CONFIRM);
-		if (use_flash_status_poll(info))
-			retcode = flash_status_poll(info, src - (1 << shift),
-						    dst - (1 << shift),
-						    info->buffer_write_tout,
-						    "buffer write");
-		else
-			retcode = flash_full_status_check(info, sector,
-							  info->buffer_write_tout,
-							  "buffer write");
+		retcode = ERR_OK;
 		break;
 
 	default:
@@ -1041,9 +1044,169 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 out_unmap:
 	return retcode;
 }
+
+/* Offset of the last port-width word of a buffer write, for data polling */
+static inline uint flash_cfibuffer_last(flash_info_t *info, int len)
+{
+	return (len & ~(info->portwidth - 1)) - info->portwidth;
+}
+
+/*
+ * Wait for a buffer started by flash_write_cfibuffer_start() to be
+ * programmed.
+ */
+static int flash_write_cfibuffer_wait(flash_info_t *info, ulong dest,
+				      uchar *cp, int len, flash_sect_t sector)
+{
+	uint last = flash_cfibuffer_last(info, len);
+	uint offset = (dest - info->start[sector] + last) / info->portwidth;
+	void *dst;
+	int retcode;
+
+	if (use_flash_status_poll(info)) {
+		dst = flash_map(info, sector, offset);
+		retcode = flash_status_poll(info, cp + last, dst,
+					    info->buffer_write_tout,
+					    "buffer write");
+		flash_unmap(info, sector, offset, dst);
+		return retcode;
+	}
+	return flash_full_status_check(info, sector, info->buffer_write_tout,
+				       "buffer write");
+}
+
+static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
+				  int len)
+{
+	flash_sect_t sector;
+	int retcode;
+
+	retcode = flash_write_cfibuffer_start(info, dest, cp, len, &sector);
+	if (retcode == ERR_OK)
+		retcode = flash_write_cfibuffer_wait(info, dest, cp, len,
+						     sector);
+	return retcode;
+}
+
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+/* Check without waiting whether a buffer is still being programmed */
+static int flash_write_cfibuffer_busy(flash_info_t *info, ulong dest,
+				      uchar *cp, int len, flash_sect_t sector)
+{
+	uint last = flash_cfibuffer_last(info, len);
+	uint offset = (dest - info->start[sector] + last) / info->portwidth;
+	void *dst;
+	int busy;
+
+	if (use_flash_status_poll(info)) {
+		dst = flash_map(info, sector, offset);
+		busy = !flash_poll_ready(info, cp + last, dst);
+		flash_unmap(info, sector, offset, dst);
+		return busy;
+	}
+	return flash_is_busy(info, sector);
+}
+#endif
 #endif /* CONFIG_SYS_FLASH_USE_BUFFER_WRITE */
 
 
+#if defined(CONFIG_SYS_FLASH_EMPTY_INFO) || \
+	defined(CONFIG_SYS_FLASH_CHECK_BLANK_BEFORE_ERASE)
+static int sector_erased(flash_info_t *info, int i)
+{
+	int k;
+	int size;
+	u32 *flash;
+
+	/*
+	 * Check if whole sector is erased
+	 */
+	size = flash_sector_size(info, i);
+	flash = (u32 *)info->start[i];
+	/* divide by 4 for longword access */
+	size = size >> 2;
+
+	for (k = 0; k < size; k++) {
+		if (flash_read32(flash++) != 0xffffffff)
+			return 0;	/* not erased */
+	}
+
+	return 1;			/* erased */
+}
+#endif
+
+/* Issue the erase command for one sector, without waiting for it */
+static void flash_erase_start(flash_info_t *info, flash_sect_t sect)
+{
+	switch (info->vendor) {
+	case CFI_CMDSET_INTEL_PROG_REGIONS:
+	case CFI_CMDSET_INTEL_STANDARD:
+	case CFI_CMDSET_INTEL_EXTENDED:
+		flash_write_cmd (info, sect, 0, FLASH_CMD_CLEAR_STATUS);
+		flash_write_cmd (info, sect, 0, FLASH_CMD_BLOCK_ERASE);
+		flash_write_cmd (info, sect, 0, FLASH_CMD_ERASE_CONFIRM);
+		break;
+	case CFI_CMDSET_AMD_STANDARD:
+	case CFI_CMDSET_AMD_EXTENDED:
+		flash_unlock_seq (info, sect);
+		flash_write_cmd (info, sect, info->addr_unlock1,
+				 AMD_CMD_ERASE_START);
+		flash_unlock_seq (info, sect);
+		flash_write_cmd (info, sect, 0, info->cmd_erase_sector);
+		break;
+#ifdef CONFIG_FLASH_CFI_LEGACY
+	case CFI_CMDSET_AMD_LEGACY:
+		flash_unlock_seq (info, 0);
+		flash_write_cmd (info, 0, info->addr_unlock1,
+				 AMD_CMD_ERASE_START);
+		flash_unlock_seq (info, 0);
+		flash_write_cmd (info, sect, 0, AMD_CMD_ERASE_SECTOR);
+		break;
+#endif
+	default:
+		debug ("Unkown flash vendor %d\n", info->vendor);
+		break;
+	}
+}
+
+/* Wait for an erase started by flash_erase_start() to complete */
+static int flash_erase_wait(flash_info_t *info, flash_sect_t sect)
+{
+	int st;
+
+	if (use_flash_status_poll(info)) {
+		cfiword_t cword;
+		void *dest;
+		cword.ll = 0xffffffffffffffffULL;
+		dest = flash_map(info, sect, 0);
+		st = flash_status_poll(info, &cword, dest,
+				       info->erase_blk_tout, "erase");
+		flash_unmap(info, sect, 0, dest);
+	} else
+		st = flash_full_status_check(info, sect,
+					     info->erase_blk_tout, "erase");
+	return st;
+}
+
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+/* Check without waiting whether a sector is still being erased */
+static int flash_erase_busy(flash_info_t *info, flash_sect_t sect)
+{
+	if (use_flash_status_poll(info)) {
+		cfiword_t cword;
+		void *dest;
+		int ready;
+
+		cword.ll = 0xffffffffffffffffULL;
+		dest = flash_map(info, sect, 0);
+		ready = flash_poll_ready(info, &cword, dest);
+		flash_unmap(info, sect, 0, dest);
+		return !ready;
+	}
+	return flash_is_busy(info, sect);
+}
+#endif
+
 /*-----------------------------------------------------------------------
  */
 int flash_erase (flash_info_t * info, int s_first, int s_last)
@@ -1084,80 +1247,14 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 
 		if (info->protect[sect] == 0) { /* not protected */
 #ifdef CONFIG_SYS_FLASH_CHECK_BLANK_BEFORE_ERASE
-			int k;
-			int size;
-			int erased;
-			u32 *flash;
-
-			/*
-			 * Check if whole sector is erased
-			 */
-			size = flash_sector_size(info, sect);
-			erased = 1;
-			flash = (u32 *)info->start[sect];
-			/* divide by 4 for longword access */
-			size = size >> 2;
-			for (k = 0; k < size; k++) {
-				if (flash_read32(flash++) != 0xffffffff) {
-					erased = 0;
-					break;
-				}
-			}
-			if (erased) {
+			if (sector_erased(info, sect)) {
 				if (flash_verbose)
 					putc(',');
 				continue;
 			}
 #endif
-			switch (info->vendor) {
-			case CFI_CMDSET_INTEL_PROG_REGIONS:
-			case CFI_CMDSET_INTEL_STANDARD:
-			case CFI_CMDSET_INTEL_EXTENDED:
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_CLEAR_STATUS);
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_BLOCK_ERASE);
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_ERASE_CONFIRM);
-				break;
-			case CFI_CMDSET_AMD_STANDARD:
-			case CFI_CMDSET_AMD_EXTENDED:
-				flash_unlock_seq (info, sect);
-				flash_write_cmd (info, sect,
-						info->addr_unlock1,
-						AMD_CMD_ERASE_START);
-				flash_unlock_seq (info, sect);
-				flash_write_cmd (info, sect, 0,
-						 info->cmd_erase_sector);
-				break;
-#ifdef CONFIG_FLASH_CFI_LEGACY
-			case CFI_CMDSET_AMD_LEGACY:
-				flash_unlock_seq (info, 0);
-				flash_write_cmd (info, 0, info->addr_unlock1,
-						AMD_CMD_ERASE_START);
-				flash_unlock_seq (info, 0);
-				flash_write_cmd (info, sect, 0,
-						AMD_CMD_ERASE_SECTOR);
-				break;
-#endif
-			default:
-				debug ("Unkown flash vendor %d\n",
-				       info->vendor);
-				break;
-			}
-
-			if (use_flash_status_poll(info)) {
-				cfiword_t cword;
-				void *dest;
-				cword.ll = 0xffffffffffffffffULL;
-				dest = flash_map(info, sect, 0);
-				st = flash_status_poll(info, &cword, dest,
-						       info->erase_blk_tout, "erase");
-				flash_unmap(info, sect, 0, dest);
-			} else
-				st = flash_full_status_check(info, sect,
-							     info->erase_blk_tout,
-							     "erase");
+			flash_erase_start(info, sect);
+			st = flash_erase_wait(info, sect);
 			if (st)
 				rcode = 1;
 			else if (flash_verbose)
@@ -1171,29 +1268,99 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 	return rcode;
 }
 
-#ifdef CONFIG_SYS_FLASH_EMPTY_INFO
-static int sector_erased(flash_info_t *info, int i)
-{
-	int k;
-	int size;
-	u32 *flash;
-
-	/*
-	 * Check if whole sector is erased
-	 */
-	size = flash_sector_size(info, i);
-	flash = (u32 *)info->start[i];
-	/* divide by 4 for longword access */
-	size = size >> 2;
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+/*-----------------------------------------------------------------------
+ * Erase sectors s_first[i]..s_last[i] of each of the first 'banks' banks,
+ * skipping banks with s_first[i] < 0. A bank erases one sector at a time,
+ * but all the banks are erasing at once. Returns 0 if ok, 1 on error.
+ */
+int flash_erase_banks(int banks, int *s_first, int *s_last)
+{
+	struct {
+		int sect;		/* next sector to erase */
+		int last;
+		int busy;		/* sector being erased, -1 if none */
+		ulong start;		/* get_timer() when it was started */
+	} job[CFI_MAX_FLASH_BANKS];
+	flash_info_t *info;
+	int bank, active, prot = 0;
+	int rcode = 0;
 
-	for (k = 0; k < size; k++) {
-		if (flash_read32(flash++) != 0xffffffff)
-			return 0;	/* not erased */
+	for (bank = 0, info = flash_info; bank < banks; bank++, info++) {
+		job[bank].busy = -1;
+		if (s_first[bank] < 0 || s_first[bank] > s_last[bank]) {
+			/* Nothing to erase in this bank */
+			job[bank].sect = 0;
+			job[bank].last = -1;
+			continue;
+		}
+		job[bank].sect = s_first[bank];
+		job[bank].last = s_last[bank];
+		if (info->flash_id != FLASH_MAN_CFI) {
+			puts ("Can't erase unknown flash type - aborted\n");
+			return 1;
+		}
+		for (active = job[bank].sect; active <= job[bank].last; active++)
+			prot += info->protect[active] != 0;
+	}
+	if (prot) {
+		printf ("- Warning: %d protected sectors will not be erased!\n",
+			prot);
+	} else if (flash_verbose) {
+		putc ('\n');
 	}
 
-	return 1;			/* erased */
+	do {
+		active = 0;
+		for (bank = 0, info = flash_info; bank < banks; bank++, info++) {
+			if (job[bank].busy >= 0) {
+				if (flash_erase_busy(info, job[bank].busy) &&
+				    get_timer(job[bank].start) <=
+				    flash_tout_ticks(info->erase_blk_tout)) {
+					active++;
+					continue;
+				}
+				/* Done, or time to give up and block */
+				if (flash_erase_wait(info, job[bank].busy))
+					rcode = 1;
+				else if (flash_verbose)
+					putc ('.');
+				job[bank].busy = -1;
+			}
+
+			/* Start the next sector, unless stopping */
+			for (; job[bank].sect <= job[bank].last && !rcode;
+			     job[bank].sect++) {
+				if (info->protect[job[bank].sect])
+					continue;
+#ifdef CONFIG_SYS_FLASH_CHECK_BLANK_BEFORE_ERASE
+				if (sector_erased(info, job[bank].sect)) {
+					if (flash_verbose)
+						putc (',');
+					continue;
+				}
+#endif
+				flash_erase_start(info, job[bank].sect);
+				job[bank].busy = job[bank].sect++;
+				job[bank].start = get_timer(0);
+				active++;
+				break;
+			}
+		}
+		if (active && !rcode && ctrlc()) {
+			/* Let the erases in flight finish */
+			putc ('\n');
+			rcode = 1;
+		}
+		udelay(1);		/* also triggers watchdog */
+	} while (active);
+
+	if (flash_verbose && !rcode)
+		puts (" done\n");
+
+	return rcode;
 }
-#endif /* CONFIG_SYS_FLASH_EMPTY_INFO */
+#endif /* CONFIG_SYS_FLASH_PIPELINE */
 
 void flash_print_info (flash_info_t * info)
 {
@@ -1427,6 +1594,158 @@ int write_buff (flash_info_t * info, uchar * src, ulong addr, ulong cnt)
 	return flash_write_cfiword (info, wp, cword);
 }
 
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+/* One bank's share of a pipelined write */
+struct flash_pipe {
+	flash_info_t *info;
+	uchar *src;
+	ulong wp;
+	ulong cnt;		/* bytes left, including the buffer in flight */
+	int len;		/* bytes in the buffer in flight, 0 if none */
+	flash_sect_t sect;
+	ulong start;		/* get_timer() when the buffer was started */
+};
+
+/* Wait for a bank's buffer in flight, if any, and move past it */
+static int flash_pipe_finish(struct flash_pipe *pipe)
+{
+	int rc;
+
+	if (!pipe->len)
+		return ERR_OK;
+	rc = flash_write_cfibuffer_wait(pipe->info, pipe->wp, pipe->src,
+					pipe->len, pipe->sect);
+	pipe->wp += pipe->len;
+	pipe->src += pipe->len;
+	pipe->cnt -= pipe->len;
+	pipe->len = 0;
+
+	return rc;
+}
+
+/*-----------------------------------------------------------------------
+ * Copy memory to flash across the banks info_first..info_last, keeping a
+ * buffer programming on each bank at once, so that chips which sit in
+ * different banks work in parallel. Returns the same as write_buff().
+ */
+int write_buff_banks(flash_info_t *info_first, flash_info_t *info_last,
+		     uchar *src, ulong addr, ulong cnt)
+{
+	struct flash_pipe pipes[CFI_MAX_FLASH_BANKS];
+	struct flash_pipe *pipe, *pipe_end = pipes;
+	flash_info_t *info;
+	int active, i;
+	int rc = ERR_OK;
+#ifdef CONFIG_FLASH_SHOW_PROGRESS
+	int digit = CONFIG_FLASH_SHOW_PROGRESS;
+	int scale = 0;
+	int dots  = 0;
+
+	if (cnt >= CONFIG_FLASH_SHOW_PROGRESS) {
+		scale = (int)((cnt + CONFIG_FLASH_SHOW_PROGRESS - 1) /
+			CONFIG_FLASH_SHOW_PROGRESS);
+	}
+#endif
+
+	/* Share out the data, writing what cannot go through a buffer now */
+	for (info = info_first; info <= info_last && cnt > 0; ++info) {
+		pipe = pipe_end++;
+		pipe->info = info;
+		pipe->src = src;
+		pipe->wp = addr;
+		pipe->cnt = info->start[0] + info->size - addr;
+		if (pipe->cnt > cnt)
+			pipe->cnt = cnt;
+		pipe->len = 0;
+		cnt -= pipe->cnt;
+		addr += pipe->cnt;
+		src += pipe->cnt;
+
+		if (info->buffer_size == 1) {
+			rc = write_buff(info, pipe->src, pipe->wp, pipe->cnt);
+			if (rc != ERR_OK)
+				return rc;
+			pipe->cnt = 0;
+			continue;
+		}
+
+		/* unaligned head and tail bytes */
+		i = pipe->wp & (info->portwidth - 1);
+		if (i) {
+			i = info->portwidth - i;
+			if (i > pipe->cnt)
+				i = pipe->cnt;
+			rc = write_buff(info, pipe->src, pipe->wp, i);
+			if (rc != ERR_OK)
+				return rc;
+			pipe->wp += i;
+			pipe->src += i;
+			pipe->cnt -= i;
+		}
+		i = pipe->cnt & (info->portwidth - 1);
+		if (i) {
+			pipe->cnt -= i;
+			rc = write_buff(info, pipe->src + pipe->cnt,
+					pipe->wp + pipe->cnt, i);
+			if (rc != ERR_OK)
+				return rc;
+		}
+	}
+
+	do {
+		active = 0;
+		for (pipe = pipes; pipe < pipe_end; pipe++) {
+			info = pipe->info;
+			if (pipe->len) {
+				if (flash_write_cfibuffer_busy(info, pipe->wp,
+						pipe->src, pipe->len, pipe->sect) &&
+				    get_timer(pipe->start) <=
+				    flash_tout_ticks(info->buffer_write_tout)) {
+					active++;
+					continue;
+				}
+				/* Done, or time to give up and block */
+				i = pipe->len;
+				rc = flash_pipe_finish(pipe);
+				if (rc != ERR_OK)
+					goto drain;
+				FLASH_SHOW_PROGRESS(scale, dots, digit, i);
+				/* Only check every once in a while */
+				if ((pipe->cnt & 0xFFFF) < i && ctrlc()) {
+					rc = ERR_ABORTED;
+					goto drain;
+				}
+			}
+			if (!pipe->cnt)
+				continue;
+
+			/* load up to the next buffered_size aligned boundary */
+			i = (info->portwidth / info->chipwidth) *
+				info->buffer_size;
+			i -= pipe->wp % i;
+			if (i > pipe->cnt)
+				i = pipe->cnt;
+			rc = flash_write_cfibuffer_start(info, pipe->wp,
+							 pipe->src, i,
+							 &pipe->sect);
+			if (rc != ERR_OK)
+				goto drain;
+			pipe->len = i;
+			pipe->start = get_timer(0);
+			active++;
+		}
+	} while (active);
+
+	return ERR_OK;
+
+drain:
+	/* leave every bank in read mode before giving up */
+	for (pipe = pipes; pipe < pipe_end; pipe++)
+		flash_pipe_finish(pipe);
+	return rc;
+}
+#endif /* CONFIG_SYS_FLASH_PIPELINE */
+
 static inline int manufact_match(flash_info_t *info, u32 manu)
 {
 	return info->manufacturer_id == ((manu & FLASH_VENDMASK) >> 16);
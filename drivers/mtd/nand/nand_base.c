@@ -1188,6 +1188,34 @@ static uint8_t *nand_transfer_oob(struct nand_chip *chip, uint8_t *oob,
 	return NULL;
 }
 
+/**
+ * nand_cache_read_len - [Internal] Number of pages to read in cache mode
+ *
+ * @mtd:	MTD device structure
+ * @chip:	nand chip info structure
+ * @col:	column of the first byte to read
+ * @page:	page number to start at
+ * @readlen:	number of bytes left to read
+ *
+ * Returns the number of whole pages, starting at @page, which can be read
+ * with READ CACHE SEQUENTIAL, or 0 if the pages should be read one by one.
+ * A cache read never goes past the end of the current block.
+ */
+static int nand_cache_read_len(struct mtd_info *mtd, struct nand_chip *chip,
+			       int col, int page, uint32_t readlen)
+{
+	int ppb = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int pages;
+
+	if (!NAND_HAS_CACHEREAD(chip) || col)
+		return 0;
+
+	pages = readlen >> chip->page_shift;
+	pages = min(pages, ppb - (page & (ppb - 1)));
+
+	return pages > 1 ? pages : 0;
+}
+
 /**
  * nand_do_read_ops - [Internal] Read data with ECC
  *
@@ -1205,6 +1233,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	struct mtd_ecc_stats stats;
 	int blkcheck = (1 << (chip->phys_erase_shift - chip->page_shift)) - 1;
 	int sndcmd = 1;
+	int cacherd = 0;
 	int ret = 0;
 	uint32_t readlen = ops->len;
 	uint32_t oobreadlen = ops->ooblen;
@@ -1239,6 +1268,22 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 			if (likely(sndcmd)) {
 				chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
 				sndcmd = 0;
+				cacherd = nand_cache_read_len(mtd, chip, col,
+							      page, readlen);
+				if (cacherd)
+					chip->pagebuf = -1;
+			}
+
+			/*
+			 * In cache mode the page is moved to the cache
+			 * register while the array loads the next one.
+			 */
+			if (cacherd) {
+				chip->cmdfunc(mtd, cacherd > 1 ?
+					      NAND_CMD_READCACHESEQ :
+					      NAND_CMD_READCACHEEND, -1, -1);
+				if (!--cacherd)
+					sndcmd = 1;
 			}
 
 			/* Now read the page into the buffer */
@@ -1317,6 +1362,9 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		 */
 		if (!NAND_CANAUTOINCR(chip) || !(page & blkcheck))
 			sndcmd = 1;
+		/* A cache read in progress has already started this page */
+		if (cacherd)
+			sndcmd = 0;
 	}
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -2849,6 +2897,13 @@ ident_done:
 	if (mtd->writesize > 512 && chip->cmdfunc == nand_command)
 		chip->cmdfunc = nand_command_lp;
 
+#ifdef CONFIG_SYS_NAND_ONFI_DETECTION
+	/* Cache reads are only known to nand_command_lp() */
+	if (chip->onfi_version && chip->cmdfunc == nand_command_lp &&
+	    (le16_to_cpu(chip->onfi_params.opt_cmd) & ONFI_OPT_CMD_CACHE_READ))
+		chip->options |= NAND_CACHERD;
+#endif
+
 	/* TODO onfi flash name */
 	name = type->name;
 #ifdef CONFIG_SYS_NAND_ONFI_DETECTION
@@ -2977,6 +3032,8 @@ int nand_scan_tail(struct mtd_info *mtd)
 
 	switch (chip->ecc.mode) {
 	case NAND_ECC_HW_OOB_FIRST:
+		/* Reading the OOB first breaks up cache reads */
+		chip->options &= ~NAND_CACHERD;
 		/* Similar to NAND_ECC_HW, but a separate read_page handle */
 		if (!chip->ecc.calculate || !chip->ecc.correct ||
 		     !chip->ecc.hwctl) {
@@ -0,0 +1,373 @@
+/*
+ * Simulated NAND flash for sandbox, backed by a host file
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * This models a 128MiB ONFI 1.0 chip with 2KiB pages, 64 bytes of OOB and
+ * 64 pages per block, which supports READ CACHE SEQUENTIAL. The host file
+ * holds each page followed by its OOB; anything past the end of the file
+ * reads as erased.
+ *
+ * Start U-Boot with '--nand <file>' to enable it.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nand.h>
+#include <os.h>
+#include <asm/getopt.h>
+#include <asm/nand.h>
+#include <asm/state.h>
+
+#define SB_NAND_PAGE_SIZE	2048
+#define SB_NAND_OOB_SIZE	64
+#define SB_NAND_RAW_SIZE	(SB_NAND_PAGE_SIZE + SB_NAND_OOB_SIZE)
+#define SB_NAND_PAGES_PER_BLOCK	64
+#define SB_NAND_BLOCKS		1024
+
+/* What read_byte()/read_buf() return */
+enum sb_nand_output {
+	SB_NAND_OUT_NONE,
+	SB_NAND_OUT_ID,
+	SB_NAND_OUT_ONFI_ID,
+	SB_NAND_OUT_PARAM,
+	SB_NAND_OUT_STATUS,
+	SB_NAND_OUT_DATA,
+};
+
+static struct sb_nand {
+	int fd;
+	int cmd;			/* last command latched */
+	int naddr;			/* address cycles since the command */
+	u32 column;
+	u32 row;
+	u32 array_page;			/* page in the data register */
+	enum sb_nand_output out;
+	u32 pos;			/* output position */
+	u8 buf[SB_NAND_RAW_SIZE];	/* data / cache register */
+	struct nand_onfi_params param;
+	struct sandbox_nand_stats stats;
+} sb_nand = {
+	.fd = -1,
+};
+
+static const u8 sb_nand_id[] = { NAND_MFR_MICRON, 0xf1, 0x80, 0x95, 0x40 };
+
+static int sb_cmdline_cb_nand(struct sandbox_state *state, const char *arg)
+{
+	state->nand_file = arg;
+	return 0;
+}
+SB_CMDLINE_OPT_SHORT(nand, 'n', 1, "Back the simulated NAND with a file");
+
+static u16 sb_nand_crc16(u16 crc, u8 const *p, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = (crc << 1) ^ ((crc & 0x8000) ? 0x8005 : 0);
+	}
+
+	return crc;
+}
+
+static void sb_nand_init_param(struct nand_onfi_params *p)
+{
+	memset(p, '\0', sizeof(*p));
+	memcpy(p->sig, "ONFI", 4);
+	p->revision = cpu_to_le16(1 << 1);
+	p->opt_cmd = cpu_to_le16(ONFI_OPT_CMD_CACHE_READ);
+	memcpy(p->manufacturer, "SANDBOX     ", sizeof(p->manufacturer));
+	memcpy(p->model, "SANDBOX NAND        ", sizeof(p->model));
+	p->jedec_id = NAND_MFR_MICRON;
+	p->byte_per_page = cpu_to_le32(SB_NAND_PAGE_SIZE);
+	p->spare_bytes_per_page = cpu_to_le16(SB_NAND_OOB_SIZE);
+	p->pages_per_block = cpu_to_le32(SB_NAND_PAGES_PER_BLOCK);
+	p->blocks_per_lun = cpu_to_le32(SB_NAND_BLOCKS);
+	p->lun_count = 1;
+	p->addr_cycles = 0x22;
+	p->bits_per_cell = 1;
+	p->programs_per_page = 4;
+	p->crc = cpu_to_le16(sb_nand_crc16(ONFI_CRC_BASE, (u8 *)p, 254));
+}
+
+static off_t sb_nand_offset(u32 page)
+{
+	return (off_t)page * SB_NAND_RAW_SIZE;
+}
+
+/* Load a page from the host file into the data register */
+static void sb_nand_load(u32 page)
+{
+	ssize_t len = 0;
+
+	if (page < SB_NAND_BLOCKS * SB_NAND_PAGES_PER_BLOCK &&
+	    os_lseek(sb_nand.fd, sb_nand_offset(page), OS_SEEK_SET) >= 0)
+		len = os_read(sb_nand.fd, sb_nand.buf, SB_NAND_RAW_SIZE);
+	if (len < 0)
+		len = 0;
+	memset(sb_nand.buf + len, 0xff, SB_NAND_RAW_SIZE - len);
+	sb_nand.array_page = page;
+	sb_nand.stats.array_loads++;
+}
+
+static void sb_nand_store(u32 page, const u8 *buf)
+{
+	if (page >= SB_NAND_BLOCKS * SB_NAND_PAGES_PER_BLOCK ||
+	    os_lseek(sb_nand.fd, sb_nand_offset(page), OS_SEEK_SET) < 0 ||
+	    os_write(sb_nand.fd, buf, SB_NAND_RAW_SIZE) != SB_NAND_RAW_SIZE)
+		printf("%s: cannot write page %u\n", __func__, page);
+}
+
+static void sb_nand_program(void)
+{
+	u8 *old;
+	int i;
+
+	/* Programming can only clear bits */
+	old = malloc(SB_NAND_RAW_SIZE);
+	if (!old)
+		return;
+	memcpy(old, sb_nand.buf, SB_NAND_RAW_SIZE);
+	sb_nand_load(sb_nand.row);
+	for (i = 0; i < SB_NAND_RAW_SIZE; i++)
+		old[i] &= sb_nand.buf[i];
+	sb_nand_store(sb_nand.row, old);
+	free(old);
+}
+
+static void sb_nand_erase(void)
+{
+	u32 page = sb_nand.row & ~(SB_NAND_PAGES_PER_BLOCK - 1);
+	int i;
+
+	memset(sb_nand.buf, 0xff, SB_NAND_RAW_SIZE);
+	for (i = 0; i < SB_NAND_PAGES_PER_BLOCK; i++)
+		sb_nand_store(page + i, sb_nand.buf);
+}
+
+static void sb_nand_command(int cmd)
+{
+	switch (cmd) {
+	case NAND_CMD_RESET:
+		sb_nand.out = SB_NAND_OUT_NONE;
+		break;
+	case NAND_CMD_STATUS:
+		sb_nand.out = SB_NAND_OUT_STATUS;
+		break;
+	case NAND_CMD_READSTART:
+		sb_nand_load(sb_nand.row);
+		sb_nand.out = SB_NAND_OUT_DATA;
+		sb_nand.pos = sb_nand.column;
+		break;
+	case NAND_CMD_RNDOUTSTART:
+		sb_nand.pos = sb_nand.column;
+		break;
+	case NAND_CMD_READCACHESEQ:
+		/* Output this page, load the next one behind it */
+		sb_nand_load(sb_nand.array_page);
+		sb_nand.array_page++;
+		sb_nand.out = SB_NAND_OUT_DATA;
+		sb_nand.pos = 0;
+		sb_nand.stats.cache_reads++;
+		break;
+	case NAND_CMD_READCACHEEND:
+		sb_nand_load(sb_nand.array_page);
+		sb_nand.out = SB_NAND_OUT_DATA;
+		sb_nand.pos = 0;
+		sb_nand.stats.cache_reads++;
+		break;
+	case NAND_CMD_SEQIN:
+		memset(sb_nand.buf, 0xff, SB_NAND_RAW_SIZE);
+		sb_nand.out = SB_NAND_OUT_NONE;
+		break;
+	case NAND_CMD_PAGEPROG:
+		sb_nand_program();
+		break;
+	case NAND_CMD_ERASE2:
+		sb_nand_erase();
+		break;
+	}
+	sb_nand.cmd = cmd;
+	sb_nand.naddr = 0;
+
+	/* Commands followed by a new address */
+	switch (cmd) {
+	case NAND_CMD_READ0:
+	case NAND_CMD_SEQIN:
+	case NAND_CMD_ERASE1:
+		sb_nand.row = 0;
+		/* fall through */
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_RNDIN:
+		sb_nand.column = 0;
+		break;
+	}
+}
+
+static void sb_nand_address(u8 addr)
+{
+	int n = sb_nand.naddr++;
+
+	switch (sb_nand.cmd) {
+	case NAND_CMD_READID:
+		sb_nand.out = addr == 0x20 ? SB_NAND_OUT_ONFI_ID :
+			SB_NAND_OUT_ID;
+		sb_nand.pos = 0;
+		return;
+	case NAND_CMD_PARAM:
+		sb_nand.out = SB_NAND_OUT_PARAM;
+		sb_nand.pos = 0;
+		return;
+	case NAND_CMD_ERASE1:
+		/* Erase only takes the row address */
+		n += 2;
+		break;
+	}
+
+	if (n < 2)
+		sb_nand.column |= addr << (8 * n);
+	else
+		sb_nand.row |= addr << (8 * (n - 2));
+	if (sb_nand.cmd == NAND_CMD_SEQIN || sb_nand.cmd == NAND_CMD_RNDIN)
+		sb_nand.pos = sb_nand.column;
+}
+
+static void sb_nand_cmd_ctrl(struct mtd_info *mtd, int dat, unsigned int ctrl)
+{
+	if (dat == NAND_CMD_NONE)
+		return;
+
+	if (ctrl & NAND_CLE)
+		sb_nand_command(dat);
+	else if (ctrl & NAND_ALE)
+		sb_nand_address(dat);
+}
+
+static int sb_nand_dev_ready(struct mtd_info *mtd)
+{
+	return 1;
+}
+
+static uint8_t sb_nand_read_byte(struct mtd_info *mtd)
+{
+	u32 pos = sb_nand.pos++;
+
+	switch (sb_nand.out) {
+	case SB_NAND_OUT_ID:
+		return pos < sizeof(sb_nand_id) ? sb_nand_id[pos] : 0;
+	case SB_NAND_OUT_ONFI_ID:
+		return pos < 4 ? "ONFI"[pos] : 0;
+	case SB_NAND_OUT_PARAM:
+		return ((u8 *)&sb_nand.param)[pos % sizeof(sb_nand.param)];
+	case SB_NAND_OUT_STATUS:
+		sb_nand.pos = 0;
+		return NAND_STATUS_READY | NAND_STATUS_WP;
+	case SB_NAND_OUT_DATA:
+		return pos < SB_NAND_RAW_SIZE ? sb_nand.buf[pos] : 0xff;
+	default:
+		return 0xff;
+	}
+}
+
+static void sb_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	if (sb_nand.out == SB_NAND_OUT_DATA &&
+	    sb_nand.pos + len <= SB_NAND_RAW_SIZE) {
+		memcpy(buf, sb_nand.buf + sb_nand.pos, len);
+		sb_nand.pos += len;
+		return;
+	}
+
+	while (len--)
+		*buf++ = sb_nand_read_byte(mtd);
+}
+
+static u16 sb_nand_read_word(struct mtd_info *mtd)
+{
+	u16 word = sb_nand_read_byte(mtd);
+
+	return word | sb_nand_read_byte(mtd) << 8;
+}
+
+static int sb_nand_verify_buf(struct mtd_info *mtd, const uint8_t *buf,
+			      int len)
+{
+	while (len--) {
+		if (*buf++ != sb_nand_read_byte(mtd))
+			return -EFAULT;
+	}
+
+	return 0;
+}
+
+static void sb_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+			      int len)
+{
+	if (sb_nand.pos + len > SB_NAND_RAW_SIZE)
+		len = SB_NAND_RAW_SIZE - sb_nand.pos;
+	memcpy(sb_nand.buf + sb_nand.pos, buf, len);
+	sb_nand.pos += len;
+}
+
+void sandbox_nand_get_stats(struct sandbox_nand_stats *stats)
+{
+	*stats = sb_nand.stats;
+}
+
+void sandbox_nand_reset_stats(void)
+{
+	memset(&sb_nand.stats, '\0', sizeof(sb_nand.stats));
+}
+
+int board_nand_init(struct nand_chip *nand)
+{
+	struct sandbox_state *state = state_get_current();
+
+	if (!state->nand_file)
+		return -ENODEV;
+
+	if (sb_nand.fd < 0) {
+		sb_nand.fd = os_open(state->nand_file, OS_O_RDWR | OS_O_CREAT);
+		if (sb_nand.fd < 0) {
+			printf("%s: cannot open '%s'\n", __func__,
+			       state->nand_file);
+			return -ENODEV;
+		}
+	}
+	sb_nand_init_param(&sb_nand.param);
+
+	nand->cmd_ctrl = sb_nand_cmd_ctrl;
+	nand->dev_ready = sb_nand_dev_ready;
+	/* The chip is not memory-mapped, so replace every default accessor */
+	nand->read_byte = sb_nand_read_byte;
+	nand->read_word = sb_nand_read_word;
+	nand->read_buf = sb_nand_read_buf;
+	nand->write_buf = sb_nand_write_buf;
+	nand->verify_buf = sb_nand_verify_buf;
+	nand->ecc.mode = NAND_ECC_SOFT;
+	nand->chip_delay = 0;
+
+	return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * Simulated CFI parallel NOR flash for sandbox
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * This models one x8 chip with the Intel command set per flash bank, each
+ * of 16 8KiB blocks with a 32 byte write buffer. The banks are separate
+ * chips, so one can erase or program while another is busy. An erase or
+ * program reads as busy for a few status reads, during which the chip
+ * ignores commands. The contents live in memory and start out erased.
+ *
+ * The banks are at CONFIG_SYS_FLASH_BANKS_LIST, one after the other above
+ * the simulated DRAM. map_physmem() returns the chip memory for them, and
+ * the cfi_flash accessors below decode accesses to it.
+ */
+
+#include <common.h>
+#include <asm/cfi_flash.h>
+#include <asm/io.h>
+#include <mtd/cfi_flash.h>
+
+#define SB_CFI_BANKS		CONFIG_SYS_MAX_FLASH_BANKS
+#define SB_CFI_SECT_SIZE	(8 << 10)
+#define SB_CFI_SECTS		16
+#define SB_CFI_SIZE		(SB_CFI_SECT_SIZE * SB_CFI_SECTS)
+#define SB_CFI_BUF_SIZE		32
+#define SB_CFI_BUSY_READS	4	/* status reads an operation takes */
+
+#define SB_CFI_MANUFACTURER	0x89
+#define SB_CFI_DEVICE		0x18
+
+/* What a read returns */
+enum sb_cfi_mode {
+	SB_CFI_ARRAY,
+	SB_CFI_STATUS,
+	SB_CFI_ID,
+	SB_CFI_QUERY,
+};
+
+/* Where we are in a multi-cycle command */
+enum sb_cfi_phase {
+	SB_CFI_IDLE,
+	SB_CFI_ERASE,			/* erase setup, waiting for confirm */
+	SB_CFI_WORD,			/* word program, waiting for data */
+	SB_CFI_COUNT,			/* buffer program, waiting for count */
+	SB_CFI_BUFFER,			/* waiting for data, then confirm */
+};
+
+static struct sb_cfi {
+	u8 *mem;
+	enum sb_cfi_mode mode;
+	enum sb_cfi_phase phase;
+	u8 status;
+	int busy;			/* status reads until done */
+	int count;			/* buffer bytes still to come */
+	int loaded;			/* buffer bytes received */
+	ulong buf_addr[SB_CFI_BUF_SIZE];
+	u8 buf[SB_CFI_BUF_SIZE];
+} sb_cfi[SB_CFI_BANKS];
+
+/* The banks follow each other, in memory as at CONFIG_SYS_FLASH_BANKS_LIST */
+static u8 sb_cfi_mem[SB_CFI_BANKS][SB_CFI_SIZE];
+static int sb_cfi_ready;
+static struct sandbox_cfi_stats sb_cfi_stats;
+
+static const phys_addr_t sb_cfi_base[] = CONFIG_SYS_FLASH_BANKS_LIST;
+
+/* The CFI query table, from FLASH_OFFSET_CFI_RESP */
+static const u8 sb_cfi_query[] = {
+	'Q', 'R', 'Y',
+	0x01, 0x00,			/* Intel/Sharp extended command set */
+	0x00, 0x00,			/* no extended table */
+	0x00, 0x00,
+	0x00, 0x00,
+	0x27, 0x36, 0x00, 0x00,		/* Vcc, Vpp */
+	4, 7, 6, 0,			/* typical timeouts: 16us 128us 64ms */
+	3, 3, 2, 0,			/* maximum: 8x each, 4x erase */
+	17,				/* 128KiB */
+	FLASH_CFI_X8, 0x00,
+	5, 0,				/* 32 byte write buffer */
+	1,				/* one erase region: */
+	SB_CFI_SECTS - 1, 0x00,		/* 16 blocks */
+	(SB_CFI_SECT_SIZE / 256) & 0xff, (SB_CFI_SECT_SIZE / 256) >> 8,
+};
+
+void *sandbox_cfi_map(phys_addr_t paddr)
+{
+	int bank;
+
+	if (!sb_cfi_ready) {
+		for (bank = 0; bank < SB_CFI_BANKS; bank++)
+			sb_cfi[bank].mem = sb_cfi_mem[bank];
+		memset(sb_cfi_mem, 0xff, sizeof(sb_cfi_mem));
+		sb_cfi_ready = 1;
+	}
+
+	for (bank = 0; bank < SB_CFI_BANKS; bank++) {
+		if (paddr >= sb_cfi_base[bank] &&
+		    paddr < sb_cfi_base[bank] + SB_CFI_SIZE)
+			return sb_cfi[bank].mem + (paddr - sb_cfi_base[bank]);
+	}
+
+	return NULL;
+}
+
+/* Find the chip an address belongs to, and the offset in it */
+static struct sb_cfi *sb_cfi_find(void *addr, ulong *offset)
+{
+	ulong pos = (u8 *)addr - sb_cfi_mem[0];
+
+	if ((u8 *)addr < sb_cfi_mem[0] || pos >= sizeof(sb_cfi_mem))
+		return NULL;
+	*offset = pos % SB_CFI_SIZE;
+
+	return &sb_cfi[pos / SB_CFI_SIZE];
+}
+
+/* Start an erase or program: the chip is busy until read a few times */
+static void sb_cfi_start(struct sb_cfi *chip)
+{
+	int bank;
+
+	for (bank = 0; bank < SB_CFI_BANKS; bank++) {
+		if (&sb_cfi[bank] != chip && sb_cfi[bank].busy)
+			sb_cfi_stats.overlaps++;
+	}
+	chip->mode = SB_CFI_STATUS;
+	chip->busy = SB_CFI_BUSY_READS;
+}
+
+static void sb_cfi_command(struct sb_cfi *chip, u8 value)
+{
+	switch (value) {
+	case FLASH_CMD_RESET:
+	case AMD_CMD_RESET:
+		chip->mode = SB_CFI_ARRAY;
+		break;
+	case FLASH_CMD_READ_ID:
+		chip->mode = SB_CFI_ID;
+		break;
+	case FLASH_CMD_CFI:
+		chip->mode = SB_CFI_QUERY;
+		break;
+	case FLASH_CMD_READ_STATUS:
+		chip->mode = SB_CFI_STATUS;
+		break;
+	case FLASH_CMD_CLEAR_STATUS:
+		chip->status = 0;
+		break;
+	case FLASH_CMD_BLOCK_ERASE:
+		chip->mode = SB_CFI_STATUS;
+		chip->phase = SB_CFI_ERASE;
+		break;
+	case FLASH_CMD_WRITE:
+		chip->mode = SB_CFI_STATUS;
+		chip->phase = SB_CFI_WORD;
+		break;
+	case FLASH_CMD_WRITE_TO_BUFFER:
+		chip->mode = SB_CFI_STATUS;
+		chip->phase = SB_CFI_COUNT;
+		break;
+	}
+}
+
+static void sb_cfi_write(struct sb_cfi *chip, ulong offset, u8 value)
+{
+	int i;
+
+	if (chip->busy)
+		return;
+
+	switch (chip->phase) {
+	case SB_CFI_IDLE:
+		sb_cfi_command(chip, value);
+		return;
+	case SB_CFI_ERASE:
+		if (value == FLASH_CMD_ERASE_CONFIRM) {
+			offset -= offset % SB_CFI_SECT_SIZE;
+			memset(chip->mem + offset, 0xff, SB_CFI_SECT_SIZE);
+			sb_cfi_stats.erases[chip - sb_cfi]++;
+			sb_cfi_start(chip);
+		} else {
+			chip->status |= FLASH_STATUS_ECLBS |
+					FLASH_STATUS_PSLBS;
+		}
+		break;
+	case SB_CFI_WORD:
+		chip->mem[offset] &= value;
+		sb_cfi_start(chip);
+		break;
+	case SB_CFI_COUNT:
+		chip->count = value + 1;
+		chip->loaded = 0;
+		if (chip->count > SB_CFI_BUF_SIZE) {
+			chip->status |= FLASH_STATUS_ECLBS |
+					FLASH_STATUS_PSLBS;
+			break;
+		}
+		chip->phase = SB_CFI_BUFFER;
+		return;
+	case SB_CFI_BUFFER:
+		if (chip->loaded < chip->count) {
+			chip->buf_addr[chip->loaded] = offset;
+			chip->buf[chip->loaded++] = value;
+			return;
+		}
+		if (value != FLASH_CMD_WRITE_BUFFER_CONFIRM) {
+			chip->status |= FLASH_STATUS_ECLBS |
+					FLASH_STATUS_PSLBS;
+			break;
+		}
+		for (i = 0; i < chip->loaded; i++)
+			chip->mem[chip->buf_addr[i]] &= chip->buf[i];
+		sb_cfi_start(chip);
+		break;
+	}
+	chip->phase = SB_CFI_IDLE;
+}
+
+static u8 sb_cfi_read(struct sb_cfi *chip, ulong offset)
+{
+	ulong query = offset - FLASH_OFFSET_CFI_RESP;
+
+	switch (chip->mode) {
+	case SB_CFI_ARRAY:
+		break;
+	case SB_CFI_STATUS:
+		if (chip->busy) {
+			chip->busy--;
+			return chip->status;
+		}
+		return chip->status | FLASH_STATUS_DONE;
+	case SB_CFI_ID:
+		switch (offset % SB_CFI_SECT_SIZE) {
+		case FLASH_OFFSET_MANUFACTURER_ID:
+			return SB_CFI_MANUFACTURER;
+		case FLASH_OFFSET_DEVICE_ID:
+			return SB_CFI_DEVICE;
+		default:
+			return 0;	/* not locked */
+		}
+	case SB_CFI_QUERY:
+		if (query < sizeof(sb_cfi_query))
+			return sb_cfi_query[query];
+		return 0;
+	}
+
+	return chip->mem[offset];
+}
+
+void flash_write8(u8 value, void *addr)
+{
+	struct sb_cfi *chip;
+	ulong offset;
+
+	chip = sb_cfi_find(addr, &offset);
+	if (chip)
+		sb_cfi_write(chip, offset, value);
+	else
+		__raw_writeb(value, addr);
+}
+
+/* The port is 8 bits wide, so split wider accesses into bytes */
+void flash_write16(u16 value, void *addr)
+{
+	flash_write8(value, addr);
+	flash_write8(value >> 8, addr + 1);
+}
+
+void flash_write32(u32 value, void *addr)
+{
+	flash_write16(value, addr);
+	flash_write16(value >> 16, addr + 2);
+}
+
+void flash_write64(u64 value, void *addr)
+{
+	flash_write32(value, addr);
+	flash_write32(value >> 32, addr + 4);
+}
+
+u8 flash_read8(void *addr)
+{
+	struct sb_cfi *chip;
+	ulong offset;
+
+	chip = sb_cfi_find(addr, &offset);
+	if (chip)
+		return sb_cfi_read(chip, offset);
+
+	return __raw_readb(addr);
+}
+
+u16 flash_read16(void *addr)
+{
+	return flash_read8(addr) | flash_read8(addr + 1) << 8;
+}
+
+u32 flash_read32(void *addr)
+{
+	return flash_read16(addr) | flash_read16(addr + 2) << 16;
+}
+
+u64 flash_read64(void *addr)
+{
+	return flash_read32(addr) | (u64)flash_read32(addr + 4) << 32;
+}
+
+void sandbox_cfi_get_stats(struct sandbox_cfi_stats *stats)
+{
+	*stats = sb_cfi_stats;
+}
+
+void sandbox_cfi_reset_stats(void)
+{
+	memset(&sb_cfi_stats, '\0', sizeof(sb_cfi_stats));
+}
@@ -0,0 +1,423 @@
+/*
+ * Simulated SPI flash for sandbox, backed by a host file
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * This models a 32MiB Spansion S25FL256S: 256 byte pages, 64KiB sectors
+ * (4KiB erase works everywhere), dual and quad reads once QE is set in
+ * the configuration register, and both 4-byte opcodes and a 4-byte
+ * address mode. Operations complete at once, so WIP never reads as set.
+ *
+ * Start U-Boot with '--spi_sf <file>' to enable it.
+ */
+
+#include <common.h>
+#include <os.h>
+#include <spi_flash.h>
+#include <asm/getopt.h>
+#include <asm/spi.h>
+#include <asm/state.h>
+
+#include "spi_flash_internal.h"
+
+#define SB_SF_SIZE		(32 << 20)
+#define SB_SF_PAGE_SIZE		256
+
+#define SB_SF_SR_WEL		0x02
+
+#define SB_SF_LINES		(SPI_XFER_DUAL | SPI_XFER_QUAD)
+
+/* Where we are in the current command */
+enum sb_sf_phase {
+	SB_SF_PHASE_NONE,		/* ignore the rest */
+	SB_SF_PHASE_CMD,
+	SB_SF_PHASE_ADDR,
+	SB_SF_PHASE_DUMMY,
+	SB_SF_PHASE_DATA,
+};
+
+static struct sb_sf {
+	int fd;
+	enum sb_sf_phase phase;
+	u8 cmd;
+	u32 addr;
+	int addr_len;
+	int addr_bytes;			/* address bytes received */
+	int dummy;			/* dummy bytes still to come */
+	unsigned long addr_lines;	/* SPI_XFER_* for address/dummy */
+	unsigned long data_lines;	/* SPI_XFER_* for data */
+	u32 pos;			/* data bytes so far */
+	u8 sr;
+	u8 cr;
+	int addr4;			/* in 4-byte address mode */
+	u8 buf[SB_SF_PAGE_SIZE];	/* page program / WRSR data */
+	struct sandbox_sf_stats stats;
+} sb_sf = {
+	.fd = -1,
+};
+
+/* Spansion S25FL256S, 64KiB sectors */
+static const u8 sb_sf_id[] = { 0x01, 0x02, 0x19, 0x4d, 0x01 };
+
+static int sb_cmdline_cb_spi_sf(struct sandbox_state *state, const char *arg)
+{
+	state->spi_sf_file = arg;
+	return 0;
+}
+SB_CMDLINE_OPT(spi_sf, 1, "Back the simulated SPI flash with a file");
+
+static void sb_sf_fill(u32 addr, u32 len)
+{
+	u8 erased[4096];
+	u32 chunk;
+
+	memset(erased, 0xff, sizeof(erased));
+	if (os_lseek(sb_sf.fd, addr, OS_SEEK_SET) < 0)
+		return;
+	for (; len; len -= chunk) {
+		chunk = min(len, (u32)sizeof(erased));
+		if (os_write(sb_sf.fd, erased, chunk) != chunk) {
+			printf("%s: cannot erase at %#x\n", __func__, addr);
+			return;
+		}
+	}
+}
+
+int sandbox_sf_attach(void)
+{
+	struct sandbox_state *state = state_get_current();
+	off_t size;
+
+	if (sb_sf.fd >= 0)
+		return 0;
+	if (!state->spi_sf_file)
+		return -1;
+
+	sb_sf.fd = os_open(state->spi_sf_file, OS_O_RDWR | OS_O_CREAT);
+	if (sb_sf.fd < 0) {
+		printf("%s: cannot open '%s'\n", __func__, state->spi_sf_file);
+		return -1;
+	}
+
+	/* A new or short file reads as erased */
+	size = os_lseek(sb_sf.fd, 0, OS_SEEK_END);
+	if (size >= 0 && size < SB_SF_SIZE)
+		sb_sf_fill(size, SB_SF_SIZE - size);
+
+	return 0;
+}
+
+static void sb_sf_read(u32 addr, u8 *buf, u32 len)
+{
+	u32 chunk;
+
+	for (; len; len -= chunk, buf += chunk, addr = 0) {
+		addr &= SB_SF_SIZE - 1;
+		chunk = min(len, (u32)SB_SF_SIZE - addr);
+		if (os_lseek(sb_sf.fd, addr, OS_SEEK_SET) < 0 ||
+		    os_read(sb_sf.fd, buf, chunk) != chunk)
+			memset(buf, 0xff, chunk);
+	}
+}
+
+/* Decode an opcode and set up the phases that follow it */
+static void sb_sf_start(u8 cmd)
+{
+	sb_sf.cmd = cmd;
+	sb_sf.addr = 0;
+	sb_sf.addr_len = sb_sf.addr4 ? 4 : 3;
+	sb_sf.addr_bytes = 0;
+	sb_sf.dummy = 0;
+	sb_sf.addr_lines = 0;
+	sb_sf.data_lines = 0;
+	sb_sf.pos = 0;
+	sb_sf.phase = SB_SF_PHASE_ADDR;
+
+	switch (cmd) {
+	case CMD_READ_ID:
+	case CMD_READ_STATUS:
+	case CMD_READ_STATUS2:
+	case CMD_WRITE_STATUS:
+		sb_sf.phase = SB_SF_PHASE_DATA;
+		break;
+	case CMD_WRITE_ENABLE:
+	case CMD_WRITE_DISABLE:
+	case CMD_ENTER_4B_MODE:
+	case CMD_EXIT_4B_MODE:
+	case CMD_ERASE_CHIP:
+		sb_sf.phase = SB_SF_PHASE_NONE;
+		break;
+	case CMD_READ_ARRAY_SLOW:
+	case CMD_PAGE_PROGRAM:
+	case CMD_ERASE_4K:
+	case CMD_ERASE_32K:
+	case CMD_ERASE_64K:
+		break;
+	case CMD_PAGE_PROGRAM_4B:
+	case CMD_ERASE_4K_4B:
+	case CMD_ERASE_64K_4B:
+		sb_sf.addr_len = 4;
+		break;
+	case CMD_READ_ARRAY_FAST_4B:
+		sb_sf.addr_len = 4;
+		/* fall through */
+	case CMD_READ_ARRAY_FAST:
+		sb_sf.dummy = 1;
+		break;
+	case CMD_READ_DUAL_OUTPUT_FAST_4B:
+		sb_sf.addr_len = 4;
+		/* fall through */
+	case CMD_READ_DUAL_OUTPUT_FAST:
+		sb_sf.dummy = 1;
+		sb_sf.data_lines = SPI_XFER_DUAL;
+		break;
+	case CMD_READ_QUAD_OUTPUT_FAST_4B:
+		sb_sf.addr_len = 4;
+		/* fall through */
+	case CMD_READ_QUAD_OUTPUT_FAST:
+		sb_sf.dummy = 1;
+		sb_sf.data_lines = SPI_XFER_QUAD;
+		break;
+	case CMD_READ_QUAD_IO_FAST_4B:
+		sb_sf.addr_len = 4;
+		/* fall through */
+	case CMD_READ_QUAD_IO_FAST:
+		/* mode byte and 4 dummy clocks */
+		sb_sf.dummy = 3;
+		sb_sf.addr_lines = SPI_XFER_QUAD;
+		sb_sf.data_lines = SPI_XFER_QUAD;
+		break;
+	default:
+		debug("%s: unknown command %02x\n", __func__, cmd);
+		sb_sf.stats.errors++;
+		sb_sf.phase = SB_SF_PHASE_NONE;
+		return;
+	}
+
+	if (sb_sf.data_lines == SPI_XFER_QUAD && !(sb_sf.cr & STATUS2_QE)) {
+		debug("%s: quad command %02x without QE\n", __func__, cmd);
+		sb_sf.stats.errors++;
+		sb_sf.phase = SB_SF_PHASE_NONE;
+	}
+	if (cmd == CMD_PAGE_PROGRAM || cmd == CMD_PAGE_PROGRAM_4B)
+		memset(sb_sf.buf, 0xff, sizeof(sb_sf.buf));
+}
+
+/* Handle len bytes of the data phase */
+static void sb_sf_data(const u8 *dout, u8 *din, u32 len)
+{
+	u32 i;
+
+	switch (sb_sf.cmd) {
+	case CMD_READ_ID:
+		for (i = 0; din && i < len; i++)
+			din[i] = sb_sf.pos + i < sizeof(sb_sf_id) ?
+				sb_sf_id[sb_sf.pos + i] : 0;
+		break;
+	case CMD_READ_STATUS:
+		if (din)
+			memset(din, sb_sf.sr, len);
+		break;
+	case CMD_READ_STATUS2:
+		if (din)
+			memset(din, sb_sf.cr, len);
+		break;
+	case CMD_WRITE_STATUS:
+		for (i = 0; dout && i < len && sb_sf.pos + i < 2; i++)
+			sb_sf.buf[sb_sf.pos + i] = dout[i];
+		break;
+	case CMD_PAGE_PROGRAM:
+	case CMD_PAGE_PROGRAM_4B:
+		for (i = 0; dout && i < len; i++)
+			sb_sf.buf[(sb_sf.addr + sb_sf.pos + i) %
+				  SB_SF_PAGE_SIZE] &= dout[i];
+		break;
+	default:
+		/* Array reads */
+		sb_sf.stats.last_read_cmd = sb_sf.cmd;
+		if (din)
+			sb_sf_read(sb_sf.addr + sb_sf.pos, din, len);
+		break;
+	}
+	sb_sf.pos += len;
+}
+
+/* Carry out a command when chip select goes away */
+static void sb_sf_finish(void)
+{
+	u32 page, erase_size = 0;
+	u8 buf[SB_SF_PAGE_SIZE];
+	int i;
+
+	if (sb_sf.phase == SB_SF_PHASE_CMD)
+		return;
+
+	switch (sb_sf.cmd) {
+	case CMD_WRITE_ENABLE:
+		sb_sf.sr |= SB_SF_SR_WEL;
+		return;
+	case CMD_WRITE_DISABLE:
+		sb_sf.sr &= ~SB_SF_SR_WEL;
+		return;
+	case CMD_ENTER_4B_MODE:
+		sb_sf.addr4 = 1;
+		return;
+	case CMD_EXIT_4B_MODE:
+		sb_sf.addr4 = 0;
+		return;
+	case CMD_WRITE_STATUS:
+		if (!(sb_sf.sr & SB_SF_SR_WEL) || sb_sf.pos < 1)
+			break;
+		sb_sf.sr = sb_sf.buf[0] & ~SB_SF_SR_WEL;
+		if (sb_sf.pos >= 2)
+			sb_sf.cr = sb_sf.buf[1];
+		return;
+	case CMD_PAGE_PROGRAM:
+	case CMD_PAGE_PROGRAM_4B:
+		if (!(sb_sf.sr & SB_SF_SR_WEL) ||
+		    sb_sf.phase != SB_SF_PHASE_DATA)
+			break;
+		page = sb_sf.addr & ~(SB_SF_PAGE_SIZE - 1) & (SB_SF_SIZE - 1);
+		sb_sf_read(page, buf, sizeof(buf));
+		for (i = 0; i < SB_SF_PAGE_SIZE; i++)
+			buf[i] &= sb_sf.buf[i];
+		if (os_lseek(sb_sf.fd, page, OS_SEEK_SET) < 0 ||
+		    os_write(sb_sf.fd, buf, sizeof(buf)) != sizeof(buf))
+			printf("%s: cannot program %#x\n", __func__, page);
+		sb_sf.sr &= ~SB_SF_SR_WEL;
+		sb_sf.stats.programs++;
+		return;
+	case CMD_ERASE_4K:
+	case CMD_ERASE_4K_4B:
+		erase_size = 4 << 10;
+		break;
+	case CMD_ERASE_32K:
+		erase_size = 32 << 10;
+		break;
+	case CMD_ERASE_64K:
+	case CMD_ERASE_64K_4B:
+		erase_size = 64 << 10;
+		break;
+	case CMD_ERASE_CHIP:
+		/* As on the real part, refused if any block is protected */
+		if (!(sb_sf.sr & STATUS_BP))
+			erase_size = SB_SF_SIZE;
+		break;
+	default:
+		return;
+	}
+
+	if (erase_size && (sb_sf.sr & SB_SF_SR_WEL) &&
+	    (sb_sf.cmd == CMD_ERASE_CHIP ||
+	     sb_sf.phase == SB_SF_PHASE_DATA)) {
+		sb_sf_fill(sb_sf.addr & ~(erase_size - 1) & (SB_SF_SIZE - 1),
+			   erase_size);
+		sb_sf.sr &= ~SB_SF_SR_WEL;
+		sb_sf.stats.erases++;
+		return;
+	}
+
+	debug("%s: command %02x ignored\n", __func__, sb_sf.cmd);
+	sb_sf.stats.errors++;
+}
+
+int sandbox_sf_xfer(unsigned int bitlen, const void *dout, void *din,
+		    unsigned long flags)
+{
+	unsigned long lines = flags & SB_SF_LINES;
+	const u8 *tx = dout;
+	u8 *rx = din;
+	u32 len = bitlen / 8, i, n;
+
+	if (sb_sf.fd < 0 || bitlen % 8)
+		return -1;
+
+	if (flags & SPI_XFER_BEGIN) {
+		sb_sf.phase = SB_SF_PHASE_CMD;
+		sb_sf.stats.commands++;
+	}
+	sb_sf.stats.cycles += lines & SPI_XFER_QUAD ? bitlen / 4 :
+		lines & SPI_XFER_DUAL ? bitlen / 2 : bitlen;
+	if (rx)
+		memset(rx, 0xff, len);
+
+	for (i = 0; i < len; i += n) {
+		n = 1;
+		switch (sb_sf.phase) {
+		case SB_SF_PHASE_NONE:
+			n = len - i;
+			break;
+		case SB_SF_PHASE_CMD:
+			if (lines || !tx)
+				goto bad_lines;
+			sb_sf_start(tx[i]);
+			break;
+		case SB_SF_PHASE_ADDR:
+			if (lines != sb_sf.addr_lines || !tx)
+				goto bad_lines;
+			sb_sf.addr = sb_sf.addr << 8 | tx[i];
+			if (++sb_sf.addr_bytes < sb_sf.addr_len)
+				break;
+			if (sb_sf.addr_len == 4)
+				sb_sf.addr &= SB_SF_SIZE - 1;
+			sb_sf.phase = sb_sf.dummy ? SB_SF_PHASE_DUMMY :
+				SB_SF_PHASE_DATA;
+			break;
+		case SB_SF_PHASE_DUMMY:
+			if (lines != sb_sf.addr_lines)
+				goto bad_lines;
+			if (!--sb_sf.dummy)
+				sb_sf.phase = SB_SF_PHASE_DATA;
+			break;
+		case SB_SF_PHASE_DATA:
+			if (lines != sb_sf.data_lines)
+				goto bad_lines;
+			n = len - i;
+			sb_sf_data(tx ? tx + i : NULL, rx ? rx + i : NULL, n);
+			break;
+		}
+	}
+
+	if (flags & SPI_XFER_END) {
+		sb_sf_finish();
+		sb_sf.phase = SB_SF_PHASE_NONE;
+	}
+
+	return 0;
+
+bad_lines:
+	debug("%s: command %02x: wrong lines %lx in phase %d\n", __func__,
+	      sb_sf.cmd, lines, sb_sf.phase);
+	sb_sf.stats.errors++;
+	sb_sf.phase = SB_SF_PHASE_NONE;
+	return 0;
+}
+
+void sandbox_sf_get_stats(struct sandbox_sf_stats *stats)
+{
+	*stats = sb_sf.stats;
+	stats->addr4 = sb_sf.addr4;
+}
+
+void sandbox_sf_reset_stats(void)
+{
+	memset(&sb_sf.stats, '\0', sizeof(sb_sf.stats));
+}
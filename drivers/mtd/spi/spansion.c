@@ -36,9 +36,13 @@ struct spansion_spi_flash_params {
 	u16 idcode2;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u16 flags;
 	const char *name;
 };
 
+#define SPANSION_QUAD_FLAGS	(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_QUAD_IO | SPI_FLASH_QE_CR)
+
 static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 	{
 		.idcode1 = 0x0213,
@@ -94,6 +98,7 @@ static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 		.idcode2 = 0x4d01,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.flags = SPANSION_QUAD_FLAGS | SPI_FLASH_ERASE_CHIP,
 		.name = "S25FL129P_64K",
 	},
 	{
@@ -101,6 +106,9 @@ static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 		.idcode2 = 0x4d01,
 		.pages_per_sector = 256,
 		.nr_sectors = 512,
+		/* ECC over 16-byte units, lost when one is reprogrammed */
+		.flags = SPANSION_QUAD_FLAGS | SPI_FLASH_ERASE_CHIP |
+			 SPI_FLASH_NO_REPROG,
 		.name = "S25FL256S",
 	},
 };
@@ -128,7 +136,7 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -136,6 +144,7 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 
 	flash->spi = spi;
 	flash->name = params->name;
+	flash->flags = params->flags;
 
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = spi_flash_cmd_erase;
@@ -15,12 +15,78 @@
 
 #include "spi_flash_internal.h"
 
-static void spi_flash_addr(u32 addr, u8 *cmd)
+/* Fill in the address after cmd[0], returns the length of the command */
+static size_t spi_flash_addr(struct spi_flash *flash, u32 addr, u8 *cmd)
 {
+	int i;
+
 	/* cmd[0] is actual command */
-	cmd[1] = addr >> 16;
-	cmd[2] = addr >> 8;
-	cmd[3] = addr >> 0;
+	for (i = flash->addr_width; i > 0; i--) {
+		cmd[i] = addr;
+		addr >>= 8;
+	}
+
+	return 1 + flash->addr_width;
+}
+
+/*
+ * Large parts which are not switched to 4-byte mode take a separate set
+ * of opcodes with 4-byte addresses; map a 3-byte address opcode to it.
+ */
+static int spi_flash_4b_opcodes(struct spi_flash *flash)
+{
+	return flash->addr_width == 4 && !(flash->flags & SPI_FLASH_4B_MODE);
+}
+
+static u8 spi_flash_opcode(struct spi_flash *flash, u8 cmd)
+{
+	if (!spi_flash_4b_opcodes(flash))
+		return cmd;
+
+	switch (cmd) {
+	case CMD_READ_ARRAY_FAST:
+		return CMD_READ_ARRAY_FAST_4B;
+	case CMD_READ_DUAL_OUTPUT_FAST:
+		return CMD_READ_DUAL_OUTPUT_FAST_4B;
+	case CMD_READ_QUAD_OUTPUT_FAST:
+		return CMD_READ_QUAD_OUTPUT_FAST_4B;
+	case CMD_READ_QUAD_IO_FAST:
+		return CMD_READ_QUAD_IO_FAST_4B;
+	case CMD_PAGE_PROGRAM:
+		return CMD_PAGE_PROGRAM_4B;
+	case CMD_ERASE_4K:
+		return CMD_ERASE_4K_4B;
+	case CMD_ERASE_64K:
+		return CMD_ERASE_64K_4B;
+	}
+
+	return cmd;
+}
+
+/*
+ * A part without the 4-byte opcodes is in 4-byte address mode only while
+ * a read, write or erase runs. Left in that mode, it would be misread by
+ * a boot ROM or SPL after a warm reset, and by an OS expecting 3 bytes.
+ */
+static int spi_flash_4b_mode(struct spi_flash *flash, int enter)
+{
+	int ret;
+
+	if (flash->addr_width != 4 || !(flash->flags & SPI_FLASH_4B_MODE))
+		return 0;
+
+	/* Some parts want WEL set first; harmless elsewhere */
+	ret = spi_flash_cmd_write_enable(flash);
+	if (!ret)
+		ret = spi_flash_cmd(flash->spi, enter ? CMD_ENTER_4B_MODE :
+				    CMD_EXIT_4B_MODE, NULL, 0);
+	if (!ret)
+		ret = spi_flash_cmd_write_disable(flash);
+	if (ret)
+		debug("SF: Failed to %s 4-byte mode\n",
+		      enter ? "enter" : "exit");
+
+	return ret;
 }
 
 static int spi_flash_read_write(struct spi_slave *spi,
@@ -65,16 +131,26 @@ int spi_flash_cmd_write(struct spi_slave *spi, const u8 *cmd, size_t cmd_len,
 	return spi_flash_read_write(spi, cmd, cmd_len, data, NULL, data_len);
 }
 
+static int spi_flash_blank(const void *buf, size_t len)
+{
+	const u8 *p = buf;
+
+	while (len--)
+		if (*p++ != 0xff)
+			return 0;
+
+	return 1;
+}
+
 int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 		size_t len, const void *buf)
 {
-	unsigned long page_addr, byte_addr, page_size;
-	size_t chunk_len, actual;
+	unsigned long byte_addr, page_size;
+	size_t chunk_len, actual, cmd_len;
 	int ret;
-	u8 cmd[4];
+	u8 cmd[5];
 
 	page_size = flash->page_size;
-	page_addr = offset / page_size;
 	byte_addr = offset % page_size;
 
 	ret = spi_claim_bus(flash->spi);
@@ -83,16 +159,25 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 		return ret;
 	}
 
-	cmd[0] = CMD_PAGE_PROGRAM;
+	ret = spi_flash_4b_mode(flash, 1);
+	if (ret) {
+		spi_release_bus(flash->spi);
+		return ret;
+	}
+
+	cmd[0] = spi_flash_opcode(flash, CMD_PAGE_PROGRAM);
 	for (actual = 0; actual < len; actual += chunk_len) {
 		chunk_len = min(len - actual, page_size - byte_addr);
+		byte_addr = 0;
+
+		/* Programming all-ones changes nothing, skip it and its poll */
+		if (spi_flash_blank(buf + actual, chunk_len))
+			continue;
 
-		cmd[1] = page_addr >> 8;
-		cmd[2] = page_addr;
-		cmd[3] = byte_addr;
+		cmd_len = spi_flash_addr(flash, offset + actual, cmd);
 
-		debug("PP: 0x%p => cmd = { 0x%02x 0x%02x%02x%02x } chunk_len = %zu\n",
-		      buf + actual, cmd[0], cmd[1], cmd[2], cmd[3], chunk_len);
+		debug("PP: 0x%p => cmd = { 0x%02x @ %#zx } chunk_len = %zu\n",
+		      buf + actual, cmd[0], offset + actual, chunk_len);
 
 		ret = spi_flash_cmd_write_enable(flash);
 		if (ret < 0) {
@@ -100,7 +185,7 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 			break;
 		}
 
-		ret = spi_flash_cmd_write(flash->spi, cmd, 4,
+		ret = spi_flash_cmd_write(flash->spi, cmd, cmd_len,
 					  buf + actual, chunk_len);
 		if (ret < 0) {
 			debug("SF: write failed\n");
@@ -110,14 +195,13 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
 		if (ret)
 			break;
-
-		page_addr++;
-		byte_addr = 0;
 	}
 
 	debug("SF: program %s %zu bytes @ %#x\n",
 	      ret ? "failure" : "success", len, offset);
 
+	if (spi_flash_4b_mode(flash, 0) && !ret)
+		ret = -1;
 	spi_release_bus(flash->spi);
 	return ret;
 }
@@ -138,13 +222,66 @@ int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
 		size_t len, void *data)
 {
-	u8 cmd[5];
+	struct spi_slave *spi = flash->spi;
+	unsigned long lines = 0;
+	size_t cmd_len;
+	int ret;
+	u8 cmd[8];
+
+	cmd[0] = flash->read_cmd;
+	cmd_len = spi_flash_addr(flash, offset, cmd);
+
+	switch (flash->read_mode) {
+	case SPI_FLASH_READ_1_4_4:
+		/* Mode byte (no continuous read) and 4 dummy clocks */
+		memset(cmd + cmd_len, '\0', 3);
+		cmd_len += 3;
+		lines = SPI_XFER_QUAD;
+		break;
+	case SPI_FLASH_READ_1_1_4:
+		lines = SPI_XFER_QUAD;
+		cmd[cmd_len++] = 0x00;
+		break;
+	case SPI_FLASH_READ_1_1_2:
+		lines = SPI_XFER_DUAL;
+		cmd[cmd_len++] = 0x00;
+		break;
+	default:
+		cmd[cmd_len++] = 0x00;
+		break;
+	}
 
-	cmd[0] = CMD_READ_ARRAY_FAST;
-	spi_flash_addr(offset, cmd);
-	cmd[4] = 0x00;
+	ret = spi_claim_bus(spi);
+	if (ret) {
+		debug("SF: unable to claim SPI bus\n");
+		return ret;
+	}
+
+	ret = spi_flash_4b_mode(flash, 1);
+	if (ret) {
+		spi_release_bus(spi);
+		return ret;
+	}
+
+	if (flash->read_mode == SPI_FLASH_READ_1_4_4) {
+		/* Only the opcode goes out on one line */
+		ret = spi_xfer(spi, 8, cmd, NULL, SPI_XFER_BEGIN);
+		if (!ret)
+			ret = spi_xfer(spi, (cmd_len - 1) * 8, cmd + 1, NULL,
+				       SPI_XFER_QUAD);
+	} else {
+		ret = spi_xfer(spi, cmd_len * 8, cmd, NULL, SPI_XFER_BEGIN);
+	}
+	if (ret)
+		debug("SF: Failed to send read command: %d\n", ret);
+	else
+		ret = spi_xfer(spi, len * 8, NULL, data, lines | SPI_XFER_END);
+
+	if (spi_flash_4b_mode(flash, 0) && !ret)
+		ret = -1;
+	spi_release_bus(spi);
 
-	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
+	return ret;
 }
 
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
@@ -190,11 +327,61 @@ int spi_flash_cmd_wait_ready(struct spi_flash *flash, unsigned long timeout)
 		CMD_READ_STATUS, STATUS_WIP);
 }
 
+/* The block protect bits in the status register of this part */
+static u8 spi_flash_bp_mask(struct spi_flash *flash)
+{
+	u8 mask = STATUS_BP;
+
+	if (flash->flags & SPI_FLASH_BP3_SR5)
+		mask |= STATUS_BP3_SR5;
+	if (flash->flags & SPI_FLASH_BP3_SR6)
+		mask |= STATUS_BP3_SR6;
+
+	return mask;
+}
+
+/*
+ * Pick the largest erase the part has that starts at offset and does not
+ * go past end, a chip erase only if allowed. Returns the opcode and sets
+ * *sizep.
+ */
+static u8 spi_flash_erase_op(struct spi_flash *flash, u32 offset, u32 end,
+			     int chip, u32 *sizep)
+{
+	u32 left = end - offset;
+
+	if (chip && offset == 0 && left == flash->size) {
+		*sizep = flash->size;
+		return CMD_ERASE_CHIP;
+	}
+	if ((flash->flags & SPI_FLASH_ERASE_64K) &&
+	    !(offset % SPI_FLASH_64K) && left >= SPI_FLASH_64K) {
+		*sizep = SPI_FLASH_64K;
+		return spi_flash_opcode(flash, CMD_ERASE_64K);
+	}
+	/* There is no common 4-byte opcode for 32KiB blocks */
+	if ((flash->flags & SPI_FLASH_ERASE_32K) &&
+	    !spi_flash_4b_opcodes(flash) &&
+	    !(offset % SPI_FLASH_32K) && left >= SPI_FLASH_32K) {
+		*sizep = SPI_FLASH_32K;
+		return CMD_ERASE_32K;
+	}
+
+	*sizep = flash->sector_size;
+	if (flash->sector_size == 4096)
+		return spi_flash_opcode(flash, CMD_ERASE_4K);
+	return spi_flash_opcode(flash, CMD_ERASE_64K);
+}
+
 int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 {
 	u32 start, end, erase_size;
+	unsigned long timeout;
+	size_t cmd_len;
+	int chip = 0;
 	int ret;
-	u8 cmd[4];
+	u8 cmd[5];
+	u8 sr;
 
 	erase_size = flash->sector_size;
 	if (offset % erase_size || len % erase_size) {
@@ -208,29 +395,47 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 		return ret;
 	}
 
-	if (erase_size == 4096)
-		cmd[0] = CMD_ERASE_4K;
-	else
-		cmd[0] = CMD_ERASE_64K;
+	ret = spi_flash_4b_mode(flash, 1);
+	if (ret) {
+		spi_release_bus(flash->spi);
+		return ret;
+	}
+
 	start = offset;
 	end = start + len;
 
+	/*
+	 * A chip erase does nothing at all if any block is protected, so
+	 * then go block by block and leave just the protected ones.
+	 */
+	if ((flash->flags & SPI_FLASH_ERASE_CHIP) && offset == 0 &&
+	    len == flash->size &&
+	    !spi_flash_cmd(flash->spi, CMD_READ_STATUS, &sr, 1))
+		chip = !(sr & spi_flash_bp_mask(flash));
+
 	while (offset < end) {
-		spi_flash_addr(offset, cmd);
-		offset += erase_size;
+		cmd[0] = spi_flash_erase_op(flash, offset, end, chip,
+					    &erase_size);
+		if (cmd[0] == CMD_ERASE_CHIP) {
+			cmd_len = 1;
+			timeout = SPI_FLASH_CHIP_ERASE_TIMEOUT;
+		} else {
+			cmd_len = spi_flash_addr(flash, offset, cmd);
+			timeout = SPI_FLASH_PAGE_ERASE_TIMEOUT;
+		}
 
-		debug("SF: erase %2x %2x %2x %2x (%x)\n", cmd[0], cmd[1],
-		      cmd[2], cmd[3], offset);
+		debug("SF: erase %2x @ %x\n", cmd[0], offset);
+		offset += erase_size;
 
 		ret = spi_flash_cmd_write_enable(flash);
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_write(flash->spi, cmd, sizeof(cmd), NULL, 0);
+		ret = spi_flash_cmd_write(flash->spi, cmd, cmd_len, NULL, 0);
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PAGE_ERASE_TIMEOUT);
+		ret = spi_flash_cmd_wait_ready(flash, timeout);
 		if (ret)
 			goto out;
 	}
@@ -238,6 +443,8 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 	debug("SF: Successfully erased %zu bytes @ %#x\n", len, start);
 
  out:
+	if (spi_flash_4b_mode(flash, 0) && !ret)
+		ret = -1;
 	spi_release_bus(flash->spi);
 	return ret;
 }
@@ -269,6 +476,75 @@ int spi_flash_cmd_write_status(struct spi_flash *flash, u8 sr)
 	return 0;
 }
 
+/* Set the quad enable bit in the second status / configuration register */
+static int spi_flash_set_qe(struct spi_flash *flash)
+{
+	u8 sr[2];
+	u8 cmd;
+	int ret;
+
+	ret = spi_flash_cmd(flash->spi, CMD_READ_STATUS2, &sr[1], 1);
+	if (ret || (sr[1] & STATUS2_QE))
+		return ret;
+	ret = spi_flash_cmd(flash->spi, CMD_READ_STATUS, &sr[0], 1);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_cmd_write_enable(flash);
+	if (ret)
+		return ret;
+	sr[1] |= STATUS2_QE;
+	cmd = CMD_WRITE_STATUS;
+	ret = spi_flash_cmd_write(flash->spi, &cmd, 1, sr, 2);
+	if (ret)
+		return ret;
+
+	return spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+}
+
+/*
+ * Pick the fastest read the part and the controller both support, and
+ * the addressing for parts above 16MiB.
+ */
+static int spi_flash_setup(struct spi_flash *flash, unsigned int spi_mode)
+{
+	static const u8 read_cmds[] = {
+		[SPI_FLASH_READ_1_1_1] = CMD_READ_ARRAY_FAST,
+		[SPI_FLASH_READ_1_1_2] = CMD_READ_DUAL_OUTPUT_FAST,
+		[SPI_FLASH_READ_1_1_4] = CMD_READ_QUAD_OUTPUT_FAST,
+		[SPI_FLASH_READ_1_4_4] = CMD_READ_QUAD_IO_FAST,
+	};
+
+	if ((flash->flags & SPI_FLASH_RD_QUAD_IO) &&
+	    (spi_mode & SPI_RX_QUAD) && (spi_mode & SPI_TX_QUAD))
+		flash->read_mode = SPI_FLASH_READ_1_4_4;
+	else if ((flash->flags & SPI_FLASH_RD_QUAD) && (spi_mode & SPI_RX_QUAD))
+		flash->read_mode = SPI_FLASH_READ_1_1_4;
+	else if ((flash->flags & SPI_FLASH_RD_DUAL) && (spi_mode & SPI_RX_DUAL))
+		flash->read_mode = SPI_FLASH_READ_1_1_2;
+	else
+		flash->read_mode = SPI_FLASH_READ_1_1_1;
+
+	if (flash->read_mode >= SPI_FLASH_READ_1_1_4 &&
+	    (flash->flags & SPI_FLASH_QE_CR) && spi_flash_set_qe(flash)) {
+		debug("SF: Failed to enable quad mode\n");
+		flash->read_mode = (flash->flags & SPI_FLASH_RD_DUAL) &&
+			(spi_mode & SPI_RX_DUAL) ?
+			SPI_FLASH_READ_1_1_2 : SPI_FLASH_READ_1_1_1;
+	}
+
+	/* 4-byte address mode, if needed, is entered by each operation */
+	flash->addr_width = 3;
+	if (flash->size > SPI_FLASH_3B_ADDR_LIMIT)
+		flash->addr_width = 4;
+
+	flash->read_cmd = spi_flash_opcode(flash, read_cmds[flash->read_mode]);
+	debug("SF: read opcode %02x, %d address bytes\n", flash->read_cmd,
+	      flash->addr_width);
+
+	return 0;
+}
+
 /*
  * The following table holds all device probe functions
  *
@@ -385,6 +661,12 @@ struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
 		goto err_manufacturer_probe;
 	}
 
+	ret = spi_flash_setup(flash, spi_mode);
+	if (ret) {
+		free(flash);
+		goto err_manufacturer_probe;
+	}
+
 	printf("SF: Detected %s with page size ", flash->name);
 	print_size(flash->sector_size, ", total ");
 	print_size(flash->size, "\n");
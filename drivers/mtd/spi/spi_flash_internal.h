@@ -11,12 +11,16 @@
 #define SPI_FLASH_PROG_TIMEOUT		(2 * CONFIG_SYS_HZ)
 #define SPI_FLASH_PAGE_ERASE_TIMEOUT	(5 * CONFIG_SYS_HZ)
 #define SPI_FLASH_SECTOR_ERASE_TIMEOUT	(10 * CONFIG_SYS_HZ)
+#define SPI_FLASH_CHIP_ERASE_TIMEOUT	(400 * CONFIG_SYS_HZ)
 
 /* Common commands */
 #define CMD_READ_ID			0x9f
 
 #define CMD_READ_ARRAY_SLOW		0x03
 #define CMD_READ_ARRAY_FAST		0x0b
+#define CMD_READ_DUAL_OUTPUT_FAST	0x3b
+#define CMD_READ_QUAD_OUTPUT_FAST	0x6b
+#define CMD_READ_QUAD_IO_FAST		0xeb
 
 #define CMD_WRITE_STATUS		0x01
 #define CMD_PAGE_PROGRAM		0x02
@@ -27,9 +31,32 @@
 #define CMD_ERASE_32K			0x52
 #define CMD_ERASE_64K			0xd8
 #define CMD_ERASE_CHIP			0xc7
+#define CMD_READ_STATUS2		0x35
+
+/* 4-byte address commands */
+#define CMD_READ_ARRAY_FAST_4B		0x0c
+#define CMD_READ_DUAL_OUTPUT_FAST_4B	0x3c
+#define CMD_READ_QUAD_OUTPUT_FAST_4B	0x6c
+#define CMD_READ_QUAD_IO_FAST_4B	0xec
+#define CMD_PAGE_PROGRAM_4B		0x12
+#define CMD_ERASE_4K_4B			0x21
+#define CMD_ERASE_64K_4B		0xdc
+#define CMD_ENTER_4B_MODE		0xb7
+#define CMD_EXIT_4B_MODE		0xe9
+
+/* Block erase sizes */
+#define SPI_FLASH_32K			(32 << 10)
+#define SPI_FLASH_64K			(64 << 10)
+
+/* Parts above this size need 4-byte addresses */
+#define SPI_FLASH_3B_ADDR_LIMIT		(16 << 20)
 
 /* Common status */
 #define STATUS_WIP			0x01
+#define STATUS_BP			0x1c	/* BP0-BP2 block protect */
+#define STATUS_BP3_SR5			0x20	/* BP3, SPI_FLASH_BP3_SR5 */
+#define STATUS_BP3_SR6			0x40	/* BP3, SPI_FLASH_BP3_SR6 */
+#define STATUS2_QE			0x02
 
 /* Send a single-byte command to the device and read the response */
 int spi_flash_cmd(struct spi_slave *spi, u8 cmd, void *response, size_t len);
@@ -40,9 +40,13 @@ struct stmicro_spi_flash_params {
 	u16 id;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u16 flags;
 	const char *name;
 };
 
+#define STMICRO_N25Q_FLAGS	(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_ERASE_CHIP | SPI_FLASH_BP3_SR6)
+
 static const struct stmicro_spi_flash_params stmicro_spi_flash_table[] = {
 	{
 		.id = 0x2011,
@@ -96,48 +100,56 @@ static const struct stmicro_spi_flash_params stmicro_spi_flash_table[] = {
 		.id = 0xba16,
 		.pages_per_sector = 256,
 		.nr_sectors = 64,
+		.flags = STMICRO_N25Q_FLAGS,
 		.name = "N25Q32",
 	},
 	{
 		.id = 0xbb16,
 		.pages_per_sector = 256,
 		.nr_sectors = 64,
+		.flags = STMICRO_N25Q_FLAGS,
 		.name = "N25Q32A",
 	},
 	{
 		.id = 0xba17,
 		.pages_per_sector = 256,
 		.nr_sectors = 128,
+		.flags = STMICRO_N25Q_FLAGS,
 		.name = "N25Q064",
 	},
 	{
 		.id = 0xbb17,
 		.pages_per_sector = 256,
 		.nr_sectors = 128,
+		.flags = STMICRO_N25Q_FLAGS,
 		.name = "N25Q64A",
 	},
 	{
 		.id = 0xba18,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.flags = STMICRO_N25Q_FLAGS,
 		.name = "N25Q128",
 	},
 	{
 		.id = 0xbb18,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.flags = STMICRO_N25Q_FLAGS,
 		.name = "N25Q128A",
 	},
 	{
 		.id = 0xba19,
 		.pages_per_sector = 256,
 		.nr_sectors = 512,
+		.flags = STMICRO_N25Q_FLAGS | SPI_FLASH_4B_MODE,
 		.name = "N25Q256",
 	},
 	{
 		.id = 0xbb19,
 		.pages_per_sector = 256,
 		.nr_sectors = 512,
+		.flags = STMICRO_N25Q_FLAGS | SPI_FLASH_4B_MODE,
 		.name = "N25Q256A",
 	},
 };
@@ -176,7 +188,7 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -184,6 +196,7 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 
 	flash->spi = spi;
 	flash->name = params->name;
+	flash->flags = params->flags;
 
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = spi_flash_cmd_erase;
@@ -13,55 +13,79 @@
 struct winbond_spi_flash_params {
 	uint16_t	id;
 	uint16_t	nr_blocks;
+	uint16_t	flags;
 	const char	*name;
 };
 
+#define WINBOND_W25X_FLAGS	(SPI_FLASH_RD_DUAL | SPI_FLASH_ERASE_64K | \
+				 SPI_FLASH_ERASE_CHIP)
+#define WINBOND_W25Q_FLAGS	(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_QUAD_IO | SPI_FLASH_QE_CR | \
+				 SPI_FLASH_ERASE_32K | SPI_FLASH_ERASE_64K | \
+				 SPI_FLASH_ERASE_CHIP)
+
 static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 	{
 		.id			= 0x3013,
 		.nr_blocks		= 8,
+		.flags			= WINBOND_W25X_FLAGS,
 		.name			= "W25X40",
 	},
 	{
 		.id			= 0x3015,
 		.nr_blocks		= 32,
+		.flags			= WINBOND_W25X_FLAGS,
 		.name			= "W25X16",
 	},
 	{
 		.id			= 0x3016,
 		.nr_blocks		= 64,
+		.flags			= WINBOND_W25X_FLAGS,
 		.name			= "W25X32",
 	},
 	{
 		.id			= 0x3017,
 		.nr_blocks		= 128,
+		.flags			= WINBOND_W25X_FLAGS,
 		.name			= "W25X64",
 	},
 	{
 		.id			= 0x4014,
 		.nr_blocks		= 16,
+		.flags			= WINBOND_W25Q_FLAGS,
 		.name			= "W25Q80BL",
 	},
 	{
 		.id			= 0x4015,
 		.nr_blocks		= 32,
+		.flags			= WINBOND_W25Q_FLAGS,
 		.name			= "W25Q16",
 	},
 	{
 		.id			= 0x4016,
 		.nr_blocks		= 64,
+		.flags			= WINBOND_W25Q_FLAGS,
 		.name			= "W25Q32",
 	},
 	{
 		.id			= 0x4017,
 		.nr_blocks		= 128,
+		.flags			= WINBOND_W25Q_FLAGS,
 		.name			= "W25Q64",
 	},
 	{
 		.id			= 0x4018,
 		.nr_blocks		= 256,
+		.flags			= WINBOND_W25Q_FLAGS,
 		.name			= "W25Q128",
 	},
+	{
+		.id			= 0x4019,
+		.nr_blocks		= 512,
+		.flags			= WINBOND_W25Q_FLAGS | SPI_FLASH_4B_MODE |
+					  SPI_FLASH_BP3_SR5,
+		.name			= "W25Q256",
+	},
 	{
 		.id			= 0x5014,
 		.nr_blocks		= 128,
@@ -70,6 +94,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 	{
 		.id			= 0x6017,
 		.nr_blocks		= 128,
+		.flags			= WINBOND_W25Q_FLAGS,
 		.name			= "W25Q64DW",
 	},
 };
@@ -92,7 +117,7 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -100,6 +125,7 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 
 	flash->spi = spi;
 	flash->name = params->name;
+	flash->flags = params->flags;
 
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = spi_flash_cmd_erase;
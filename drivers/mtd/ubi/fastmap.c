@@ -0,0 +1,509 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * UBI fastmap attaching unit.
+ *
+ * Instead of reading the EC and VID headers of every physical eraseblock,
+ * this unit builds the scanning information from a fastmap written by the
+ * Linux UBI implementation: the anchor PEB is looked for among the first
+ * %UBI_FM_MAX_START PEBs, the fastmap it points to provides the erase
+ * counters and the EBA tables, and only the PEBs of the fastmap pools (which
+ * may have been written after the fastmap) are scanned.
+ *
+ * The fastmap is only read. Its PEBs belong to "delete"-compatible internal
+ * volumes, so they are put to the @corr list just like a full scan would do,
+ * and Linux writes a new fastmap the next time it attaches.
+ */
+
+#include <ubi_uboot.h>
+#include "ubi.h"
+
+/* What the fastmap tells us about a PEB */
+#define FM_PEB_USED	1
+#define FM_PEB_SCRUB	2
+
+/**
+ * struct fm_attach - state while attaching from a fastmap
+ * @si: scanning information being built
+ * @fm: raw fastmap data
+ * @fm_size: size of @fm
+ * @fm_pos: parse position in @fm
+ * @ec: erase counter of each used PEB
+ * @state: %FM_PEB_USED or %FM_PEB_SCRUB for used PEBs
+ * @seen: whether a PEB has already been accounted for
+ * @peb_count: number of PEBs accounted for
+ */
+struct fm_attach {
+	struct ubi_scan_info *si;
+	void *fm;
+	int fm_size;
+	int fm_pos;
+	int *ec;
+	u8 *state;
+	u8 *seen;
+	int peb_count;
+};
+
+/*
+ * Return a pointer to the next @len bytes of the fastmap, or %NULL if the
+ * fastmap is too short.
+ */
+static void *fm_get(struct fm_attach *fa, int len)
+{
+	void *p;
+
+	if (len < 0 || fa->fm_pos + len > fa->fm_size)
+		return NULL;
+
+	p = fa->fm + fa->fm_pos;
+	fa->fm_pos += len;
+	return p;
+}
+
+/*
+ * Account for PEB @pnum, making sure the fastmap mentions each PEB only once.
+ */
+static int fm_see_peb(struct ubi_device *ubi, struct fm_attach *fa, int pnum)
+{
+	if (pnum < 0 || pnum >= ubi->peb_count) {
+		ubi_err("fastmap refers to bad PEB number %d", pnum);
+		return -EINVAL;
+	}
+	if (fa->seen[pnum]) {
+		ubi_err("PEB %d found twice in fastmap", pnum);
+		return -EINVAL;
+	}
+
+	fa->seen[pnum] = 1;
+	fa->peb_count += 1;
+	return 0;
+}
+
+static void fm_adjust_ec(struct ubi_scan_info *si, int ec)
+{
+	si->ec_sum += ec;
+	si->ec_count += 1;
+	if (ec > si->max_ec)
+		si->max_ec = ec;
+	if (ec < si->min_ec)
+		si->min_ec = ec;
+}
+
+/*
+ * Add PEB @pnum to one of the @si lists (free, erase or corrupted).
+ */
+static int fm_add_to_list(struct ubi_device *ubi, struct fm_attach *fa,
+			  int pnum, int ec, struct list_head *list)
+{
+	struct ubi_scan_leb *seb;
+	int err;
+
+	err = fm_see_peb(ubi, fa, pnum);
+	if (err)
+		return err;
+
+	seb = kmalloc(sizeof(struct ubi_scan_leb), GFP_KERNEL);
+	if (!seb)
+		return -ENOMEM;
+
+	seb->pnum = pnum;
+	seb->ec = ec;
+	list_add_tail(&seb->u.list, list);
+	fm_adjust_ec(fa->si, ec);
+	return 0;
+}
+
+/*
+ * Read the @count erase counter records at the current position and add them
+ * to @list, or when @list is %NULL, remember them as used PEBs with @state.
+ */
+static int fm_read_ec_list(struct ubi_device *ubi, struct fm_attach *fa,
+			   int count, struct list_head *list, int state)
+{
+	struct ubi_fm_ec *fmec;
+	int i, pnum, ec, err;
+
+	fmec = fm_get(fa, count * sizeof(struct ubi_fm_ec));
+	if (!fmec)
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		pnum = be32_to_cpu(fmec[i].pnum);
+		ec = be32_to_cpu(fmec[i].ec);
+
+		if (list) {
+			err = fm_add_to_list(ubi, fa, pnum, ec, list);
+			if (err)
+				return err;
+			continue;
+		}
+
+		if (pnum < 0 || pnum >= ubi->peb_count || fa->state[pnum]) {
+			ubi_err("bad used PEB %d in fastmap", pnum);
+			return -EINVAL;
+		}
+		fa->ec[pnum] = ec;
+		fa->state[pnum] = state;
+	}
+
+	return 0;
+}
+
+/*
+ * Add the mapped LEBs of one volume to the scanning information. A VID header
+ * is made up from the fastmap volume header so that the volume is checked and
+ * added exactly like during a full scan.
+ */
+static int fm_read_volume(struct ubi_device *ubi, struct fm_attach *fa,
+			  struct ubi_vid_hdr *vh)
+{
+	struct ubi_fm_volhdr *fmvhdr;
+	struct ubi_fm_eba *fm_eba;
+	int lnum, pnum, reserved_pebs, err;
+
+	fmvhdr = fm_get(fa, sizeof(struct ubi_fm_volhdr));
+	if (!fmvhdr || be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC) {
+		ubi_err("bad fastmap volume header");
+		return -EINVAL;
+	}
+
+	fm_eba = fm_get(fa, sizeof(struct ubi_fm_eba));
+	if (!fm_eba || be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC) {
+		ubi_err("bad fastmap EBA header");
+		return -EINVAL;
+	}
+
+	reserved_pebs = be32_to_cpu(fm_eba->reserved_pebs);
+	if (!fm_get(fa, reserved_pebs * sizeof(__be32)))
+		return -EINVAL;
+
+	memset(vh, 0, sizeof(struct ubi_vid_hdr));
+	vh->vol_id = fmvhdr->vol_id;
+	vh->vol_type = fmvhdr->vol_type == UBI_DYNAMIC_VOLUME ?
+		       UBI_VID_DYNAMIC : UBI_VID_STATIC;
+	vh->used_ebs = fmvhdr->used_ebs;
+	vh->data_pad = fmvhdr->data_pad;
+	/* Only used for the last LEB of static volumes */
+	vh->data_size = fmvhdr->last_eb_bytes;
+
+	for (lnum = 0; lnum < reserved_pebs; lnum++) {
+		pnum = be32_to_cpu(fm_eba->pnum[lnum]);
+		if (pnum < 0)
+			continue;
+
+		if (pnum >= ubi->peb_count || !fa->state[pnum]) {
+			ubi_err("PEB %d is in EBA but not in used list", pnum);
+			return -EINVAL;
+		}
+
+		err = fm_see_peb(ubi, fa, pnum);
+		if (err)
+			return err;
+
+		vh->lnum = cpu_to_be32(lnum);
+		err = ubi_scan_add_used(ubi, fa->si, pnum, fa->ec[pnum], vh,
+					fa->state[pnum] == FM_PEB_SCRUB);
+		if (err)
+			return err;
+		fm_adjust_ec(fa->si, fa->ec[pnum]);
+	}
+
+	return 0;
+}
+
+/*
+ * Scan the PEBs of a fastmap pool; they may have been written or erased
+ * after the fastmap was taken.
+ */
+static int fm_scan_pool(struct ubi_device *ubi, struct fm_attach *fa)
+{
+	struct ubi_fm_scan_pool *fmpl;
+	int i, size, pnum, err;
+
+	fmpl = fm_get(fa, sizeof(struct ubi_fm_scan_pool));
+	if (!fmpl || be32_to_cpu(fmpl->magic) != UBI_FM_POOL_MAGIC) {
+		ubi_err("bad fastmap pool magic");
+		return -EINVAL;
+	}
+
+	size = be16_to_cpu(fmpl->size);
+	if (size > UBI_FM_MAX_POOL_SIZE) {
+		ubi_err("bad fastmap pool size %d", size);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < size; i++) {
+		pnum = be32_to_cpu(fmpl->pebs[i]);
+		err = fm_see_peb(ubi, fa, pnum);
+		if (err)
+			return err;
+
+		dbg_bld("scan pool PEB %d", pnum);
+		err = ubi_scan_process_eb(ubi, fa->si, pnum);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/*
+ * Find the fastmap anchor among the first PEBs. Returns its PEB number, or
+ * -ENOENT if there is none.
+ */
+static int fm_find_anchor(struct ubi_device *ubi, struct ubi_vid_hdr *vh)
+{
+	unsigned long long sqnum, max_sqnum = 0;
+	int pnum, err, anchor = -ENOENT;
+
+	for (pnum = 0; pnum < UBI_FM_MAX_START && pnum < ubi->peb_count;
+	     pnum++) {
+		cond_resched();
+
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			return err;
+		else if (err)
+			continue;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vh, 0);
+		if (err < 0)
+			return err;
+		if (err != 0 && err != UBI_IO_BITFLIPS)
+			continue;
+
+		if (be32_to_cpu(vh->vol_id) != UBI_FM_SB_VOLUME_ID)
+			continue;
+
+		sqnum = be64_to_cpu(vh->sqnum);
+		if (anchor < 0 || sqnum > max_sqnum) {
+			max_sqnum = sqnum;
+			anchor = pnum;
+		}
+	}
+
+	return anchor;
+}
+
+/*
+ * Read the fastmap blocks listed in @fmsb into @fm and check their headers
+ * and the fastmap CRC.
+ */
+static int fm_read_blocks(struct ubi_device *ubi, struct ubi_fm_sb *fmsb,
+			  void *fm, struct ubi_vid_hdr *vh)
+{
+	struct ubi_ec_hdr *ech;
+	struct ubi_fm_sb *fmsb2;
+	int i, pnum, used_blocks, err;
+	uint32_t crc, data_crc;
+
+	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	if (!ech)
+		return -ENOMEM;
+
+	used_blocks = be32_to_cpu(fmsb->used_blocks);
+	for (i = 0; i < used_blocks; i++) {
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		err = -EINVAL;
+		if (pnum < 0 || pnum >= ubi->peb_count)
+			goto out;
+
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+		if (err < 0)
+			goto out;
+		if ((err && err != UBI_IO_BITFLIPS) ||
+		    be64_to_cpu(ech->ec) != be32_to_cpu(fmsb->block_ec[i])) {
+			ubi_err("bad EC header in fastmap PEB %d", pnum);
+			err = -EINVAL;
+			goto out;
+		}
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vh, 0);
+		if (err < 0)
+			goto out;
+		if ((err && err != UBI_IO_BITFLIPS) ||
+		    be32_to_cpu(vh->vol_id) != (i ? UBI_FM_DATA_VOLUME_ID :
+						     UBI_FM_SB_VOLUME_ID)) {
+			ubi_err("bad VID header in fastmap PEB %d", pnum);
+			err = -EINVAL;
+			goto out;
+		}
+
+		err = ubi_io_read_data(ubi, fm + i * ubi->leb_size, pnum, 0,
+				       ubi->leb_size);
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out;
+	}
+
+	fmsb2 = fm;
+	data_crc = be32_to_cpu(fmsb2->data_crc);
+	fmsb2->data_crc = 0;
+	crc = crc32(UBI_CRC32_INIT, fm, used_blocks * ubi->leb_size);
+	if (crc != data_crc) {
+		ubi_err("fastmap data CRC is invalid, calculated %#08x, "
+			"read %#08x", crc, data_crc);
+		err = -EINVAL;
+		goto out;
+	}
+	err = 0;
+
+out:
+	kfree(ech);
+	return err;
+}
+
+/**
+ * ubi_scan_fastmap - build scanning information from a fastmap.
+ * @ubi: UBI device description object
+ * @si: empty scanning information to fill
+ *
+ * This function returns zero if @si was filled from the fastmap,
+ * %UBI_NO_FASTMAP if there is no fastmap, %UBI_BAD_FASTMAP if it could not
+ * be used, and a negative error code on fatal errors. In the two former
+ * cases @si has to be thrown away and the device scanned in full.
+ */
+int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si)
+{
+	struct fm_attach fa;
+	struct ubi_vid_hdr *vh;
+	struct ubi_fm_sb *fmsb;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_scan_pool *fmpl;
+	int anchor, used_blocks, i, pnum, err;
+
+	memset(&fa, 0, sizeof(fa));
+	fa.si = si;
+
+	vh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	fmsb = kmalloc(sizeof(struct ubi_fm_sb), GFP_KERNEL);
+	fa.ec = kmalloc(ubi->peb_count * sizeof(int), GFP_KERNEL);
+	fa.state = kzalloc(ubi->peb_count, GFP_KERNEL);
+	fa.seen = kzalloc(ubi->peb_count, GFP_KERNEL);
+	err = -ENOMEM;
+	if (!vh || !fmsb || !fa.ec || !fa.state || !fa.seen)
+		goto out;
+
+	anchor = fm_find_anchor(ubi, vh);
+	if (anchor < 0) {
+		err = anchor == -ENOENT ? UBI_NO_FASTMAP : UBI_BAD_FASTMAP;
+		goto out;
+	}
+
+	dbg_bld("fastmap anchor at PEB %d", anchor);
+	err = ubi_io_read_data(ubi, fmsb, anchor, 0,
+			       sizeof(struct ubi_fm_sb));
+	if (err && err != UBI_IO_BITFLIPS)
+		goto bad;
+
+	used_blocks = be32_to_cpu(fmsb->used_blocks);
+	if (be32_to_cpu(fmsb->magic) != UBI_FM_SB_MAGIC ||
+	    fmsb->version != UBI_FM_FMT_VERSION ||
+	    used_blocks < 1 || used_blocks > UBI_FM_MAX_BLOCKS ||
+	    be32_to_cpu(fmsb->block_loc[0]) != anchor) {
+		ubi_err("bad fastmap super block at PEB %d", anchor);
+		goto bad;
+	}
+
+	fa.fm_size = used_blocks * ubi->leb_size;
+	fa.fm = vmalloc(fa.fm_size);
+	if (!fa.fm) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	err = fm_read_blocks(ubi, fmsb, fa.fm, vh);
+	if (err == -ENOMEM)
+		goto out;
+	if (err)
+		goto bad;
+
+	/* The fastmap PEBs are dropped, see the comment at the top */
+	for (i = 0; i < used_blocks; i++) {
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		err = fm_add_to_list(ubi, &fa, pnum,
+				     be32_to_cpu(fmsb->block_ec[i]), &si->corr);
+		if (err)
+			goto fail;
+	}
+
+	fm_get(&fa, sizeof(struct ubi_fm_sb));
+	fmhdr = fm_get(&fa, sizeof(struct ubi_fm_hdr));
+	if (!fmhdr || be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC) {
+		ubi_err("bad fastmap header");
+		goto bad;
+	}
+
+	/* The pools are scanned last, once all other PEBs are known */
+	fmpl = fm_get(&fa, 2 * sizeof(struct ubi_fm_scan_pool));
+	if (!fmpl)
+		goto bad;
+
+	si->is_empty = 0;
+	si->bad_peb_count = be32_to_cpu(fmhdr->bad_peb_count);
+	si->max_sqnum = be64_to_cpu(fmsb->sqnum);
+
+	err = fm_read_ec_list(ubi, &fa, be32_to_cpu(fmhdr->free_peb_count),
+			      &si->free, 0);
+	if (!err)
+		err = fm_read_ec_list(ubi, &fa,
+				      be32_to_cpu(fmhdr->used_peb_count),
+				      NULL, FM_PEB_USED);
+	if (!err)
+		err = fm_read_ec_list(ubi, &fa,
+				      be32_to_cpu(fmhdr->scrub_peb_count),
+				      NULL, FM_PEB_SCRUB);
+	if (!err)
+		err = fm_read_ec_list(ubi, &fa,
+				      be32_to_cpu(fmhdr->erase_peb_count),
+				      &si->erase, 0);
+	for (i = 0; !err && i < be32_to_cpu(fmhdr->vol_count); i++)
+		err = fm_read_volume(ubi, &fa, vh);
+	if (err)
+		goto fail;
+
+	fa.fm_pos = sizeof(struct ubi_fm_sb) + sizeof(struct ubi_fm_hdr);
+	for (i = 0; i < 2; i++) {
+		err = fm_scan_pool(ubi, &fa);
+		if (err)
+			goto fail;
+	}
+
+	if (fa.peb_count + si->bad_peb_count != ubi->peb_count) {
+		ubi_err("fastmap accounts for %d of %d PEBs",
+			fa.peb_count + si->bad_peb_count, ubi->peb_count);
+		goto bad;
+	}
+
+	ubi_msg("attached by fastmap at PEB %d", anchor);
+	err = 0;
+	goto out;
+
+fail:
+	if (err == -ENOMEM)
+		goto out;
+bad:
+	ubi_warn("fastmap is unusable, falling back to full scan");
+	err = UBI_BAD_FASTMAP;
+out:
+	vfree(fa.fm);
+	kfree(fa.seen);
+	kfree(fa.state);
+	kfree(fa.ec);
+	kfree(fmsb);
+	ubi_free_vid_hdr(ubi, vh);
+	return err;
+}
@@ -746,7 +746,7 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
 }
 
 /**
- * process_eb - read UBI headers, check them and add corresponding data
+ * ubi_scan_process_eb - read UBI headers, check them and add corresponding data
  * to the scanning information.
  * @ubi: UBI device description object
  * @si: scanning information
@@ -755,7 +755,8 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
  * This function returns a zero if the physical eraseblock was successfully
  * handled and a negative error code in case of failure.
  */
-static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum)
+int ubi_scan_process_eb(struct ubi_device *ubi, struct ubi_scan_info *si,
+			int pnum)
 {
 	long long uninitialized_var(ec);
 	int err, bitflips = 0, vol_id, ec_corr = 0;
@@ -896,32 +897,63 @@ adjust_mean_ec:
 	return 0;
 }
 
+static struct ubi_scan_info *alloc_si(void)
+{
+	struct ubi_scan_info *si;
+
+	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	if (!si)
+		return NULL;
+
+	INIT_LIST_HEAD(&si->corr);
+	INIT_LIST_HEAD(&si->free);
+	INIT_LIST_HEAD(&si->erase);
+	INIT_LIST_HEAD(&si->alien);
+	si->volumes = RB_ROOT;
+	si->is_empty = 1;
+
+	return si;
+}
+
+static int scan_all(struct ubi_device *ubi, struct ubi_scan_info *si)
+{
+	int err, pnum;
+
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		cond_resched();
+
+		dbg_msg("process PEB %d", pnum);
+		err = ubi_scan_process_eb(ubi, si, pnum);
+		if (err < 0)
+			return err;
+	}
+
+	dbg_msg("scanning is finished");
+	return 0;
+}
+
 /**
  * ubi_scan - scan an MTD device.
  * @ubi: UBI device description object
  *
  * This function does full scanning of an MTD device and returns complete
  * information about it. In case of failure, an error code is returned.
+ *
+ * With %CONFIG_MTD_UBI_FASTMAP, the information is taken from the fastmap
+ * when there is a valid one, and only the fastmap pool PEBs are scanned.
  */
 struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 {
-	int err, pnum;
+	int err;
 	struct rb_node *rb1, *rb2;
 	struct ubi_scan_volume *sv;
 	struct ubi_scan_leb *seb;
 	struct ubi_scan_info *si;
 
-	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	si = alloc_si();
 	if (!si)
 		return ERR_PTR(-ENOMEM);
 
-	INIT_LIST_HEAD(&si->corr);
-	INIT_LIST_HEAD(&si->free);
-	INIT_LIST_HEAD(&si->erase);
-	INIT_LIST_HEAD(&si->alien);
-	si->volumes = RB_ROOT;
-	si->is_empty = 1;
-
 	err = -ENOMEM;
 	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
 	if (!ech)
@@ -931,16 +963,23 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
-
-		dbg_msg("process PEB %d", pnum);
-		err = process_eb(ubi, si, pnum);
-		if (err < 0)
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	err = ubi_scan_fastmap(ubi, si);
+	if (err > 0) {
+		/* Start over from scratch */
+		ubi_scan_destroy_si(si);
+		si = alloc_si();
+		if (!si) {
+			err = -ENOMEM;
 			goto out_vidh;
+		}
+		err = scan_all(ubi, si);
 	}
-
-	dbg_msg("scanning is finished");
+#else
+	err = scan_all(ubi, si);
+#endif
+	if (err < 0)
+		goto out_vidh;
 
 	/* Calculate mean erase counter */
 	if (si->ec_count) {
@@ -991,7 +1030,8 @@ out_vidh:
 out_ech:
 	kfree(ech);
 out_si:
-	ubi_scan_destroy_si(si);
+	if (si)
+		ubi_scan_destroy_si(si);
 	return ERR_PTR(err);
 }
 
@@ -159,7 +159,17 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
 					   struct ubi_scan_info *si);
 int ubi_scan_erase_peb(struct ubi_device *ubi, const struct ubi_scan_info *si,
 		       int pnum, int ec);
+int ubi_scan_process_eb(struct ubi_device *ubi, struct ubi_scan_info *si,
+			int pnum);
 struct ubi_scan_info *ubi_scan(struct ubi_device *ubi);
 void ubi_scan_destroy_si(struct ubi_scan_info *si);
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+/* ubi_scan_fastmap() return codes asking for a full scan */
+#define UBI_NO_FASTMAP	1
+#define UBI_BAD_FASTMAP	2
+
+int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si);
+#endif
+
 #endif /* !__UBI_SCAN_H__ */
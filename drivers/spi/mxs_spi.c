@@ -26,6 +26,7 @@
 #include <common.h>
 #include <malloc.h>
 #include <spi.h>
+#include <bouncebuf.h>
 #include <asm/errno.h>
 #include <asm/io.h>
 #include <asm/arch/clock.h>
@@ -39,17 +40,23 @@
 #define MXS_SSP_CHIPSELECT_SHIFT	20
 
 #define MXSSSP_SMALL_TRANSFER	512
+#define MXSSSP_BOUNCE_CHUNK	0x10000
 
 /*
- * CONFIG_MXS_SPI_DMA_ENABLE: Experimental mixed PIO/DMA support for MXS SPI
- *                            host. Use with utmost caution!
+ * CONFIG_MXS_SPI_DMA_ENABLE: Mixed PIO/DMA support for MXS SPI host.
  *
- *                            Enabling this is not yet recommended since this
- *                            still doesn't support transfers to/from unaligned
- *                            addresses. Therefore this driver will not work
- *                            for example with saving environment. This is
- *                            caused by DMA alignment constraints on MXS.
+ *                            Transfers of MXSSSP_SMALL_TRANSFER bytes and
+ *                            more go through the APBH DMA. Unaligned buffers
+ *                            are bounced through an aligned one, so this
+ *                            needs CONFIG_BOUNCE_BUFFER. The bounce is done
+ *                            MXSSSP_BOUNCE_CHUNK bytes at a time, so large
+ *                            reads do not need a malloc() area as big as
+ *                            themselves. If even that cannot be allocated,
+ *                            the piece is done by PIO.
  */
+#if defined(CONFIG_MXS_SPI_DMA_ENABLE) && !defined(CONFIG_BOUNCE_BUFFER)
+#error "CONFIG_MXS_SPI_DMA_ENABLE needs CONFIG_BOUNCE_BUFFER"
+#endif
 
 struct mxs_spi_slave {
 	struct spi_slave	slave;
@@ -212,24 +219,30 @@ static int mxs_spi_xfer_pio(struct mxs_spi_slave *slave,
 	return 0;
 }
 
-static int mxs_spi_xfer_dma(struct mxs_spi_slave *slave,
+static int mxs_spi_xfer_dma_buf(struct mxs_spi_slave *slave,
 			char *data, int length, int write, unsigned long flags)
 {
 	const int xfer_max_sz = 0xff00;
 	const int desc_count = DIV_ROUND_UP(length, xfer_max_sz) + 1;
 	struct mxs_ssp_regs *ssp_regs = slave->regs;
 	struct mxs_dma_desc *dp;
+	struct bounce_buffer bbstate;
 	uint32_t ctrl0;
-	uint32_t cache_data_count;
-	const uint32_t dstart = (uint32_t)data;
 	int dmach;
 	int tl;
-	int ret = 0;
+	int ret;
 
 	ALLOC_CACHE_ALIGN_BUFFER(struct mxs_dma_desc, desc, desc_count);
 
 	memset(desc, 0, sizeof(struct mxs_dma_desc) * desc_count);
 
+	/* Cache maintenance, and an aligned copy if data is unaligned */
+	ret = bounce_buffer_start(&bbstate, data, length,
+				  write ? GEN_BB_READ : GEN_BB_WRITE);
+	if (ret)
+		return ret;
+	data = bbstate.bounce_buffer;
+
 	ctrl0 = readl(&ssp_regs->hw_ssp_ctrl0);
 	ctrl0 |= SSP_CTRL0_DATA_XFER;
 
@@ -238,18 +251,6 @@ static int mxs_spi_xfer_dma(struct mxs_spi_slave *slave,
 	if (!write)
 		ctrl0 |= SSP_CTRL0_READ;
 
-	if (length % ARCH_DMA_MINALIGN)
-		cache_data_count = roundup(length, ARCH_DMA_MINALIGN);
-	else
-		cache_data_count = length;
-
-	/* Flush data to DRAM so DMA can pick them up */
-	if (write)
-		flush_dcache_range(dstart, dstart + cache_data_count);
-
-	/* Invalidate the area, so no writeback into the RAM races with DMA */
-	invalidate_dcache_range(dstart, dstart + cache_data_count);
-
 	dmach = MXS_DMA_CHANNEL_AHB_APBH_SSP0 + slave->slave.bus;
 
 	dp = desc;
@@ -316,13 +317,51 @@ static int mxs_spi_xfer_dma(struct mxs_spi_slave *slave,
 	if (mxs_dma_go(dmach))
 		ret = -EINVAL;
 
-	/* The data arrived into DRAM, invalidate cache over them */
-	if (!write)
-		invalidate_dcache_range(dstart, dstart + cache_data_count);
+	bounce_buffer_stop(&bbstate);
 
 	return ret;
 }
 
+static int mxs_spi_xfer_dma(struct mxs_spi_slave *slave,
+			char *data, int length, int write, unsigned long flags)
+{
+	struct mxs_ssp_regs *ssp_regs = slave->regs;
+	unsigned long chunk_flags;
+	int aligned;
+	int chunk;
+	int ret;
+
+	aligned = !((ulong)data & (ARCH_DMA_MINALIGN - 1)) &&
+		  !(length & (ARCH_DMA_MINALIGN - 1));
+
+	/* Keep the chip select asserted from one piece to the next */
+	while (length) {
+		chunk = aligned ? length : min(length, MXSSSP_BOUNCE_CHUNK);
+		chunk_flags = flags;
+		if (chunk < length)
+			chunk_flags &= ~SPI_XFER_END;
+
+		ret = mxs_spi_xfer_dma_buf(slave, data, chunk, write,
+					   chunk_flags);
+		if (ret == -ENOMEM) {
+			writel(SSP_CTRL1_DMA_ENABLE,
+			       &ssp_regs->hw_ssp_ctrl1_clr);
+			ret = mxs_spi_xfer_pio(slave, data, chunk, write,
+					       chunk_flags);
+			writel(SSP_CTRL1_DMA_ENABLE,
+			       &ssp_regs->hw_ssp_ctrl1_set);
+		}
+		if (ret)
+			return ret;
+
+		flags &= ~SPI_XFER_BEGIN;
+		data += chunk;
+		length -= chunk;
+	}
+
+	return 0;
+}
+
 int spi_xfer(struct spi_slave *slave, unsigned int bitlen,
 		const void *dout, void *din, unsigned long flags)
 {
@@ -362,18 +401,7 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen,
 		write = 0;
 	}
 
-	/*
-	 * Check for alignment, if the buffer is aligned, do DMA transfer,
-	 * PIO otherwise. This is a temporary workaround until proper bounce
-	 * buffer is in place.
-	 */
-	if (dma) {
-		if (((uint32_t)data) & (ARCH_DMA_MINALIGN - 1))
-			dma = 0;
-		if (((uint32_t)len) & (ARCH_DMA_MINALIGN - 1))
-			dma = 0;
-	}
-
+	/* Short transfers are cheaper to do by PIO than to set up */
 	if (!dma || (len < MXSSSP_SMALL_TRANSFER)) {
 		writel(SSP_CTRL1_DMA_ENABLE, &ssp_regs->hw_ssp_ctrl1_clr);
 		return mxs_spi_xfer_pio(mxs_slave, data, len, write, flags);
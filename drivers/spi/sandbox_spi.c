@@ -0,0 +1,104 @@
+/*
+ * Sandbox SPI controller, with the simulated SPI flash on bus 0, cs 0
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <spi.h>
+#include <asm/spi.h>
+
+struct sandbox_spi_slave {
+	struct spi_slave slave;
+	unsigned int mode;
+};
+
+static inline struct sandbox_spi_slave *to_sandbox_spi(struct spi_slave *slave)
+{
+	return container_of(slave, struct sandbox_spi_slave, slave);
+}
+
+void spi_init(void)
+{
+}
+
+int spi_cs_is_valid(unsigned int bus, unsigned int cs)
+{
+	return bus == 0 && cs == 0;
+}
+
+struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
+		unsigned int max_hz, unsigned int mode)
+{
+	struct sandbox_spi_slave *ss;
+
+	if (!spi_cs_is_valid(bus, cs)) {
+		debug("%s: no slave at %u:%u\n", __func__, bus, cs);
+		return NULL;
+	}
+	if (sandbox_sf_attach()) {
+		printf("SPI: no flash, start with --spi_sf <file>\n");
+		return NULL;
+	}
+
+	ss = malloc(sizeof(struct sandbox_spi_slave));
+	if (!ss)
+		return NULL;
+
+	ss->slave.bus = bus;
+	ss->slave.cs = cs;
+	ss->mode = mode;
+
+	return &ss->slave;
+}
+
+void spi_free_slave(struct spi_slave *slave)
+{
+	free(to_sandbox_spi(slave));
+}
+
+int spi_claim_bus(struct spi_slave *slave)
+{
+	return 0;
+}
+
+void spi_release_bus(struct spi_slave *slave)
+{
+}
+
+int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
+		void *din, unsigned long flags)
+{
+	struct sandbox_spi_slave *ss = to_sandbox_spi(slave);
+	unsigned int need = 0;
+
+	/* Only use the extra lines the slave was set up for */
+	if (flags & SPI_XFER_QUAD)
+		need = (dout ? SPI_TX_QUAD : 0) | (din ? SPI_RX_QUAD : 0);
+	else if (flags & SPI_XFER_DUAL)
+		need = (dout ? SPI_TX_DUAL : 0) | (din ? SPI_RX_DUAL : 0);
+	if ((ss->mode & need) != need || (dout && din && need)) {
+		debug("%s: mode %x cannot do flags %lx\n", __func__, ss->mode,
+		      flags);
+		return -1;
+	}
+
+	return sandbox_sf_xfer(bitlen, dout, din, flags);
+}
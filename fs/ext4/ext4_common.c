@@ -1517,7 +1517,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_EXT2_BLOCK_SIZE(ext4fs_root);
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		char *buf = zalloc(blksz);
+		char *buf = zalloc_tmp(blksz);
 		if (!buf)
 			return -ENOMEM;
 		struct ext4_extent_header *ext_block;
@@ -1530,7 +1530,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 						    fileblock, log2_blksz);
 		if (!ext_block) {
 			printf("invalid extent block\n");
-			free(buf);
+			arena_free(buf);
 			return -EINVAL;
 		}
 
@@ -1544,19 +1544,19 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 		if (--i >= 0) {
 			fileblock -= le32_to_cpu(extent[i].ee_block);
 			if (fileblock >= le32_to_cpu(extent[i].ee_len)) {
-				free(buf);
+				arena_free(buf);
 				return 0;
 			}
 
 			start = le32_to_cpu(extent[i].ee_start_hi);
 			start = (start << 32) +
 					le32_to_cpu(extent[i].ee_start_lo);
-			free(buf);
+			arena_free(buf);
 			return fileblock + start;
 		}
 
 		printf("Extent Error\n");
-		free(buf);
+		arena_free(buf);
 		return -1;
 	}
 
@@ -2166,7 +2166,11 @@ int ext4fs_open(const char *filename)
 	if (ext4fs_root == NULL)
 		return -1;
 
-	ext4fs_file = NULL;
+	/* Drop any file left open by a previous ext4fs_open() */
+	if (ext4fs_file != NULL) {
+		ext4fs_free_node(ext4fs_file, &ext4fs_root->diropen);
+		ext4fs_file = NULL;
+	}
 	status = ext4fs_find_file(filename, &ext4fs_root->diropen, &fdiro,
 				  FILETYPE_REG);
 	if (status == 0)
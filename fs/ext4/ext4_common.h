@@ -33,6 +33,7 @@
 
 #ifndef __EXT4_COMMON__
 #define __EXT4_COMMON__
+#include <arena.h>
 #include <ext_common.h>
 #include <ext4fs.h>
 #include <malloc.h>
@@ -62,6 +63,16 @@ static inline void *zalloc(size_t size)
 	return p;
 }
 
+/* For a buffer freed again, with arena_free(), before the command ends */
+static inline void *zalloc_tmp(size_t size)
+{
+	void *p = arena_memalign(ARCH_DMA_MINALIGN, size);
+
+	if (p)
+		memset(p, 0, size);
+	return p;
+}
+
 int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
 int ext4fs_read_file(struct ext2fs_node *node, int pos,
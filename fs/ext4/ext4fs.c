@@ -79,8 +79,10 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 	short status;
 
 	/* Adjust len so it we can't read past the end of the file. */
-	if (len > filesize)
-		len = filesize;
+	if (pos >= filesize)
+		return 0;
+	if (len > filesize - pos)
+		len = filesize - pos;
 
 	blockcnt = ((len + pos) + blocksize - 1) / blocksize;
 
@@ -190,11 +192,16 @@ int ext4fs_ls(const char *dirname)
 }
 
 int ext4fs_read(char *buf, unsigned len)
+{
+	return ext4fs_read_at(buf, 0, len);
+}
+
+int ext4fs_read_at(char *buf, unsigned pos, unsigned len)
 {
 	if (ext4fs_root == NULL || ext4fs_file == NULL)
 		return 0;
 
-	return ext4fs_read_file(ext4fs_file, 0, len, buf);
+	return ext4fs_read_file(ext4fs_file, pos, len, buf);
 }
 
 #if defined(CONFIG_EXT4_WRITE)
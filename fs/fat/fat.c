@@ -54,6 +54,21 @@ static void downcase(char *str)
 
 static block_dev_desc_t *cur_dev;
 static disk_partition_t cur_part_info;
+static ulong cur_scan_count;	/* part_scan_count() when cur_dev was set */
+
+/*
+ * Directory entry of the last file looked up on the current volume, so that
+ * repeated reads of the same file (e.g. chunked reads through fs_read_at())
+ * do not walk the directory tree every time.
+ */
+static char fat_dent_cache_name[256];
+static dir_entry fat_dent_cache;
+static int fat_dent_cache_valid;
+
+static void fat_dent_cache_invalidate(void)
+{
+	fat_dent_cache_valid = 0;
+}
 
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
@@ -72,8 +87,14 @@ int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
 
+	/* Another volume, or the device was rescanned and may hold one */
+	if (cur_dev != dev_desc || cur_part_info.start != info->start ||
+	    cur_scan_count != part_scan_count())
+		fat_dent_cache_invalidate();
+
 	cur_dev = dev_desc;
 	cur_part_info = *info;
+	cur_scan_count = part_scan_count();
 
 	/* Make sure it has a valid FAT header */
 	if (disk_read(0, 1, buffer) != 1) {
@@ -909,6 +930,12 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	strcpy(fnamecopy, filename);
 	downcase(fnamecopy);
 
+	if (!dols && fat_dent_cache_valid &&
+	    !strcmp(fnamecopy, fat_dent_cache_name)) {
+		dentptr = &fat_dent_cache;
+		goto found;
+	}
+
 	if (*fnamecopy == '\0') {
 		if (!dols)
 			goto exit;
@@ -1168,6 +1195,20 @@ rootdir_done:
 			subname = nextname;
 	}
 
+	if (!dols && strlen(filename) < sizeof(fat_dent_cache_name)) {
+		strcpy(fat_dent_cache_name, filename);
+		downcase(fat_dent_cache_name);
+		fat_dent_cache = *dentptr;
+		fat_dent_cache_valid = 1;
+	}
+
+found:
+	/* A NULL buffer only asks for the file size */
+	if (buffer == NULL) {
+		ret = FAT2CPU32(dentptr->size);
+		goto exit;
+	}
+
 	ret = get_contents(mydata, dentptr, pos, buffer, maxsize);
 	debug("Size: %d, got: %ld\n", FAT2CPU32(dentptr->size), ret);
 
@@ -1256,6 +1297,11 @@ long file_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	return do_fat_read_at(filename, pos, buffer, maxsize, LS_NO);
 }
 
+long file_fat_size(const char *filename)
+{
+	return do_fat_read_at(filename, 0, NULL, 0, LS_NO);
+}
+
 long file_fat_read(const char *filename, void *buffer, unsigned long maxsize)
 {
 	return file_fat_read_at(filename, 0, buffer, maxsize);
@@ -1090,5 +1090,6 @@ exit:
 int file_fat_write(const char *filename, void *buffer, unsigned long maxsize)
 {
 	printf("writing %s\n", filename);
+	fat_dent_cache_invalidate();
 	return do_fat_write(filename, buffer, maxsize);
 }
@@ -20,12 +20,26 @@
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <malloc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 static block_dev_desc_t *fs_dev_desc;
 static disk_partition_t fs_partition;
 static int fs_type = FS_TYPE_ANY;
+static ulong fs_scan_count;	/* part_scan_count() at mount time */
+
+/*
+ * An open file is just its path and size; the filesystem drivers cache
+ * the result of the last lookup, so repeated reads of one file do not walk
+ * the directory tree again.
+ */
+struct fs_file {
+	char *name;
+	int size;
+};
+
+static struct fs_file fs_files[FS_MAX_FILES];
 
 static inline int fs_ls_unsupported(const char *dirname)
 {
@@ -33,53 +47,84 @@ static inline int fs_ls_unsupported(const char *dirname)
 	return -1;
 }
 
-static inline int fs_read_unsupported(const char *filename, ulong addr,
-				      int offset, int len)
+static inline int fs_open_unsupported(struct fs_file *file)
 {
 	printf("** Unrecognized filesystem type **\n");
 	return -1;
 }
 
+static inline int fs_read_at_unsupported(struct fs_file *file, ulong addr,
+					 int offset, int len)
+{
+	printf("** Unrecognized filesystem type **\n");
+	return -1;
+}
+
+static inline void fs_release_unsupported(struct fs_file *file)
+{
+}
+
 #ifdef CONFIG_FS_FAT
 static int fs_probe_fat(void)
 {
 	return fat_set_blk_dev(fs_dev_desc, &fs_partition);
 }
 
+/*
+ * FAT keeps no mount state beyond the device, so just point it back at
+ * our partition in case someone else (e.g. env_fat) has moved it.
+ */
+#define fs_revalidate_fat fs_probe_fat
+
 static void fs_close_fat(void)
 {
 }
 
 #define fs_ls_fat file_fat_ls
 
-static int fs_read_fat(const char *filename, ulong addr, int offset, int len)
+static int fs_open_fat(struct fs_file *file)
+{
+	return file_fat_size(file->name);
+}
+
+static int fs_read_at_fat(struct fs_file *file, ulong addr, int offset,
+			  int len)
 {
 	int len_read;
 
-	len_read = file_fat_read_at(filename, offset,
+	len_read = file_fat_read_at(file->name, offset,
 				    (unsigned char *)addr, len);
 	if (len_read == -1) {
-		printf("** Unable to read file %s **\n", filename);
+		printf("** Unable to read file %s **\n", file->name);
 		return -1;
 	}
 
 	return len_read;
 }
+
+#define fs_release_fat fs_release_unsupported
 #else
 static inline int fs_probe_fat(void)
 {
 	return -1;
 }
 
+#define fs_revalidate_fat fs_probe_fat
+
 static inline void fs_close_fat(void)
 {
 }
 
 #define fs_ls_fat fs_ls_unsupported
-#define fs_read_fat fs_read_unsupported
+#define fs_open_fat fs_open_unsupported
+#define fs_read_at_fat fs_read_at_unsupported
+#define fs_release_fat fs_release_unsupported
 #endif
 
 #ifdef CONFIG_FS_EXT4
+/* File whose node ext4fs_open() last left in ext4fs_file */
+static struct fs_file *fs_ext_file;
+
 static int fs_probe_ext(void)
 {
 	ext4fs_set_blk_dev(fs_dev_desc, &fs_partition);
@@ -92,89 +137,188 @@ static int fs_probe_ext(void)
 	return 0;
 }
 
+static int fs_revalidate_ext(void)
+{
+	if (ext4fs_root == NULL || get_fs()->dev_desc != fs_dev_desc)
+		return -1;
+
+	return 0;
+}
+
 static void fs_close_ext(void)
 {
+	fs_ext_file = NULL;
 	ext4fs_close();
 }
 
 #define fs_ls_ext ext4fs_ls
 
-static int fs_read_ext(const char *filename, ulong addr, int offset, int len)
+static int fs_open_ext(struct fs_file *file)
 {
 	int file_len;
-	int len_read;
 
-	if (offset != 0) {
-		printf("** Cannot support non-zero offset **\n");
-		return -1;
-	}
+	fs_ext_file = NULL;
+	file_len = ext4fs_open(file->name);
+	if (file_len >= 0)
+		fs_ext_file = file;
 
-	file_len = ext4fs_open(filename);
-	if (file_len < 0) {
-		printf("** File not found %s **\n", filename);
-		ext4fs_close();
-		return -1;
-	}
+	return file_len;
+}
 
-	if (len == 0)
-		len = file_len;
+static int fs_read_at_ext(struct fs_file *file, ulong addr, int offset,
+			  int len)
+{
+	int len_read;
 
-	len_read = ext4fs_read((char *)addr, len);
-	ext4fs_close();
+	if (fs_ext_file != file && fs_open_ext(file) < 0) {
+		printf("** File not found %s **\n", file->name);
+		return -1;
+	}
 
-	if (len_read != len) {
-		printf("** Unable to read file %s **\n", filename);
+	len_read = ext4fs_read_at((char *)addr, offset, len);
+	if (len_read < 0) {
+		printf("** Unable to read file %s **\n", file->name);
 		return -1;
 	}
 
 	return len_read;
 }
+
+static void fs_release_ext(struct fs_file *file)
+{
+	if (fs_ext_file == file)
+		fs_ext_file = NULL;
+}
 #else
 static inline int fs_probe_ext(void)
 {
 	return -1;
 }
 
+#define fs_revalidate_ext fs_probe_ext
+
 static inline void fs_close_ext(void)
 {
 }
 
 #define fs_ls_ext fs_ls_unsupported
-#define fs_read_ext fs_read_unsupported
+#define fs_open_ext fs_open_unsupported
+#define fs_read_at_ext fs_read_at_unsupported
+#define fs_release_ext fs_release_unsupported
 #endif
 
-static struct {
+static struct fstype_info {
 	int fstype;
 	int (*probe)(void);
+	int (*revalidate)(void);
+	void (*close)(void);
+	int (*ls)(const char *dirname);
+	int (*open)(struct fs_file *file);
+	int (*read_at)(struct fs_file *file, ulong addr, int offset, int len);
+	void (*release)(struct fs_file *file);
 } fstypes[] = {
 	{
 		.fstype = FS_TYPE_FAT,
 		.probe = fs_probe_fat,
+		.revalidate = fs_revalidate_fat,
+		.close = fs_close_fat,
+		.ls = fs_ls_fat,
+		.open = fs_open_fat,
+		.read_at = fs_read_at_fat,
+		.release = fs_release_fat,
 	},
 	{
 		.fstype = FS_TYPE_EXT,
 		.probe = fs_probe_ext,
+		.revalidate = fs_revalidate_ext,
+		.close = fs_close_ext,
+		.ls = fs_ls_ext,
+		.open = fs_open_ext,
+		.read_at = fs_read_at_ext,
+		.release = fs_release_ext,
 	},
 };
 
+static struct fstype_info *fs_get_info(int fstype)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fstypes); i++) {
+		if (fstypes[i].fstype == fstype)
+			return &fstypes[i];
+	}
+
+	return NULL;
+}
+
+static struct fs_file *fs_get_file(int fd)
+{
+	if (fd < 0 || fd >= FS_MAX_FILES || !fs_files[fd].name)
+		return NULL;
+
+	return &fs_files[fd];
+}
+
+void fs_unmount(void)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	int fd;
+
+	for (fd = 0; fd < FS_MAX_FILES; fd++)
+		fs_close(fd);
+
+	if (info)
+		info->close();
+
+	fs_type = FS_TYPE_ANY;
+}
+
 int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 {
+	block_dev_desc_t *dev_desc;
+	disk_partition_t partition;
+	struct fstype_info *info;
 	int part, i;
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	static int relocated;
 
 	if (!relocated) {
-		for (i = 0; i < ARRAY_SIZE(fstypes); i++)
+		for (i = 0; i < ARRAY_SIZE(fstypes); i++) {
 			fstypes[i].probe += gd->reloc_off;
+			fstypes[i].revalidate += gd->reloc_off;
+			fstypes[i].close += gd->reloc_off;
+			fstypes[i].ls += gd->reloc_off;
+			fstypes[i].open += gd->reloc_off;
+			fstypes[i].read_at += gd->reloc_off;
+			fstypes[i].release += gd->reloc_off;
+		}
 		relocated = 1;
 	}
 #endif
 
-	part = get_device_and_partition(ifname, dev_part_str, &fs_dev_desc,
-					&fs_partition, 1);
+	part = get_device_and_partition(ifname, dev_part_str, &dev_desc,
+					&partition, 1);
 	if (part < 0)
 		return -1;
 
+	/*
+	 * Reuse the current mount if it is the same partition, and no device
+	 * was rescanned since (the card may have been swapped)
+	 */
+	info = fs_get_info(fs_type);
+	if (info && dev_desc == fs_dev_desc &&
+	    fs_scan_count == part_scan_count() &&
+	    partition.start == fs_partition.start &&
+	    partition.size == fs_partition.size &&
+	    (fstype == FS_TYPE_ANY || fstype == fs_type) &&
+	    !info->revalidate())
+		return 0;
+
+	fs_unmount();
+	fs_dev_desc = dev_desc;
+	fs_partition = partition;
+	fs_scan_count = part_scan_count();
+
 	for (i = 0; i < ARRAY_SIZE(fstypes); i++) {
 		if ((fstype != FS_TYPE_ANY) && (fstype != fstypes[i].fstype))
 			continue;
@@ -189,62 +333,110 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	return -1;
 }
 
-static void fs_close(void)
+int fs_ls(const char *dirname)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+
+	if (!info)
+		return fs_ls_unsupported(dirname);
+
+	return info->ls(dirname);
+}
+
+int fs_open(const char *filename)
 {
-	switch (fs_type) {
-	case FS_TYPE_FAT:
-		fs_close_fat();
-		break;
-	case FS_TYPE_EXT:
-		fs_close_ext();
-		break;
-	default:
-		break;
+	struct fstype_info *info = fs_get_info(fs_type);
+	struct fs_file *file = NULL;
+	int fd;
+
+	if (!info)
+		return fs_open_unsupported(NULL);
+
+	for (fd = 0; fd < FS_MAX_FILES; fd++) {
+		if (!fs_files[fd].name) {
+			file = &fs_files[fd];
+			break;
+		}
+	}
+	if (!file) {
+		printf("** Too many open files **\n");
+		return -1;
 	}
 
-	fs_type = FS_TYPE_ANY;
+	file->name = strdup(filename);
+	if (!file->name)
+		return -1;
+
+	file->size = info->open(file);
+	if (file->size < 0) {
+		printf("** File not found %s **\n", filename);
+		fs_close(fd);
+		return -1;
+	}
+
+	return fd;
 }
 
-int fs_ls(const char *dirname)
+int fs_size(int fd)
 {
-	int ret;
-
-	switch (fs_type) {
-	case FS_TYPE_FAT:
-		ret = fs_ls_fat(dirname);
-		break;
-	case FS_TYPE_EXT:
-		ret = fs_ls_ext(dirname);
-		break;
-	default:
-		ret = fs_ls_unsupported(dirname);
-		break;
+	struct fs_file *file = fs_get_file(fd);
+
+	if (!file)
+		return -1;
+
+	return file->size;
+}
+
+int fs_read_at(int fd, ulong addr, int offset, int len)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	struct fs_file *file = fs_get_file(fd);
+
+	if (!file || !info)
+		return -1;
+
+	if (offset < 0 || offset > file->size) {
+		printf("** Offset %d beyond end of file %s **\n", offset,
+		       file->name);
+		return -1;
 	}
 
-	fs_close();
+	if (len == 0 || len > file->size - offset)
+		len = file->size - offset;
+	if (len == 0)
+		return 0;
+
+	return info->read_at(file, addr, offset, len);
+}
+
+void fs_close(int fd)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	struct fs_file *file = fs_get_file(fd);
+
+	if (!file)
+		return;
+
+	if (info)
+		info->release(file);
 
-	return ret;
+	free(file->name);
+	file->name = NULL;
 }
 
 int fs_read(const char *filename, ulong addr, int offset, int len)
 {
-	int ret;
-
-	switch (fs_type) {
-	case FS_TYPE_FAT:
-		ret = fs_read_fat(filename, addr, offset, len);
-		break;
-	case FS_TYPE_EXT:
-		ret = fs_read_ext(filename, addr, offset, len);
-		break;
-	default:
-		ret = fs_read_unsupported(filename, addr, offset, len);
-		break;
-	}
+	int fd;
+	int len_read;
 
-	fs_close();
+	fd = fs_open(filename);
+	if (fd < 0)
+		return -1;
+
+	len_read = fs_read_at(fd, addr, offset, len);
+	fs_close(fd);
 
-	return ret;
+	return len_read;
 }
 
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
@@ -314,6 +506,88 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+#if defined(CONFIG_FIT)
+static int fs_read_fit(void *priv, void *dst, ulong offset, ulong len)
+{
+	int fd = *(int *)priv;
+
+	if (fs_read_at(fd, (ulong)dst, offset, len) != len) {
+		printf("** Unable to read %lu bytes at offset %lu **\n", len,
+		       offset);
+		return -1;
+	}
+
+	return 0;
+}
+
+int do_load_fit(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
+		int fstype)
+{
+	unsigned long addr;
+	const char *addr_str;
+	const char *filename;
+	const char *conf_uname;
+	ulong loaded;
+	int fd, size, ret;
+	char buf[12];
+	unsigned long time;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (argc > 6)
+		return CMD_RET_USAGE;
+
+	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype))
+		return 1;
+
+	if (argc >= 4) {
+		addr = simple_strtoul(argv[3], NULL, 16);
+	} else {
+		addr_str = getenv("loadaddr");
+		if (addr_str != NULL)
+			addr = simple_strtoul(addr_str, NULL, 16);
+		else
+			addr = CONFIG_SYS_LOAD_ADDR;
+	}
+	if (argc >= 5) {
+		filename = argv[4];
+	} else {
+		filename = getenv("bootfile");
+		if (!filename) {
+			puts("** No boot file defined **\n");
+			return 1;
+		}
+	}
+	conf_uname = (argc >= 6) ? argv[5] : NULL;
+
+	fd = fs_open(filename);
+	if (fd < 0)
+		return 1;
+
+	size = fs_size(fd);
+	time = get_timer(0);
+	ret = fit_load_conf((void *)addr, conf_uname, fs_read_fit, &fd, size,
+			    &loaded);
+	time = get_timer(time);
+	fs_close(fd);
+	if (ret < 0)
+		return 1;
+
+	printf("%lu of %d bytes read in %lu ms", loaded, size, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(loaded / time * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	sprintf(buf, "0x%x", size);
+	setenv("filesize", buf);
+
+	return 0;
+}
+#endif
+
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	int fstype)
 {
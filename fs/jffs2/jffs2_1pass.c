@@ -113,6 +113,7 @@
 
 #include <common.h>
 #include <config.h>
+#include <arena.h>
 #include <malloc.h>
 #include <linux/stat.h>
 #include <linux/time.h>
@@ -214,7 +215,7 @@ static int read_nand_cached(u32 off, u32 size, u_char *buf)
 
 static void *get_fl_mem_nand(u32 off, u32 size, void *ext_buf)
 {
-	u_char *buf = ext_buf ? (u_char*)ext_buf : (u_char*)malloc(size);
+	u_char *buf = ext_buf ? ext_buf : arena_alloc(size);
 
 	if (NULL == buf) {
 		printf("get_fl_mem_nand: can't alloc %d bytes\n", size);
@@ -222,7 +223,7 @@ static void *get_fl_mem_nand(u32 off, u32 size, void *ext_buf)
 	}
 	if (read_nand_cached(off, size, buf) < 0) {
 		if (!ext_buf)
-			free(buf);
+			arena_free(buf);
 		return NULL;
 	}
 
@@ -248,7 +249,7 @@ static void *get_node_mem_nand(u32 off, void *ext_buf)
 
 static void put_fl_mem_nand(void *buf)
 {
-	free(buf);
+	arena_free(buf);
 }
 #endif
 
@@ -313,7 +314,7 @@ static int read_onenand_cached(u32 off, u32 size, u_char *buf)
 
 static void *get_fl_mem_onenand(u32 off, u32 size, void *ext_buf)
 {
-	u_char *buf = ext_buf ? (u_char *)ext_buf : (u_char *)malloc(size);
+	u_char *buf = ext_buf ? ext_buf : arena_alloc(size);
 
 	if (NULL == buf) {
 		printf("get_fl_mem_onenand: can't alloc %d bytes\n", size);
@@ -321,7 +322,7 @@ static void *get_fl_mem_onenand(u32 off, u32 size, void *ext_buf)
 	}
 	if (read_onenand_cached(off, size, buf) < 0) {
 		if (!ext_buf)
-			free(buf);
+			arena_free(buf);
 		return NULL;
 	}
 
@@ -349,7 +350,7 @@ static void *get_node_mem_onenand(u32 off, void *ext_buf)
 
 static void put_fl_mem_onenand(void *buf)
 {
-	free(buf);
+	arena_free(buf);
 }
 #endif
 
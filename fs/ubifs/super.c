@@ -393,9 +393,33 @@ static int init_constants_early(struct ubifs_info *c)
 	 */
 	c->leb_overhead = c->leb_size % UBIFS_MAX_DATA_NODE_SZ;
 
+	/* Buffer size for bulk-reads */
+	c->max_bu_buf_len = UBIFS_MAX_BULK_READ * UBIFS_MAX_DATA_NODE_SZ;
+	if (c->max_bu_buf_len > c->leb_size)
+		c->max_bu_buf_len = c->leb_size;
 	return 0;
 }
 
+/**
+ * bu_init - initialize bulk-read information.
+ * @c: UBIFS file-system description object
+ *
+ * Allocates the bulk-read buffer used by 'ubifs_load()'. If there is not
+ * enough memory for it, bulk-read is simply disabled and files are read one
+ * data node at a time.
+ */
+static void bu_init(struct ubifs_info *c)
+{
+	c->bu.buf = kmalloc(c->max_bu_buf_len, GFP_KERNEL);
+	if (!c->bu.buf) {
+		ubifs_warn("cannot allocate %d bytes of memory for bulk-read, "
+			   "disabling it", c->max_bu_buf_len);
+		c->bulk_read = 0;
+		return;
+	}
+	c->bulk_read = 1;
+}
+
 /*
  * init_constants_sb - initialize UBIFS constants.
  * @c: UBIFS file-system description object
@@ -717,6 +741,8 @@ static int mount_ubifs(struct ubifs_info *c)
 
 	c->always_chk_crc = 0;
 
+	bu_init(c);
+
 	ubifs_msg("mounted UBI device %d, volume %d, name \"%s\"",
 		  c->vi.ubi_num, c->vi.vol_id, c->vi.name);
 	if (mounted_read_only)
@@ -838,7 +864,9 @@ void ubifs_umount(struct ubifs_info *c)
 
 	free_orphans(c);
 	ubifs_lpt_free(c, 0);
+	ubifs_tnc_close(c);
 
+	kfree(c->bu.buf);
 	kfree(c->cbuf);
 	kfree(c->rcvrd_mst_node);
 	kfree(c->mst_node);
@@ -1712,6 +1712,23 @@ int ubifs_tnc_bulk_read(struct ubifs_info *c, struct bu_info *bu)
 	return 0;
 }
 
+/**
+ * ubifs_tnc_close - close TNC subsystem and free all related resources.
+ * @c: UBIFS file-system description object
+ *
+ * The TNC (and the leaf nodes cached in it) is kept for as long as the file
+ * system stays mounted, so that index nodes read by one command are reused by
+ * the next. This function drops it on un-mount.
+ */
+void ubifs_tnc_close(struct ubifs_info *c)
+{
+	if (c->zroot.znode) {
+		ubifs_destroy_tnc_subtree(c->zroot.znode);
+		c->zroot.znode = NULL;
+	}
+	destroy_old_idx(c);
+}
+
 /**
  * do_lookup_nm- look up a "hashed" node.
  * @c: UBIFS file-system description object
@@ -24,6 +24,7 @@
  */
 
 #include "ubifs.h"
+#include <arena.h>
 #include <u-boot/zlib.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -519,23 +520,21 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/**
+ * decompress_node - decompress a data node into the destination.
+ * @c: UBIFS file-system description object
+ * @inode: inode the data node belongs to
+ * @dn: data node
+ * @addr: destination, with room for a full block
+ *
+ * Returns zero in case of success and %-EINVAL if the data node is bad.
+ */
+static int decompress_node(struct ubifs_info *c, struct inode *inode,
+			   struct ubifs_data_node *dn, void *addr)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -561,11 +560,30 @@ static int read_block(struct inode *inode, void *addr, unsigned int block,
 
 dump:
 	ubifs_err("bad data node (block %u, inode %lu)",
-		  block, inode->i_ino);
+		  key_block_flash(c, &dn->key), inode->i_ino);
 	dbg_dump_node(c, dn);
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	int err;
+	union ubifs_key key;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decompress_node(c, inode, dn, addr);
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -588,7 +606,7 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		goto out;
 	}
 
-	dn = kmalloc(UBIFS_MAX_DATA_NODE_SZ, GFP_NOFS);
+	dn = arena_alloc(UBIFS_MAX_DATA_NODE_SZ);
 	if (!dn)
 		return -ENOMEM;
 
@@ -615,7 +633,7 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 				 * destination area to a multiple of
 				 * UBIFS_BLOCK_SIZE.
 				 */
-				buff = malloc(UBIFS_BLOCK_SIZE);
+				buff = arena_alloc(UBIFS_BLOCK_SIZE);
 				if (!buff) {
 					printf("%s: Error, malloc fails!\n",
 					       __func__);
@@ -628,7 +646,7 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 				if (ret) {
 					err = ret;
 					if (err != -ENOENT) {
-						free(buff);
+						arena_free(buff);
 						break;
 					}
 				}
@@ -641,7 +659,7 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 				/* Now copy required size back to dest */
 				memcpy(addr, buff, dlen);
 
-				free(buff);
+				arena_free(buff);
 			} else {
 				ret = read_block(inode, addr, block, dn);
 				if (ret) {
@@ -668,15 +686,122 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 	}
 
 out_free:
-	kfree(dn);
+	arena_free(dn);
 out:
 	return 0;
 
 error:
-	kfree(dn);
+	arena_free(dn);
 	return err;
 }
 
+/**
+ * fill_block - fill in one block of the destination buffer.
+ * @c: UBIFS file-system description object
+ * @inode: inode the data belongs to
+ * @dn: data node of the block, or %NULL for a hole
+ * @addr: where the block goes
+ * @len: number of bytes wanted, %UBIFS_BLOCK_SIZE except for the last block
+ * @buff: bounce buffer for a partial last block
+ *
+ * Full blocks are decompressed straight into @addr. Only a partial last block
+ * goes through @buff, so that nothing is written past the requested size.
+ */
+static int fill_block(struct ubifs_info *c, struct inode *inode,
+		      struct ubifs_data_node *dn, void *addr, int len,
+		      void *buff)
+{
+	int err;
+
+	if (!dn) {
+		memset(addr, 0, len);
+		return 0;
+	}
+
+	if (len == UBIFS_BLOCK_SIZE)
+		return decompress_node(c, inode, dn, addr);
+
+	err = decompress_node(c, inode, dn, buff);
+	if (!err)
+		memcpy(addr, buff, len);
+	return err;
+}
+
+/**
+ * read_bulk - read consecutive data nodes of a file in one go.
+ * @c: UBIFS file-system description object
+ * @inode: inode to read from
+ * @block: first block to read
+ * @count: number of blocks to read in total
+ * @tail: size of the last block, %0 if it is a full one
+ * @addr: destination of block %0
+ * @buff: bounce buffer for a partial last block
+ *
+ * Looks up the data nodes starting at @block which lie back to back in the
+ * same LEB, reads all of them with a single 'ubi_read()' and decompresses
+ * each one directly into its place in @addr. Holes are zeroed out. Returns
+ * the number of blocks filled in, %0 if nothing could be bulk-read (the caller
+ * then falls back to 'do_readpage()'), or a negative error code.
+ */
+static int read_bulk(struct ubifs_info *c, struct inode *inode,
+		     unsigned int block, unsigned int count, int tail,
+		     void *addr, void *buff)
+{
+	struct bu_info *bu = &c->bu;
+	struct ubifs_data_node *dn;
+	unsigned int next, end = block;
+	int err, i, len;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+
+	/* Do not read nodes beyond the requested size */
+	while (bu->cnt &&
+	       key_block(c, &bu->zbranch[bu->cnt - 1].key) >= count) {
+		bu->cnt -= 1;
+		bu->eof = 1;
+	}
+
+	if (bu->cnt) {
+		err = ubifs_tnc_bulk_read(c, bu);
+		if (err == -EAGAIN)
+			return 0;
+		if (err)
+			return err;
+	} else if (!bu->eof)
+		return 0;
+
+	dn = bu->buf;
+	for (i = 0; i <= bu->cnt; i++) {
+		/* After the last node, holes run up to the end of the file */
+		if (i < bu->cnt)
+			next = key_block(c, &bu->zbranch[i].key);
+		else if (bu->eof)
+			next = count;
+		else
+			break;
+
+		for (; end <= next && end < count; end++) {
+			len = UBIFS_BLOCK_SIZE;
+			if (end + 1 == count && tail)
+				len = tail;
+			err = fill_block(c, inode, end == next ? dn : NULL,
+					 addr + (end << UBIFS_BLOCK_SHIFT),
+					 len, buff);
+			if (err)
+				return err;
+		}
+
+		if (i < bu->cnt)
+			dn = (void *)dn + ALIGN(bu->zbranch[i].len, 8);
+	}
+
+	return end - block;
+}
+
 int ubifs_load(char *filename, u32 addr, u32 size)
 {
 	struct ubifs_info *c = ubifs_sb->s_fs_info;
@@ -684,9 +809,9 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
-	int count;
-	int last_block_size = 0;
+	int tail;
+	unsigned int block, count;
+	void *buff = NULL;
 	char buf [10];
 
 	c->ubi = ubi_open_volume(c->vi.ubi_num, c->vi.vol_id, UBI_READONLY);
@@ -716,25 +841,44 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 		size = inode->i_size;
 
 	count = (size + UBIFS_BLOCK_SIZE - 1) >> UBIFS_BLOCK_SHIFT;
+	tail = size & (UBIFS_BLOCK_SIZE - 1);
 	printf("Loading file '%s' to addr 0x%08x with size %d (0x%08x)...\n",
 	       filename, addr, size, size);
 
-	page.addr = (void *)addr;
-	page.index = 0;
+	if (tail) {
+		buff = malloc(UBIFS_BLOCK_SIZE);
+		if (!buff) {
+			printf("%s: Error, malloc fails!\n", __func__);
+			err = -ENOMEM;
+			goto out_iput;
+		}
+	}
+
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	block = 0;
+	while (block < count) {
+		if (c->bulk_read) {
+			err = read_bulk(c, inode, block, count, tail,
+					(void *)addr, buff);
+			if (err < 0)
+				break;
+			if (err) {
+				block += err;
+				err = 0;
+				continue;
+			}
+		}
+
 		/*
 		 * Make sure to not read beyond the requested size
 		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
-
-		err = do_readpage(c, inode, &page, last_block_size);
+		page.addr = (void *)addr + (block << UBIFS_BLOCK_SHIFT);
+		page.index = block;
+		err = do_readpage(c, inode, &page,
+				  block + 1 == count ? tail : 0);
 		if (err)
 			break;
-
-		page.addr += PAGE_SIZE;
-		page.index++;
+		block++;
 	}
 
 	if (err)
@@ -745,6 +889,8 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 		printf("Done\n");
 	}
 
+	free(buff);
+out_iput:
 	ubifs_iput(inode);
 
 out:
@@ -0,0 +1,166 @@
+/*
+ * Scoped arena for short-lived allocations
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <malloc.h>
+
+/*
+ * Code which allocates and frees many small buffers while a command runs
+ * can take them from the arena instead of malloc(). The arena is one block
+ * of CONFIG_SYS_ARENA_LEN bytes, handed out by moving a pointer up. Freeing
+ * the most recent allocation moves the pointer back down, so the usual
+ * allocate, use and free pattern keeps reusing the same memory. Anything
+ * freed out of order is reclaimed once everything above it is freed, and
+ * anything left over is reclaimed when the scope ends.
+ *
+ * cmd_process() opens a scope around each command. Outside a scope, or
+ * when the arena is full, the allocation comes from malloc() instead, and
+ * arena_free() passes it on to free(). So memory from the arena must not
+ * be kept once the command finishes: caches and anything else which lives
+ * on must still use malloc().
+ *
+ * Without CONFIG_ARENA these are malloc(), memalign(), realloc() and free().
+ */
+
+#ifdef CONFIG_ARENA
+
+struct arena_hdr;
+
+/* What arena_leave() restores, kept by the caller of arena_enter() */
+struct arena_scope {
+	ulong top;
+	ulong floor;
+	struct arena_hdr *last;
+};
+
+/* Usage figures, from arena_get_info() */
+struct arena_info {
+	ulong size;		/* size of the arena, 0 if not set up yet */
+	ulong used;		/* bytes in use now, including headers */
+	ulong peak;		/* most bytes ever in use */
+	ulong fallbacks;	/* allocations passed to malloc() when full */
+	ulong fallback_bytes;	/* bytes asked for by those */
+	ulong malloc_size;	/* size of the malloc() pool */
+	ulong malloc_peak;	/* most of the malloc() pool ever used */
+};
+
+/**
+ * Start a scope, setting up the arena the first time
+ *
+ * @param scope	Somewhere to keep the state, for arena_leave()
+ */
+void arena_enter(struct arena_scope *scope);
+
+/**
+ * End a scope, reclaiming everything allocated since arena_enter()
+ *
+ * @param scope	State from arena_enter()
+ */
+void arena_leave(struct arena_scope *scope);
+
+/**
+ * Allocate memory aligned like malloc()'s
+ *
+ * @param size	Number of bytes
+ * @return pointer to the memory, or NULL if there is none
+ */
+void *arena_alloc(size_t size);
+
+/**
+ * Allocate aligned memory
+ *
+ * @param align	Alignment, a power of two
+ * @param size	Number of bytes
+ * @return pointer to the memory, or NULL if there is none
+ */
+void *arena_memalign(size_t align, size_t size);
+
+/**
+ * Resize an allocation, in place if it is the most recent one
+ *
+ * One made in an outer scope is moved to malloc(), so that it still lasts
+ * as long as that scope.
+ *
+ * @param ptr	Memory from the arena or malloc(), or NULL
+ * @param size	New size in bytes
+ * @return pointer to the memory, or NULL if there is none (in which case
+ * ptr is left alone)
+ */
+void *arena_realloc(void *ptr, size_t size);
+
+/**
+ * Free memory from arena_alloc() and friends
+ *
+ * @param ptr	Memory to free, or NULL
+ */
+void arena_free(void *ptr);
+
+/**
+ * Read the usage figures
+ *
+ * @param info	Place to put them
+ */
+void arena_get_info(struct arena_info *info);
+
+/**
+ * Start counting the peaks and fallbacks from now
+ */
+void arena_reset_info(void);
+
+#else
+
+struct arena_scope {
+};
+
+static inline void arena_enter(struct arena_scope *scope)
+{
+}
+
+static inline void arena_leave(struct arena_scope *scope)
+{
+}
+
+static inline void *arena_alloc(size_t size)
+{
+	return malloc(size);
+}
+
+static inline void *arena_memalign(size_t align, size_t size)
+{
+	return memalign(align, size);
+}
+
+static inline void *arena_realloc(void *ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+static inline void arena_free(void *ptr)
+{
+	free(ptr);
+}
+
+#endif /* CONFIG_ARENA */
+
+#endif /* __ARENA_H */
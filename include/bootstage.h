@@ -207,6 +207,14 @@ enum bootstage_id {
 	BOOTSTAGE_ID_MAIN_CPU_READY,
 
 	BOOTSTAGE_ID_ACCUM_LCD,
+	BOOTSTAGE_ID_ACCUM_BOOTM,
+	BOOTSTAGE_ID_ACCUM_LOAD_OS,
+	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_FDT,
+	BOOTSTAGE_ID_ACCUM_MMC_READ,
+	BOOTSTAGE_ID_ACCUM_NAND_READ,
+	BOOTSTAGE_ID_ACCUM_SF_READ,
+	BOOTSTAGE_ID_ACCUM_SPL_LOAD,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -233,7 +241,8 @@ void show_boot_progress(int val);
 #define show_boot_progress(val) do {} while (0)
 #endif
 
-#if defined(CONFIG_BOOTSTAGE) && !defined(CONFIG_SPL_BUILD)
+#if defined(CONFIG_BOOTSTAGE) && \
+	(!defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_BOOTSTAGE))
 /* This is the full bootstage implementation */
 
 /**
@@ -269,6 +278,14 @@ ulong bootstage_mark_name(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_start(enum bootstage_id id, const char *name);
 
+/**
+ * Allocate an id for an activity timed with bootstage_start() and
+ * bootstage_accum(), for when there is no fixed one
+ *
+ * @return new id, or BOOTSTAGE_ID_COUNT if there are none left
+ */
+enum bootstage_id bootstage_alloc_id(void);
+
 /**
  * Mark the end of a bootstage activity
  *
@@ -283,9 +300,55 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * Mark the start of a span, an activity timed like bootstage_start() which
+ * can contain other spans
+ *
+ * A span started while another is running is taken to be part of it the
+ * first time, which is how the report and export show it. Spans must end
+ * in the reverse order that they started; ending one also ends any still
+ * running inside it.
+ *
+ * @param id	Bootstage id to record this span against
+ * @param name	Textual name to display for this id in the report (maybe NULL)
+ * @return start timestamp in microseconds, or 0 if spans are nested too
+ *		deeply to record this one
+ */
+uint32_t bootstage_span_start(enum bootstage_id id, const char *name);
+
+/**
+ * Mark the end of a span
+ *
+ * @param id	Bootstage id of a span started with bootstage_span_start()
+ * @return time spent in this run of the span, 0 if it was not running
+ */
+uint32_t bootstage_span_end(enum bootstage_id id);
+
+/**
+ * Count bytes transferred in a span, to show the throughput of a driver
+ *
+ * @param id	Bootstage id of the span
+ * @param bytes	Number of bytes to add to its total
+ */
+void bootstage_add_bytes(enum bootstage_id id, ulong bytes);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
+/**
+ * Export all records and spans as CSV, one line each after a header line
+ *
+ * The columns are id, parent span, type (mark, error or span), name, time
+ * and time outside inner spans in microseconds, count, bytes and the names
+ * of the enclosing spans and this one, separated by ';'. The last two
+ * columns together are what flame graph tools expect.
+ *
+ * @param buf	Buffer to write the text to, nul-terminated
+ * @param size	Size of buffer
+ * @return length of text, or -1 if the buffer is too small
+ */
+int bootstage_export_csv(char *buf, int size);
+
 /**
  * Add bootstage information to the device tree
  *
@@ -337,6 +400,21 @@ static inline ulong bootstage_mark_name(enum bootstage_id id, const char *name)
 	return 0;
 }
 
+static inline uint32_t bootstage_span_start(enum bootstage_id id,
+					    const char *name)
+{
+	return 0;
+}
+
+static inline uint32_t bootstage_span_end(enum bootstage_id id)
+{
+	return 0;
+}
+
+static inline void bootstage_add_bytes(enum bootstage_id id, ulong bytes)
+{
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -0,0 +1,147 @@
+/*
+ * Batched data cache maintenance for DMA
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __CACHE_BATCH_H
+#define __CACHE_BATCH_H
+
+/*
+ * A driver setting up DMA collects the memory areas which need a flush
+ * (or an invalidate) in a batch, then carries them out in one go before
+ * starting the transfer. Adjacent and overlapping areas are merged, so
+ * that a buffer split over many descriptors becomes one range, and a
+ * large enough flush becomes a flush of the whole cache, which is quicker
+ * than going through it a line at a time.
+ *
+ * The operation on an area added to a batch may happen at any time until
+ * cache_batch_run(): a batch which fills up is run there and then. So add
+ * an area to a flush batch only once the CPU has finished writing to it,
+ * and to an invalidate batch only once the device has finished with it.
+ *
+ * Without CONFIG_CACHE_BATCH each area is flushed or invalidated as it is
+ * added, as drivers did before.
+ */
+
+enum {
+	CACHE_BATCH_FLUSH	= 0,		/* write back and invalidate */
+	CACHE_BATCH_INVALIDATE	= 1 << 0,	/* discard */
+
+	/*
+	 * Remember what a flush batch flushed, and skip adding it again
+	 * until the driver reports that it wrote to it with
+	 * cache_batch_dirty(). For areas such as descriptor rings, which
+	 * the CPU changes a little at a time.
+	 */
+	CACHE_BATCH_TRACK	= 1 << 1,
+};
+
+#ifdef CONFIG_CACHE_BATCH
+
+#ifndef CONFIG_CACHE_BATCH_RANGES
+#define CONFIG_CACHE_BATCH_RANGES	32
+#endif
+
+struct cache_range {
+	ulong start;
+	ulong end;		/* exclusive */
+};
+
+struct cache_batch {
+	int flags;				/* CACHE_BATCH_... */
+	int count;				/* ranges waiting */
+	struct cache_range range[CONFIG_CACHE_BATCH_RANGES];
+
+	/* Known clean, with CACHE_BATCH_TRACK */
+	int clean_count;
+	struct cache_range clean[CONFIG_CACHE_BATCH_RANGES];
+};
+
+/**
+ * Set up an empty batch
+ *
+ * @param batch	Batch to set up
+ * @param flags	CACHE_BATCH_FLUSH or CACHE_BATCH_INVALIDATE, and optionally
+ *		CACHE_BATCH_TRACK
+ */
+void cache_batch_init(struct cache_batch *batch, int flags);
+
+/**
+ * Add an area to a batch
+ *
+ * For a flush the area is widened to whole cache lines. An invalidate
+ * area must already cover whole lines, as for invalidate_dcache_range().
+ *
+ * @param batch	Batch to add to
+ * @param start	Start address
+ * @param end	End address (exclusive)
+ */
+void cache_batch_add(struct cache_batch *batch, ulong start, ulong end);
+
+/**
+ * Flush or invalidate everything in a batch, leaving it empty
+ *
+ * @param batch	Batch to run
+ */
+void cache_batch_run(struct cache_batch *batch);
+
+/**
+ * Report that the CPU wrote to an area, so it is no longer clean
+ *
+ * This only matters to a batch with CACHE_BATCH_TRACK.
+ *
+ * @param batch	Batch tracking the area
+ * @param start	Start address
+ * @param end	End address (exclusive)
+ */
+void cache_batch_dirty(struct cache_batch *batch, ulong start, ulong end);
+
+#else
+
+struct cache_batch {
+	int flags;
+};
+
+static inline void cache_batch_init(struct cache_batch *batch, int flags)
+{
+	batch->flags = flags;
+}
+
+static inline void cache_batch_add(struct cache_batch *batch, ulong start,
+				   ulong end)
+{
+	if (batch->flags & CACHE_BATCH_INVALIDATE)
+		invalidate_dcache_range(start, end);
+	else
+		flush_dcache_range(start, end);
+}
+
+static inline void cache_batch_run(struct cache_batch *batch)
+{
+}
+
+static inline void cache_batch_dirty(struct cache_batch *batch, ulong start,
+				     ulong end)
+{
+}
+
+#endif /* CONFIG_CACHE_BATCH */
+
+#endif /* __CACHE_BATCH_H */
@@ -45,6 +45,7 @@
 
 #define CONFIG_SYS_PROMPT		"=>"	/* Command Prompt */
 #define CONFIG_SYS_HUSH_PARSER
+#define CONFIG_HUSH_CACHE
 #define CONFIG_SYS_LONGHELP			/* #undef to save memory */
 #define CONFIG_SYS_CBSIZE		1024	/* Console I/O Buffer Size */
 
@@ -57,8 +58,41 @@
 #define CONFIG_COMMAND_HISTORY
 #define CONFIG_AUTO_COMPLETE
 
-#define CONFIG_ENV_SIZE		8192
+#define CONFIG_ENV_SIZE			8192
+#ifdef CONFIG_SANDBOX_SPI_ENV
+/* sandbox_spienv: environment in the simulated SPI flash, see --spi_sf */
+#define CONFIG_ENV_IS_IN_SPI_FLASH
+#define CONFIG_ENV_SPI_MODE		SPI_MODE_0
+#define CONFIG_ENV_SECT_SIZE		0x10000
+#define CONFIG_ENV_OFFSET		0
+#define CONFIG_ENV_OFFSET_REDUND	(CONFIG_ENV_OFFSET + CONFIG_ENV_SECT_SIZE)
+#define CONFIG_SYS_REDUNDAND_ENVIRONMENT
+#define CONFIG_ENV_LOG
+#else
 #define CONFIG_ENV_IS_NOWHERE
+#endif
+
+#define CONFIG_INIT_JOBS
+
+/* Host threads stand in for the secondary cores */
+#define CONFIG_WORKERS
+#define CONFIG_WORKER_MAX		3
+
+#define CONFIG_BOOTSTAGE
+#define CONFIG_CMD_BOOTSTAGE
+
+#define CONFIG_ZLIB_CHUNK
+#define CONFIG_GZIP_COMPRESSED
+#define CONFIG_LZ4
+#define CONFIG_ZSTD
+
+#define CONFIG_KALLSYMS
+#define CONFIG_PROF
+#define CONFIG_CMD_PROF
+#define CONFIG_CMD_MEMBENCH
+#define CONFIG_CACHE_BATCH
+#define CONFIG_ARENA
+#define CONFIG_CMD_ARENA
 
 #define CONFIG_SYS_HZ			1000
 
@@ -76,7 +110,43 @@
 					115200}
 #define CONFIG_SANDBOX_SERIAL
 
-#define CONFIG_SYS_NO_FLASH
+/* Simulated CFI flash: two banks after the DRAM */
+#define CONFIG_FLASH_CFI_DRIVER
+#define CONFIG_FLASH_CFI_SANDBOX
+#define CONFIG_SYS_FLASH_CFI
+#define CONFIG_CFI_FLASH_USE_WEAK_ACCESSORS
+#define CONFIG_SYS_FLASH_USE_BUFFER_WRITE
+#define CONFIG_SYS_FLASH_PIPELINE
+#define CONFIG_SYS_FLASH_BASE		CONFIG_SYS_SDRAM_SIZE
+#define CONFIG_SYS_FLASH_BANKS_LIST	{ CONFIG_SYS_FLASH_BASE, \
+					  CONFIG_SYS_FLASH_BASE + 0x20000 }
+#define CONFIG_SYS_MAX_FLASH_BANKS	2
+#define CONFIG_SYS_MAX_FLASH_SECT	16
+
+/* Simulated NAND, see --nand */
+#define CONFIG_CMD_NAND
+#define CONFIG_NAND_SANDBOX
+#define CONFIG_SYS_MAX_NAND_DEVICE	1
+#define CONFIG_SYS_NAND_BASE		0
+#define CONFIG_SYS_NAND_ONFI_DETECTION
+
+/* UBI on the simulated NAND */
+#define CONFIG_CMD_UBI
+#define CONFIG_RBTREE
+#define CONFIG_MTD_DEVICE
+#define CONFIG_MTD_PARTITIONS
+#define CONFIG_CMD_MTDPARTS
+#define CONFIG_MTD_UBI_FASTMAP
+#define MTDIDS_DEFAULT			"nand0=nand0"
+#define MTDPARTS_DEFAULT		"mtdparts=nand0:-(ubi)"
+
+/* Simulated SPI flash, see --spi_sf */
+#define CONFIG_SANDBOX_SPI
+#define CONFIG_SPI_FLASH
+#define CONFIG_SPI_FLASH_SANDBOX
+#define CONFIG_SPI_FLASH_SPANSION
+#define CONFIG_CMD_SF
+#define CONFIG_SF_DEFAULT_MODE		(SPI_MODE_0 | SPI_TX_QUAD | SPI_RX_QUAD)
 
 /* include default commands */
 #include <config_cmd_default.h>
@@ -138,7 +138,14 @@ extern unsigned long nand_env_oob_offset;
 extern char *env_name_spec;
 #endif
 
-#define ENV_SIZE (CONFIG_ENV_SIZE - ENV_HEADER_SIZE)
+#ifdef CONFIG_ENV_LOG
+# ifndef CONFIG_ENV_LOG_SIZE
+#  define CONFIG_ENV_LOG_SIZE	(CONFIG_ENV_SIZE / 4)
+# endif
+# define ENV_SIZE (CONFIG_ENV_SIZE - ENV_HEADER_SIZE - CONFIG_ENV_LOG_SIZE)
+#else
+# define ENV_SIZE (CONFIG_ENV_SIZE - ENV_HEADER_SIZE)
+#endif
 
 typedef struct environment_s {
 	uint32_t	crc;		/* CRC32 over data bytes	*/
@@ -146,6 +153,9 @@ typedef struct environment_s {
 	unsigned char	flags;		/* active/obsolete flags	*/
 #endif
 	unsigned char	data[ENV_SIZE]; /* Environment data		*/
+#ifdef CONFIG_ENV_LOG
+	unsigned char	log[CONFIG_ENV_LOG_SIZE]; /* Change records	*/
+#endif
 } env_t;
 
 #ifdef ENV_IS_EMBEDDED
@@ -193,6 +203,20 @@ int set_default_vars(int nvars, char * const vars[]);
 /* Import from binary representation into hash table */
 int env_import(const char *buf, int check);
 
+#ifdef CONFIG_ENV_LOG
+/* Replay the change records of an imported environment */
+void env_log_replay(const env_t *ep);
+
+/* Have the next saveenv write the whole environment */
+void env_log_forget(void);
+
+/* Build a change record for saveenv; returns its length, 0 or -1 */
+int env_log_prepare(const void **rec, ulong *offset);
+
+/* Note that a record (ep == NULL) or a whole environment was written */
+void env_log_saved(const env_t *ep);
+#endif
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENVIRONMENT_H_ */
@@ -131,6 +131,7 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 struct ext_filesystem *get_fs(void);
 int ext4fs_open(const char *filename);
 int ext4fs_read(char *buf, unsigned len);
+int ext4fs_read_at(char *buf, unsigned pos, unsigned len);
 int ext4fs_mount(unsigned part_length);
 void ext4fs_close(void);
 int ext4fs_ls(const char *dirname);
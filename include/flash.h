@@ -108,6 +108,13 @@ extern int flash_write (char *, ulong, ulong);
 extern flash_info_t *addr2info (ulong);
 extern int write_buff (flash_info_t *info, uchar *src, ulong addr, ulong cnt);
 
+/* drivers/mtd/cfi_flash.c */
+#ifdef CONFIG_SYS_FLASH_PIPELINE
+extern int write_buff_banks(flash_info_t *info_first, flash_info_t *info_last,
+			    uchar *src, ulong addr, ulong cnt);
+extern int flash_erase_banks(int banks, int *s_first, int *s_last);
+#endif
+
 /* drivers/mtd/cfi_mtd.c */
 #ifdef CONFIG_FLASH_CFI_MTD
 extern int cfi_mtd_init(void);
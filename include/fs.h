@@ -22,6 +22,9 @@
 #define FS_TYPE_FAT	1
 #define FS_TYPE_EXT	2
 
+/* Number of files that may be open at once through fs_open() */
+#define FS_MAX_FILES	4
+
 /*
  * Tell the fs layer which block device an partition to use for future
  * commands. This also internally identifies the filesystem that is present
@@ -34,6 +37,13 @@
  */
 int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype);
 
+/*
+ * Drop the filesystem mounted by fs_set_blk_dev(), closing any open files.
+ * fs_set_blk_dev() keeps the mount across calls for the same partition, so
+ * call this if the medium may have changed underneath it.
+ */
+void fs_unmount(void);
+
 /*
  * Print the list of files on the partition previously set by fs_set_blk_dev(),
  * in directory "dirname".
@@ -53,6 +63,35 @@ int fs_ls(const char *dirname);
  */
 int fs_read(const char *filename, ulong addr, int offset, int len);
 
+/*
+ * Open file "filename" on the partition previously set by fs_set_blk_dev(),
+ * for reading with fs_read_at(). Files stay valid until fs_close() or until
+ * fs_set_blk_dev() selects another partition.
+ *
+ * Returns a file descriptor >= 0 on success, or -1 on error.
+ */
+int fs_open(const char *filename);
+
+/*
+ * Return the size in bytes of the file open as "fd", or -1 on error.
+ */
+int fs_size(int fd);
+
+/*
+ * Read "len" bytes starting at byte offset "offset" of the file open as "fd"
+ * to address "addr". "len" may be 0 to read up to the end of the file, and
+ * is clipped to the end of the file. This allows large files to be read in
+ * chunks without looking them up or mounting the filesystem again.
+ *
+ * Returns number of bytes read on success, or -1 on error.
+ */
+int fs_read_at(int fd, ulong addr, int offset, int len);
+
+/*
+ * Close the file open as "fd".
+ */
+void fs_close(int fd);
+
 /*
  * Common implementation for various filesystem commands, optionally limited
  * to a specific filesystem type via the fstype parameter.
@@ -62,4 +101,11 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
 
+/*
+ * Load only the parts of a FIT image needed by one configuration, see
+ * fit_load_conf().
+ */
+int do_load_fit(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
+		int fstype);
+
 #endif /* _FS_H */
@@ -174,6 +174,8 @@
 #define IH_COMP_BZIP2		2	/* bzip2 Compression Used	*/
 #define IH_COMP_LZMA		3	/* lzma  Compression Used	*/
 #define IH_COMP_LZO		4	/* lzo   Compression Used	*/
+#define IH_COMP_LZ4		5	/* lz4   Compression Used	*/
+#define IH_COMP_ZSTD		6	/* zstd  Compression Used	*/
 
 #define IH_MAGIC	0x27051956	/* Image Magic Number		*/
 #define IH_NMLEN		32	/* Image Name Length		*/
@@ -517,6 +519,8 @@ static inline int image_check_target_arch(const image_header_t *hdr)
 
 /* image node */
 #define FIT_DATA_PROP		"data"
+#define FIT_DATA_OFFSET_PROP	"data-offset"
+#define FIT_DATA_SIZE_PROP	"data-size"
 #define FIT_TIMESTAMP_PROP	"timestamp"
 #define FIT_DESC_PROP		"description"
 #define FIT_ARCH_PROP		"arch"
@@ -557,15 +561,19 @@ static inline ulong fit_get_size(const void *fit)
 }
 
 /**
- * fit_get_end - get FIT image end
+ * fit_get_ext_data - get start of FIT external image data
  * @fit: pointer to the FIT format image header
  *
+ * Image data moved out of the FIT structure (mkimage -E) is stored after the
+ * blob, starting at the next 4-byte boundary. The FIT_DATA_OFFSET_PROP of an
+ * image node is relative to this offset.
+ *
  * returns:
- *     end address of the FIT image (blob) in memory
+ *     offset of the external data area from the start of the FIT image
  */
-static inline ulong fit_get_end(const void *fit)
+static inline ulong fit_get_ext_data(const void *fit)
 {
-	return (ulong)fit + fdt_totalsize(fit);
+	return (fdt_totalsize(fit) + 3) & ~3;
 }
 
 /**
@@ -594,6 +602,9 @@ int fit_image_get_load(const void *fit, int noffset, ulong *load);
 int fit_image_get_entry(const void *fit, int noffset, ulong *entry);
 int fit_image_get_data(const void *fit, int noffset,
 				const void **data, size_t *size);
+ulong fit_get_end(const void *fit);
+int fit_image_get_data_offset(const void *fit, int noffset, int *data_offset);
+int fit_image_get_data_size(const void *fit, int noffset, int *data_size);
 
 int fit_image_hash_get_algo(const void *fit, int noffset, char **algo);
 int fit_image_hash_get_value(const void *fit, int noffset, uint8_t **value,
@@ -624,6 +635,17 @@ int fit_conf_get_fdt_node(const void *fit, int noffset);
 
 void fit_conf_print(const void *fit, int noffset, const char *p);
 
+#ifndef USE_HOSTCC
+/*
+ * Read "len" bytes at byte offset "offset" of a FIT image from storage to
+ * "dst". Returns 0 on success, non-zero on error.
+ */
+typedef int (*fit_read_func)(void *priv, void *dst, ulong offset, ulong len);
+
+int fit_load_conf(void *fit, const char *conf_uname, fit_read_func read,
+		  void *priv, ulong size, ulong *loaded);
+#endif
+
 #ifndef USE_HOSTCC
 static inline int fit_image_check_target_arch(const void *fdt, int node)
 {
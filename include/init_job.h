@@ -0,0 +1,88 @@
+/*
+ * Init jobs: device initialization that runs in the background
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __INIT_JOB_H
+#define __INIT_JOB_H
+
+#include <bootstage.h>
+#include <linux/list.h>
+
+/*
+ * Much of the time spent initializing devices is spent waiting for the
+ * hardware: a card powering up, a PHY negotiating, a port resetting.
+ * A driver can instead start such a wait and hand the rest over to an
+ * init job, a state machine which is polled while the boot goes on, so
+ * that the waits of different devices overlap.
+ *
+ * The start() and poll() functions must not wait themselves; they do
+ * what can be done now and return INIT_JOB_BUSY to be polled again, or
+ * INIT_JOB_DONE (or an error) when the job is finished.  Anything that
+ * needs the result of a job calls init_job_wait() on it first.
+ */
+
+enum {
+	INIT_JOB_DONE	= 0,
+	INIT_JOB_BUSY	= 1,
+};
+
+struct init_job {
+	const char *name;
+	int (*start)(struct init_job *job);
+	int (*poll)(struct init_job *job);
+	void *priv;			/* for the job's own use */
+	enum bootstage_id id;		/* to time it, 0 to allocate one */
+
+	/* private to init_job.c */
+	struct list_head link;
+	int ret;
+};
+
+/**
+ * Start an init job
+ *
+ * The job is timed with bootstage from here until it is finished.
+ *
+ * @param job	Job to start; it must stay around until finished
+ * @return INIT_JOB_BUSY if the job goes on in the background, else its
+ * result
+ */
+int init_job_add(struct init_job *job);
+
+/**
+ * Poll each unfinished job once
+ *
+ * This can be called from anywhere that waits a while, to let the jobs
+ * make progress in the meantime.
+ *
+ * @return number of jobs still busy
+ */
+int init_job_poll(void);
+
+/**
+ * Wait for an init job to finish
+ *
+ * @param job	Job to wait for, or NULL to wait for all of them
+ * @return result of the job, or the first error from any of them
+ */
+int init_job_wait(struct init_job *job);
+
+#endif
@@ -930,11 +930,13 @@ struct mallinfo mALLINFo();
 #endif
 
 /*
- * Begin and End of memory area for malloc(), and current "brk"
+ * Begin and End of memory area for malloc(), current "brk" and the
+ * highest it has been
  */
 extern ulong mem_malloc_start;
 extern ulong mem_malloc_end;
 extern ulong mem_malloc_brk;
+extern ulong mem_malloc_peak;
 
 void mem_malloc_init(ulong start, ulong size);
 void malloc_bin_reloc(void);
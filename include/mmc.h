@@ -62,6 +62,7 @@
 #define UNUSABLE_ERR		-17 /* Unusable Card */
 #define COMM_ERR		-18 /* Communications Error */
 #define TIMEOUT			-19
+#define IN_PROGRESS		-20 /* operation is in progress */
 
 #define MMC_CMD_GO_IDLE_STATE		0
 #define MMC_CMD_SEND_OP_COND		1
@@ -260,11 +261,18 @@ struct mmc {
 	int (*init)(struct mmc *mmc);
 	int (*getcd)(struct mmc *mmc);
 	uint b_max;
+	int init_in_progress;	/* between mmc_start_init() and done */
+	int op_cond_sd;		/* an SD rather than an MMC card */
+	ulong op_cond_start;	/* when the card was first asked to power up */
 };
 
 int mmc_register(struct mmc *mmc);
 int mmc_initialize(bd_t *bis);
 int mmc_init(struct mmc *mmc);
+/* Start initializing a card; mmc_poll_init() waits for it to power up */
+int mmc_start_init(struct mmc *mmc);
+/* Returns 0 once the card is ready, IN_PROGRESS while it is not */
+int mmc_poll_init(struct mmc *mmc);
 int mmc_read(struct mmc *mmc, u64 src, uchar *dst, int size);
 void mmc_set_clock(struct mmc *mmc, uint clock);
 struct mmc *find_mmc_device(int dev_num);
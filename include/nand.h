@@ -40,6 +40,7 @@ extern void nand_init(void);
 #include <linux/compat.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
+#include <bootstage.h>
 
 #ifdef CONFIG_SYS_NAND_SELF_INIT
 void board_nand_init(void);
@@ -55,7 +56,14 @@ extern nand_info_t nand_info[];
 
 static inline int nand_read(nand_info_t *info, loff_t ofs, size_t *len, u_char *buf)
 {
-	return info->read(info, ofs, *len, (size_t *)len, buf);
+	int ret;
+
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_NAND_READ, "nand_read");
+	ret = info->read(info, ofs, *len, (size_t *)len, buf);
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_NAND_READ, *len);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_NAND_READ);
+
+	return ret;
 }
 
 static inline int nand_write(nand_info_t *info, loff_t ofs, size_t *len, u_char *buf)
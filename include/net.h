@@ -102,6 +102,11 @@ extern int eth_register(struct eth_device* dev);/* Register network device */
 extern int eth_unregister(struct eth_device *dev);/* Remove network device */
 extern void eth_try_another(int first_restart);	/* Change the device */
 extern void eth_set_current(void);		/* set nterface to ethcur var */
+#if defined(CONFIG_LAZY_INIT) && defined(CONFIG_CMD_NET)
+extern void eth_probe(void);		/* probe devices if not done yet */
+#else
+static inline void eth_probe(void) {}
+#endif
 
 /* get the current device MAC */
 extern struct eth_device *eth_current;
@@ -124,6 +124,33 @@ void os_usleep(unsigned long usec);
  */
 u64 os_get_nsec(void);
 
+/**
+ * Start a host timer which samples the program counter, for profiling
+ *
+ * The handler is called from a signal handler, with the program counter
+ * at link address, or 0 if it was outside U-Boot (in a host library).
+ *
+ * \param hz		Requested number of samples per second of CPU time
+ * \param handler	Function to call with each sample
+ * \return rate actually used in samples per second, or -ve on error
+ */
+int os_prof_start(unsigned int hz, void (*handler)(unsigned long pc));
+
+/* Stop the timer started by os_prof_start() */
+void os_prof_stop(void);
+
+/**
+ * Start a host thread
+ *
+ * The thread should never return: it would free its resources with the
+ * host's free(), which is U-Boot's own and not thread-safe.
+ *
+ * \param fn	Function the thread runs
+ * \param arg	Argument to pass to it
+ * \return 0 if ok, -ve on error
+ */
+int os_thread_start(void *(*fn)(void *arg), void *arg);
+
 /**
  * Parse arguments and update sandbox state.
  *
@@ -114,6 +114,8 @@ block_dev_desc_t* mg_disk_get_dev(int dev);
 int get_partition_info (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
 void print_part (block_dev_desc_t *dev_desc);
 void  init_part (block_dev_desc_t *dev_desc);
+/* Number of init_part() calls so far: changes whenever a device is scanned */
+ulong part_scan_count(void);
 void dev_print(block_dev_desc_t *dev_desc);
 int get_device(const char *ifname, const char *dev_str,
 	       block_dev_desc_t **dev_desc);
@@ -135,6 +137,7 @@ static inline int get_partition_info (block_dev_desc_t * dev_desc, int part,
 	disk_partition_t *info) { return -1; }
 static inline void print_part (block_dev_desc_t *dev_desc) {}
 static inline void  init_part (block_dev_desc_t *dev_desc) {}
+static inline ulong part_scan_count(void) { return 0; }
 static inline void dev_print(block_dev_desc_t *dev_desc) {}
 static inline int get_device(const char *ifname, const char *dev_str,
 	       block_dev_desc_t **dev_desc)
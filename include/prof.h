@@ -0,0 +1,77 @@
+/*
+ * Sampling profiler
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __PROF_H
+#define __PROF_H
+
+/*
+ * While the profiler runs, a timer interrupt records the program counter
+ * it interrupted with prof_sample(). The samples go into a ring buffer of
+ * CONFIG_PROF_SAMPLES entries, so a long run keeps the latest ones, and
+ * the report counts them per function (with CONFIG_KALLSYMS) or per
+ * address.
+ */
+
+/**
+ * Record a sample, from the profiling timer interrupt
+ *
+ * This does nothing unless the profiler is running.
+ *
+ * @param pc	Program counter that was interrupted, or 0 if it was outside
+ *		U-Boot (in the host OS, on sandbox)
+ */
+void prof_sample(ulong pc);
+
+/**
+ * Start sampling, architecture or board code
+ *
+ * This sets up a timer interrupt which calls prof_sample().
+ *
+ * @param hz	Requested number of samples per second
+ * @return rate actually used in samples per second, or -ve on error
+ */
+int prof_timer_start(unsigned int hz);
+
+/* Stop sampling, architecture or board code */
+void prof_timer_stop(void);
+
+/**
+ * Clear the samples and start the profiler
+ *
+ * @param hz	Requested number of samples per second
+ * @return 0 if ok, -ve on error
+ */
+int prof_start(unsigned int hz);
+
+/* Stop the profiler, keeping the samples for prof_report() */
+void prof_stop(void);
+
+/**
+ * Print the samples, grouped by function and most frequent first
+ *
+ * This stops the profiler if it is running.
+ *
+ * @param max_lines	Maximum number of functions to list, 0 for all
+ */
+void prof_report(int max_lines);
+
+#endif
@@ -37,10 +37,16 @@
 #define	SPI_LSB_FIRST	0x08			/* per-word bits-on-wire */
 #define	SPI_3WIRE	0x10			/* SI/SO signals shared */
 #define	SPI_LOOP	0x20			/* loopback mode */
+#define	SPI_TX_DUAL	0x100			/* transmit with 2 wires */
+#define	SPI_TX_QUAD	0x200			/* transmit with 4 wires */
+#define	SPI_RX_DUAL	0x400			/* receive with 2 wires */
+#define	SPI_RX_QUAD	0x800			/* receive with 4 wires */
 
 /* SPI transfer flags */
 #define SPI_XFER_BEGIN	0x01			/* Assert CS before transfer */
 #define SPI_XFER_END	0x02			/* Deassert CS after transfer */
+#define SPI_XFER_DUAL	0x04			/* Shift data on 2 wires */
+#define SPI_XFER_QUAD	0x08			/* Shift data on 4 wires */
 
 /*-----------------------------------------------------------------------
  * Representation of a SPI slave, i.e. what we're communicating with.
@@ -135,6 +141,12 @@ void spi_release_bus(struct spi_slave *slave);
  *   din:	Pointer to a string of bits that will be filled in.
  *   flags:	A bitwise combination of SPI_XFER_* flags.
  *
+ * With SPI_XFER_DUAL or SPI_XFER_QUAD the bits are shifted on 2 or 4
+ * data lines, in the direction given by whichever of dout and din is
+ * set. Only controllers which accepted SPI_TX_* / SPI_RX_* in the mode
+ * passed to spi_setup_slave() need to support this; the others should
+ * fail such transfers.
+ *
  *   Returns: 0 on success, not 0 on failure
  */
 int  spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
@@ -26,6 +26,28 @@
 #include <spi.h>
 #include <linux/types.h>
 #include <linux/compiler.h>
+#include <bootstage.h>
+
+/* Read protocols, as opcode-address-data lines */
+enum spi_flash_read_mode {
+	SPI_FLASH_READ_1_1_1,		/* fast read */
+	SPI_FLASH_READ_1_1_2,		/* dual output fast read */
+	SPI_FLASH_READ_1_1_4,		/* quad output fast read */
+	SPI_FLASH_READ_1_4_4,		/* quad I/O fast read */
+};
+
+/* spi_flash flags, set by the manufacturer probe */
+#define SPI_FLASH_RD_DUAL	0x01	/* supports 1-1-2 reads */
+#define SPI_FLASH_RD_QUAD	0x02	/* supports 1-1-4 reads */
+#define SPI_FLASH_RD_QUAD_IO	0x04	/* supports 1-4-4 reads */
+#define SPI_FLASH_QE_CR		0x08	/* quad needs QE in status reg 2 */
+#define SPI_FLASH_4B_MODE	0x10	/* no 4B opcodes, use 4-byte mode */
+#define SPI_FLASH_ERASE_32K	0x20	/* has 32KiB block erase */
+#define SPI_FLASH_ERASE_64K	0x40	/* has 64KiB block erase */
+#define SPI_FLASH_ERASE_CHIP	0x80	/* C7h erases the whole part */
+#define SPI_FLASH_NO_REPROG	0x100	/* ECC: program each page once */
+#define SPI_FLASH_BP3_SR5	0x200	/* BP3 block protect is status bit 5 */
+#define SPI_FLASH_BP3_SR6	0x400	/* BP3 block protect is status bit 6 */
 
 struct spi_flash {
 	struct spi_slave *spi;
@@ -39,6 +61,14 @@ struct spi_flash {
 	/* Erase (sector) size */
 	u32		sector_size;
 
+	/* SPI_FLASH_* flags */
+	u16		flags;
+	/* Address bytes sent with each command, 4 above 16MiB */
+	u8		addr_width;
+	/* Read opcode and the protocol it uses */
+	u8		read_cmd;
+	enum spi_flash_read_mode read_mode;
+
 	int		(*read)(struct spi_flash *flash, u32 offset,
 				size_t len, void *buf);
 	int		(*write)(struct spi_flash *flash, u32 offset,
@@ -54,7 +84,15 @@ void spi_flash_free(struct spi_flash *flash);
 static inline int spi_flash_read(struct spi_flash *flash, u32 offset,
 		size_t len, void *buf)
 {
-	return flash->read(flash, offset, len, buf);
+	int ret;
+
+	bootstage_span_start(BOOTSTAGE_ID_ACCUM_SF_READ, "sf_read");
+	ret = flash->read(flash, offset, len, buf);
+	if (!ret)
+		bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_SF_READ, len);
+	bootstage_span_end(BOOTSTAGE_ID_ACCUM_SF_READ);
+
+	return ret;
 }
 
 static inline int spi_flash_write(struct spi_flash *flash, u32 offset,
@@ -77,4 +77,9 @@ void spl_net_load_image(const char *device);
 #ifdef CONFIG_SPL_BOARD_INIT
 void spl_board_init(void);
 #endif
+
+#ifdef CONFIG_SPL_CACHE_SUPPORT
+/* Turn on the MMU and caches, architecture code */
+void spl_enable_caches(void);
+#endif
 #endif
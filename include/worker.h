@@ -0,0 +1,110 @@
+/*
+ * Workers: jobs run on the secondary cores
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __WORKER_H
+#define __WORKER_H
+
+/*
+ * U-Boot runs on the boot CPU while any other cores wait in their spin
+ * loop. A worker is such a core which instead waits for jobs: long
+ * computations such as hashing or copying an image, which the boot CPU
+ * hands over so that it can go on with something else meanwhile.
+ *
+ * A job runs on another core, so it must only work on the memory it was
+ * given: no console output, no malloc(), no drivers and nothing which
+ * uses global data. When no worker is free (or there are none), the job
+ * runs at once on the calling CPU, so callers need not care whether
+ * there are any workers.
+ */
+
+enum {
+	WORKER_JOB_DONE	= 0,
+	WORKER_JOB_BUSY	= 1,
+};
+
+struct worker_job {
+	int (*fn)(struct worker_job *job);
+	void *priv;			/* for the job's own use */
+
+	/* private to worker.c */
+	volatile int state;
+	int ret;
+};
+
+/**
+ * Hand a job over to a worker
+ *
+ * @param job	Job to run; it must stay around until worker_wait()
+ */
+void worker_submit(struct worker_job *job);
+
+/**
+ * Wait for a job to finish
+ *
+ * @param job	Job given to worker_submit()
+ * @return the value returned by the job's function
+ */
+int worker_wait(struct worker_job *job);
+
+/**
+ * Copy memory with the help of the workers
+ *
+ * The copy is split among the free workers and the calling CPU. This is
+ * just memmove_wd() if there are no free workers, or the areas overlap or
+ * are too small to be worth it. The calling CPU resets the watchdog as it
+ * goes, as memmove_wd() does.
+ *
+ * @param dest	Destination address
+ * @param src	Source address
+ * @param len	Number of bytes to copy
+ */
+void worker_memmove(void *dest, const void *src, size_t len);
+
+/**
+ * Stop the workers
+ *
+ * This waits for any running jobs and sends the cores back to their spin
+ * loop, which is where an OS expects to find them. The next job starts
+ * them again.
+ */
+void worker_stop(void);
+
+/**
+ * Start a secondary core running a worker, architecture or board code
+ *
+ * Only sandbox provides this so far, with host threads. Elsewhere the
+ * default fails, so there are no workers and every job runs on the boot
+ * CPU.
+ *
+ * The core should call entry(nr) with a stack of its own, and return to
+ * its spin loop (or whatever it did before) when entry() returns.
+ *
+ * @param nr	Worker number, from 0 to CONFIG_WORKER_MAX - 1
+ * @param entry	Function to run
+ * @return 0 if ok, -ve if there is no such core
+ */
+int worker_cpu_start(int nr, void (*entry)(int nr));
+
+/* Let a worker with nothing to do wait a little, architecture code */
+void worker_cpu_relax(void);
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * xxHash - fast non-cryptographic hash, as used by the LZ4 and Zstandard
+ * frame formats for their checksums
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _XXHASH_H
+#define _XXHASH_H
+
+/**
+ * Calculate the 32-bit xxHash of a buffer
+ *
+ * @param input		Data to hash
+ * @param len		Number of bytes
+ * @param seed		Starting value, normally 0
+ * @return hash value
+ */
+u32 xxh32(const void *input, size_t len, u32 seed);
+
+/**
+ * Calculate the 64-bit xxHash of a buffer
+ *
+ * @param input		Data to hash
+ * @param len		Number of bytes
+ * @param seed		Starting value, normally 0
+ * @return hash value
+ */
+u64 xxh64(const void *input, size_t len, u64 seed);
+
+#endif /* _XXHASH_H */
@@ -0,0 +1,46 @@
+/*
+ * Zstandard decompression
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _ZSTD_H
+#define _ZSTD_H
+
+/**
+ * Decompress Zstandard data, as written by the zstd tool
+ *
+ * Frames may be concatenated, and skippable frames are skipped. Content
+ * checksums are checked. Dictionaries are not supported.
+ *
+ * This needs about 140KB of malloc() space while it runs.
+ *
+ * @param src		Compressed data
+ * @param src_len	Size of compressed data
+ * @param dst		Buffer for the decompressed data
+ * @param dst_len	Size of the buffer on entry, of the data on return
+ * @return 0 if ok, -EINVAL if the data is corrupt, -ENOSPC if the
+ *	buffer is too small, -EBADMSG on a checksum mismatch,
+ *	-EPROTONOSUPPORT if the frame needs a dictionary, -ENOMEM if
+ *	out of memory
+ */
+int zstd_decompress(const void *src, size_t src_len, void *dst,
+		    size_t *dst_len);
+
+#endif /* _ZSTD_H */
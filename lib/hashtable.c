@@ -71,6 +71,7 @@
 
 typedef struct _ENTRY {
 	int used;
+	unsigned int hash;
 	ENTRY entry;
 } _ENTRY;
 
@@ -78,6 +79,47 @@ typedef struct _ENTRY {
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
 
+/*
+ * Compute the hash value of a key.  This is FNV-1a, which spreads the
+ * short and similar names found in an environment (ethaddr, eth1addr,
+ * ...) much better than a shift-and-add hash and so keeps the probe
+ * sequences short.
+ */
+static inline unsigned int hash_key(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* First hash function: simply take the modulus but prevent zero. */
+static inline unsigned int hash_first(unsigned int hash, unsigned int size)
+{
+	unsigned int hval = hash % size;
+
+	return hval ? hval : 1;
+}
+
+/* Second hash function, as suggested in [Knuth] */
+static inline unsigned int hash_second(unsigned int hash, unsigned int size)
+{
+	return 1 + hash % (size - 2);
+}
+
+/*
+ * The table is grown once it is more than three quarters full, since
+ * the probe sequences of double hashing get long quickly beyond that.
+ */
+static inline int hash_overloaded(unsigned int nel, unsigned int size)
+{
+	return nel * 4 > size * 3;
+}
+
 /*
  * hcreate()
  */
@@ -148,17 +190,11 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
  * be freed and the local static variable can be marked as not used.
  */
 
-void hdestroy_r(struct hsearch_data *htab)
+/* Free all entries, leaving an empty table of the same size */
+static void hclear_r(struct hsearch_data *htab)
 {
 	int i;
 
-	/* Test for correct arguments.  */
-	if (htab == NULL) {
-		__set_errno(EINVAL);
-		return;
-	}
-
-	/* free used memory */
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			ENTRY *ep = &htab->table[i].entry;
@@ -167,12 +203,75 @@ void hdestroy_r(struct hsearch_data *htab)
 			free(ep->data);
 		}
 	}
+	memset(htab->table, 0, (htab->size + 1) * sizeof(_ENTRY));
+	htab->filled = 0;
+}
+
+void hdestroy_r(struct hsearch_data *htab)
+{
+	/* Test for correct arguments.  */
+	if (htab == NULL) {
+		__set_errno(EINVAL);
+		return;
+	}
+
+	hclear_r(htab);
 	free(htab->table);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
 }
 
+/*
+ * hresize()
+ */
+
+/*
+ * Move all entries into a new table of at least NEL elements.  The
+ * entries are moved as they are, with their key, data, callback and
+ * flags; deleted slots are dropped on the way.  This must not happen
+ * while a callback is running, since the caller of the callback still
+ * holds a pointer into the old table.
+ */
+static int hresize_r(size_t nel, struct hsearch_data *htab)
+{
+	struct hsearch_data new = { .table = NULL };
+	unsigned int i;
+
+	if (hcreate_r(nel, &new) == 0)
+		return 0;
+
+	debug("hresize: %u -> %u entries, %u used\n", htab->size, new.size,
+	      htab->filled);
+
+	for (i = 1; i <= htab->size; ++i) {
+		unsigned int hash = htab->table[i].hash;
+		unsigned int hval, hval2, idx;
+
+		if (htab->table[i].used <= 0)
+			continue;
+
+		hval = hash_first(hash, new.size);
+		hval2 = hash_second(hash, new.size);
+		for (idx = hval; new.table[idx].used; ) {
+			if (idx <= hval2)
+				idx = new.size + idx - hval2;
+			else
+				idx -= hval2;
+		}
+		new.table[idx] = htab->table[i];
+		new.table[idx].used = hval;
+		++new.filled;
+	}
+
+	free(htab->table);
+	htab->table = new.table;
+	htab->size = new.size;
+	htab->filled = new.filled;
+
+	return 1;
+}
+
 /*
  * hsearch()
  */
@@ -192,6 +291,11 @@ void hdestroy_r(struct hsearch_data *htab)
  * equality of the stored and the parameter value. This helps to prevent
  * unnecessary expensive calls of strcmp.
  *
+ * The full hash value is kept with each entry as well, so that the
+ * table can be grown without computing all the hashes again.  Growing
+ * happens on ENTER when the table gets too full (see hash_overloaded()),
+ * but never from within a change_ok() or callback function.
+ *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
  *
@@ -259,9 +363,9 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
  */
 static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 	ENTRY **retval, struct hsearch_data *htab, int flag,
-	unsigned int hval, unsigned int idx)
+	unsigned int hash, unsigned int idx)
 {
-	if (htab->table[idx].used == hval
+	if (htab->table[idx].used > 0 && htab->table[idx].hash == hash
 	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
 		/* Overwrite existing value? */
 		if ((action == ENTER) && (item.data != NULL)) {
@@ -303,31 +407,16 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 	return -1;
 }
 
-int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+static int _hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	      struct hsearch_data *htab, int flag)
 {
+	unsigned int hash = hash_key(item.key);
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hash_first(hash, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -344,15 +433,11 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			first_deleted = idx;
 
 		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
+			flag, hash, idx);
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
+		hval2 = hash_second(hash, htab->size);
 
 		do {
 			/*
@@ -373,7 +458,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 
 			/* If entry is found use it. */
 			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
+				htab, flag, hash, idx);
 			if (ret != -1)
 				return ret;
 		}
@@ -400,6 +485,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			idx = first_deleted;
 
 		htab->table[idx].used = hval;
+		htab->table[idx].hash = hash;
 		htab->table[idx].entry.key = strdup(item.key);
 		htab->table[idx].entry.data = strdup(item.data);
 		if (!htab->table[idx].entry.key ||
@@ -449,6 +535,24 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	return 0;
 }
 
+int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+	      struct hsearch_data *htab, int flag)
+{
+	int ret;
+
+	/* Make room first; if that fails, carry on in the full table */
+	if (action == ENTER && htab->table && !htab->nesting &&
+	    hash_overloaded(htab->filled + 1, htab->size))
+		hresize_r(2 * htab->size, htab);
+
+	/* Callbacks may set other variables, but must not move the table */
+	++htab->nesting;
+	ret = _hsearch_r(item, action, retval, htab, flag);
+	--htab->nesting;
+
+	return ret;
+}
+
 
 /*
  * hdelete()
@@ -474,7 +578,7 @@ static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	--htab->filled;
 }
 
-int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
+static int _hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 {
 	ENTRY e, *ep;
 	int idx;
@@ -512,6 +616,17 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	return 1;
 }
 
+int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
+{
+	int ret;
+
+	++htab->nesting;
+	ret = _hdelete_r(key, htab, flag);
+	--htab->nesting;
+
+	return ret;
+}
+
 /*
  * hexport()
  */
@@ -721,6 +836,28 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
 	return res;
 }
 
+/*
+ * Count the "name=value" pairs in linearized data, for sizing the hash
+ * table.  Comments and escaped separators make this an estimate, which
+ * is all that is needed.
+ */
+static unsigned int himport_count(const char *env, size_t size, char sep)
+{
+	const char *p = env, *end = env + size;
+	unsigned int n = 0;
+
+	while (p < end && *p) {
+		++n;
+		while (p < end && *p && *p != sep)
+			++p;
+		if (p >= end || (*p == '\0' && sep != '\0'))
+			break;
+		++p;
+	}
+
+	return n;
+}
+
 /*
  * Import linearized data into hash table.
  *
@@ -733,7 +870,9 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  * The "flag" argument can be used to control the behaviour: when the
  * H_NOCLEAR bit is set, then an existing hash table will kept, i. e.
  * new data will be added to an existing hash table; otherwise, old
- * data will be discarded and a new hash table will be created.
+ * data will be discarded.  Either way the table itself is reused when
+ * it is large enough for the new data, and grown once beforehand when
+ * it is not.
  *
  * The separator character for the "name=value" pairs can be selected,
  * so we both support importing from externally stored environment
@@ -762,6 +901,7 @@ int himport_r(struct hsearch_data *htab,
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
+	unsigned int count, need, nent;
 	int i;
 
 	/* Test for correct arguments.  */
@@ -783,38 +923,40 @@ int himport_r(struct hsearch_data *htab,
 	if (nvars)
 		memcpy(localvars, vars, sizeof(vars[0]) * nvars);
 
-	if ((flag & H_NOCLEAR) == 0) {
-		/* Destroy old hash table if one exists */
-		debug("Destroy Hash Table: %p table = %p\n", htab,
+	/*
+	 * Size the hash table from the number of entries actually being
+	 * imported: half full leaves plenty of room for dynamic additions
+	 * before the table has to grow.  CONFIG_ENV_MIN_ENTRIES adds free
+	 * space when importing very small buffers, and CONFIG_ENV_MAX_ENTRIES
+	 * caps that headroom for big environments; the table still grows
+	 * beyond it when needed.  Both can be overwritten in the board
+	 * config file.
+	 */
+	count = himport_count(env, size, sep);
+	nent = 2 * count;
+	if (nent < CONFIG_ENV_MIN_ENTRIES)
+		nent = CONFIG_ENV_MIN_ENTRIES;
+	if (nent > CONFIG_ENV_MAX_ENTRIES)
+		nent = CONFIG_ENV_MAX_ENTRIES;
+	need = (flag & H_NOCLEAR) ? htab->filled + count : count;
+	if (hash_overloaded(need, nent))
+		nent = 2 * need;
+
+	if (htab->table && (flag & H_NOCLEAR) == 0) {
+		/* Empty the old hash table, keeping it if the new data fits */
+		debug("Clear Hash Table: %p table = %p\n", htab,
 		       htab->table);
-		if (htab->table)
+		if (hash_overloaded(need, htab->size) && !htab->nesting)
 			hdestroy_r(htab);
+		else
+			hclear_r(htab);
+	} else if (htab->table && !htab->nesting &&
+		   hash_overloaded(need, htab->size)) {
+		/* Grow it once rather than while importing */
+		hresize_r(nent, htab);
 	}
 
-	/*
-	 * Create new hash table (if needed).  The computation of the hash
-	 * table size is based on heuristics: in a sample of some 70+
-	 * existing systems we found an average size of 39+ bytes per entry
-	 * in the environment (for the whole key=value pair). Assuming a
-	 * size of 8 per entry (= safety factor of ~5) should provide enough
-	 * safety margin for any existing environment definitions and still
-	 * allow for more than enough dynamic additions. Note that the
-	 * "size" argument is supposed to give the maximum enviroment size
-	 * (CONFIG_ENV_SIZE).  This heuristics will result in
-	 * unreasonably large numbers (and thus memory footprint) for
-	 * big flash environments (>8,000 entries for 64 KB
-	 * envrionment size), so we clip it to a reasonable value.
-	 * On the other hand we need to add some more entries for free
-	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
-	 */
-
 	if (!htab->table) {
-		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
-
-		if (nent > CONFIG_ENV_MAX_ENTRIES)
-			nent = CONFIG_ENV_MAX_ENTRIES;
-
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
@@ -0,0 +1,333 @@
+/*
+ * LZ4 decompression: blocks, frames and the legacy format
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <lz4.h>
+#include <watchdog.h>
+#include <xxhash.h>
+#include <asm/unaligned.h>
+
+#define LZ4_MAGIC		0x184d2204
+#define LZ4_LEGACY_MAGIC	0x184c2102
+#define LZ4_SKIP_MAGIC		0x184d2a50	/* 16 of them */
+#define LZ4_SKIP_MASK		0xfffffff0
+
+/* Frame descriptor */
+#define LZ4_FLG_VERSION_MASK	0xc0
+#define LZ4_FLG_VERSION		0x40
+#define LZ4_FLG_BLOCK_SUM	0x10
+#define LZ4_FLG_SIZE		0x08
+#define LZ4_FLG_CONTENT_SUM	0x04
+#define LZ4_FLG_RESERVED	0x02
+#define LZ4_FLG_DICT		0x01
+#define LZ4_BD_RESERVED		0x8f
+#define LZ4_BD_SIZE_SHIFT	4
+#define LZ4_BD_SIZE_MASK	7
+
+#define LZ4_BLOCK_RAW		0x80000000	/* block is not compressed */
+
+#define LZ4_MIN_MATCH		4
+#define LZ4_RUN_MASK		15
+
+/*
+ * Copies go 8 bytes at a time, and may write up to 7 bytes past their
+ * end, so they are only used with that much room left in the buffer
+ */
+#define LZ4_COPY		8
+
+static inline void lz4_copy8(u8 *dst, const u8 *src)
+{
+	__builtin_memcpy(dst, src, LZ4_COPY);
+}
+
+/* Add up the 255s (and the last byte) of a long literal or match length */
+static int lz4_len(const u8 **ipp, const u8 *iend, size_t *len)
+{
+	const u8 *ip = *ipp;
+	u8 val;
+
+	do {
+		if (ip >= iend)
+			return -EINVAL;
+		val = *ip++;
+		*len += val;
+	} while (val == 255);
+	*ipp = ip;
+
+	return 0;
+}
+
+/*
+ * Copy a match of len bytes from offset bytes back. A copy chunk must
+ * not overlap its own source, so for a short offset the pattern is first
+ * repeated byte by byte until it is at least a chunk long.
+ */
+static inline void lz4_match(u8 *op, size_t offset, size_t len)
+{
+	const u8 *match = op - offset;
+	u8 *cpy = op + len;
+	size_t period, n;
+
+	if (offset < LZ4_COPY) {
+		for (period = offset; period < LZ4_COPY; period <<= 1)
+			;
+		n = min(len, period);
+		while (n--)
+			*op++ = *match++;
+		match = op - period;
+	}
+	while (op < cpy) {
+		lz4_copy8(op, match);
+		op += LZ4_COPY;
+		match += LZ4_COPY;
+	}
+}
+
+/**
+ * Decompress a single LZ4 block
+ *
+ * @param ip	Compressed block
+ * @param len	Size of compressed block
+ * @param opp	Output pointer, updated on return
+ * @param oend	End of output buffer
+ * @param base	Earliest output byte that a match may refer to
+ * @return 0 if ok, -ve on error
+ */
+static int lz4_block(const u8 *ip, size_t len, u8 **opp, u8 *oend,
+		     const u8 *base)
+{
+	const u8 *iend = ip + len;
+	u8 *op = *opp;
+	size_t offset;
+	uint token;
+
+	for (;;) {
+		if (ip >= iend)
+			return -EINVAL;
+		token = *ip++;
+
+		/* Literals */
+		len = token >> 4;
+		if (len == LZ4_RUN_MASK && lz4_len(&ip, iend, &len))
+			return -EINVAL;
+		if (len > iend - ip)
+			return -EINVAL;
+		if (len > oend - op)
+			return -ENOSPC;
+		if (len <= 2 * LZ4_COPY && iend - ip >= 2 * LZ4_COPY &&
+		    oend - op >= 2 * LZ4_COPY) {
+			lz4_copy8(op, ip);
+			lz4_copy8(op + LZ4_COPY, ip + LZ4_COPY);
+		} else {
+			memcpy(op, ip, len);
+		}
+		ip += len;
+		op += len;
+
+		/* The last sequence has no match */
+		if (ip == iend)
+			break;
+
+		/* Match */
+		if (iend - ip < 2)
+			return -EINVAL;
+		offset = get_unaligned_le16(ip);
+		ip += 2;
+		if (!offset || offset > op - base)
+			return -EINVAL;
+		len = token & LZ4_RUN_MASK;
+		if (len == LZ4_RUN_MASK && lz4_len(&ip, iend, &len))
+			return -EINVAL;
+		len += LZ4_MIN_MATCH;
+		if (len > oend - op)
+			return -ENOSPC;
+		if (oend - op >= len + LZ4_COPY) {
+			lz4_match(op, offset, len);
+		} else {
+			const u8 *match = op - offset;
+			size_t i;
+
+			for (i = 0; i < len; i++)
+				op[i] = match[i];
+		}
+		op += len;
+	}
+	*opp = op;
+
+	return 0;
+}
+
+/* Decompress a frame, from just after its magic number */
+static int lz4_frame(const u8 **ipp, const u8 *iend, u8 **opp, u8 *oend)
+{
+	const u8 *ip = *ipp;
+	const u8 *desc = ip;
+	u8 *start = *opp;
+	u8 *op = start;
+	u64 content_size = 0;
+	size_t max_block;
+	u32 size;
+	uint flg, bd;
+	int ret;
+
+	if (iend - ip < 3)
+		return -EINVAL;
+	flg = *ip++;
+	bd = *ip++;
+	if ((flg & (LZ4_FLG_VERSION_MASK | LZ4_FLG_RESERVED)) !=
+	    LZ4_FLG_VERSION || (bd & LZ4_BD_RESERVED) ||
+	    (bd >> LZ4_BD_SIZE_SHIFT & LZ4_BD_SIZE_MASK) < 4)
+		return -EINVAL;
+	/* From 64KB to 4MB */
+	max_block = 1 << (8 + 2 * (bd >> LZ4_BD_SIZE_SHIFT & LZ4_BD_SIZE_MASK));
+	if (flg & LZ4_FLG_SIZE) {
+		if (iend - ip < 9)
+			return -EINVAL;
+		content_size = get_unaligned_le64(ip);
+		ip += 8;
+	}
+	if (flg & LZ4_FLG_DICT)
+		return -EPROTONOSUPPORT;
+	if (ip >= iend)
+		return -EINVAL;
+	if (*ip != (xxh32(desc, ip - desc, 0) >> 8 & 0xff))
+		return -EBADMSG;
+	ip++;
+
+	for (;;) {
+		if (iend - ip < 4)
+			return -EINVAL;
+		size = get_unaligned_le32(ip);
+		ip += 4;
+		if (!size)
+			break;		/* end mark */
+		if ((size & ~LZ4_BLOCK_RAW) > max_block ||
+		    (size & ~LZ4_BLOCK_RAW) > iend - ip)
+			return -EINVAL;
+		if (flg & LZ4_FLG_BLOCK_SUM) {
+			if (iend - ip - (size & ~LZ4_BLOCK_RAW) < 4)
+				return -EINVAL;
+			if (xxh32(ip, size & ~LZ4_BLOCK_RAW, 0) !=
+			    get_unaligned_le32(ip + (size & ~LZ4_BLOCK_RAW)))
+				return -EBADMSG;
+		}
+		if (size & LZ4_BLOCK_RAW) {
+			size &= ~LZ4_BLOCK_RAW;
+			if (size > oend - op)
+				return -ENOSPC;
+			memcpy(op, ip, size);
+			op += size;
+		} else {
+			/* Dependent blocks may refer back into earlier ones */
+			ret = lz4_block(ip, size, &op, oend, start);
+			if (ret)
+				return ret;
+		}
+		ip += size;
+		if (flg & LZ4_FLG_BLOCK_SUM)
+			ip += 4;
+		WATCHDOG_RESET();
+	}
+
+	if (flg & LZ4_FLG_CONTENT_SUM) {
+		if (iend - ip < 4)
+			return -EINVAL;
+		if (xxh32(start, op - start, 0) != get_unaligned_le32(ip))
+			return -EBADMSG;
+		ip += 4;
+	}
+	if ((flg & LZ4_FLG_SIZE) && content_size != op - start)
+		return -EINVAL;
+	*ipp = ip;
+	*opp = op;
+
+	return 0;
+}
+
+/*
+ * Decompress a legacy frame: independent blocks which each decompress to
+ * 8MB, except the last. It ends with the input or the next frame.
+ */
+static int lz4_legacy(const u8 **ipp, const u8 *iend, u8 **opp, u8 *oend)
+{
+	const u8 *ip = *ipp;
+	u32 size;
+	int ret;
+
+	while (iend - ip >= 4) {
+		size = get_unaligned_le32(ip);
+		if (size == LZ4_MAGIC || size == LZ4_LEGACY_MAGIC ||
+		    (size & LZ4_SKIP_MASK) == LZ4_SKIP_MAGIC)
+			break;
+		ip += 4;
+		if (size > iend - ip)
+			return -EINVAL;
+		ret = lz4_block(ip, size, opp, oend, *opp);
+		if (ret)
+			return ret;
+		ip += size;
+		WATCHDOG_RESET();
+	}
+	*ipp = ip;
+
+	return 0;
+}
+
+int lz4_decompress(const void *src, size_t src_len, void *dst,
+		   size_t *dst_len)
+{
+	const u8 *ip = src;
+	const u8 *iend = ip + src_len;
+	u8 *op = dst;
+	u32 magic, size;
+	int ret;
+
+	do {
+		if (iend - ip < 4) {
+			ret = -EINVAL;
+			break;
+		}
+		magic = get_unaligned_le32(ip);
+		ip += 4;
+		if (magic == LZ4_MAGIC) {
+			ret = lz4_frame(&ip, iend, &op, dst + *dst_len);
+		} else if (magic == LZ4_LEGACY_MAGIC) {
+			ret = lz4_legacy(&ip, iend, &op, dst + *dst_len);
+		} else if ((magic & LZ4_SKIP_MASK) == LZ4_SKIP_MAGIC) {
+			ret = -EINVAL;
+			if (iend - ip < 4)
+				break;
+			size = get_unaligned_le32(ip);
+			ip += 4;
+			if (size > iend - ip)
+				break;
+			ip += size;
+			ret = 0;
+		} else {
+			ret = -EINVAL;
+		}
+	} while (!ret && ip < iend);
+	*dst_len = op - (u8 *)dst;
+
+	return ret;
+}
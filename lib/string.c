@@ -19,6 +19,7 @@
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
+#include <asm/byteorder.h>
 
 
 /**
@@ -400,6 +401,120 @@ char *strswab(const char *s)
 }
 #endif
 
+#define MEM_WORD	sizeof(unsigned long)
+#define MEM_MASK	(MEM_WORD - 1)
+
+#if !defined(__HAVE_ARCH_MEMCPY) || !defined(__HAVE_ARCH_MEMMOVE)
+/*
+ * Large copies prefetch the source this far ahead, a few cache lines, in
+ * case the CPU does not spot the stream by itself (or has no caches on,
+ * in which case this does nothing).
+ */
+#define MEM_PREFETCH	256
+
+/*
+ * Merge the end of one aligned source word with the start of the next,
+ * for a source which is 'shift' bits further into a word than the
+ * destination
+ */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define MEM_MERGE(lo, hi, shift) \
+	((lo) >> (shift) | (hi) << (8 * MEM_WORD - (shift)))
+#else
+#define MEM_MERGE(lo, hi, shift) \
+	((lo) << (shift) | (hi) >> (8 * MEM_WORD - (shift)))
+#endif
+
+/*
+ * Copy the whole words of count bytes upwards, to a word-aligned d8, and
+ * return the number of bytes copied. A source which is not aligned is
+ * read a word at a time all the same, and shifted into place; this may
+ * read a little past the end, but never outside the last word touched.
+ *
+ * Each word is read before anything above it is written, so this is
+ * safe for memmove() with d8 below s8.
+ */
+static size_t mem_copy_fwd(char *d8, const char *s8, size_t count)
+{
+	unsigned long *dl = (unsigned long *)d8;
+	const unsigned long *sl;
+	uint shift = ((ulong)s8 & MEM_MASK) * 8;
+	size_t words = count / MEM_WORD;
+	unsigned long lo, hi;
+
+	if (!shift) {
+		sl = (const unsigned long *)s8;
+		for (; words >= 4; words -= 4) {
+			if (words * MEM_WORD > MEM_PREFETCH)
+				__builtin_prefetch(sl + MEM_PREFETCH / MEM_WORD);
+			dl[0] = sl[0];
+			dl[1] = sl[1];
+			dl[2] = sl[2];
+			dl[3] = sl[3];
+			dl += 4;
+			sl += 4;
+		}
+		while (words--)
+			*dl++ = *sl++;
+	} else if (words >= 4) {
+		sl = (const unsigned long *)(s8 - shift / 8);
+		lo = *sl++;
+		while (words--) {
+			hi = *sl++;
+			*dl++ = MEM_MERGE(lo, hi, shift);
+			lo = hi;
+		}
+	} else {
+		return 0;	/* not worth shifting */
+	}
+
+	return count & ~MEM_MASK;
+}
+#endif
+
+#ifndef __HAVE_ARCH_MEMMOVE
+/*
+ * The same downwards, from just below the word-aligned d8 and s8, for
+ * memmove() with d8 above s8
+ */
+static size_t mem_copy_bwd(char *d8, const char *s8, size_t count)
+{
+	unsigned long *dl = (unsigned long *)d8;
+	const unsigned long *sl;
+	uint shift = ((ulong)s8 & MEM_MASK) * 8;
+	size_t words = count / MEM_WORD;
+	unsigned long lo, hi;
+
+	if (!shift) {
+		sl = (const unsigned long *)s8;
+		for (; words >= 4; words -= 4) {
+			if (words * MEM_WORD > MEM_PREFETCH)
+				__builtin_prefetch(sl - MEM_PREFETCH / MEM_WORD);
+			dl -= 4;
+			sl -= 4;
+			dl[3] = sl[3];
+			dl[2] = sl[2];
+			dl[1] = sl[1];
+			dl[0] = sl[0];
+		}
+		while (words--)
+			*--dl = *--sl;
+	} else if (words >= 4) {
+		sl = (const unsigned long *)(s8 - shift / 8);
+		hi = *sl;
+		while (words--) {
+			lo = *--sl;
+			*--dl = MEM_MERGE(lo, hi, shift);
+			hi = lo;
+		}
+	} else {
+		return 0;
+	}
+
+	return count & ~MEM_MASK;
+}
+#endif
+
 #ifndef __HAVE_ARCH_MEMSET
 /**
  * memset - Fill a region of memory with the given value
@@ -411,24 +526,34 @@ char *strswab(const char *s)
  */
 void * memset(void * s,int c,size_t count)
 {
-	unsigned long *sl = (unsigned long *) s;
+	unsigned long *sl;
 	unsigned long cl = 0;
-	char *s8;
+	char *s8 = s;
 	int i;
 
-	/* do it one word at a time (32 bits or 64 bits) while possible */
-	if ( ((ulong)s & (sizeof(*sl) - 1)) == 0) {
-		for (i = 0; i < sizeof(*sl); i++) {
+	/* align, then do it four words at a time (32 bits or 64 bits) */
+	if (count >= 2 * MEM_WORD) {
+		while ((ulong)s8 & MEM_MASK) {
+			*s8++ = c;
+			count--;
+		}
+		for (i = 0; i < MEM_WORD; i++) {
 			cl <<= 8;
 			cl |= c & 0xff;
 		}
-		while (count >= sizeof(*sl)) {
-			*sl++ = cl;
-			count -= sizeof(*sl);
+		sl = (unsigned long *)s8;
+		for (; count >= 4 * MEM_WORD; count -= 4 * MEM_WORD) {
+			sl[0] = cl;
+			sl[1] = cl;
+			sl[2] = cl;
+			sl[3] = cl;
+			sl += 4;
 		}
+		for (; count >= MEM_WORD; count -= MEM_WORD)
+			*sl++ = cl;
+		s8 = (char *)sl;
 	}
 	/* fill 8 bits at a time */
-	s8 = (char *)sl;
 	while (count--)
 		*s8++ = c;
 
@@ -472,22 +597,25 @@ char * bcopy(const char * src, char * dest, int count)
  */
 void * memcpy(void *dest, const void *src, size_t count)
 {
-	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
-	char *d8, *s8;
+	char *d8 = dest;
+	const char *s8 = src;
+	size_t done;
 
 	if (src == dest)
 		return dest;
 
-	/* while all data is aligned (common case), copy a word at a time */
-	if ( (((ulong)dest | (ulong)src) & (sizeof(*dl) - 1)) == 0) {
-		while (count >= sizeof(*dl)) {
-			*dl++ = *sl++;
-			count -= sizeof(*dl);
+	/* align the destination, then copy a word at a time */
+	if (count >= 2 * MEM_WORD) {
+		while ((ulong)d8 & MEM_MASK) {
+			*d8++ = *s8++;
+			count--;
 		}
+		done = mem_copy_fwd(d8, s8, count);
+		d8 += done;
+		s8 += done;
+		count -= done;
 	}
-	/* copy the reset one byte at a time */
-	d8 = (char *)dl;
-	s8 = (char *)sl;
+	/* copy the rest one byte at a time */
 	while (count--)
 		*d8++ = *s8++;
 
@@ -506,23 +634,44 @@ void * memcpy(void *dest, const void *src, size_t count)
  */
 void * memmove(void * dest,const void *src,size_t count)
 {
-	char *tmp, *s;
+	char *d8;
+	const char *s8;
+	size_t done;
 
 	if (src == dest)
 		return dest;
 
 	if (dest <= src) {
-		tmp = (char *) dest;
-		s = (char *) src;
-		while (count--)
-			*tmp++ = *s++;
+		d8 = dest;
+		s8 = src;
+		if (count >= 2 * MEM_WORD) {
+			while ((ulong)d8 & MEM_MASK) {
+				*d8++ = *s8++;
+				count--;
+			}
+			done = mem_copy_fwd(d8, s8, count);
+			d8 += done;
+			s8 += done;
+			count -= done;
 		}
-	else {
-		tmp = (char *) dest + count;
-		s = (char *) src + count;
 		while (count--)
-			*--tmp = *--s;
+			*d8++ = *s8++;
+	} else {
+		d8 = (char *)dest + count;
+		s8 = (const char *)src + count;
+		if (count >= 2 * MEM_WORD) {
+			while ((ulong)d8 & MEM_MASK) {
+				*--d8 = *--s8;
+				count--;
+			}
+			done = mem_copy_bwd(d8, s8, count);
+			d8 -= done;
+			s8 -= done;
+			count -= done;
 		}
+		while (count--)
+			*--d8 = *--s8;
+	}
 
 	return dest;
 }
@@ -0,0 +1,159 @@
+/*
+ * xxHash - fast non-cryptographic hash, after the reference code by
+ * Yann Collet (BSD licence)
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <xxhash.h>
+#include <asm/unaligned.h>
+
+#define PRIME32_1	2654435761U
+#define PRIME32_2	2246822519U
+#define PRIME32_3	3266489917U
+#define PRIME32_4	668265263U
+#define PRIME32_5	374761393U
+
+#define PRIME64_1	11400714785074694791ULL
+#define PRIME64_2	14029467366897019727ULL
+#define PRIME64_3	1609587929392839161ULL
+#define PRIME64_4	9650029242287828579ULL
+#define PRIME64_5	2870177450012600261ULL
+
+#define rotl32(x, r)	(((x) << (r)) | ((x) >> (32 - (r))))
+#define rotl64(x, r)	(((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline u32 xxh32_round(u32 acc, u32 input)
+{
+	acc += input * PRIME32_2;
+	acc = rotl32(acc, 13);
+
+	return acc * PRIME32_1;
+}
+
+u32 xxh32(const void *input, size_t len, u32 seed)
+{
+	const u8 *p = input;
+	const u8 *end = p + len;
+	u32 v1, v2, v3, v4, h;
+
+	if (len >= 16) {
+		v1 = seed + PRIME32_1 + PRIME32_2;
+		v2 = seed + PRIME32_2;
+		v3 = seed;
+		v4 = seed - PRIME32_1;
+		do {
+			v1 = xxh32_round(v1, get_unaligned_le32(p));
+			v2 = xxh32_round(v2, get_unaligned_le32(p + 4));
+			v3 = xxh32_round(v3, get_unaligned_le32(p + 8));
+			v4 = xxh32_round(v4, get_unaligned_le32(p + 12));
+			p += 16;
+		} while (p <= end - 16);
+		h = rotl32(v1, 1) + rotl32(v2, 7) + rotl32(v3, 12) +
+			rotl32(v4, 18);
+	} else {
+		h = seed + PRIME32_5;
+	}
+
+	h += (u32)len;
+	for (; p + 4 <= end; p += 4) {
+		h += get_unaligned_le32(p) * PRIME32_3;
+		h = rotl32(h, 17) * PRIME32_4;
+	}
+	for (; p < end; p++) {
+		h += *p * PRIME32_5;
+		h = rotl32(h, 11) * PRIME32_1;
+	}
+
+	h ^= h >> 15;
+	h *= PRIME32_2;
+	h ^= h >> 13;
+	h *= PRIME32_3;
+	h ^= h >> 16;
+
+	return h;
+}
+
+static inline u64 xxh64_round(u64 acc, u64 input)
+{
+	acc += input * PRIME64_2;
+	acc = rotl64(acc, 31);
+
+	return acc * PRIME64_1;
+}
+
+static inline u64 xxh64_merge_round(u64 acc, u64 val)
+{
+	acc ^= xxh64_round(0, val);
+
+	return acc * PRIME64_1 + PRIME64_4;
+}
+
+u64 xxh64(const void *input, size_t len, u64 seed)
+{
+	const u8 *p = input;
+	const u8 *end = p + len;
+	u64 v1, v2, v3, v4, h;
+
+	if (len >= 32) {
+		v1 = seed + PRIME64_1 + PRIME64_2;
+		v2 = seed + PRIME64_2;
+		v3 = seed;
+		v4 = seed - PRIME64_1;
+		do {
+			v1 = xxh64_round(v1, get_unaligned_le64(p));
+			v2 = xxh64_round(v2, get_unaligned_le64(p + 8));
+			v3 = xxh64_round(v3, get_unaligned_le64(p + 16));
+			v4 = xxh64_round(v4, get_unaligned_le64(p + 24));
+			p += 32;
+		} while (p <= end - 32);
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) +
+			rotl64(v4, 18);
+		h = xxh64_merge_round(h, v1);
+		h = xxh64_merge_round(h, v2);
+		h = xxh64_merge_round(h, v3);
+		h = xxh64_merge_round(h, v4);
+	} else {
+		h = seed + PRIME64_5;
+	}
+
+	h += (u64)len;
+	for (; p + 8 <= end; p += 8) {
+		h ^= xxh64_round(0, get_unaligned_le64(p));
+		h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+	}
+	if (p + 4 <= end) {
+		h ^= (u64)get_unaligned_le32(p) * PRIME64_1;
+		h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * PRIME64_5;
+		h = rotl64(h, 11) * PRIME64_1;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+
+	return h;
+}
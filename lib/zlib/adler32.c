@@ -53,6 +53,64 @@
 #  define MOD4(a) a %= BASE
 #endif
 
+/* U-boot: with CONFIG_ZLIB_CHUNK, do whole blocks of 16 bytes with SSE2 */
+#if defined(CONFIG_ZLIB_CHUNK) && defined(__SSE2__)
+/* Keep emmintrin.h from pulling in stdlib.h for _mm_malloc(), unused */
+#define _MM_MALLOC_H_INCLUDED
+#include <emmintrin.h>
+
+/*
+   For a block of n bytes, sum2 grows by n times adler plus each byte
+   weighted by its distance from the end of the block. Each 16 bytes are
+   summed plainly (for adler) and weighted by 16..1, and the sums of the
+   earlier 16-byte pieces, times 16, make up the rest of the weights. An
+   NMAX block keeps every lane within 32 bits, as it does the scalar sums.
+ */
+local uInt adler32_sse2(unsigned long *adlerp, unsigned long *sum2p,
+                        const Bytef **bufp, uInt len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w_lo = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+    const __m128i w_hi = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+    unsigned long adler = *adlerp, sum2 = *sum2p;
+    const Bytef *buf = *bufp;
+    __m128i va, vs, vprev, b;
+    unsigned int lanes[4];
+    unsigned n;
+
+    while (len >= 16) {
+        n = len < NMAX ? len & ~15 : NMAX;
+        len -= n;
+        sum2 += adler * n;
+        va = vs = vprev = zero;
+        for (; n; n -= 16) {
+            b = _mm_loadu_si128((const __m128i *)buf);
+            vprev = _mm_add_epi32(vprev, va);
+            va = _mm_add_epi32(va, _mm_sad_epu8(b, zero));
+            vs = _mm_add_epi32(vs,
+                               _mm_madd_epi16(_mm_unpacklo_epi8(b, zero), w_lo));
+            vs = _mm_add_epi32(vs,
+                               _mm_madd_epi16(_mm_unpackhi_epi8(b, zero), w_hi));
+            buf += 16;
+        }
+        vs = _mm_add_epi32(vs, _mm_slli_epi32(vprev, 4));
+
+        _mm_storeu_si128((__m128i *)lanes, va);
+        adler += lanes[0] + lanes[2];
+        _mm_storeu_si128((__m128i *)lanes, vs);
+        sum2 += (unsigned)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+        MOD(adler);
+        MOD(sum2);
+    }
+
+    *adlerp = adler;
+    *sum2p = sum2;
+    *bufp = buf;
+    return len;
+}
+#define ADLER32_SIMD adler32_sse2
+#endif
+
 /* ========================================================================= */
 uLong ZEXPORT adler32(uLong adler, const Bytef *buf, uInt len)
 {
@@ -90,6 +148,10 @@ uLong ZEXPORT adler32(uLong adler, const Bytef *buf, uInt len)
         return adler | (sum2 << 16);
     }
 
+#ifdef ADLER32_SIMD
+    len = ADLER32_SIMD(&adler, &sum2, &buf, len);
+#endif
+
     /* do length NMAX blocks -- requires just one modulo operation */
     while (len >= NMAX) {
         len -= NMAX;
@@ -8,4 +8,13 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* U-boot: input and output that inflate_fast() needs to be called */
+#ifdef CONFIG_ZLIB_CHUNK
+#define INFLATE_FAST_MIN_INPUT  (6 + 2 * sizeof(unsigned long))
+#define INFLATE_FAST_MIN_OUTPUT (258 + 16)
+#else
+#define INFLATE_FAST_MIN_INPUT  6
+#define INFLATE_FAST_MIN_OUTPUT 258
+#endif
+
 void inflate_fast OF((z_streamp strm, unsigned start));
@@ -0,0 +1,371 @@
+/* inffast_chunk.c -- fast decoding with wide refills and chunked copies
+ * Copyright (C) 1995-2004 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* U-boot: this is inffast.c, reworked for CONFIG_ZLIB_CHUNK:
+
+   - The bit buffer is refilled a whole word at a time instead of a byte
+     at a time. On a 64-bit machine one refill then covers a complete
+     length/distance pair, so there is one refill per code instead of up
+     to four.
+
+   - Where unaligned accesses just work, matches are copied in chunks of
+     16 bytes (SSE2 or NEON registers, if the compiler has them) or a
+     word, rather than a byte at a time. A chunk copy may write up to a
+     chunk past the end of the match, which is later overwritten with
+     the right data; INFLATE_FAST_MIN_OUTPUT leaves room for it at the
+     end of the output buffer.
+
+   The input is read up to two words ahead, hence INFLATE_FAST_MIN_INPUT.
+   The bits of the bit buffer above 'bits' hold input bytes which have
+   been loaded but not yet counted: a refill ORs the same bytes into the
+   same place again, and they are cleared before returning.
+ */
+
+#ifndef ASMINF
+
+/* Architectures where unaligned loads and stores just work */
+#if defined(__i386__) || defined(__x86_64__)
+#define INFLATE_UNALIGNED_OK
+#endif
+
+#define HOLD_BITS	(8 * sizeof(unsigned long))
+
+#ifdef INFLATE_UNALIGNED_OK
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+typedef unsigned char z_chunk_t __attribute__((vector_size(16)));
+#else
+typedef unsigned long z_chunk_t;
+#endif
+#define CHUNK_SIZE	sizeof(z_chunk_t)
+
+/* Load a word of input, little-endian */
+static inline unsigned long load_hold(const unsigned char FAR *in)
+{
+    unsigned long val;
+
+    __builtin_memcpy(&val, in, sizeof(val));
+    return sizeof(val) == 8 ? le64_to_cpu(val) : le32_to_cpu(val);
+}
+
+static inline void copy_chunk(unsigned char FAR *out,
+                              const unsigned char FAR *from)
+{
+    z_chunk_t chunk;
+
+    __builtin_memcpy(&chunk, from, sizeof(chunk));
+    __builtin_memcpy(out, &chunk, sizeof(chunk));
+}
+
+/*
+   Copy a match of len bytes from dist bytes back, returning the new end
+   of the output. A chunk must not overlap its own source, so for a short
+   distance the pattern is first repeated byte by byte, until it is at
+   least a chunk long.
+ */
+static inline unsigned char FAR *copy_match(unsigned char FAR *out,
+                                            unsigned dist, unsigned len)
+{
+    unsigned char FAR *from = out - dist;
+    unsigned period, n;
+
+    if (dist < CHUNK_SIZE) {
+        for (period = dist; period < CHUNK_SIZE; period <<= 1)
+            ;
+        n = len < period ? len : period;
+        len -= n;
+        do {
+            *out++ = *from++;
+        } while (--n);
+        from = out - period;
+    }
+    while (len >= CHUNK_SIZE) {
+        copy_chunk(out, from);
+        out += CHUNK_SIZE;
+        from += CHUNK_SIZE;
+        len -= CHUNK_SIZE;
+    }
+    if (len) {
+        copy_chunk(out, from);
+        out += len;
+    }
+
+    return out;
+}
+#else
+static inline unsigned long load_hold(const unsigned char FAR *in)
+{
+    if (sizeof(unsigned long) == 8)
+        return get_unaligned_le64(in);
+    return get_unaligned_le32(in);
+}
+
+static inline unsigned char FAR *copy_match(unsigned char FAR *out,
+                                            unsigned dist, unsigned len)
+{
+    unsigned char FAR *from = out - dist;
+
+    while (len > 2) {
+        *out++ = *from++;
+        *out++ = *from++;
+        *out++ = *from++;
+        len -= 3;
+    }
+    if (len) {
+        *out++ = *from++;
+        if (len > 1)
+            *out++ = *from++;
+    }
+
+    return out;
+}
+#endif
+
+/* Fill the bit buffer to at least HOLD_BITS - 8 bits */
+#define REFILL() \
+    do { \
+        hold |= load_hold(in) << bits; \
+        in += (HOLD_BITS - 1 - bits) >> 3; \
+        bits |= HOLD_BITS - 8; \
+    } while (0)
+
+/*
+   Decode literal, length, and distance codes and write out the resulting
+   literal and match bytes until either not enough input or output is
+   available, an end-of-block is encountered, or a data error is encountered.
+
+   Entry assumptions:
+
+        state->mode == LEN
+        strm->avail_in >= INFLATE_FAST_MIN_INPUT
+        strm->avail_out >= INFLATE_FAST_MIN_OUTPUT
+        start >= strm->avail_out
+        state->bits < 8
+
+   On return, state->mode is one of:
+
+        LEN -- ran out of enough output space or enough available input
+        TYPE -- reached end of block code, inflate() to interpret next block
+        BAD -- error in block data
+ */
+void inflate_fast(z_streamp strm, unsigned start)
+/* start: inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    unsigned long hold;         /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_INPUT - 1) {
+        /*
+         * overflow detected, limit strm->avail_in to the
+         * max. possible size and recalculate last
+         */
+        strm->avail_in = 0xffffffff - (uintptr_t)in;
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
+    }
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_OUTPUT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        if (bits < 15)
+            REFILL();
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                if (bits < op)
+                    REFILL();
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            if (bits < 15)
+                REFILL();
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                if (bits < op)
+                    REFILL();
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    from = window;
+                    if (write == 0) {           /* very common case */
+                        from += wsize - op;
+                        if (op < len) {         /* some from window */
+                            len -= op;
+                            do {
+                                *out++ = *from++;
+                            } while (--op);
+                            from = out - dist;  /* rest from output */
+                        }
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from += wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            do {
+                                *out++ = *from++;
+                            } while (--op);
+                            from = window;
+                            if (write < len) {  /* some from start of window */
+                                op = write;
+                                len -= op;
+                                do {
+                                    *out++ = *from++;
+                                } while (--op);
+                                from = out - dist;      /* rest from output */
+                            }
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += write - op;
+                        if (op < len) {         /* some from window */
+                            len -= op;
+                            do {
+                                *out++ = *from++;
+                            } while (--op);
+                            from = out - dist;  /* rest from output */
+                        }
+                    }
+                    while (len > 2) {
+                        *out++ = *from++;
+                        *out++ = *from++;
+                        *out++ = *from++;
+                        len -= 3;
+                    }
+                    if (len) {
+                        *out++ = *from++;
+                        if (len > 1)
+                            *out++ = *from++;
+                    }
+                }
+                else
+                    out = copy_match(out, dist, len);
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1UL << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+        (INFLATE_FAST_MIN_INPUT - 1) + (last - in) :
+        (INFLATE_FAST_MIN_INPUT - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+        (INFLATE_FAST_MIN_OUTPUT - 1) + (end - out) :
+        (INFLATE_FAST_MIN_OUTPUT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+    return;
+}
+
+#endif /* !ASMINF */
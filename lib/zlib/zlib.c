@@ -10,6 +10,7 @@
  * - added minCompression parameter to deflateInit2
  * - added Z_PACKET_FLUSH (see zlib.h for details)
  * - added inflateIncomp
+ * - added inffast_chunk.c, a faster inflate_fast() (CONFIG_ZLIB_CHUNK)
  */
 
 #include <common.h>
@@ -25,7 +26,11 @@
 #include "inflate.h"
 #include "inffast.h"
 #include "inffixed.h"
+#ifdef CONFIG_ZLIB_CHUNK
+#include "inffast_chunk.c"
+#else
 #include "inffast.c"
+#endif
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
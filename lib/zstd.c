@@ -0,0 +1,1042 @@
+/*
+ * Zstandard decompression, following RFC 8878
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * The whole output is in memory, so matches are copied straight from
+ * earlier output and there is no separate window. Literals are decoded
+ * into a buffer of their own, one block at a time.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <xxhash.h>
+#include <zstd.h>
+#include <asm/unaligned.h>
+
+#define ZSTD_MAGIC		0xfd2fb528
+#define ZSTD_SKIP_MAGIC		0x184d2a50	/* 16 of them */
+#define ZSTD_SKIP_MASK		0xfffffff0
+
+#define ZSTD_BLOCK_MAX		(128 << 10)
+
+/* Frame header descriptor */
+#define ZSTD_FHD_SIZE_SHIFT	6
+#define ZSTD_FHD_SINGLE		0x20
+#define ZSTD_FHD_RESERVED	0x08
+#define ZSTD_FHD_CHECKSUM	0x04
+#define ZSTD_FHD_DICT_MASK	0x03
+
+enum {
+	ZSTD_BLOCK_RAW,
+	ZSTD_BLOCK_RLE,
+	ZSTD_BLOCK_COMPRESSED,
+	ZSTD_BLOCK_RESERVED,
+};
+
+enum {
+	ZSTD_LIT_RAW,
+	ZSTD_LIT_RLE,
+	ZSTD_LIT_COMPRESSED,
+	ZSTD_LIT_TREELESS,
+};
+
+/* How each table of the sequences section is given */
+enum {
+	ZSTD_MODE_PREDEFINED,
+	ZSTD_MODE_RLE,
+	ZSTD_MODE_FSE,
+	ZSTD_MODE_REPEAT,
+};
+
+#define HUF_MAX_BITS		11
+#define HUF_MAX_SYMBOLS		256
+#define HUF_WEIGHT_LOG		6
+
+#define FSE_MAX_LOG		9
+#define FSE_MAX_SYMBOLS		256
+
+#define LL_MAX_LOG		9
+#define LL_MAX_SYMBOL		35
+#define ML_MAX_LOG		9
+#define ML_MAX_SYMBOL		52
+#define OF_MAX_LOG		8
+#define OF_MAX_SYMBOL		31
+
+/*
+ * Copies go 8 bytes at a time, and may write up to 7 bytes past their
+ * end, so they are only used with that much room left in the buffer
+ */
+#define ZSTD_COPY		8
+
+/* Predefined distributions */
+static const s16 ll_default[LL_MAX_SYMBOL + 1] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1,
+};
+#define LL_DEFAULT_LOG		6
+
+static const s16 ml_default[ML_MAX_SYMBOL + 1] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1,
+};
+#define ML_DEFAULT_LOG		6
+
+static const s16 of_default[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+#define OF_DEFAULT_LOG		5
+
+/* Literal and match length codes: base value and number of extra bits */
+static const u32 ll_base[LL_MAX_SYMBOL + 1] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048,
+	4096, 8192, 16384, 32768, 65536,
+};
+
+static const u8 ll_bits[LL_MAX_SYMBOL + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16,
+};
+
+static const u32 ml_base[ML_MAX_SYMBOL + 1] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027,
+	2051, 4099, 8195, 16387, 32771, 65539,
+};
+
+static const u8 ml_bits[ML_MAX_SYMBOL + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16,
+};
+
+/* What each kind of sequences table needs */
+struct zstd_seq_kind {
+	const s16 *def;		/* predefined distribution */
+	int def_count;
+	int def_log;
+	int max_log;
+	int max_sym;
+	const u32 *value;	/* value of each length code, NULL for offsets */
+	const u8 *extra;	/* extra bits of each length code */
+};
+
+static const struct zstd_seq_kind ll_kind = {
+	ll_default, ARRAY_SIZE(ll_default), LL_DEFAULT_LOG, LL_MAX_LOG,
+	LL_MAX_SYMBOL, ll_base, ll_bits,
+};
+
+static const struct zstd_seq_kind ml_kind = {
+	ml_default, ARRAY_SIZE(ml_default), ML_DEFAULT_LOG, ML_MAX_LOG,
+	ML_MAX_SYMBOL, ml_base, ml_bits,
+};
+
+/* Offset code n stands for 1 << n, plus n extra bits */
+static const struct zstd_seq_kind of_kind = {
+	of_default, ARRAY_SIZE(of_default), OF_DEFAULT_LOG, OF_MAX_LOG,
+	OF_MAX_SYMBOL, NULL, NULL,
+};
+
+struct fse_entry {
+	u32 value;		/* symbol, or for sequences its base value */
+	u16 base;		/* next state, before adding those bits */
+	u8 bits;		/* bits to read for the next state */
+	u8 extra;		/* extra bits to add to the base value */
+};
+
+struct fse_table {
+	int valid;		/* for ZSTD_MODE_REPEAT */
+	int log;
+	struct fse_entry e[1 << FSE_MAX_LOG];
+};
+
+struct huf_entry {
+	u8 symbol;
+	u8 bits;
+};
+
+struct huf_table {
+	int valid;		/* for ZSTD_LIT_TREELESS */
+	int max_bits;
+	struct huf_entry e[1 << HUF_MAX_BITS];
+};
+
+struct zstd_ctx {
+	struct huf_table huf;
+	struct fse_table ll, of, ml;
+	struct fse_table weights;	/* for the Huffman tree */
+	u32 rep[3];			/* repeat offsets */
+	u8 lit[ZSTD_BLOCK_MAX + 2 * ZSTD_COPY];
+};
+
+/*
+ * Bitstreams are read backwards, from the last byte, whose highest set
+ * bit marks where they start. The low 'avail' bits of 'hold' are the
+ * next to be read, highest first. Reading on past the first byte gives
+ * zeroes, and makes 'avail' negative.
+ */
+struct zstd_bits {
+	const u8 *start;
+	const u8 *ptr;		/* bytes below here are not loaded yet */
+	u64 hold;
+	int avail;
+};
+
+/*
+ * Load as many whole bytes as fit. Once 8 bytes are in, 'hold' is just
+ * the 8 bytes at 'ptr', so it can be reloaded in one go.
+ */
+static inline void bits_refill(struct zstd_bits *b)
+{
+	int n;
+
+	if (b->ptr - b->start >= 8) {
+		n = (63 - b->avail) >> 3;
+		b->ptr -= n;
+		b->hold = get_unaligned_le64(b->ptr);
+		b->avail += n * 8;
+		return;
+	}
+	while (b->avail <= 56 && b->ptr > b->start) {
+		b->hold = b->hold << 8 | *--b->ptr;
+		b->avail += 8;
+	}
+}
+
+static int bits_init(struct zstd_bits *b, const u8 *src, size_t len)
+{
+	if (!len || !src[len - 1])
+		return -EINVAL;
+	b->start = src;
+	b->ptr = src + len;
+	b->hold = 0;
+	b->avail = 0;
+	if (len >= 8) {
+		b->ptr -= 8;
+		b->hold = get_unaligned_le64(b->ptr);
+		b->avail = 64;
+	} else {
+		bits_refill(b);
+	}
+	b->avail -= 8 - (31 - __builtin_clz(src[len - 1]));
+
+	return 0;
+}
+
+/* Look at the next n bits, at most 32, without reading them */
+static inline u32 bits_peek(struct zstd_bits *b, int n)
+{
+	if (b->avail < n)
+		bits_refill(b);
+	if (b->avail >= n)
+		return (b->hold >> (b->avail - n)) & ((1ULL << n) - 1);
+	if (b->avail <= 0)
+		return 0;
+
+	return (b->hold << (n - b->avail)) & ((1ULL << n) - 1);
+}
+
+static inline u32 bits_read(struct zstd_bits *b, int n)
+{
+	u32 val = bits_peek(b, n);
+
+	b->avail -= n;
+
+	return val;
+}
+
+static inline int bits_done(struct zstd_bits *b)
+{
+	return !b->avail && b->ptr == b->start;
+}
+
+static inline int bits_overflow(struct zstd_bits *b)
+{
+	return b->avail < 0;
+}
+
+struct fse_state {
+	const struct fse_entry *e;
+	u32 state;
+};
+
+static inline void fse_init(struct fse_state *s, const struct fse_table *t,
+			    struct zstd_bits *b)
+{
+	s->e = t->e;
+	s->state = bits_read(b, t->log);
+}
+
+static inline uint fse_symbol(struct fse_state *s)
+{
+	return s->e[s->state].value;
+}
+
+/* Read the length or offset value that the state stands for */
+static inline u32 fse_value(struct fse_state *s, struct zstd_bits *b)
+{
+	const struct fse_entry *e = &s->e[s->state];
+
+	return e->value + bits_read(b, e->extra);
+}
+
+static inline void fse_update(struct fse_state *s, struct zstd_bits *b)
+{
+	const struct fse_entry *e = &s->e[s->state];
+
+	s->state = e->base + bits_read(b, e->bits);
+}
+
+/* Build a decoding table from a normalised distribution */
+static int fse_build(struct fse_table *t, const s16 *norm, int count, int log)
+{
+	uint size = 1 << log;
+	uint high = size;
+	uint step = (size >> 1) + (size >> 3) + 3;
+	u16 next[FSE_MAX_SYMBOLS];
+	uint pos, i, state;
+	int sym, n;
+
+	/* Symbols with a "less than 1" probability go at the end */
+	for (sym = 0; sym < count; sym++) {
+		if (norm[sym] == -1) {
+			t->e[--high].value = sym;
+			next[sym] = 1;
+		} else {
+			next[sym] = norm[sym];
+		}
+	}
+
+	for (sym = pos = 0; sym < count; sym++) {
+		for (n = 0; n < norm[sym]; n++) {
+			t->e[pos].value = sym;
+			do {
+				pos = (pos + step) & (size - 1);
+			} while (pos >= high);
+		}
+	}
+	if (pos)
+		return -EINVAL;
+
+	for (i = 0; i < size; i++) {
+		state = next[t->e[i].value]++;
+		t->e[i].extra = 0;
+		t->e[i].bits = log - (31 - __builtin_clz(state));
+		t->e[i].base = (state << t->e[i].bits) - size;
+	}
+	t->log = log;
+	t->valid = 1;
+
+	return 0;
+}
+
+/* Read up to 16 bits from a little-endian forward bitstream */
+static u32 fwd_peek(const u8 *src, size_t len, size_t pos, int n)
+{
+	u32 val = 0;
+	int i;
+
+	for (i = 0; i < 4 && pos / 8 + i < len; i++)
+		val |= (u32)src[pos / 8 + i] << (8 * i);
+
+	return (val >> (pos & 7)) & ((1 << n) - 1);
+}
+
+/* Read a table description, returning the number of bytes it used */
+static int fse_read(struct fse_table *t, const u8 *src, size_t len,
+		    int max_log, int max_sym)
+{
+	s16 norm[FSE_MAX_SYMBOLS];
+	int remaining, log, sym, bits, repeat, i;
+	u32 val, lower, threshold;
+	size_t pos;
+
+	if (!len)
+		return -EINVAL;
+	log = (src[0] & 15) + 5;
+	if (log > max_log)
+		return -EINVAL;
+
+	pos = 4;
+	remaining = 1 << log;
+	sym = 0;
+	while (remaining > 0 && sym <= max_sym) {
+		bits = 32 - __builtin_clz(remaining + 1);
+		val = fwd_peek(src, len, pos, bits);
+		lower = (1 << (bits - 1)) - 1;
+		threshold = (1 << bits) - 1 - (remaining + 1);
+		if ((val & lower) < threshold) {
+			val &= lower;
+			pos += bits - 1;
+		} else {
+			if (val > lower)
+				val -= threshold;
+			pos += bits;
+		}
+		norm[sym] = val - 1;
+		remaining -= norm[sym] < 0 ? 1 : norm[sym];
+		if (!norm[sym++]) {
+			do {
+				repeat = fwd_peek(src, len, pos, 2);
+				pos += 2;
+				for (i = 0; i < repeat; i++) {
+					if (sym > max_sym)
+						return -EINVAL;
+					norm[sym++] = 0;
+				}
+			} while (repeat == 3 && pos <= len * 8);
+		}
+		if (pos > len * 8)
+			return -EINVAL;
+	}
+	if (remaining)
+		return -EINVAL;
+	if (fse_build(t, norm, sym, log))
+		return -EINVAL;
+
+	return (pos + 7) / 8;
+}
+
+/* Set up a sequences table as its mode says, moving *ipp past it */
+static int zstd_table(struct fse_table *t, const u8 **ipp, const u8 *iend,
+		      int mode, const struct zstd_seq_kind *kind)
+{
+	uint sym, i;
+	int ret;
+
+	switch (mode) {
+	case ZSTD_MODE_PREDEFINED:
+		ret = fse_build(t, kind->def, kind->def_count, kind->def_log);
+		if (ret)
+			return ret;
+		break;
+	case ZSTD_MODE_RLE:
+		if (*ipp >= iend || **ipp > kind->max_sym)
+			return -EINVAL;
+		t->e[0].value = *(*ipp)++;
+		t->e[0].bits = 0;
+		t->e[0].base = 0;
+		t->log = 0;
+		t->valid = 1;
+		break;
+	case ZSTD_MODE_FSE:
+		ret = fse_read(t, *ipp, iend - *ipp, kind->max_log,
+			       kind->max_sym);
+		if (ret < 0)
+			return ret;
+		*ipp += ret;
+		break;
+	default:
+		return t->valid ? 0 : -EINVAL;
+	}
+
+	/* Look up what each code stands for once, rather than each time */
+	for (i = 0; i < 1 << t->log; i++) {
+		sym = t->e[i].value;
+		t->e[i].value = kind->value ? kind->value[sym] : 1U << sym;
+		t->e[i].extra = kind->extra ? kind->extra[sym] : sym;
+	}
+
+	return 0;
+}
+
+/* Build the Huffman decoding table from the weights of all but one symbol */
+static int huf_build(struct huf_table *t, u8 *weights, int count)
+{
+	u16 rank[HUF_MAX_BITS + 2];
+	u32 total, left;
+	int max_bits, sym, bits, n, i;
+
+	for (i = total = 0; i < count; i++) {
+		if (weights[i] > HUF_MAX_BITS)
+			return -EINVAL;
+		if (weights[i])
+			total += 1 << (weights[i] - 1);
+	}
+	if (!total)
+		return -EINVAL;
+	max_bits = 32 - __builtin_clz(total);
+	if (max_bits > HUF_MAX_BITS)
+		return -EINVAL;
+
+	/* The last weight makes the total up to a power of two */
+	left = (1 << max_bits) - total;
+	if (left & (left - 1))
+		return -EINVAL;
+	weights[count++] = 32 - __builtin_clz(left);
+
+	/* The longest codes come first */
+	memset(rank, '\0', sizeof(rank));
+	for (i = 0; i < count; i++) {
+		if (weights[i])
+			rank[max_bits + 1 - weights[i]]++;
+	}
+	for (bits = max_bits, n = 0; bits >= 1; bits--) {
+		i = n + (rank[bits] << (max_bits - bits));
+		for (; n < i; n++)
+			t->e[n].bits = bits;
+		rank[bits] = n - (rank[bits] << (max_bits - bits));
+	}
+	for (sym = 0; sym < count; sym++) {
+		if (!weights[sym])
+			continue;
+		bits = max_bits + 1 - weights[sym];
+		n = 1 << (max_bits - bits);
+		for (i = rank[bits]; i < rank[bits] + n; i++)
+			t->e[i].symbol = sym;
+		rank[bits] += n;
+	}
+	t->max_bits = max_bits;
+	t->valid = 1;
+
+	return 0;
+}
+
+/* Read a Huffman tree description, returning the number of bytes used */
+static int huf_read(struct zstd_ctx *ctx, const u8 *src, size_t len)
+{
+	u8 weights[HUF_MAX_SYMBOLS];
+	struct zstd_bits b;
+	struct fse_state s1, s2;
+	int count, size, ret;
+
+	if (!len)
+		return -EINVAL;
+	size = *src++;
+	if (size >= 128) {
+		/* Weights given directly, 4 bits each */
+		count = size - 127;
+		size = (count + 1) / 2;
+		if (size >= len)
+			return -EINVAL;
+		for (ret = 0; ret < count; ret++)
+			weights[ret] = ret & 1 ? src[ret / 2] & 15 :
+				src[ret / 2] >> 4;
+	} else {
+		/* FSE-compressed weights, from two interleaved states */
+		if (size >= len)
+			return -EINVAL;
+		ret = fse_read(&ctx->weights, src, size, HUF_WEIGHT_LOG,
+			       HUF_MAX_BITS);
+		if (ret < 0)
+			return ret;
+		if (bits_init(&b, src + ret, size - ret))
+			return -EINVAL;
+		fse_init(&s1, &ctx->weights, &b);
+		fse_init(&s2, &ctx->weights, &b);
+		count = 0;
+		for (;;) {
+			if (count >= HUF_MAX_SYMBOLS - 2)
+				return -EINVAL;
+			weights[count++] = fse_symbol(&s1);
+			fse_update(&s1, &b);
+			if (bits_overflow(&b)) {
+				weights[count++] = fse_symbol(&s2);
+				break;
+			}
+			weights[count++] = fse_symbol(&s2);
+			fse_update(&s2, &b);
+			if (bits_overflow(&b)) {
+				weights[count++] = fse_symbol(&s1);
+				break;
+			}
+		}
+	}
+	ret = huf_build(&ctx->huf, weights, count);
+	if (ret)
+		return ret;
+
+	return size + 1;
+}
+
+/* Decode a stream of Huffman-coded literals, which must fill out exactly */
+static int huf_stream(const struct huf_table *t, const u8 *src, size_t len,
+		      u8 *out, size_t count)
+{
+	const struct huf_entry *e;
+	struct zstd_bits b;
+	u8 *end = out + count;
+	int max_bits = t->max_bits;
+	u32 mask = (1 << max_bits) - 1;
+
+	if (bits_init(&b, src, len))
+		return -EINVAL;
+
+	/* A refill gives at least 56 bits, enough for four symbols */
+	while (end - out >= 4 && b.ptr - b.start >= 8) {
+		bits_refill(&b);
+		e = &t->e[b.hold >> (b.avail - max_bits) & mask];
+		out[0] = e->symbol;
+		b.avail -= e->bits;
+		e = &t->e[b.hold >> (b.avail - max_bits) & mask];
+		out[1] = e->symbol;
+		b.avail -= e->bits;
+		e = &t->e[b.hold >> (b.avail - max_bits) & mask];
+		out[2] = e->symbol;
+		b.avail -= e->bits;
+		e = &t->e[b.hold >> (b.avail - max_bits) & mask];
+		out[3] = e->symbol;
+		b.avail -= e->bits;
+		out += 4;
+	}
+	while (out < end) {
+		e = &t->e[bits_peek(&b, max_bits)];
+		*out++ = e->symbol;
+		b.avail -= e->bits;
+	}
+
+	return bits_done(&b) ? 0 : -EINVAL;
+}
+
+/* Decode the literals section into ctx->lit, returning its size */
+static int zstd_literals(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			 size_t *lit_len)
+{
+	uint type = src[0] & 3;
+	uint format = src[0] >> 2 & 3;
+	size_t size, csize, seg, slen[4];
+	int hsize, streams, bits, ret, i;
+	u64 hdr;
+
+	if (type == ZSTD_LIT_RAW || type == ZSTD_LIT_RLE) {
+		if (!(format & 1)) {
+			hsize = 1;
+			size = src[0] >> 3;
+		} else if (format == 1) {
+			hsize = 2;
+			if (len < hsize)
+				return -EINVAL;
+			size = src[0] >> 4 | src[1] << 4;
+		} else {
+			hsize = 3;
+			if (len < hsize)
+				return -EINVAL;
+			size = src[0] >> 4 | src[1] << 4 | src[2] << 12;
+		}
+		if (size > ZSTD_BLOCK_MAX)
+			return -EINVAL;
+		*lit_len = size;
+		if (type == ZSTD_LIT_RLE) {
+			if (len < hsize + 1)
+				return -EINVAL;
+			memset(ctx->lit, src[hsize], size);
+			return hsize + 1;
+		}
+		if (len < hsize + size)
+			return -EINVAL;
+		memcpy(ctx->lit, src + hsize, size);
+		return hsize + size;
+	}
+
+	/* Huffman-coded, in one or four streams */
+	streams = format ? 4 : 1;
+	hsize = format < 2 ? 3 : format + 2;
+	bits = format < 2 ? 10 : format * 4 + 6;
+	if (len < hsize)
+		return -EINVAL;
+	for (i = hsize - 1, hdr = 0; i >= 0; i--)
+		hdr = hdr << 8 | src[i];
+	size = hdr >> 4 & ((1 << bits) - 1);
+	csize = hdr >> (4 + bits) & ((1 << bits) - 1);
+	if (size > ZSTD_BLOCK_MAX || len < hsize + csize)
+		return -EINVAL;
+	*lit_len = size;
+	src += hsize;
+	len = csize;
+
+	if (type == ZSTD_LIT_COMPRESSED) {
+		ret = huf_read(ctx, src, len);
+		if (ret < 0)
+			return ret;
+		src += ret;
+		len -= ret;
+	} else if (!ctx->huf.valid) {
+		return -EINVAL;
+	}
+
+	if (streams == 1) {
+		ret = huf_stream(&ctx->huf, src, len, ctx->lit, size);
+		return ret ? ret : hsize + csize;
+	}
+
+	/* A jump table gives the sizes of the first three streams */
+	if (len < 6)
+		return -EINVAL;
+	for (i = 0, slen[3] = len - 6; i < 3; i++) {
+		slen[i] = get_unaligned_le16(src + 2 * i);
+		if (slen[i] > slen[3])
+			return -EINVAL;
+		slen[3] -= slen[i];
+	}
+	src += 6;
+	seg = (size + 3) / 4;
+	if (size < 3 * seg)
+		return -EINVAL;
+	for (i = 0; i < 4; i++) {
+		ret = huf_stream(&ctx->huf, src, slen[i], ctx->lit + i * seg,
+				 i < 3 ? seg : size - 3 * seg);
+		if (ret)
+			return ret;
+		src += slen[i];
+	}
+
+	return hsize + csize;
+}
+
+static inline void zstd_copy8(u8 *dst, const u8 *src)
+{
+	__builtin_memcpy(dst, src, ZSTD_COPY);
+}
+
+/*
+ * Copy a match of len bytes from offset bytes back. A copy chunk must
+ * not overlap its own source, so for a short offset the pattern is first
+ * repeated byte by byte until it is at least a chunk long.
+ */
+static inline void zstd_match(u8 *op, size_t offset, size_t len)
+{
+	const u8 *match = op - offset;
+	u8 *cpy = op + len;
+	size_t period, n;
+
+	if (offset < ZSTD_COPY) {
+		for (period = offset; period < ZSTD_COPY; period <<= 1)
+			;
+		n = min(len, period);
+		while (n--)
+			*op++ = *match++;
+		match = op - period;
+	}
+	while (op < cpy) {
+		zstd_copy8(op, match);
+		op += ZSTD_COPY;
+		match += ZSTD_COPY;
+	}
+}
+
+/* Decode the sequences section and carry out the sequences */
+static int zstd_sequences(struct zstd_ctx *ctx, const u8 *ip, size_t len,
+			  size_t lit_len, u8 **opp, u8 *oend, const u8 *base)
+{
+	const u8 *iend = ip + len;
+	const u8 *lit = ctx->lit;
+	const u8 *lit_end = lit + lit_len;
+	struct fse_state ll, of, ml;
+	struct zstd_bits b;
+	u32 offset, code, rep[3];
+	size_t ll_len, ml_len;
+	u8 *op = *opp;
+	int nseq, modes, ret;
+
+	if (!len)
+		return -EINVAL;
+	nseq = *ip++;
+	if (nseq == 255) {
+		if (iend - ip < 2)
+			return -EINVAL;
+		nseq = get_unaligned_le16(ip) + 0x7f00;
+		ip += 2;
+	} else if (nseq >= 128) {
+		if (ip >= iend)
+			return -EINVAL;
+		nseq = (nseq - 128) << 8 | *ip++;
+	}
+
+	if (nseq) {
+		if (ip >= iend)
+			return -EINVAL;
+		modes = *ip++;
+		if (modes & 3)
+			return -EINVAL;
+		ret = zstd_table(&ctx->ll, &ip, iend, modes >> 6, &ll_kind);
+		if (!ret)
+			ret = zstd_table(&ctx->of, &ip, iend, modes >> 4 & 3,
+					 &of_kind);
+		if (!ret)
+			ret = zstd_table(&ctx->ml, &ip, iend, modes >> 2 & 3,
+					 &ml_kind);
+		if (ret || bits_init(&b, ip, iend - ip))
+			return -EINVAL;
+		fse_init(&ll, &ctx->ll, &b);
+		fse_init(&of, &ctx->of, &b);
+		fse_init(&ml, &ctx->ml, &b);
+	} else if (ip != iend) {
+		return -EINVAL;
+	}
+
+	/* Kept here, where the output cannot alias them */
+	memcpy(rep, ctx->rep, sizeof(rep));
+
+	while (nseq--) {
+		/* Extra bits come in the order offset, match, literals */
+		offset = fse_value(&of, &b);
+		ml_len = fse_value(&ml, &b);
+		ll_len = fse_value(&ll, &b);
+
+		if (offset > 3) {
+			offset -= 3;
+			rep[2] = rep[1];
+			rep[1] = rep[0];
+			rep[0] = offset;
+		} else {
+			/* Repeat offsets, shifted by one without literals */
+			code = offset - (ll_len ? 1 : 0);
+			if (code) {
+				offset = code < 3 ? rep[code] : rep[0] - 1;
+				if (code > 1)
+					rep[2] = rep[1];
+				rep[1] = rep[0];
+				rep[0] = offset;
+			} else {
+				offset = rep[0];
+			}
+		}
+
+		if (nseq) {
+			fse_update(&ll, &b);
+			fse_update(&ml, &b);
+			fse_update(&of, &b);
+		}
+
+		/* Literals, then the match */
+		if (ll_len > lit_end - lit)
+			return -EINVAL;
+		if (ll_len + ml_len > oend - op)
+			return -ENOSPC;
+		if (oend - op >= ll_len + ZSTD_COPY) {
+			/* ctx->lit has room for the overrun too */
+			u8 *cpy = op + ll_len;
+			const u8 *src = lit;
+
+			while (op < cpy) {
+				zstd_copy8(op, src);
+				op += ZSTD_COPY;
+				src += ZSTD_COPY;
+			}
+			op = cpy;
+		} else {
+			memcpy(op, lit, ll_len);
+			op += ll_len;
+		}
+		lit += ll_len;
+
+		if (!offset || offset > op - base)
+			return -EINVAL;
+		if (oend - op >= ml_len + ZSTD_COPY) {
+			zstd_match(op, offset, ml_len);
+		} else {
+			const u8 *match = op - offset;
+			size_t i;
+
+			for (i = 0; i < ml_len; i++)
+				op[i] = match[i];
+		}
+		op += ml_len;
+
+		if (!nseq && !bits_done(&b))
+			return -EINVAL;
+	}
+	memcpy(ctx->rep, rep, sizeof(rep));
+
+	/* The rest of the literals */
+	if (lit_end - lit > oend - op)
+		return -ENOSPC;
+	memcpy(op, lit, lit_end - lit);
+	*opp = op + (lit_end - lit);
+
+	return 0;
+}
+
+static int zstd_block(struct zstd_ctx *ctx, const u8 *src, size_t len,
+		      u8 **opp, u8 *oend, const u8 *base)
+{
+	size_t lit_len;
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	ret = zstd_literals(ctx, src, len, &lit_len);
+	if (ret < 0)
+		return ret;
+
+	return zstd_sequences(ctx, src + ret, len - ret, lit_len, opp, oend,
+			      base);
+}
+
+/* Decompress a frame, from just after its magic number */
+static int zstd_frame(struct zstd_ctx *ctx, const u8 **ipp, const u8 *iend,
+		      u8 **opp, u8 *oend)
+{
+	static const u8 dict_len[] = { 0, 1, 2, 4 };
+	static const u8 size_len[] = { 0, 2, 4, 8 };
+	const u8 *ip = *ipp;
+	u8 *start = *opp;
+	u8 *op = start;
+	u64 content_size = 0;
+	u32 hdr, size, dict = 0;
+	uint fhd;
+	int i, len, last, ret;
+
+	if (ip >= iend)
+		return -EINVAL;
+	fhd = *ip++;
+	if (fhd & ZSTD_FHD_RESERVED)
+		return -EINVAL;
+	if (!(fhd & ZSTD_FHD_SINGLE))
+		ip++;		/* window descriptor: no window is needed */
+
+	len = dict_len[fhd & ZSTD_FHD_DICT_MASK];
+	if (iend - ip < len)
+		return -EINVAL;
+	for (i = len - 1; i >= 0; i--)
+		dict = dict << 8 | ip[i];
+	ip += len;
+	if (dict)
+		return -EPROTONOSUPPORT;
+
+	len = size_len[fhd >> ZSTD_FHD_SIZE_SHIFT];
+	if (!len && (fhd & ZSTD_FHD_SINGLE))
+		len = 1;
+	if (iend - ip < len)
+		return -EINVAL;
+	for (i = len - 1; i >= 0; i--)
+		content_size = content_size << 8 | ip[i];
+	if (len == 2)
+		content_size += 256;
+	ip += len;
+
+	ctx->rep[0] = 1;
+	ctx->rep[1] = 4;
+	ctx->rep[2] = 8;
+	ctx->huf.valid = 0;
+	ctx->ll.valid = 0;
+	ctx->of.valid = 0;
+	ctx->ml.valid = 0;
+
+	do {
+		if (iend - ip < 3)
+			return -EINVAL;
+		hdr = ip[0] | ip[1] << 8 | ip[2] << 16;
+		ip += 3;
+		last = hdr & 1;
+		size = hdr >> 3;
+		if (size > ZSTD_BLOCK_MAX)
+			return -EINVAL;
+
+		switch (hdr >> 1 & 3) {
+		case ZSTD_BLOCK_RAW:
+			if (size > iend - ip)
+				return -EINVAL;
+			if (size > oend - op)
+				return -ENOSPC;
+			memcpy(op, ip, size);
+			ip += size;
+			op += size;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if (ip >= iend)
+				return -EINVAL;
+			if (size > oend - op)
+				return -ENOSPC;
+			memset(op, *ip++, size);
+			op += size;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if (size > iend - ip)
+				return -EINVAL;
+			ret = zstd_block(ctx, ip, size, &op, oend, start);
+			if (ret)
+				return ret;
+			ip += size;
+			break;
+		default:
+			return -EINVAL;
+		}
+		WATCHDOG_RESET();
+	} while (!last);
+
+	if (fhd & ZSTD_FHD_CHECKSUM) {
+		if (iend - ip < 4)
+			return -EINVAL;
+		if ((u32)xxh64(start, op - start, 0) != get_unaligned_le32(ip))
+			return -EBADMSG;
+		ip += 4;
+	}
+	if ((len || (fhd & ZSTD_FHD_SINGLE)) && content_size != op - start)
+		return -EINVAL;
+	*ipp = ip;
+	*opp = op;
+
+	return 0;
+}
+
+int zstd_decompress(const void *src, size_t src_len, void *dst,
+		    size_t *dst_len)
+{
+	struct zstd_ctx *ctx;
+	const u8 *ip = src;
+	const u8 *iend = ip + src_len;
+	u8 *op = dst;
+	u32 magic, size;
+	int ret;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+
+	do {
+		if (iend - ip < 4) {
+			ret = -EINVAL;
+			break;
+		}
+		magic = get_unaligned_le32(ip);
+		ip += 4;
+		if (magic == ZSTD_MAGIC) {
+			ret = zstd_frame(ctx, &ip, iend, &op, dst + *dst_len);
+		} else if ((magic & ZSTD_SKIP_MASK) == ZSTD_SKIP_MAGIC) {
+			ret = -EINVAL;
+			if (iend - ip < 4)
+				break;
+			size = get_unaligned_le32(ip);
+			ip += 4;
+			if (size > iend - ip)
+				break;
+			ip += size;
+			ret = 0;
+		} else {
+			ret = -EINVAL;
+		}
+	} while (!ret && ip < iend);
+	*dst_len = op - (u8 *)dst;
+	free(ctx);
+
+	return ret;
+}
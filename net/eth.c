@@ -123,6 +123,9 @@ static unsigned int eth_rcv_current, eth_rcv_last;
 
 static struct eth_device *eth_devices;
 struct eth_device *eth_current;
+#ifdef CONFIG_LAZY_INIT
+static bd_t *eth_probe_bis;	/* set until the devices are probed */
+#endif
 
 struct eth_device *eth_get_dev_by_name(const char *devname)
 {
@@ -130,6 +133,8 @@ struct eth_device *eth_get_dev_by_name(const char *devname)
 
 	BUG_ON(devname == NULL);
 
+	eth_probe();
+
 	if (!eth_devices)
 		return NULL;
 
@@ -150,6 +155,8 @@ struct eth_device *eth_get_dev_by_index(int index)
 {
 	struct eth_device *dev, *target_dev;
 
+	eth_probe();
+
 	if (!eth_devices)
 		return NULL;
 
@@ -288,9 +295,10 @@ static void eth_env_init(bd_t *bis)
 		copy_filename(BootFile, s, sizeof(BootFile));
 }
 
+static int eth_probe_devices(bd_t *bis);
+
 int eth_initialize(bd_t *bis)
 {
-	int num_devices = 0;
 	eth_devices = NULL;
 	eth_current = NULL;
 
@@ -305,6 +313,22 @@ int eth_initialize(bd_t *bis)
 
 	eth_env_init(bis);
 
+#ifdef CONFIG_LAZY_INIT
+	if (getenv_yesno("eagerinit") != 1) {
+		eth_probe_bis = bis;
+		puts("deferred\n");
+		return 0;
+	}
+#endif
+
+	return eth_probe_devices(bis);
+}
+
+/* Probe the devices and pick the current one */
+static int eth_probe_devices(bd_t *bis)
+{
+	int num_devices = 0;
+
 	/*
 	 * If board-specific initialization exists, call it.
 	 * If not, call a CPU-specific one
@@ -355,6 +379,22 @@ int eth_initialize(bd_t *bis)
 	return num_devices;
 }
 
+#ifdef CONFIG_LAZY_INIT
+void eth_probe(void)
+{
+	bd_t *bis = eth_probe_bis;
+
+	if (!bis)
+		return;
+
+	/* Drivers may look the devices up while they are probed */
+	eth_probe_bis = NULL;
+	bootstage_mark(BOOTSTAGE_ID_NET_ETH_START);
+	puts("Net:   ");
+	eth_probe_devices(bis);
+}
+#endif
+
 #ifdef CONFIG_MCAST_TFTP
 /* Multicast.
  * mcast_addr: multicast ipaddr from which multicast Mac is made
@@ -405,6 +445,8 @@ int eth_init(bd_t *bis)
 {
 	struct eth_device *old_current, *dev;
 
+	eth_probe();
+
 	if (!eth_current) {
 		puts("No ethernet found.\n");
 		return -1;
@@ -543,6 +585,8 @@ void eth_set_current(void)
 	struct eth_device *old_current;
 	int	env_id;
 
+	eth_probe();
+
 	if (!eth_current)	/* XXX no current */
 		return;
 
@@ -0,0 +1,195 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+
+#define DEBUG
+
+#include <common.h>
+#include <arena.h>
+
+/* This runs as a command, so there is a scope open already */
+static ulong arena_used(void)
+{
+	struct arena_info info;
+
+	arena_get_info(&info);
+	return info.used;
+}
+
+/* Freed in order, out of order and not at all */
+static void check_free(void)
+{
+	ulong base = arena_used(), used;
+	struct arena_scope scope;
+	char *a, *b, *c;
+
+	a = arena_alloc(100);
+	used = arena_used();
+	b = arena_alloc(200);
+	assert(a && b && a < b && arena_used() > used);
+	assert(((ulong)a & (2 * sizeof(ulong) - 1)) == 0);
+	memset(a, 'a', 100);
+	memset(b, 'b', 200);
+
+	/* The most recent one goes straight back, to be used again */
+	arena_free(b);
+	assert(arena_used() == used);
+	c = arena_alloc(200);
+	assert(c == b);
+	arena_free(c);
+
+	/* An earlier one goes once everything above it has gone too */
+	b = arena_alloc(200);
+	arena_free(a);
+	assert(arena_used() > used);
+	arena_free(b);
+	assert(arena_used() == base);
+
+	/* The end of a scope takes back what was left */
+	arena_enter(&scope);
+	a = arena_alloc(100);
+	b = arena_alloc(100);
+	arena_free(a);
+	arena_leave(&scope);
+	assert(arena_used() == base);
+}
+
+/* A scope inside another leaves the outer one's memory alone */
+static void check_nest(void)
+{
+	ulong base = arena_used(), used;
+	struct arena_scope scope;
+	char *x, *y, *z;
+
+	x = arena_alloc(64);
+	strcpy(x, "outer");
+	used = arena_used();
+
+	arena_enter(&scope);
+	y = arena_alloc(64);
+	assert(y > x);
+	arena_free(x);
+	assert(arena_used() > used);
+	arena_leave(&scope);
+	assert(arena_used() == used);
+
+	/* x was freed inside, so goes as soon as the top is freed */
+	z = arena_alloc(64);
+	assert(z == y);
+	arena_free(z);
+	assert(arena_used() == base);
+
+	/* Nor can the inner scope free or grow the outer one's last */
+	x = arena_alloc(64);
+	strcpy(x, "outer");
+	arena_enter(&scope);
+	arena_free(x);
+	assert(arena_used() == used);
+	arena_leave(&scope);
+	arena_free(arena_alloc(16));
+	assert(arena_used() == base);
+
+	x = arena_alloc(64);
+	strcpy(x, "outer");
+	arena_enter(&scope);
+	x = arena_realloc(x, 1000);
+	memset(x + 64, 'x', 1000 - 64);
+	arena_leave(&scope);
+	y = arena_alloc(1000);
+	memset(y, '\0', 1000);
+	assert(!strcmp(x, "outer") && x[999] == 'x');
+	arena_free(y);
+	arena_free(x);
+	assert(arena_used() == base);
+}
+
+static void check_realloc(void)
+{
+	ulong base = arena_used();
+	char *a, *b, *c;
+
+	a = arena_realloc(NULL, 16);
+	strcpy(a, "hello");
+
+	/* The most recent allocation grows where it is */
+	b = arena_realloc(a, 1000);
+	assert(b == a);
+
+	/* Anything else moves */
+	c = arena_alloc(16);
+	a = arena_realloc(b, 2000);
+	assert(a != b && !strcmp(a, "hello"));
+	arena_free(c);
+	arena_free(a);
+	assert(arena_used() == base);
+
+	/* Shrinking the top gives the rest back */
+	a = arena_alloc(1000);
+	a = arena_realloc(a, 16);
+	b = arena_alloc(16);
+	assert(b < a + 1000);
+	arena_free(b);
+	arena_free(a);
+	assert(arena_used() == base);
+}
+
+/* Too big for what is left, so malloc() steps in */
+static void check_full(void)
+{
+	ulong base = arena_used();
+	struct arena_info info;
+	ulong fallbacks;
+	char *a, *b;
+
+	arena_get_info(&info);
+	assert(info.size);
+	assert(info.malloc_peak && info.malloc_peak <= info.malloc_size);
+	fallbacks = info.fallbacks;
+
+	a = arena_memalign(256, 10);
+	assert(((ulong)a & 255) == 0);
+	b = arena_alloc(info.size);
+	assert(b);
+	memset(b, '\0', info.size);
+	arena_get_info(&info);
+	assert(info.fallbacks == fallbacks + 1);
+	assert(info.fallback_bytes >= info.size);
+	arena_free(b);
+	arena_free(a);
+	assert(arena_used() == base);
+}
+
+static int do_ut_arena(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	printf("%s: Testing the arena\n", __func__);
+	check_free();
+	check_nest();
+	check_realloc();
+	check_full();
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_arena,	1,	1,	do_ut_arena,
+	"Test the arena allocator",
+	""
+);
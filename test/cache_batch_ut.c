@@ -0,0 +1,156 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <cache_batch.h>
+
+#define LINE		ARCH_DMA_MINALIGN
+#define BASE		0x100000UL
+
+static void check_range(const struct cache_range *range, ulong start,
+			ulong end)
+{
+	assert(range->start == start);
+	assert(range->end == end);
+}
+
+static void check_merge(void)
+{
+	struct cache_batch batch;
+	int i;
+
+	cache_batch_init(&batch, CACHE_BATCH_FLUSH);
+
+	/* Widened to whole lines */
+	cache_batch_add(&batch, BASE + 1, BASE + LINE + 1);
+	assert(batch.count == 1);
+	check_range(&batch.range[0], BASE, BASE + 2 * LINE);
+
+	/* Pieces of one buffer, out of order, become one range */
+	for (i = 9; i >= 2; i--)
+		cache_batch_add(&batch, BASE + i * LINE, BASE + (i + 1) * LINE);
+	assert(batch.count == 1);
+	check_range(&batch.range[0], BASE, BASE + 10 * LINE);
+
+	/* Apart, kept sorted, then bridged */
+	cache_batch_add(&batch, BASE + 20 * LINE, BASE + 21 * LINE);
+	cache_batch_add(&batch, BASE - 10 * LINE, BASE - 9 * LINE);
+	assert(batch.count == 3);
+	check_range(&batch.range[0], BASE - 10 * LINE, BASE - 9 * LINE);
+	check_range(&batch.range[2], BASE + 20 * LINE, BASE + 21 * LINE);
+	cache_batch_add(&batch, BASE + 5 * LINE, BASE + 20 * LINE);
+	assert(batch.count == 2);
+	check_range(&batch.range[1], BASE, BASE + 21 * LINE);
+
+	cache_batch_run(&batch);
+	assert(batch.count == 0);
+
+	/* A full batch is run to make room */
+	for (i = 0; i < CONFIG_CACHE_BATCH_RANGES; i++)
+		cache_batch_add(&batch, BASE + i * 2 * LINE,
+				BASE + (i * 2 + 1) * LINE);
+	assert(batch.count == CONFIG_CACHE_BATCH_RANGES);
+	cache_batch_add(&batch, BASE - 4 * LINE, BASE - 3 * LINE);
+	assert(batch.count == 1);
+	check_range(&batch.range[0], BASE - 4 * LINE, BASE - 3 * LINE);
+
+	/* A ring and 16 packets, as for a network driver, fit in one go */
+	cache_batch_init(&batch, CACHE_BATCH_FLUSH);
+	cache_batch_add(&batch, BASE + 64 * LINE, BASE + 65 * LINE);
+	for (i = 0; i < 16; i++)
+		cache_batch_add(&batch, BASE + i * 4 * LINE,
+				BASE + (i * 4 + 3) * LINE);
+	assert(batch.count == 17);
+	check_range(&batch.range[0], BASE, BASE + 3 * LINE);
+	cache_batch_run(&batch);
+
+	/* Invalidate areas are left as they are */
+	cache_batch_init(&batch, CACHE_BATCH_INVALIDATE);
+	cache_batch_add(&batch, BASE + 1, BASE + 3);
+	check_range(&batch.range[0], BASE + 1, BASE + 3);
+	cache_batch_add(&batch, BASE, BASE);
+	assert(batch.count == 1);
+	cache_batch_run(&batch);
+}
+
+static void check_track(void)
+{
+	struct cache_batch batch;
+
+	cache_batch_init(&batch, CACHE_BATCH_FLUSH | CACHE_BATCH_TRACK);
+	cache_batch_add(&batch, BASE, BASE + 16 * LINE);
+	cache_batch_run(&batch);
+	assert(batch.clean_count == 1);
+
+	/* Clean, so nothing to do */
+	cache_batch_add(&batch, BASE + LINE, BASE + 2 * LINE);
+	cache_batch_add(&batch, BASE, BASE + 16 * LINE);
+	assert(batch.count == 0);
+
+	/* Only partly clean */
+	cache_batch_add(&batch, BASE + 15 * LINE, BASE + 17 * LINE);
+	assert(batch.count == 1);
+	cache_batch_run(&batch);
+	check_range(&batch.clean[0], BASE, BASE + 17 * LINE);
+
+	/* Writing to the middle splits the clean range */
+	cache_batch_dirty(&batch, BASE + 4 * LINE + 1, BASE + 5 * LINE);
+	assert(batch.clean_count == 2);
+	check_range(&batch.clean[0], BASE, BASE + 4 * LINE);
+	check_range(&batch.clean[1], BASE + 5 * LINE, BASE + 17 * LINE);
+	cache_batch_add(&batch, BASE + 4 * LINE, BASE + 5 * LINE);
+	assert(batch.count == 1);
+	cache_batch_add(&batch, BASE + 6 * LINE, BASE + 7 * LINE);
+	assert(batch.count == 1);
+	cache_batch_run(&batch);
+	assert(batch.clean_count == 1);
+
+	/* Ends and the whole of it */
+	cache_batch_dirty(&batch, BASE - LINE, BASE + LINE);
+	cache_batch_dirty(&batch, BASE + 16 * LINE, BASE + 20 * LINE);
+	check_range(&batch.clean[0], BASE + LINE, BASE + 16 * LINE);
+	cache_batch_dirty(&batch, 0, BASE + 20 * LINE);
+	assert(batch.clean_count == 0);
+
+	/* Without tracking, the same area is flushed every time */
+	cache_batch_init(&batch, CACHE_BATCH_FLUSH);
+	cache_batch_add(&batch, BASE, BASE + LINE);
+	cache_batch_run(&batch);
+	cache_batch_add(&batch, BASE, BASE + LINE);
+	assert(batch.count == 1);
+}
+
+static int do_ut_cache_batch(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	printf("%s: Testing cache batches\n", __func__);
+	check_merge();
+	check_track();
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_cache_batch,	1,	1,	do_ut_cache_batch,
+	"Test batched cache maintenance",
+	""
+);
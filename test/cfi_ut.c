@@ -0,0 +1,107 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <asm/cfi_flash.h>
+
+/* Check that a range of flash reads back as erased */
+static int is_erased(ulong addr, ulong size)
+{
+	u8 *p = (u8 *)addr;
+
+	while (size--) {
+		if (*p++ != 0xff)
+			return 0;
+	}
+
+	return 1;
+}
+
+static int do_ut_cfi(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	flash_info_t *bank0 = &flash_info[0], *bank1 = &flash_info[1];
+	struct sandbox_cfi_stats stats;
+	ulong base, size, sect, addr;
+	u8 *pattern;
+	int i;
+
+	printf("%s: Testing CFI flash on two banks\n", __func__);
+	assert(bank0->flash_id == FLASH_MAN_CFI);
+	assert(bank1->flash_id == FLASH_MAN_CFI);
+	base = bank0->start[0];
+	size = bank0->size + bank1->size;
+	sect = flash_sector_size(bank0, 0);
+	assert(bank1->start[0] == base + bank0->size);
+
+	pattern = malloc(size);
+	assert(pattern);
+	for (i = 0; i < size; i++)
+		pattern[i] = i ^ (i >> 9);
+
+	/* 'erase all' erases both banks at once */
+	sandbox_cfi_reset_stats();
+	assert(!run_command("erase all", 0));
+	sandbox_cfi_get_stats(&stats);
+	assert(stats.erases[0] == bank0->sector_count);
+	assert(stats.erases[1] == bank1->sector_count);
+	assert(stats.overlaps);
+	assert(is_erased(base, size));
+
+	/* A write across both banks programs them at once */
+	sandbox_cfi_reset_stats();
+	assert(flash_write((char *)pattern, base, size) == ERR_OK);
+	sandbox_cfi_get_stats(&stats);
+	assert(stats.overlaps);
+	assert(!memcmp((void *)base, pattern, size));
+
+	/* A range inside one bank leaves the other alone */
+	sandbox_cfi_reset_stats();
+	addr = bank0->start[2];
+	assert(!flash_sect_erase(addr, addr + 3 * sect - 1));
+	sandbox_cfi_get_stats(&stats);
+	assert(stats.erases[0] == 3 && stats.erases[1] == 0);
+	assert(is_erased(addr, 3 * sect));
+	assert(!memcmp((void *)base, pattern, addr - base));
+	assert(!memcmp((void *)addr + 3 * sect, pattern + addr + 3 * sect - base,
+		       size - (addr + 3 * sect - base)));
+
+	sandbox_cfi_reset_stats();
+	addr = bank1->start[1];
+	assert(!flash_sect_erase(addr, addr + sect - 1));
+	sandbox_cfi_get_stats(&stats);
+	assert(stats.erases[0] == 0 && stats.erases[1] == 1);
+	assert(is_erased(addr, sect));
+	assert(!memcmp((void *)bank1->start[0], pattern + bank0->size, sect));
+
+	free(pattern);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_cfi,	1,	1,	do_ut_cfi,
+	"Test erasing and writing the simulated two-bank CFI flash",
+	""
+);
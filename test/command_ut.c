@@ -28,8 +28,72 @@ static const char test_cmd[] = "setenv list 1\n setenv list ${list}2; "
 		"setenv list ${list}3\0"
 		"setenv list ${list}4";
 
+/* What a boot script looks up most, and some abbreviations */
+static const char * const bench_cmds[] = {
+	"setenv", "test", "if", "echo", "sete", "run", "version", "cp.b",
+};
+
+#define BENCH_LOOKUPS	100000
+
+/* find_cmd() must find just what a linear search of the table finds */
+static void check_find_cmd(void)
+{
+	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
+	const int count = ll_entry_count(cmd_tbl_t, cmd);
+	char name[40];
+	int i, len;
+
+	for (i = 0; i < count; i++) {
+		for (len = 0; len <= strlen(start[i].name); len++) {
+			strncpy(name, start[i].name, len);
+			strcpy(name + len, ".b");
+			assert(find_cmd(name) ==
+			       find_cmd_tbl(name, start, count));
+			name[len] = '\0';
+			assert(find_cmd(name) ==
+			       find_cmd_tbl(name, start, count));
+		}
+	}
+	assert(!strcmp(find_cmd("sete")->name, "setenv"));
+	assert(!strcmp(find_cmd("cp.l")->name, "cp"));
+	assert(!find_cmd("s"));
+	assert(!find_cmd("setenvx"));
+	assert(!find_cmd(""));
+}
+
+/* Time command lookups, by linear search and with find_cmd() */
+static void bench_find_cmd(void)
+{
+	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
+	const int count = ll_entry_count(cmd_tbl_t, cmd);
+	ulong linear, sorted;
+	int i, j;
+
+	linear = get_timer(0);
+	for (i = 0; i < BENCH_LOOKUPS; i++) {
+		for (j = 0; j < ARRAY_SIZE(bench_cmds); j++)
+			find_cmd_tbl(bench_cmds[j], start, count);
+	}
+	linear = get_timer(linear);
+
+	sorted = get_timer(0);
+	for (i = 0; i < BENCH_LOOKUPS; i++) {
+		for (j = 0; j < ARRAY_SIZE(bench_cmds); j++)
+			find_cmd(bench_cmds[j]);
+	}
+	sorted = get_timer(sorted);
+
+	printf("%s: %d lookups in %d commands: linear %lu ms, sorted %lu ms\n",
+	       __func__, BENCH_LOOKUPS * (int)ARRAY_SIZE(bench_cmds), count,
+	       linear, sorted);
+}
+
 static int do_ut_cmd(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+#ifdef CONFIG_SYS_HUSH_PARSER
+	int i;
+#endif
+
 	printf("%s: Testing commands\n", __func__);
 	run_command("env default -f", 0);
 
@@ -74,6 +138,43 @@ static int do_ut_cmd(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		"setenv list ${list}3", strlen("setenv list 1"), 0);
 	assert(!strcmp("1", getenv("list")));
 
+#ifdef CONFIG_SYS_HUSH_PARSER
+	/* scripts run again (perhaps without parsing) do the same again */
+	for (i = 0; i < 3; i++) {
+		run_command("setenv list", 0);
+		run_command_list("for n in 1 2 3; do setenv list ${list}${n}; "
+			"done\nsetenv list ${list}4", -1, 0);
+		assert(!strcmp("1234", getenv("list")));
+	}
+
+	/* a script which changes itself */
+	run_command("setenv check 0", 0);
+	run_command("setenv list 'setenv check 1; setenv list setenv check 2'",
+		    0);
+	run_command("run list", 0);
+	assert(!strcmp("1", getenv("check")));
+	run_command("run list", 0);
+	assert(!strcmp("2", getenv("check")));
+	run_command("setenv list", 0);
+	run_command("setenv check", 0);
+
+	/* a script which runs itself from inside a loop, once cached */
+	run_command("setenv list 'for n in a b; do setenv check ${check}${n}; "
+		    "if test ${again} = 1; then setenv again 0; run list; fi; "
+		    "done'", 0);
+	run_command("setenv again 0; setenv check; run list", 0);
+	assert(!strcmp("ab", getenv("check")));
+	run_command("setenv again 1; setenv check; run list", 0);
+	assert(!strcmp("aabb", getenv("check")));
+	run_command("setenv list", 0);
+	run_command("setenv check", 0);
+	run_command("setenv again", 0);
+#endif
+
+	/* command lookup */
+	check_find_cmd();
+	bench_find_cmd();
+
 	printf("%s: Everything went swimmingly\n", __func__);
 	return 0;
 }
@@ -0,0 +1,425 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <errno.h>
+#include <lz4.h>
+#include <malloc.h>
+#include <os.h>
+#include <zstd.h>
+#include <asm/unaligned.h>
+
+#define TEST_SIZE	1024
+#define RLE_SIZE	2000
+#define SENTINEL	0xa5
+
+#define BENCH_RUNS	20
+
+#define LZ4_MAGIC	0x184d2204
+#define LZ4_LEGACY	0x184c2102
+#define ZSTD_MAGIC	0xfd2fb528
+
+typedef int (*decompress_fn)(const void *src, size_t src_len, void *dst,
+			     size_t *dst_len);
+
+/*
+ * The vectors below were made by the lz4 and zstd tools from what
+ * make_text() gives ('lz4 -BX --content-size', 'lz4 -l', 'zstd -3',
+ * 'zstd -19'), and from 1000 'A's then 1000 'B's ('zstd').
+ */
+
+static const u8 lz4_frame[] = {
+	0x04, 0x22, 0x4d, 0x18, 0x7c, 0x40, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x85, 0x02, 0x02, 0x00, 0x00, 0xf1, 0x0b, 0x7a, 0x73, 0x74,
+	0x64, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x6f, 0x61, 0x64, 0x20, 0x63,
+	0x6f, 0x6d, 0x70, 0x72, 0x65, 0x73, 0x73, 0x65, 0x64, 0x20, 0x0a, 0x11,
+	0x00, 0x60, 0x30, 0x78, 0x38, 0x30, 0x30, 0x30, 0x04, 0x00, 0x11, 0x20,
+	0x2a, 0x00, 0x80, 0x77, 0x69, 0x74, 0x68, 0x20, 0x61, 0x64, 0x64, 0x25,
+	0x00, 0x52, 0x20, 0x62, 0x6f, 0x6f, 0x74, 0x38, 0x00, 0x01, 0x0a, 0x00,
+	0x00, 0x46, 0x00, 0x04, 0x1b, 0x00, 0x07, 0x49, 0x00, 0xf1, 0x00, 0x6c,
+	0x7a, 0x34, 0x20, 0x6b, 0x65, 0x72, 0x6e, 0x65, 0x6c, 0x20, 0x74, 0x72,
+	0x65, 0x65, 0x10, 0x00, 0x72, 0x72, 0x61, 0x6d, 0x64, 0x69, 0x73, 0x6b,
+	0x3d, 0x00, 0x44, 0x0a, 0x61, 0x6e, 0x64, 0x22, 0x00, 0x01, 0x75, 0x00,
+	0x01, 0x6a, 0x00, 0x04, 0x4a, 0x00, 0x01, 0x5b, 0x00, 0x01, 0x12, 0x00,
+	0x01, 0x1c, 0x00, 0x01, 0x0f, 0x00, 0x04, 0x3f, 0x00, 0x01, 0x17, 0x00,
+	0x01, 0x93, 0x00, 0x01, 0x05, 0x00, 0x01, 0x0f, 0x00, 0x00, 0x86, 0x00,
+	0x01, 0x2a, 0x00, 0x00, 0x68, 0x00, 0x03, 0x78, 0x00, 0x17, 0x0a, 0xc7,
+	0x00, 0x03, 0x13, 0x00, 0x00, 0x1e, 0x00, 0x04, 0x47, 0x00, 0x08, 0x1f,
+	0x00, 0x01, 0x44, 0x00, 0x00, 0x91, 0x00, 0x07, 0xc2, 0x00, 0x07, 0x3e,
+	0x00, 0x00, 0x5e, 0x00, 0x04, 0x37, 0x00, 0x04, 0xa2, 0x00, 0x01, 0x33,
+	0x00, 0x01, 0x05, 0x00, 0x08, 0x29, 0x00, 0x00, 0xeb, 0x00, 0x01, 0xf0,
+	0x00, 0x09, 0x27, 0x00, 0x07, 0x22, 0x00, 0x04, 0x18, 0x00, 0x03, 0x91,
+	0x00, 0x01, 0xc2, 0x00, 0x04, 0x14, 0x00, 0x01, 0x0d, 0x00, 0x00, 0xa3,
+	0x00, 0x01, 0x09, 0x00, 0x01, 0xf4, 0x00, 0x07, 0x90, 0x00, 0x00, 0x9f,
+	0x00, 0x53, 0x64, 0x65, 0x76, 0x69, 0x63, 0x62, 0x00, 0x01, 0x7c, 0x00,
+	0x04, 0x11, 0x00, 0x24, 0x68, 0x65, 0x0b, 0x00, 0x03, 0x59, 0x00, 0x00,
+	0xb3, 0x00, 0x00, 0x4b, 0x00, 0x07, 0x41, 0x00, 0x01, 0x72, 0x01, 0x01,
+	0x5b, 0x00, 0x07, 0x15, 0x00, 0x04, 0x7c, 0x00, 0x07, 0x13, 0x00, 0x05,
+	0xea, 0x00, 0x44, 0x6e, 0x64, 0x20, 0x0a, 0x0d, 0x00, 0x08, 0x6e, 0x00,
+	0x04, 0x14, 0x00, 0x01, 0xe9, 0x00, 0x01, 0x05, 0x00, 0x00, 0x6a, 0x00,
+	0x04, 0x04, 0x00, 0x04, 0x1e, 0x00, 0x04, 0x89, 0x00, 0x00, 0x13, 0x01,
+	0x01, 0x76, 0x00, 0x77, 0x69, 0x6d, 0x61, 0x67, 0x65, 0x20, 0x0a, 0x6a,
+	0x00, 0x01, 0xb2, 0x01, 0x04, 0x30, 0x00, 0x01, 0x0d, 0x00, 0x01, 0x29,
+	0x00, 0x03, 0x3a, 0x00, 0x02, 0x30, 0x00, 0x07, 0x2f, 0x00, 0x04, 0x2a,
+	0x00, 0x10, 0x0a, 0xdd, 0x00, 0x01, 0x1f, 0x01, 0x01, 0x2f, 0x00, 0x03,
+	0xf9, 0x00, 0x01, 0x89, 0x00, 0x02, 0x34, 0x00, 0x06, 0x4b, 0x00, 0x01,
+	0xb7, 0x00, 0x07, 0x43, 0x00, 0x07, 0x0b, 0x00, 0x01, 0x25, 0x00, 0x04,
+	0x53, 0x00, 0x07, 0xa2, 0x01, 0x01, 0x33, 0x00, 0x01, 0x59, 0x00, 0x01,
+	0x22, 0x00, 0x13, 0x0a, 0x5f, 0x00, 0x03, 0x95, 0x00, 0x00, 0xe6, 0x00,
+	0x02, 0x65, 0x00, 0x04, 0x3b, 0x00, 0x00, 0x8d, 0x00, 0x00, 0x04, 0x00,
+	0x01, 0x38, 0x00, 0x07, 0x48, 0x00, 0x01, 0xa1, 0x00, 0x03, 0x3d, 0x00,
+	0x01, 0x4f, 0x00, 0x03, 0x42, 0x00, 0x07, 0x23, 0x00, 0x0a, 0x49, 0x00,
+	0x02, 0x0e, 0x00, 0x07, 0x1f, 0x00, 0x01, 0x36, 0x00, 0x05, 0x82, 0x01,
+	0x11, 0x0a, 0x61, 0x00, 0x00, 0x80, 0x00, 0x05, 0x09, 0x00, 0x07, 0x2c,
+	0x00, 0x01, 0x14, 0x00, 0x12, 0x0a, 0x32, 0x00, 0x00, 0x24, 0x00, 0x04,
+	0x9e, 0x00, 0x00, 0x36, 0x02, 0x00, 0x04, 0x00, 0x05, 0x10, 0x00, 0x50,
+	0x64, 0x64, 0x72, 0x65, 0x73, 0x2d, 0x18, 0x05, 0xd7, 0x00, 0x00, 0x00,
+	0x00, 0x1d, 0x66, 0xc4, 0x73,
+};
+
+static const u8 lz4_legacy[] = {
+	0x02, 0x21, 0x4c, 0x18, 0x02, 0x02, 0x00, 0x00, 0xf1, 0x0b, 0x7a, 0x73,
+	0x74, 0x64, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x6f, 0x61, 0x64, 0x20,
+	0x63, 0x6f, 0x6d, 0x70, 0x72, 0x65, 0x73, 0x73, 0x65, 0x64, 0x20, 0x0a,
+	0x11, 0x00, 0x60, 0x30, 0x78, 0x38, 0x30, 0x30, 0x30, 0x04, 0x00, 0x11,
+	0x20, 0x2a, 0x00, 0x80, 0x77, 0x69, 0x74, 0x68, 0x20, 0x61, 0x64, 0x64,
+	0x25, 0x00, 0x52, 0x20, 0x62, 0x6f, 0x6f, 0x74, 0x38, 0x00, 0x01, 0x0a,
+	0x00, 0x00, 0x46, 0x00, 0x04, 0x1b, 0x00, 0x07, 0x49, 0x00, 0xf1, 0x00,
+	0x6c, 0x7a, 0x34, 0x20, 0x6b, 0x65, 0x72, 0x6e, 0x65, 0x6c, 0x20, 0x74,
+	0x72, 0x65, 0x65, 0x10, 0x00, 0x72, 0x72, 0x61, 0x6d, 0x64, 0x69, 0x73,
+	0x6b, 0x3d, 0x00, 0x44, 0x0a, 0x61, 0x6e, 0x64, 0x22, 0x00, 0x01, 0x75,
+	0x00, 0x01, 0x6a, 0x00, 0x04, 0x4a, 0x00, 0x01, 0x5b, 0x00, 0x01, 0x12,
+	0x00, 0x01, 0x1c, 0x00, 0x01, 0x0f, 0x00, 0x04, 0x3f, 0x00, 0x01, 0x17,
+	0x00, 0x01, 0x93, 0x00, 0x01, 0x05, 0x00, 0x01, 0x0f, 0x00, 0x00, 0x86,
+	0x00, 0x01, 0x2a, 0x00, 0x00, 0x68, 0x00, 0x03, 0x78, 0x00, 0x17, 0x0a,
+	0xc7, 0x00, 0x03, 0x13, 0x00, 0x00, 0x1e, 0x00, 0x04, 0x47, 0x00, 0x08,
+	0x1f, 0x00, 0x01, 0x44, 0x00, 0x00, 0x91, 0x00, 0x07, 0xc2, 0x00, 0x07,
+	0x3e, 0x00, 0x00, 0x5e, 0x00, 0x04, 0x37, 0x00, 0x04, 0xa2, 0x00, 0x01,
+	0x33, 0x00, 0x01, 0x05, 0x00, 0x08, 0x29, 0x00, 0x00, 0xeb, 0x00, 0x01,
+	0xf0, 0x00, 0x09, 0x27, 0x00, 0x07, 0x22, 0x00, 0x04, 0x18, 0x00, 0x03,
+	0x91, 0x00, 0x01, 0xc2, 0x00, 0x04, 0x14, 0x00, 0x01, 0x0d, 0x00, 0x00,
+	0xa3, 0x00, 0x01, 0x09, 0x00, 0x01, 0xf4, 0x00, 0x07, 0x90, 0x00, 0x00,
+	0x9f, 0x00, 0x53, 0x64, 0x65, 0x76, 0x69, 0x63, 0x62, 0x00, 0x01, 0x7c,
+	0x00, 0x04, 0x11, 0x00, 0x24, 0x68, 0x65, 0x0b, 0x00, 0x03, 0x59, 0x00,
+	0x00, 0xb3, 0x00, 0x00, 0x4b, 0x00, 0x07, 0x41, 0x00, 0x01, 0x72, 0x01,
+	0x01, 0x5b, 0x00, 0x07, 0x15, 0x00, 0x04, 0x7c, 0x00, 0x07, 0x13, 0x00,
+	0x05, 0xea, 0x00, 0x44, 0x6e, 0x64, 0x20, 0x0a, 0x0d, 0x00, 0x08, 0x6e,
+	0x00, 0x04, 0x14, 0x00, 0x01, 0xe9, 0x00, 0x01, 0x05, 0x00, 0x00, 0x6a,
+	0x00, 0x04, 0x04, 0x00, 0x04, 0x1e, 0x00, 0x04, 0x89, 0x00, 0x00, 0x13,
+	0x01, 0x01, 0x76, 0x00, 0x77, 0x69, 0x6d, 0x61, 0x67, 0x65, 0x20, 0x0a,
+	0x6a, 0x00, 0x01, 0xb2, 0x01, 0x04, 0x30, 0x00, 0x01, 0x0d, 0x00, 0x01,
+	0x29, 0x00, 0x03, 0x3a, 0x00, 0x02, 0x30, 0x00, 0x07, 0x2f, 0x00, 0x04,
+	0x2a, 0x00, 0x10, 0x0a, 0xdd, 0x00, 0x01, 0x1f, 0x01, 0x01, 0x2f, 0x00,
+	0x03, 0xf9, 0x00, 0x01, 0x89, 0x00, 0x02, 0x34, 0x00, 0x06, 0x4b, 0x00,
+	0x01, 0xb7, 0x00, 0x07, 0x43, 0x00, 0x07, 0x0b, 0x00, 0x01, 0x25, 0x00,
+	0x04, 0x53, 0x00, 0x07, 0xa2, 0x01, 0x01, 0x33, 0x00, 0x01, 0x59, 0x00,
+	0x01, 0x22, 0x00, 0x13, 0x0a, 0x5f, 0x00, 0x03, 0x95, 0x00, 0x00, 0xe6,
+	0x00, 0x02, 0x65, 0x00, 0x04, 0x3b, 0x00, 0x00, 0x8d, 0x00, 0x00, 0x04,
+	0x00, 0x01, 0x38, 0x00, 0x07, 0x48, 0x00, 0x01, 0xa1, 0x00, 0x03, 0x3d,
+	0x00, 0x01, 0x4f, 0x00, 0x03, 0x42, 0x00, 0x07, 0x23, 0x00, 0x0a, 0x49,
+	0x00, 0x02, 0x0e, 0x00, 0x07, 0x1f, 0x00, 0x01, 0x36, 0x00, 0x05, 0x82,
+	0x01, 0x11, 0x0a, 0x61, 0x00, 0x00, 0x80, 0x00, 0x05, 0x09, 0x00, 0x07,
+	0x2c, 0x00, 0x01, 0x14, 0x00, 0x12, 0x0a, 0x32, 0x00, 0x00, 0x24, 0x00,
+	0x04, 0x9e, 0x00, 0x00, 0x36, 0x02, 0x00, 0x04, 0x00, 0x05, 0x10, 0x00,
+	0x50, 0x64, 0x64, 0x72, 0x65, 0x73,
+};
+
+static const u8 zstd_fast[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x00, 0x03, 0x6d, 0x09, 0x00, 0x72, 0xc6,
+	0x13, 0x16, 0xa0, 0xa7, 0x39, 0x60, 0x5e, 0x6c, 0x02, 0x4f, 0x4b, 0xad,
+	0xf6, 0xbb, 0x94, 0x8d, 0xff, 0x5f, 0x45, 0xde, 0xa6, 0x5f, 0x3d, 0x51,
+	0x79, 0xb4, 0xcf, 0xcc, 0xcc, 0x7a, 0xc1, 0x9d, 0x62, 0x35, 0x22, 0xd6,
+	0x49, 0x51, 0x0a, 0xb7, 0x19, 0x9d, 0x0d, 0xb2, 0xf8, 0x1c, 0xfe, 0xa8,
+	0x6a, 0x8e, 0xf0, 0x83, 0x12, 0xcb, 0xa8, 0x94, 0x02, 0xb5, 0xaf, 0x44,
+	0x15, 0x43, 0xc7, 0x18, 0x80, 0xc3, 0xb0, 0xfa, 0x99, 0x47, 0xc2, 0x49,
+	0x45, 0x7d, 0xc9, 0xf4, 0x44, 0xd5, 0x2a, 0x57, 0x7b, 0xa8, 0x61, 0x93,
+	0x82, 0x24, 0xd9, 0xda, 0x0c, 0x20, 0x02, 0x62, 0x94, 0x83, 0xeb, 0x01,
+	0x10, 0x30, 0x69, 0xc4, 0x24, 0x93, 0xc6, 0x89, 0xf8, 0x23, 0x32, 0x71,
+	0x6f, 0xa3, 0x56, 0xe1, 0xb1, 0xb7, 0x16, 0x7b, 0xd0, 0x40, 0x16, 0x5d,
+	0xc8, 0x99, 0x09, 0xdb, 0x68, 0x31, 0xcb, 0xa5, 0x69, 0x25, 0x01, 0x47,
+	0x1a, 0xf8, 0x41, 0xca, 0x03, 0xf2, 0x47, 0x66, 0x74, 0xd3, 0xbd, 0x6f,
+	0x6b, 0x96, 0x35, 0xc5, 0x44, 0x4a, 0x17, 0x01, 0x33, 0x17, 0x83, 0xe8,
+	0x7c, 0x8e, 0xf5, 0x3e, 0x16, 0x78, 0x40, 0x92, 0x10, 0x81, 0x0d, 0xae,
+	0xad, 0x96, 0xc7, 0xc4, 0xda, 0x8f, 0x01, 0x20, 0xe6, 0xf8, 0xbd, 0x05,
+	0xad, 0xe5, 0xbf, 0x85, 0x60, 0xa8, 0x61, 0xf1, 0x6f, 0xcd, 0xc7, 0xa7,
+	0x0b, 0xc6, 0x27, 0x20, 0x86, 0x60, 0x1b, 0x9b, 0x3e, 0x09, 0x71, 0xbc,
+	0xa8, 0x10, 0x90, 0xbf, 0x65, 0xe0, 0x74, 0x3c, 0x19, 0xb1, 0x4d, 0xf2,
+	0x67, 0x22, 0x65, 0x42, 0xb4, 0x27, 0x60, 0x6d, 0x45, 0x65, 0x32, 0x30,
+	0xa1, 0x8b, 0x8d, 0xd2, 0xac, 0x28, 0x68, 0x6a, 0x8f, 0xe0, 0xce, 0xb1,
+	0x0e, 0xb6, 0x5b, 0xd2, 0x81, 0xe3, 0x7c, 0xc5, 0x2f, 0x1a, 0xca, 0x3b,
+	0x34, 0xc5, 0x24, 0x3c, 0x6b, 0xb0, 0xf2, 0xde, 0x47, 0xcf, 0xdc, 0x38,
+	0x5b, 0x2e, 0x41, 0xd8, 0xde, 0x8a, 0xde, 0x68, 0xa0, 0x6d, 0xdc, 0x73,
+	0xcb, 0x3c, 0x01, 0x90, 0x9a, 0xc3, 0xc4, 0x4e, 0x26, 0x42, 0x8b, 0x76,
+	0x53, 0x1f, 0xf9, 0x6f, 0x94, 0xd2, 0x2f, 0x95, 0xcc, 0xac, 0x02, 0x63,
+	0x47, 0x79, 0xb4,
+};
+
+static const u8 zstd_best[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x00, 0x03, 0xd5, 0x08, 0x00, 0x32, 0x86,
+	0x12, 0x11, 0xa0, 0x3d, 0xf0, 0xd3, 0xce, 0x6f, 0x15, 0x9e, 0xa4, 0x86,
+	0xaa, 0xef, 0xd7, 0xf5, 0xcb, 0x0d, 0x0a, 0xaa, 0xea, 0xda, 0xfe, 0xaa,
+	0xdb, 0x66, 0xa8, 0xa3, 0xde, 0x5e, 0x0e, 0x6c, 0x5e, 0xca, 0x6b, 0x28,
+	0x7a, 0x87, 0xd5, 0x70, 0xdd, 0xee, 0x37, 0xf5, 0x72, 0x8d, 0x36, 0xcc,
+	0xf4, 0x8c, 0x91, 0x65, 0x1e, 0xeb, 0x7f, 0xe2, 0x02, 0x00, 0x84, 0x04,
+	0xba, 0xdc, 0xef, 0xb5, 0x6b, 0x8a, 0x95, 0xe5, 0xc1, 0xd2, 0xb6, 0xff,
+	0xf2, 0xbf, 0x19, 0x6f, 0xa8, 0x31, 0x9f, 0x82, 0x24, 0xd9, 0xda, 0x0c,
+	0x20, 0x84, 0x18, 0xe5, 0xdc, 0x79, 0x21, 0x0c, 0xd7, 0x10, 0x2c, 0x30,
+	0x93, 0x24, 0x05, 0x85, 0x0c, 0x07, 0xc2, 0x92, 0xdf, 0x43, 0xae, 0xee,
+	0x82, 0xac, 0xf4, 0x72, 0x93, 0xcc, 0xc0, 0xcd, 0xe4, 0xd9, 0xb9, 0x6c,
+	0x89, 0x19, 0x5e, 0x4c, 0x66, 0x6c, 0xad, 0x0f, 0xf0, 0x24, 0x1f, 0xdb,
+	0x15, 0x06, 0xd5, 0x09, 0x02, 0x7d, 0xd9, 0x52, 0xb6, 0xa4, 0x08, 0x58,
+	0xbd, 0x54, 0x80, 0x6a, 0x90, 0xee, 0xec, 0xc0, 0xed, 0x61, 0xac, 0xd2,
+	0x20, 0x22, 0x04, 0x1c, 0x7f, 0x0a, 0x80, 0x2d, 0xca, 0x10, 0x6b, 0xbb,
+	0x58, 0xeb, 0x39, 0x73, 0x02, 0x64, 0xa0, 0xde, 0xb7, 0x36, 0x8e, 0x9c,
+	0x13, 0x27, 0x03, 0x44, 0x43, 0xfb, 0xb4, 0xef, 0x08, 0x91, 0xc7, 0xea,
+	0x32, 0x61, 0x76, 0xb7, 0xe3, 0x2d, 0xa5, 0x59, 0x84, 0x3b, 0x04, 0xa8,
+	0x74, 0x22, 0x7a, 0xa2, 0x77, 0x0c, 0x63, 0x32, 0x30, 0xed, 0x12, 0x94,
+	0x79, 0xfb, 0xb2, 0x15, 0x0d, 0xe2, 0x66, 0x19, 0x4d, 0xec, 0x96, 0x24,
+	0x6d, 0x61, 0x65, 0x77, 0x39, 0x08, 0xfd, 0x9f, 0x78, 0x89, 0xb3, 0x01,
+	0xa2, 0xc4, 0xef, 0xc1, 0x13, 0x45, 0xd7, 0xe2, 0x09, 0xa7, 0xfc, 0xda,
+	0xa0, 0x6b, 0x3b, 0x4d, 0xba, 0x28, 0x26, 0x00, 0x53, 0xb3, 0x83, 0xf9,
+	0x5e, 0x09, 0x50, 0x56, 0x6c, 0x85, 0x8f, 0xf6, 0xad, 0x4b, 0xe9, 0x4f,
+	0xa5, 0x62, 0x56, 0x01, 0x63, 0x47, 0x79, 0xb4,
+};
+
+static const u8 zstd_rle[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x64, 0xd0, 0x06, 0x6d, 0x00, 0x00, 0x18, 0x41,
+	0x41, 0x42, 0x02, 0x00, 0xe4, 0x41, 0x25, 0xc6, 0x57, 0x00, 0x0b, 0x7a,
+	0x9f, 0x4f, 0x45,
+};
+
+static uint32_t seed;
+
+static uint32_t next_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/* Words with the odd run of random bytes */
+static void make_text(uchar *buf, size_t size)
+{
+	static const char *const words[] = {
+		"the ", "kernel ", "boot ", "image ", "load ", "address ",
+		"0x80008000 ", "and ", "ramdisk ", "device ", "tree ",
+		"compressed ", "with ", "lz4 ", "zstd ", "\n",
+	};
+	uchar tmp[32];
+	size_t pos = 0;
+	uint32_t r;
+	int i, n;
+
+	seed = 1;
+	while (pos < size) {
+		r = next_rand();
+		if (r % 64 == 0) {
+			n = r >> 4 & 7;
+			for (i = 0; i < n; i++)
+				tmp[i] = next_rand();
+		} else {
+			n = strlen(words[r % ARRAY_SIZE(words)]);
+			memcpy(tmp, words[r % ARRAY_SIZE(words)], n);
+		}
+		n = min(n, (int)(size - pos));
+		memcpy(buf + pos, tmp, n);
+		pos += n;
+	}
+}
+
+/* Decompress into a buffer of exactly the given size, checking the ends */
+static int check_one(decompress_fn fn, const uchar *src, size_t src_len,
+		     uchar *out, size_t size, size_t *out_len)
+{
+	int ret;
+
+	memset(out, SENTINEL, size + 1);
+	*out_len = size;
+	ret = fn(src, src_len, out, out_len);
+	assert(*out_len <= size);
+	assert(out[size] == SENTINEL);
+
+	return ret;
+}
+
+static void check_vector(decompress_fn fn, const uchar *vec, size_t len,
+			 const uchar *plain, size_t size, int checksum)
+{
+	uchar *src = malloc(len);
+	uchar *out = malloc(size + 1);
+	size_t out_len, i;
+	int ret;
+
+	assert(src && out);
+	memcpy(src, vec, len);
+
+	/* Exactly right, then a byte short */
+	assert(!check_one(fn, src, len, out, size, &out_len));
+	assert(out_len == size);
+	assert(!memcmp(out, plain, size));
+	assert(check_one(fn, src, len, out, size - 1, &out_len) == -ENOSPC);
+
+	/* Never the whole thing when cut short */
+	for (i = 0; i < len; i++) {
+		ret = check_one(fn, src, i, out, size, &out_len);
+		assert(ret || out_len < size);
+	}
+
+	/* Damage never gets written outside the buffer... */
+	for (i = 0; i < len * 8; i++) {
+		src[i / 8] ^= 1 << (i & 7);
+		check_one(fn, src, len, out, size, &out_len);
+		src[i / 8] = vec[i / 8];
+	}
+
+	/* ...and is caught by a checksum, if there is one */
+	for (i = 0; i < len; i++) {
+		src[i] ^= 0xff;
+		ret = check_one(fn, src, len, out, size, &out_len);
+		if (checksum)
+			assert(ret);
+		src[i] = vec[i];
+	}
+
+	free(out);
+	free(src);
+}
+
+static int read_file(const char *fname, uchar **bufp, size_t *sizep)
+{
+	off_t size;
+	int fd;
+
+	fd = os_open(fname, OS_O_RDONLY);
+	if (fd < 0) {
+		printf("Cannot open '%s'\n", fname);
+		return 1;
+	}
+	size = os_lseek(fd, 0, OS_SEEK_END);
+	os_lseek(fd, 0, OS_SEEK_SET);
+	*bufp = os_malloc(size + 1);
+	if (!*bufp || os_read(fd, *bufp, size) != size) {
+		printf("Cannot read '%s'\n", fname);
+		os_close(fd);
+		return 1;
+	}
+	os_close(fd);
+	*sizep = size;
+
+	return 0;
+}
+
+/* Decompress a file from the host, check it and see how fast it goes */
+static int bench_file(const char *fname, const char *orig)
+{
+	uchar *src, *plain = NULL, *out;
+	size_t src_len, size, out_len;
+	decompress_fn fn;
+	ulong start, taken;
+	u32 magic;
+	int i, ret;
+
+	if (read_file(fname, &src, &src_len))
+		return 1;
+	if (orig && read_file(orig, &plain, &size))
+		return 1;
+	if (!orig)
+		size = 64 << 20;
+	magic = src_len >= 4 ? get_unaligned_le32(src) : 0;
+	if (magic == LZ4_MAGIC || magic == LZ4_LEGACY) {
+		fn = lz4_decompress;
+	} else if (magic == ZSTD_MAGIC) {
+		fn = zstd_decompress;
+	} else {
+		printf("'%s' is not lz4 or zstd\n", fname);
+		return 1;
+	}
+	out = os_malloc(size + 1);
+	if (!out)
+		return 1;
+
+	start = get_timer(0);
+	for (i = 0; i < BENCH_RUNS; i++) {
+		out_len = size;
+		ret = fn(src, src_len, out, &out_len);
+		if (ret) {
+			printf("%s: error %d\n", fname, ret);
+			return 1;
+		}
+	}
+	taken = get_timer(start);
+
+	if (plain && (out_len != size || memcmp(out, plain, size))) {
+		printf("%s: does not match %s\n", fname, orig);
+		return 1;
+	}
+	printf("bench_compression: %d x %s, %lu KB to %lu KB: %lu ms, %lu MB/s\n",
+	       BENCH_RUNS, fname, (ulong)src_len >> 10, (ulong)out_len >> 10,
+	       taken, taken ?
+	       (ulong)((u64)out_len * BENCH_RUNS * 1000 / taken >> 20) : 0);
+
+	return 0;
+}
+
+static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	uchar *plain;
+
+	if (argc > 1)
+		return bench_file(argv[1], argc > 2 ? argv[2] : NULL);
+
+	printf("%s: Testing lz4 and zstd\n", __func__);
+	plain = malloc(RLE_SIZE);
+	assert(plain);
+
+	make_text(plain, TEST_SIZE);
+	check_vector(lz4_decompress, lz4_frame, sizeof(lz4_frame), plain,
+		     TEST_SIZE, 1);
+	check_vector(lz4_decompress, lz4_legacy, sizeof(lz4_legacy), plain,
+		     TEST_SIZE, 0);
+	check_vector(zstd_decompress, zstd_fast, sizeof(zstd_fast), plain,
+		     TEST_SIZE, 1);
+	check_vector(zstd_decompress, zstd_best, sizeof(zstd_best), plain,
+		     TEST_SIZE, 1);
+
+	memset(plain, 'A', RLE_SIZE / 2);
+	memset(plain + RLE_SIZE / 2, 'B', RLE_SIZE / 2);
+	check_vector(zstd_decompress, zstd_rle, sizeof(zstd_rle), plain,
+		     RLE_SIZE, 1);
+
+	/* Neither takes the other's data */
+	assert(lz4_decompress(zstd_fast, sizeof(zstd_fast), plain,
+			      &(size_t){ RLE_SIZE }) == -EINVAL);
+	assert(zstd_decompress(lz4_frame, sizeof(lz4_frame), plain,
+			       &(size_t){ RLE_SIZE }) == -EINVAL);
+
+	free(plain);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_compression,	3,	1,	do_ut_compression,
+	"Test and benchmark lz4 and zstd decompression",
+	"[<file> [<orig>]] - benchmark decompressing a file from the host,\n"
+	"    checking it against the original if given"
+);
@@ -0,0 +1,228 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <malloc.h>
+#include <search.h>
+
+/*
+ * A big environment, like those found on real boards, with long names
+ * sharing a prefix as in bootargs_mmc, bootargs_nfs, ...
+ */
+#define TEST_VARS	400
+#define TEST_PREFIX	"board_setting_"
+#define TEST_EXTRA	300
+#define TEST_GROW	1000
+
+#define BENCH_IMPORTS	200
+#define BENCH_LOOKUPS	2000
+
+static struct hsearch_data htab;
+
+/* Build "prefixN=value" pairs in env format, returning the size used */
+static size_t make_env(char *buf, const char *prefix, int count)
+{
+	char *p = buf;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		sprintf(p, "%s%d=value of %s%d, padded to look real", prefix, i,
+			prefix, i);
+		p += strlen(p) + 1;
+	}
+	*p++ = '\0';
+
+	return p - buf;
+}
+
+static void check_vars(const char *prefix, int count)
+{
+	char name[32], value[80];
+	ENTRY e, *ep;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		sprintf(name, "%s%d", prefix, i);
+		sprintf(value, "value of %s, padded to look real", name);
+		e.key = name;
+		e.data = NULL;
+		assert(hsearch_r(e, FIND, &ep, &htab, 0));
+		assert(!strcmp(ep->data, value));
+	}
+}
+
+static void check_load(void)
+{
+	assert(htab.filled * 4 <= htab.size * 3);
+}
+
+/* Setting "nest" enters more variables from inside hsearch_r() */
+static int nested_change_ok(const ENTRY *item, const char *newval,
+			    enum env_op op, int flag)
+{
+	char name[32];
+	ENTRY e, *ep;
+	int i;
+
+	if (op != env_op_create || strcmp(item->key, "nest"))
+		return 0;
+	for (i = 0; i < TEST_GROW; i++) {
+		sprintf(name, "nested%d", i);
+		e.key = name;
+		e.data = "1";
+		if (!hsearch_r(e, ENTER, &ep, &htab, 0))
+			break;
+	}
+
+	return 0;
+}
+
+static void bench_env(const char *env, size_t size)
+{
+	ulong reuse, fresh, lookups;
+	char *names[TEST_VARS];
+	ENTRY e, *ep;
+	int i, j;
+
+	reuse = get_timer(0);
+	for (i = 0; i < BENCH_IMPORTS; i++)
+		himport_r(&htab, env, size, '\0', 0, 0, NULL);
+	reuse = get_timer(reuse);
+
+	fresh = get_timer(0);
+	for (i = 0; i < BENCH_IMPORTS; i++) {
+		hdestroy_r(&htab);
+		himport_r(&htab, env, size, '\0', 0, 0, NULL);
+	}
+	fresh = get_timer(fresh);
+
+	for (j = 0; j < TEST_VARS; j++) {
+		names[j] = malloc(32);
+		sprintf(names[j], TEST_PREFIX "%d", j);
+	}
+	e.data = NULL;
+	lookups = get_timer(0);
+	for (i = 0; i < BENCH_LOOKUPS; i++) {
+		for (j = 0; j < TEST_VARS; j++) {
+			e.key = names[j];
+			hsearch_r(e, FIND, &ep, &htab, 0);
+		}
+	}
+	lookups = get_timer(lookups);
+	for (j = 0; j < TEST_VARS; j++)
+		free(names[j]);
+
+	printf("%s: %d imports of %zu bytes: reused table %lu ms, new table %lu ms\n",
+	       __func__, BENCH_IMPORTS, size, reuse, fresh);
+	printf("%s: %d lookups in %u/%u entries: %lu ms\n", __func__,
+	       BENCH_LOOKUPS * TEST_VARS, htab.filled, htab.size, lookups);
+}
+
+static int do_ut_env(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	struct _ENTRY *table;
+	char *env, *extra;
+	size_t size, extra_size;
+	unsigned int old_size;
+	char name[32];
+	ENTRY e, *ep;
+	int i;
+
+	printf("%s: Testing the environment hash table\n", __func__);
+	env = malloc(TEST_VARS * 80);
+	extra = malloc(TEST_EXTRA * 80);
+	assert(env && extra);
+	size = make_env(env, TEST_PREFIX, TEST_VARS);
+	extra_size = make_env(extra, "extra", TEST_EXTRA);
+
+	/* A fresh import is sized for what is imported */
+	assert(himport_r(&htab, env, size, '\0', 0, 0, NULL));
+	assert(htab.filled == TEST_VARS);
+	check_load();
+	check_vars(TEST_PREFIX, TEST_VARS);
+
+	/* Importing again reuses the table */
+	table = htab.table;
+	assert(himport_r(&htab, env, size, '\0', 0, 0, NULL));
+	assert(htab.table == table && htab.filled == TEST_VARS);
+	check_vars(TEST_PREFIX, TEST_VARS);
+
+	/* Adding to it grows it at most once */
+	assert(himport_r(&htab, extra, extra_size, '\0', H_NOCLEAR, 0, NULL));
+	assert(htab.filled == TEST_VARS + TEST_EXTRA);
+	check_load();
+	check_vars(TEST_PREFIX, TEST_VARS);
+	check_vars("extra", TEST_EXTRA);
+
+	/* Entering one by one grows it as needed */
+	old_size = htab.size;
+	e.data = "1";
+	for (i = 0; i < TEST_GROW; i++) {
+		sprintf(name, "grow%d", i);
+		e.key = name;
+		assert(hsearch_r(e, ENTER, &ep, &htab, 0));
+	}
+	assert(htab.size > old_size);
+	check_load();
+	check_vars(TEST_PREFIX, TEST_VARS);
+	for (i = 0; i < TEST_GROW; i += 2) {
+		sprintf(name, "grow%d", i);
+		assert(hdelete_r(name, &htab, 0));
+	}
+	for (i = 0; i < TEST_GROW; i++) {
+		sprintf(name, "grow%d", i);
+		e.key = name;
+		assert(!hsearch_r(e, FIND, &ep, &htab, 0) == !(i & 1));
+	}
+
+	/* The table does not move under a change_ok() or callback function */
+	htab.change_ok = nested_change_ok;
+	table = htab.table;
+	e.key = "nest";
+	e.data = "1";
+	assert(hsearch_r(e, ENTER, &ep, &htab, 0));
+	assert(htab.table == table);
+	assert(!strcmp(ep->key, "nest"));
+	htab.change_ok = NULL;
+
+	/* A full import empties it again */
+	assert(himport_r(&htab, env, size, '\0', 0, 0, NULL));
+	assert(htab.filled == TEST_VARS);
+	check_vars(TEST_PREFIX, TEST_VARS);
+	e.key = "extra0";
+	assert(!hsearch_r(e, FIND, &ep, &htab, 0));
+
+	bench_env(env, size);
+
+	hdestroy_r(&htab);
+	free(extra);
+	free(env);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_env,	1,	1,	do_ut_env,
+	"Test the environment hash table",
+	""
+);
@@ -0,0 +1,130 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <errno.h>
+#include <init_job.h>
+
+/* How long each of the slow jobs waits for its 'hardware' */
+#define TEST_WAIT_MS	50
+#define TEST_JOBS	3
+
+struct test_dev {
+	ulong start;		/* when the job was started */
+	int polls;		/* number of times it was polled */
+	int result;		/* what to finish with */
+};
+
+static int slow_start(struct init_job *job)
+{
+	struct test_dev *dev = job->priv;
+
+	dev->start = get_timer(0);
+	dev->polls = 0;
+
+	return INIT_JOB_BUSY;
+}
+
+static int slow_poll(struct init_job *job)
+{
+	struct test_dev *dev = job->priv;
+
+	dev->polls++;
+	if (get_timer(dev->start) < TEST_WAIT_MS)
+		return INIT_JOB_BUSY;
+
+	return dev->result;
+}
+
+static int quick_start(struct init_job *job)
+{
+	return INIT_JOB_DONE;
+}
+
+static int do_ut_init_job(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	struct test_dev devs[TEST_JOBS + 1];
+	struct init_job jobs[TEST_JOBS + 1];
+	struct init_job quick;
+	ulong start, taken;
+	int i;
+
+	printf("%s: Testing init jobs\n", __func__);
+	memset(jobs, '\0', sizeof(jobs));
+	memset(devs, '\0', sizeof(devs));
+	for (i = 0; i <= TEST_JOBS; i++) {
+		jobs[i].name = "ut_slow";
+		jobs[i].start = slow_start;
+		jobs[i].poll = slow_poll;
+		jobs[i].priv = &devs[i];
+	}
+
+	/* A job which needs no waiting is finished straight away */
+	memset(&quick, '\0', sizeof(quick));
+	quick.name = "ut_quick";
+	quick.start = quick_start;
+	assert(init_job_add(&quick) == INIT_JOB_DONE);
+	assert(init_job_wait(&quick) == INIT_JOB_DONE);
+	assert(!init_job_poll());
+
+	/* The waits of several jobs overlap */
+	start = get_timer(0);
+	for (i = 0; i < TEST_JOBS; i++)
+		assert(init_job_add(&jobs[i]) == INIT_JOB_BUSY);
+	assert(init_job_poll() == TEST_JOBS);
+	assert(init_job_wait(NULL) == 0);
+	taken = get_timer(start);
+	printf("%s: %d jobs of %d ms took %lu ms\n", __func__, TEST_JOBS,
+	       TEST_WAIT_MS, taken);
+	assert(taken >= TEST_WAIT_MS && taken < 2 * TEST_WAIT_MS);
+	for (i = 0; i < TEST_JOBS; i++) {
+		assert(jobs[i].ret == INIT_JOB_DONE);
+		assert(devs[i].polls > 1);
+	}
+	assert(!init_job_poll());
+
+	/* Waiting for one job leaves the others running */
+	assert(init_job_add(&jobs[0]) == INIT_JOB_BUSY);
+	udelay(TEST_WAIT_MS * 1000 / 2);
+	assert(init_job_add(&jobs[1]) == INIT_JOB_BUSY);
+	assert(init_job_wait(&jobs[0]) == INIT_JOB_DONE);
+	assert(jobs[1].ret == INIT_JOB_BUSY);
+	assert(init_job_poll() == 1);
+
+	/* An error is reported by the job and by waiting for all of them */
+	devs[TEST_JOBS].result = -ETIMEDOUT;
+	assert(init_job_add(&jobs[TEST_JOBS]) == INIT_JOB_BUSY);
+	assert(init_job_wait(&jobs[TEST_JOBS]) == -ETIMEDOUT);
+	assert(init_job_wait(NULL) == -ETIMEDOUT);
+	assert(jobs[1].ret == INIT_JOB_DONE);
+	assert(!init_job_poll());
+
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_init_job,	1,	1,	do_ut_init_job,
+	"Test init jobs",
+	""
+);
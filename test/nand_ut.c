@@ -0,0 +1,107 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <malloc.h>
+#include <nand.h>
+#include <asm/nand.h>
+
+/* Run this with the simulated NAND: u-boot --nand <file> -c ut_nand */
+
+#define TEST_OFFSET	0x100000
+#define TEST_BLOCKS	2
+
+static int do_ut_nand(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	nand_info_t *nand = &nand_info[0];
+	struct nand_chip *chip = nand->priv;
+	struct sandbox_nand_stats stats;
+	size_t size, len;
+	u_char *pattern, *buf;
+	int pages, i;
+
+	printf("%s: Testing NAND reads\n", __func__);
+	if (!nand->name) {
+		printf("%s: no NAND, start with --nand <file>\n", __func__);
+		return 1;
+	}
+	assert(NAND_HAS_CACHEREAD(chip));
+
+	size = TEST_BLOCKS * nand->erasesize;
+	pages = size / nand->writesize;
+	pattern = malloc(size);
+	buf = malloc(size);
+	assert(pattern && buf);
+	for (i = 0; i < size; i++)
+		pattern[i] = i ^ (i >> 11);
+
+	assert(!nand_erase(nand, TEST_OFFSET, size));
+	len = size;
+	assert(!nand_write(nand, TEST_OFFSET, &len, pattern));
+
+	/* Whole blocks go through one cache read per block */
+	sandbox_nand_reset_stats();
+	memset(buf, '\0', size);
+	len = size;
+	assert(!nand_read(nand, TEST_OFFSET, &len, buf));
+	assert(len == size && !memcmp(buf, pattern, size));
+	sandbox_nand_get_stats(&stats);
+	assert(stats.cache_reads == pages);
+	assert(stats.array_loads == pages + TEST_BLOCKS);
+
+	/* Unaligned start and end, crossing the block boundary */
+	memset(buf, '\0', size);
+	len = size - 2 * nand->writesize + 123;
+	assert(!nand_read(nand, TEST_OFFSET + nand->writesize - 7, &len, buf));
+	assert(!memcmp(buf, pattern + nand->writesize - 7, len));
+
+	/* A single page is read without cache commands */
+	sandbox_nand_reset_stats();
+	len = nand->writesize;
+	assert(!nand_read(nand, TEST_OFFSET + 5 * nand->writesize, &len, buf));
+	assert(!memcmp(buf, pattern + 5 * nand->writesize, len));
+	sandbox_nand_get_stats(&stats);
+	assert(stats.cache_reads == 0);
+
+	/* And the same data comes back page by page */
+	chip->options &= ~NAND_CACHERD;
+	sandbox_nand_reset_stats();
+	memset(buf, '\0', size);
+	len = size;
+	assert(!nand_read(nand, TEST_OFFSET, &len, buf));
+	assert(!memcmp(buf, pattern, size));
+	sandbox_nand_get_stats(&stats);
+	assert(stats.cache_reads == 0 && stats.array_loads == pages);
+	chip->options |= NAND_CACHERD;
+
+	free(buf);
+	free(pattern);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_nand,	1,	1,	do_ut_nand,
+	"Test NAND cache reads on the simulated chip",
+	""
+);
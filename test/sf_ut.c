@@ -0,0 +1,315 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <environment.h>
+#include <malloc.h>
+#include <spi.h>
+#include <spi_flash.h>
+#include <asm/io.h>
+#include <asm/spi.h>
+
+/*
+ * Run this with the simulated flash: u-boot --spi_sf <file> -c ut_sf
+ * The environment log is tested by the sandbox_spienv build, which keeps
+ * the environment in that flash.
+ */
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Straddle the 16MiB line so that 4-byte addressing matters */
+#define TEST_OFFSET	((16 << 20) - (64 << 10))
+#define TEST_SIZE	(128 << 10)
+
+/* Where 'sf update' takes the new image from */
+#define TEST_RAM_ADDR	0x100000
+
+/* Read back the pattern in one mode, returning the SCK cycles it took */
+static unsigned long check_read(unsigned int mode, u8 expect_cmd,
+				const u8 *pattern, u8 *buf)
+{
+	struct sandbox_sf_stats stats;
+	struct spi_flash *flash;
+
+	flash = spi_flash_probe(0, 0, 1000000, SPI_MODE_0 | mode);
+	assert(flash);
+	assert(flash->addr_width == 4);
+
+	sandbox_sf_reset_stats();
+	memset(buf, '\0', TEST_SIZE);
+	assert(!spi_flash_read(flash, TEST_OFFSET, TEST_SIZE, buf));
+	assert(!memcmp(buf, pattern, TEST_SIZE));
+
+	/* Unaligned, inside the upper half */
+	memset(buf, '\0', TEST_SIZE);
+	assert(!spi_flash_read(flash, TEST_OFFSET + 0x10003, 1001, buf));
+	assert(!memcmp(buf, pattern + 0x10003, 1001));
+
+	sandbox_sf_get_stats(&stats);
+	assert(stats.errors == 0);
+	assert(stats.last_read_cmd == expect_cmd);
+	spi_flash_free(flash);
+
+	return stats.cycles;
+}
+
+/* Write the status register, e.g. to set the block protect bits */
+static void set_status(u8 sr)
+{
+	struct spi_flash *flash;
+	u8 cmd[2] = { 0x06 };	/* write enable */
+
+	flash = spi_flash_probe(0, 0, 1000000, SPI_MODE_0);
+	assert(flash);
+	assert(!spi_claim_bus(flash->spi));
+	assert(!spi_xfer(flash->spi, 8, cmd, NULL,
+			 SPI_XFER_BEGIN | SPI_XFER_END));
+	cmd[0] = 0x01;		/* write status */
+	cmd[1] = sr;
+	assert(!spi_xfer(flash->spi, 16, cmd, NULL,
+			 SPI_XFER_BEGIN | SPI_XFER_END));
+	spi_release_bus(flash->spi);
+	spi_flash_free(flash);
+}
+
+/* Run 'sf update' with the image in RAM, checking the work it did */
+static void check_update(const u8 *image, unsigned int programs,
+			 unsigned int erases)
+{
+	struct sandbox_sf_stats stats;
+	char cmd[80];
+
+	memcpy(map_physmem(TEST_RAM_ADDR, TEST_SIZE, 0), image, TEST_SIZE);
+	sprintf(cmd, "sf update %x %x %x", TEST_RAM_ADDR, TEST_OFFSET,
+		TEST_SIZE);
+	sandbox_sf_reset_stats();
+	assert(!run_command(cmd, 0));
+	sandbox_sf_get_stats(&stats);
+	debug("%s: %u programs, %u erases\n", __func__, stats.programs,
+	      stats.erases);
+	assert(stats.errors == 0);
+	assert(stats.programs == programs && stats.erases == erases);
+
+	sprintf(cmd, "sf read %x %x %x", TEST_RAM_ADDR, TEST_OFFSET, TEST_SIZE);
+	assert(!run_command(cmd, 0));
+	assert(!memcmp(map_physmem(TEST_RAM_ADDR, TEST_SIZE, 0), image,
+		       TEST_SIZE));
+}
+
+#ifdef CONFIG_ENV_LOG
+/* Run saveenv, checking whether it appended to the log or erased */
+static void check_saveenv(int append)
+{
+	struct sandbox_sf_stats stats;
+
+	sandbox_sf_reset_stats();
+	assert(!saveenv());
+	sandbox_sf_get_stats(&stats);
+	debug("%s: %u programs, %u erases\n", __func__, stats.programs,
+	      stats.erases);
+	assert(stats.errors == 0);
+	if (append)	/* a page, or two if the record straddles them */
+		assert(stats.erases == 0 && stats.programs && stats.programs <= 2);
+	else
+		assert(stats.erases);
+}
+
+/* Save the environment in its log, reading it back as on a reset */
+static void check_env(void)
+{
+	struct sandbox_sf_stats stats;
+	struct spi_flash *flash;
+	char value[60];
+	const void *rec;
+	ulong offset;
+	int valid, saves, len;
+
+	printf("%s: Testing the environment log\n", __func__);
+
+	/* Nothing valid is stored, so the first save writes it all */
+	env_relocate_spec();
+	check_saveenv(0);
+	valid = gd->env_valid;
+
+	/* Changes and deletions are appended */
+	setenv("envlog", "1");
+	check_saveenv(1);
+	setenv("envlog_del", "1");
+	check_saveenv(1);
+	setenv("envlog_del", NULL);
+	setenv("envlog", "2");
+	check_saveenv(1);
+
+	/* Saving nothing new writes nothing */
+	sandbox_sf_reset_stats();
+	assert(!saveenv());
+	sandbox_sf_get_stats(&stats);
+	assert(stats.programs == 0 && stats.erases == 0);
+
+	/* Unsaved changes are lost, saved ones replayed */
+	setenv("envlog", "unsaved");
+	env_relocate_spec();
+	assert(gd->env_valid == valid);
+	assert(!strcmp(getenv("envlog"), "2"));
+	assert(!getenv("envlog_del"));
+
+	/* A full log is compacted into the other copy */
+	for (saves = 0; ; saves++) {
+		sprintf(value, "%d, padded to fill up the log quicker", saves);
+		setenv("envlog", value);
+		sandbox_sf_reset_stats();
+		assert(!saveenv());
+		sandbox_sf_get_stats(&stats);
+		if (stats.erases)
+			break;
+	}
+	debug("%s: %d saves before the log was full\n", __func__, saves);
+	assert(saves > 10 && gd->env_valid != valid);
+	valid = gd->env_valid;
+	env_relocate_spec();
+	assert(gd->env_valid == valid);
+	assert(!strcmp(getenv("envlog"), value));
+
+	/* A save cut short is dropped, and the next one compacts */
+	setenv("envlog", "torn");
+	len = env_log_prepare(&rec, &offset);
+	assert(len > 0);
+	/* Whole 16-byte units, so that an ECC part never reprograms one */
+	assert(len % 16 == 0 && offset % 16 == 0);
+	flash = spi_flash_probe(0, 0, 1000000, SPI_MODE_0);
+	assert(flash);
+	assert(!spi_flash_write(flash, (valid == 1 ? CONFIG_ENV_OFFSET :
+			CONFIG_ENV_OFFSET_REDUND) + offset, len / 2, rec));
+	spi_flash_free(flash);
+	env_relocate_spec();
+	assert(gd->env_valid == valid);
+	assert(!strcmp(getenv("envlog"), value));
+	setenv("envlog", "3");
+	check_saveenv(0);
+	assert(gd->env_valid != valid);
+	env_relocate_spec();
+	assert(!strcmp(getenv("envlog"), "3"));
+}
+#endif
+
+static int do_ut_sf(cmd_tbl_t *cmdtp, int flag, int argc,
+		    char * const argv[])
+{
+	struct sandbox_sf_stats stats;
+	struct spi_flash *flash;
+	unsigned long single, dual, quad, quad_io;
+	u8 *pattern, *buf;
+	int i;
+
+	printf("%s: Testing SPI flash reads\n", __func__);
+	pattern = malloc(TEST_SIZE);
+	buf = malloc(TEST_SIZE);
+	assert(pattern && buf);
+	for (i = 0; i < TEST_SIZE; i++)
+		pattern[i] = i ^ (i >> 9);
+
+	flash = spi_flash_probe(0, 0, 1000000, SPI_MODE_0);
+	if (!flash) {
+		printf("%s: no flash, start with --spi_sf <file>\n", __func__);
+		return 1;
+	}
+	assert(flash->read_mode == SPI_FLASH_READ_1_1_1);
+	assert(flash->flags & SPI_FLASH_NO_REPROG);
+	assert(flash->sector_size == 64 << 10);
+
+	/*
+	 * As a part without the 4-byte opcodes, which must be in 4-byte
+	 * mode for the address to fit but must not be left in it
+	 */
+	flash->flags |= SPI_FLASH_4B_MODE;
+	sandbox_sf_reset_stats();
+	assert(!spi_flash_erase(flash, TEST_OFFSET, TEST_SIZE));
+	assert(!spi_flash_write(flash, TEST_OFFSET, TEST_SIZE, pattern));
+	assert(!spi_flash_read(flash, TEST_OFFSET, TEST_SIZE, buf));
+	assert(!memcmp(buf, pattern, TEST_SIZE));
+	sandbox_sf_get_stats(&stats);
+	assert(stats.errors == 0);
+	assert(!stats.addr4);
+	spi_flash_free(flash);
+
+	single = check_read(0, 0x0c, pattern, buf);
+	dual = check_read(SPI_RX_DUAL, 0x3c, pattern, buf);
+	quad = check_read(SPI_RX_QUAD, 0x6c, pattern, buf);
+	quad_io = check_read(SPI_RX_QUAD | SPI_TX_QUAD, 0xec, pattern, buf);
+	printf("%s: SCK cycles: 1-1-1 %lu, 1-1-2 %lu, 1-1-4 %lu, 1-4-4 %lu\n",
+	       __func__, single, dual, quad, quad_io);
+	assert(dual < single && quad < dual && quad_io <= quad);
+
+	/* Updates only touch what changed */
+	printf("%s: Testing SPI flash update\n", __func__);
+	assert(!run_command("sf probe 0:0 1000000 0", 0));
+	check_update(pattern, 0, 0);
+
+	/*
+	 * The S25FL256S has ECC (SPI_FLASH_NO_REPROG), so even clearing bits
+	 * in a programmed page means erasing and rewriting the sector
+	 */
+	pattern[3 * 256 + 5] &= ~0x10;
+	pattern[3 * 256 + 6] = 0;
+	check_update(pattern, 256, 1);
+
+	/* Setting bits erases; a blank page is not programmed */
+	pattern[0x100] |= 0x01;
+	pattern[0x10000] |= 0x01;
+	memset(pattern + 0x11000, 0xff, 256);
+	check_update(pattern, TEST_SIZE / 256 - 1, 2);
+
+	/* Filling a blank page needs no erase, just the page */
+	for (i = 0; i < 256; i++)
+		pattern[0x11000 + i] = i;
+	check_update(pattern, 1, 0);
+
+	/* Erasing everything is a single chip erase */
+	sandbox_sf_reset_stats();
+	assert(!run_command("sf erase 0 2000000", 0));
+	sandbox_sf_get_stats(&stats);
+	assert(stats.erases == 1 && stats.errors == 0);
+
+	/* Not if a block is protected: the part would ignore it */
+	set_status(0x04);
+	sandbox_sf_reset_stats();
+	assert(!run_command("sf erase 0 2000000", 0));
+	sandbox_sf_get_stats(&stats);
+	assert(stats.erases == (32 << 20) / (64 << 10));
+	assert(stats.errors == 0);
+	set_status(0);
+
+#ifdef CONFIG_ENV_LOG
+	check_env();
+#endif
+
+	free(buf);
+	free(pattern);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_sf,	1,	1,	do_ut_sf,
+	"Test SPI flash reads on the simulated flash",
+	""
+);
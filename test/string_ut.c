@@ -0,0 +1,139 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <malloc.h>
+
+#define TEST_MAX	300	/* a few times the largest unrolled step */
+#define TEST_ALIGN	16
+#define TEST_BIG	((64 << 10) + 5)
+#define BUF_SIZE	(TEST_BIG * 2 + 256)
+
+static void fill(uchar *buf, size_t len, int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (i * 13 + seed) ^ (i >> 8);
+}
+
+/* The reference, a byte at a time */
+static void copy(uchar *dest, const uchar *src, size_t len)
+{
+	while (len--)
+		*dest++ = *src++;
+}
+
+/* Check memcpy() into and out of every alignment, and that it stays put */
+static void check_memcpy(uchar *buf, uchar *ref, size_t len, int dofs,
+			 int sofs)
+{
+	uchar *dest = buf + 64 + dofs;
+	uchar *src = buf + BUF_SIZE / 2 + sofs;
+
+	fill(buf, BUF_SIZE, len + dofs);
+	copy(ref, buf, BUF_SIZE);
+	copy(ref + 64 + dofs, src, len);
+	assert(memcpy(dest, src, len) == dest);
+	assert(!memcmp(buf, ref, BUF_SIZE));
+}
+
+/* Move by a given distance either way, so that the areas may overlap */
+static void check_memmove(uchar *buf, uchar *ref, size_t len, int dofs,
+			  int sofs)
+{
+	uchar *dest = buf + 128 + dofs;
+	uchar *src = buf + 128 + sofs;
+	size_t i;
+
+	fill(buf, BUF_SIZE, len + sofs);
+	copy(ref, buf, BUF_SIZE);
+	if (dest < src) {
+		for (i = 0; i < len; i++)
+			ref[128 + dofs + i] = buf[128 + sofs + i];
+	} else {
+		for (i = len; i; i--)
+			ref[128 + dofs + i - 1] = buf[128 + sofs + i - 1];
+	}
+	assert(memmove(dest, src, len) == dest);
+	assert(!memcmp(buf, ref, BUF_SIZE));
+}
+
+static void check_memset(uchar *buf, uchar *ref, size_t len, int ofs)
+{
+	size_t i;
+
+	fill(buf, BUF_SIZE, len);
+	copy(ref, buf, BUF_SIZE);
+	for (i = 0; i < len; i++)
+		ref[64 + ofs + i] = 0x80 | len;
+	assert(memset(buf + 64 + ofs, 0x180 | len, len) == buf + 64 + ofs);
+	assert(!memcmp(buf, ref, BUF_SIZE));
+}
+
+static int do_ut_string(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	static const int dists[] = { 1, 3, 7, 8, 9, 31, 32, 33, 64, 200 };
+	uchar *buf, *ref;
+	size_t len;
+	int d, s, i;
+
+	printf("%s: Testing memcpy, memmove and memset\n", __func__);
+	buf = malloc(BUF_SIZE);
+	ref = malloc(BUF_SIZE);
+	assert(buf && ref);
+
+	for (len = 0; len <= TEST_MAX; len += len < 80 ? 1 : 23) {
+		for (d = 0; d < TEST_ALIGN; d++) {
+			for (s = 0; s < TEST_ALIGN; s++)
+				check_memcpy(buf, ref, len, d, s);
+			check_memset(buf, ref, len, d);
+		}
+		for (i = 0; i < ARRAY_SIZE(dists); i++) {
+			for (d = 0; d < TEST_ALIGN / 2; d++) {
+				check_memmove(buf, ref, len, d, d + dists[i]);
+				check_memmove(buf, ref, len, d + dists[i], d);
+			}
+		}
+	}
+
+	/* Long enough for the prefetching */
+	for (d = 0; d < 9; d += 4) {
+		check_memcpy(buf, ref, TEST_BIG, d, 0);
+		check_memcpy(buf, ref, TEST_BIG, 0, d);
+		check_memset(buf, ref, TEST_BIG, d);
+		check_memmove(buf, ref, TEST_BIG, d, d + 100);
+		check_memmove(buf, ref, TEST_BIG, d + 101, 0);
+	}
+
+	free(ref);
+	free(buf);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_string,	1,	1,	do_ut_string,
+	"Test memcpy, memmove and memset",
+	""
+);
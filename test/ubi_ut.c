@@ -0,0 +1,317 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <malloc.h>
+#include <nand.h>
+#include <asm/io.h>
+#include <asm/nand.h>
+#include <linux/crc32.h>
+#include <mtd/ubi-user.h>
+#include "../drivers/mtd/ubi/ubi-media.h"
+
+/*
+ * Run this with the simulated NAND: u-boot --nand <file> -c ut_ubi
+ *
+ * U-Boot does not write fastmaps, so the test makes one up from the
+ * headers on the chip, the way Linux would on detach.
+ */
+
+#define TEST_VOL_SIZE	(8 << 20)
+#define TEST_WRITE_ADDR	0x100000
+#define TEST_READ_ADDR	(TEST_WRITE_ADDR + TEST_VOL_SIZE)
+#define TEST_MAX_VOLS	4
+
+/* What the headers of a PEB say */
+struct peb_info {
+	u32 ec;
+	int vol_id;		/* -1 for a free PEB */
+	int lnum;
+	int vol_type;
+	int data_pad;
+};
+
+static void *fm_put(u8 *fm, int *pos, int len)
+{
+	void *p = fm + *pos;
+
+	*pos += len;
+	return p;
+}
+
+/* Add the volume header and EBA table of volume @vol_id */
+static void fm_put_volume(u8 *fm, int *pos, struct peb_info *peb,
+			  int peb_count, int vol_id, int leb_size)
+{
+	struct ubi_fm_volhdr *fmvhdr;
+	struct ubi_fm_eba *fm_eba;
+	int pnum, leb_count = 0, last = -1;
+	__be32 *eba;
+
+	for (pnum = 0; pnum < peb_count; pnum++) {
+		if (peb[pnum].vol_id == vol_id) {
+			leb_count = max(leb_count, peb[pnum].lnum + 1);
+			last = pnum;
+		}
+	}
+
+	fmvhdr = fm_put(fm, pos, sizeof(*fmvhdr));
+	fmvhdr->magic = cpu_to_be32(UBI_FM_VHDR_MAGIC);
+	fmvhdr->vol_id = cpu_to_be32(vol_id);
+	fmvhdr->vol_type = peb[last].vol_type == UBI_VID_DYNAMIC ?
+			   UBI_DYNAMIC_VOLUME : UBI_STATIC_VOLUME;
+	fmvhdr->data_pad = cpu_to_be32(peb[last].data_pad);
+	fmvhdr->used_ebs = cpu_to_be32(leb_count);
+	fmvhdr->last_eb_bytes = cpu_to_be32(leb_size - peb[last].data_pad);
+
+	fm_eba = fm_put(fm, pos, sizeof(*fm_eba));
+	fm_eba->magic = cpu_to_be32(UBI_FM_EBA_MAGIC);
+	fm_eba->reserved_pebs = cpu_to_be32(leb_count);
+	eba = fm_put(fm, pos, leb_count * sizeof(*eba));
+	memset(eba, 0xff, leb_count * sizeof(*eba));
+	for (pnum = 0; pnum < peb_count; pnum++) {
+		if (peb[pnum].vol_id == vol_id)
+			eba[peb[pnum].lnum] = cpu_to_be32(pnum);
+	}
+}
+
+/*
+ * Write a fastmap describing the chip to the first free PEB, with a bad
+ * data CRC if @bad_crc
+ */
+static void write_fastmap(nand_info_t *nand, int bad_crc)
+{
+	int peb_count = nand->size / nand->erasesize;
+	int vid_offset = 0, data_offset = 0, leb_size;
+	int pnum, anchor = -1, free_count = 0, used_count = 0;
+	int vol_ids[TEST_MAX_VOLS], vol_count = 0;
+	u64 max_sqnum = 0;
+	struct peb_info *peb;
+	struct ubi_ec_hdr *ech;
+	struct ubi_vid_hdr *vh;
+	struct ubi_fm_sb *fmsb;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_scan_pool *fmpl;
+	struct ubi_fm_ec *fmec;
+	u8 *page, *fm;
+	size_t len;
+	int pos, i;
+
+	peb = calloc(peb_count, sizeof(*peb));
+	page = malloc(nand->writesize);
+	assert(peb && page);
+
+	/* Read the headers, which are all in the first page */
+	for (pnum = 0; pnum < peb_count; pnum++) {
+		len = nand->writesize;
+		assert(!nand_read(nand, (loff_t)pnum * nand->erasesize, &len,
+				  page));
+		ech = (struct ubi_ec_hdr *)page;
+		assert(be32_to_cpu(ech->magic) == UBI_EC_HDR_MAGIC);
+		vid_offset = be32_to_cpu(ech->vid_hdr_offset);
+		data_offset = be32_to_cpu(ech->data_offset);
+		peb[pnum].ec = be64_to_cpu(ech->ec);
+
+		vh = (struct ubi_vid_hdr *)(page + vid_offset);
+		if (be32_to_cpu(vh->magic) != UBI_VID_HDR_MAGIC) {
+			peb[pnum].vol_id = -1;
+			if (anchor < 0 && pnum < UBI_FM_MAX_START)
+				anchor = pnum;
+			else
+				free_count++;
+			continue;
+		}
+		peb[pnum].vol_id = be32_to_cpu(vh->vol_id);
+		peb[pnum].lnum = be32_to_cpu(vh->lnum);
+		peb[pnum].vol_type = vh->vol_type;
+		peb[pnum].data_pad = be32_to_cpu(vh->data_pad);
+		max_sqnum = max(max_sqnum, be64_to_cpu(vh->sqnum));
+		used_count++;
+
+		for (i = 0; i < vol_count; i++) {
+			if (vol_ids[i] == peb[pnum].vol_id)
+				break;
+		}
+		if (i == vol_count) {
+			assert(vol_count < TEST_MAX_VOLS);
+			vol_ids[vol_count++] = peb[pnum].vol_id;
+		}
+	}
+	assert(anchor >= 0);
+
+	leb_size = nand->erasesize - data_offset;
+	fm = calloc(1, leb_size);
+	assert(fm);
+	pos = 0;
+
+	fmsb = fm_put(fm, &pos, sizeof(*fmsb));
+	fmsb->magic = cpu_to_be32(UBI_FM_SB_MAGIC);
+	fmsb->version = UBI_FM_FMT_VERSION;
+	fmsb->used_blocks = cpu_to_be32(1);
+	fmsb->block_loc[0] = cpu_to_be32(anchor);
+	fmsb->block_ec[0] = cpu_to_be32(peb[anchor].ec);
+	fmsb->sqnum = cpu_to_be64(max_sqnum);
+
+	fmhdr = fm_put(fm, &pos, sizeof(*fmhdr));
+	fmhdr->magic = cpu_to_be32(UBI_FM_HDR_MAGIC);
+	fmhdr->free_peb_count = cpu_to_be32(free_count);
+	fmhdr->used_peb_count = cpu_to_be32(used_count);
+	fmhdr->vol_count = cpu_to_be32(vol_count);
+
+	/* Both pools are empty */
+	for (i = 0; i < 2; i++) {
+		fmpl = fm_put(fm, &pos, sizeof(*fmpl));
+		fmpl->magic = cpu_to_be32(UBI_FM_POOL_MAGIC);
+		fmpl->max_size = cpu_to_be16(UBI_FM_MAX_POOL_SIZE);
+	}
+
+	/* Free PEBs first, then used ones */
+	for (i = 0; i < 2; i++) {
+		for (pnum = 0; pnum < peb_count; pnum++) {
+			if (pnum == anchor || (peb[pnum].vol_id < 0) == i)
+				continue;
+			fmec = fm_put(fm, &pos, sizeof(*fmec));
+			fmec->pnum = cpu_to_be32(pnum);
+			fmec->ec = cpu_to_be32(peb[pnum].ec);
+		}
+	}
+
+	for (i = 0; i < vol_count; i++)
+		fm_put_volume(fm, &pos, peb, peb_count, vol_ids[i], leb_size);
+	assert(pos <= leb_size);
+
+	fmsb->data_crc = cpu_to_be32(crc32(UBI_CRC32_INIT, fm, leb_size) ^
+				     bad_crc);
+
+	/* The anchor keeps its EC header and gets a VID header */
+	len = nand->writesize;
+	assert(!nand_read(nand, (loff_t)anchor * nand->erasesize, &len, page));
+	vh = (struct ubi_vid_hdr *)(page + vid_offset);
+	memset(vh, '\0', sizeof(*vh));
+	vh->magic = cpu_to_be32(UBI_VID_HDR_MAGIC);
+	vh->version = UBI_VERSION;
+	vh->vol_type = UBI_VID_DYNAMIC;
+	vh->compat = UBI_COMPAT_DELETE;
+	vh->vol_id = cpu_to_be32(UBI_FM_SB_VOLUME_ID);
+	vh->sqnum = cpu_to_be64(max_sqnum + 1);
+	vh->hdr_crc = cpu_to_be32(crc32(UBI_CRC32_INIT, vh,
+					UBI_VID_HDR_SIZE_CRC));
+
+	assert(!nand_erase(nand, (loff_t)anchor * nand->erasesize,
+			   nand->erasesize));
+	len = nand->writesize;
+	assert(!nand_write(nand, (loff_t)anchor * nand->erasesize, &len,
+			   page));
+	len = leb_size;
+	assert(!nand_write(nand, (loff_t)anchor * nand->erasesize +
+			   data_offset, &len, fm));
+
+	free(fm);
+	free(page);
+	free(peb);
+}
+
+/* Attach the UBI partition, returning the time and page loads it took */
+static ulong ubi_attach(struct sandbox_nand_stats *stats)
+{
+	ulong start;
+
+	sandbox_nand_reset_stats();
+	start = get_timer(0);
+	assert(!run_command("ubi part ubi", 0));
+	start = get_timer(start);
+	sandbox_nand_get_stats(stats);
+
+	return start;
+}
+
+static void check_volume(const u8 *pattern)
+{
+	u8 *buf = map_physmem(TEST_READ_ADDR, TEST_VOL_SIZE, MAP_NOCACHE);
+	char cmd[60];
+
+	memset(buf, '\0', TEST_VOL_SIZE);
+	sprintf(cmd, "ubi read %lx vol %x", (ulong)buf, TEST_VOL_SIZE);
+	assert(!run_command(cmd, 0));
+	assert(!memcmp(buf, pattern, TEST_VOL_SIZE));
+}
+
+static int do_ut_ubi(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	nand_info_t *nand = &nand_info[0];
+	struct sandbox_nand_stats scan, fastmap, bad;
+	ulong scan_ms, fastmap_ms;
+	char cmd[60];
+	u8 *pattern;
+	int i;
+
+	printf("%s: Testing UBI attach\n", __func__);
+	if (!nand->name) {
+		printf("%s: no NAND, start with --nand <file>\n", __func__);
+		return 1;
+	}
+
+	/* A fresh UBI device with one volume, written in full */
+	assert(!nand_erase(nand, 0, nand->size));
+	assert(!run_command("mtdparts default", 0));
+	assert(!run_command("ubi part ubi", 0));
+	sprintf(cmd, "ubi create vol %x", TEST_VOL_SIZE);
+	assert(!run_command(cmd, 0));
+	pattern = map_physmem(TEST_WRITE_ADDR, TEST_VOL_SIZE, MAP_NOCACHE);
+	for (i = 0; i < TEST_VOL_SIZE; i++)
+		pattern[i] = i ^ (i >> 13);
+	sprintf(cmd, "ubi write %lx vol %x", (ulong)pattern, TEST_VOL_SIZE);
+	assert(!run_command(cmd, 0));
+
+	scan_ms = ubi_attach(&scan);
+	check_volume(pattern);
+
+	/* Only the fastmap is read */
+	write_fastmap(nand, 0);
+	fastmap_ms = ubi_attach(&fastmap);
+	check_volume(pattern);
+	assert(fastmap.array_loads * 4 < scan.array_loads);
+
+	/* The fastmap was dropped, so this is a full scan again */
+	ubi_attach(&bad);
+	assert(bad.array_loads * 4 > scan.array_loads * 3);
+
+	/* A bad fastmap means a full scan */
+	write_fastmap(nand, 1);
+	ubi_attach(&bad);
+	assert(bad.array_loads >= scan.array_loads);
+	check_volume(pattern);
+
+	printf("%s: attach by scan %lu ms, %u page loads\n", __func__,
+	       scan_ms, scan.array_loads);
+	printf("%s: attach by fastmap %lu ms, %u page loads\n", __func__,
+	       fastmap_ms, fastmap.array_loads);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_ubi,	1,	1,	do_ut_ubi,
+	"Test attaching UBI from a fastmap on the simulated chip",
+	""
+);
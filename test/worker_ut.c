@@ -0,0 +1,156 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <malloc.h>
+#include <worker.h>
+
+/* Enough jobs that some have to run on the boot CPU */
+#define TEST_JOBS	(CONFIG_WORKER_MAX * 2 + 1)
+#define TEST_PART	(256 << 10)
+#define TEST_COPY	((1 << 20) + 13)
+
+#define BENCH_COPIES	50
+
+struct test_crc {
+	struct worker_job job;
+	const uchar *buf;
+	uint len;
+	u32 crc;
+};
+
+static int crc_job(struct worker_job *job)
+{
+	struct test_crc *tc = job->priv;
+
+	tc->crc = crc32(0, tc->buf, tc->len);
+
+	return tc->len;
+}
+
+static void fill(uchar *buf, size_t len, int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (i * 7 + seed) ^ (i >> 11);
+}
+
+static void check_copy(uchar *buf, size_t dest, size_t src, size_t len)
+{
+	uchar *ref = malloc(len);
+
+	assert(ref);
+	fill(buf, TEST_COPY * 2, 3);
+	memcpy(ref, buf + src, len);
+	worker_memmove(buf + dest, buf + src, len);
+	assert(!memcmp(buf + dest, ref, len));
+	free(ref);
+}
+
+static void bench_worker(uchar *buf, struct test_crc *tcs)
+{
+	ulong alone, together;
+	int i;
+
+	alone = get_timer(0);
+	for (i = 0; i < TEST_JOBS; i++)
+		crc_job(&tcs[i].job);
+	alone = get_timer(alone);
+
+	together = get_timer(0);
+	for (i = 0; i < TEST_JOBS; i++)
+		worker_submit(&tcs[i].job);
+	for (i = 0; i < TEST_JOBS; i++)
+		worker_wait(&tcs[i].job);
+	together = get_timer(together);
+
+	printf("%s: crc32 of %d x %d KB: alone %lu ms, with workers %lu ms\n",
+	       __func__, TEST_JOBS, TEST_PART >> 10, alone, together);
+
+	alone = get_timer(0);
+	for (i = 0; i < BENCH_COPIES; i++)
+		memmove(buf + TEST_COPY, buf, TEST_COPY);
+	alone = get_timer(alone);
+
+	together = get_timer(0);
+	for (i = 0; i < BENCH_COPIES; i++)
+		worker_memmove(buf + TEST_COPY, buf, TEST_COPY);
+	together = get_timer(together);
+
+	printf("%s: %d copies of %d KB: alone %lu ms, with workers %lu ms\n",
+	       __func__, BENCH_COPIES, TEST_COPY >> 10, alone,
+	       together);
+}
+
+static int do_ut_worker(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct test_crc tcs[TEST_JOBS];
+	uchar *buf;
+	int i;
+
+	printf("%s: Testing workers\n", __func__);
+	buf = malloc(TEST_COPY * 2);
+	assert(buf);
+	fill(buf, TEST_JOBS * TEST_PART, 1);
+
+	/* Each job runs once, whether on a worker or here */
+	for (i = 0; i < TEST_JOBS; i++) {
+		tcs[i].job.fn = crc_job;
+		tcs[i].job.priv = &tcs[i];
+		tcs[i].buf = buf + i * TEST_PART;
+		tcs[i].len = TEST_PART - i;
+		tcs[i].crc = 0;
+		worker_submit(&tcs[i].job);
+	}
+	for (i = 0; i < TEST_JOBS; i++) {
+		assert(worker_wait(&tcs[i].job) == TEST_PART - i);
+		assert(tcs[i].crc == crc32(0, tcs[i].buf, tcs[i].len));
+	}
+
+	/* Stopped workers start again for the next job */
+	worker_stop();
+	worker_stop();
+	worker_submit(&tcs[0].job);
+	assert(worker_wait(&tcs[0].job) == TEST_PART);
+
+	/* Copies: small, split up, and overlapping either way */
+	check_copy(buf, TEST_COPY, 0, 100);
+	check_copy(buf, TEST_COPY, 0, TEST_COPY);
+	check_copy(buf, 1, TEST_COPY + 5, TEST_COPY - 5);
+	check_copy(buf, 4096, 0, TEST_COPY);
+	check_copy(buf, 0, 4096, TEST_COPY);
+
+	bench_worker(buf, tcs);
+	worker_stop();
+
+	free(buf);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_worker,	1,	1,	do_ut_worker,
+	"Test the workers on secondary cores",
+	""
+);
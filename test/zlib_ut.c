@@ -0,0 +1,300 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#define DEBUG
+
+#include <common.h>
+#include <malloc.h>
+#include <os.h>
+#include <u-boot/zlib.h>
+#include <asm/unaligned.h>
+
+#define TEST_SIZE	(1 << 20)
+#define TEST_PATTERN	(64 << 10)
+#define TEST_CHUNK	777		/* output chunk for streaming */
+#define GZIP_HEADER	10
+
+#define BENCH_RUNS	50
+
+static uint32_t seed;
+
+static uint32_t next_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/*
+ * Something that compresses like a kernel: code made of a small set of
+ * instructions with varying operands, strings, and runs of zeroes
+ */
+static void make_kernel(uchar *buf, size_t size)
+{
+	static const char *const strs[] = {
+		"Unable to handle kernel paging request",
+		"%s: probe of %s failed with error %d\n",
+		"<6>usb 1-1: new high-speed USB device",
+	};
+	uint32_t insns[64];
+	size_t pos = 0;
+	uint32_t r;
+	int i, n;
+
+	seed = 1;
+	for (i = 0; i < ARRAY_SIZE(insns); i++)
+		insns[i] = next_rand() << 8 | next_rand();
+	while (pos + 64 < size) {
+		r = next_rand();
+		if (r % 100 < 3) {
+			n = next_rand() % 48;
+			memset(buf + pos, '\0', n);
+			pos += n;
+		} else if (r % 100 < 6) {
+			n = strlen(strs[r % ARRAY_SIZE(strs)]);
+			memcpy(buf + pos, strs[r % ARRAY_SIZE(strs)], n);
+			pos += n;
+		} else {
+			/* Favour a few instructions, with a varied operand */
+			n = next_rand() % ARRAY_SIZE(insns);
+			n = n * n / ARRAY_SIZE(insns);
+			put_unaligned(insns[n] ^ (r % 4 ? 0 : next_rand() & 0xff),
+				      (uint32_t *)(buf + pos));
+			pos += 4;
+		}
+	}
+	memset(buf + pos, '\0', size - pos);
+}
+
+/* Repeat a short pattern, with the odd change to break up the matches */
+static void make_pattern(uchar *buf, size_t size, int period)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = i < period ? next_rand() : buf[i - period];
+	for (i = 0; i < size; i += 1000 + next_rand() % 1000)
+		buf[i] ^= 0x55;
+}
+
+/* gzip data and check that it inflates back, in one go */
+static uchar *check_gunzip(const uchar *data, size_t size,
+			   unsigned long *gz_size)
+{
+	unsigned long len = size + size / 8 + 1024;
+	uchar *gz = malloc(len);
+	uchar *out = malloc(size + 1);
+
+	assert(gz && out);
+	assert(!gzip(gz, &len, (uchar *)data, size));
+	*gz_size = len;
+
+	/* Nothing may be written past the buffer given */
+	out[size] = 0xa5;
+	assert(!gunzip(out, size, gz, &len));
+	assert(len == size);
+	assert(!memcmp(out, data, size));
+	assert(out[size] == 0xa5);
+	free(out);
+
+	return gz;
+}
+
+/* Inflate a little at a time, so that matches come from the window */
+static void check_stream(const uchar *data, size_t size, uchar *gz,
+			 unsigned long gz_size)
+{
+	uchar *out = malloc(TEST_CHUNK);
+	size_t pos = 0;
+	z_stream s;
+	int r;
+
+	assert(out);
+	memset(&s, '\0', sizeof(s));
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	assert(inflateInit2(&s, -MAX_WBITS) == Z_OK);
+	s.next_in = gz + GZIP_HEADER;
+	s.avail_in = gz_size - GZIP_HEADER;
+	do {
+		s.next_out = out;
+		s.avail_out = TEST_CHUNK;
+		r = inflate(&s, Z_NO_FLUSH);
+		assert(r == Z_OK || r == Z_STREAM_END);
+		assert(!memcmp(out, data + pos, TEST_CHUNK - s.avail_out));
+		pos += TEST_CHUNK - s.avail_out;
+	} while (r != Z_STREAM_END);
+	assert(pos == size);
+	inflateEnd(&s);
+	free(out);
+}
+
+static uint32_t ref_adler32(uint32_t adler, const uchar *buf, uint len)
+{
+	uint32_t a = adler & 0xffff, b = adler >> 16;
+
+	while (len--) {
+		a = (a + *buf++) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return b << 16 | a;
+}
+
+static void check_adler32(const uchar *buf, size_t size)
+{
+	static const uint lens[] = { 0, 1, 15, 16, 17, 63, 64, 5551, 5552,
+				     5553, 5552 * 2 + 31, 65537 };
+	uint32_t adler;
+	int i, ofs;
+
+	for (i = 0; i < ARRAY_SIZE(lens); i++) {
+		for (ofs = 0; ofs < 4; ofs++) {
+			adler = next_rand();
+			adler = (adler >> 16) % 65521 << 16 | adler % 65521;
+			assert(adler32(adler, buf + ofs, lens[i]) ==
+			       ref_adler32(adler, buf + ofs, lens[i]));
+		}
+	}
+
+	/* All 0xff is the worst case for the sums */
+	memset((uchar *)buf, 0xff, 65537);
+	assert(adler32(0xfff0fff0, buf, 65537) ==
+	       ref_adler32(0xfff0fff0, buf, 65537));
+	assert(adler32(adler32(1, buf, 100), buf + 100, 40000) ==
+	       adler32(1, buf, 40100));
+}
+
+static void bench_gunzip(const char *name, uchar *gz, unsigned long gz_size,
+			 uchar *out, size_t size)
+{
+	unsigned long len;
+	ulong start, taken;
+	int i;
+
+	start = get_timer(0);
+	for (i = 0; i < BENCH_RUNS; i++) {
+		len = gz_size;
+		if (gunzip(out, size, gz, &len))
+			return;
+	}
+	taken = get_timer(start);
+
+	printf("bench_zlib: %d x gunzip %s, %lu KB to %lu KB: %lu ms, %lu MB/s\n",
+	       BENCH_RUNS, name, gz_size >> 10, len >> 10, taken,
+	       taken ? (ulong)((u64)len * BENCH_RUNS * 1000 / taken >> 20) : 0);
+}
+
+static void bench_adler32(const uchar *buf, size_t size)
+{
+	ulong start, taken;
+	int i;
+
+	start = get_timer(0);
+	for (i = 0; i < BENCH_RUNS * 10; i++)
+		adler32(1, buf, size);
+	taken = get_timer(start);
+
+	printf("bench_zlib: %d x adler32 of %zu KB: %lu ms, %lu MB/s\n",
+	       BENCH_RUNS * 10, size >> 10, taken,
+	       taken ? (ulong)((u64)size * BENCH_RUNS * 10000 / taken >> 20) :
+	       0);
+}
+
+/* Benchmark a gzip file from the host, e.g. a kernel */
+static int bench_file(const char *fname)
+{
+	uchar *gz, *out;
+	size_t size;
+	off_t gz_size;
+	int fd;
+
+	fd = os_open(fname, OS_O_RDONLY);
+	if (fd < 0) {
+		printf("Cannot open '%s'\n", fname);
+		return 1;
+	}
+	gz_size = os_lseek(fd, 0, OS_SEEK_END);
+	os_lseek(fd, 0, OS_SEEK_SET);
+	gz = os_malloc(gz_size);
+	if (gz_size < 18 || !gz || os_read(fd, gz, gz_size) != gz_size) {
+		printf("Cannot read '%s'\n", fname);
+		os_close(fd);
+		return 1;
+	}
+	os_close(fd);
+
+	/* The gzip trailer gives the size */
+	size = get_unaligned_le32(gz + gz_size - 4);
+	out = os_malloc(size);
+	if (!out)
+		return 1;
+	bench_gunzip(fname, gz, gz_size, out, size);
+	bench_adler32(out, size);
+
+	return 0;
+}
+
+static int do_ut_zlib(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	unsigned long gz_size;
+	uchar *data, *gz;
+	int period;
+
+	if (argc > 1)
+		return bench_file(argv[1]);
+
+	printf("%s: Testing zlib\n", __func__);
+	data = malloc(TEST_SIZE);
+	assert(data);
+
+	/* Matches at every short distance */
+	for (period = 1; period <= 40; period++) {
+		make_pattern(data, TEST_PATTERN, period);
+		gz = check_gunzip(data, TEST_PATTERN, &gz_size);
+		check_stream(data, TEST_PATTERN, gz, gz_size);
+		free(gz);
+	}
+
+	/* Random data, mostly literals */
+	for (period = 0; period < TEST_PATTERN; period++)
+		data[period] = next_rand();
+	gz = check_gunzip(data, TEST_PATTERN, &gz_size);
+	free(gz);
+
+	make_kernel(data, TEST_SIZE);
+	gz = check_gunzip(data, TEST_SIZE, &gz_size);
+	check_stream(data, TEST_SIZE, gz, gz_size);
+
+	bench_gunzip("kernel-like data", gz, gz_size, data, TEST_SIZE);
+	bench_adler32(data, TEST_SIZE);
+	check_adler32(data, TEST_SIZE);
+
+	free(gz);
+	free(data);
+	printf("%s: Everything went swimmingly\n", __func__);
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_zlib,	2,	1,	do_ut_zlib,
+	"Test and benchmark zlib inflate",
+	"[<file.gz>] - benchmark decompressing a gzip file from the host"
+);
@@ -85,6 +85,22 @@ static int dev_current;
 
 #define ENV_SIZE      getenvsize()
 
+/*
+ * With CONFIG_ENV_LOG, U-Boot's saveenv appends change records to a log
+ * at the end of the environment (see common/env_log.c).  They are applied
+ * when the environment is read, and the log is written back erased along
+ * with the whole environment.
+ */
+#ifdef CONFIG_ENV_LOG
+# ifndef CONFIG_ENV_LOG_SIZE
+#  define CONFIG_ENV_LOG_SIZE	(CONFIG_ENV_SIZE / 4)
+# endif
+# define ENV_LOG_SIZE	CONFIG_ENV_LOG_SIZE
+#else
+# define ENV_LOG_SIZE	0
+#endif
+#define ENV_LOG_ALIGN	4
+
 struct env_image_single {
 	uint32_t	crc;	/* CRC32 over data bytes    */
 	char		data[];
@@ -136,7 +152,7 @@ static inline ulong getenvsize (void)
 
 	if (HaveRedundEnv)
 		rc -= sizeof (char);
-	return rc;
+	return rc - ENV_LOG_SIZE;
 }
 
 static char *fw_string_blank(char *s, int noblank)
@@ -1049,6 +1065,50 @@ static char *envmatch (char * s1, char * s2)
 	return NULL;
 }
 
+#ifdef CONFIG_ENV_LOG
+/*
+ * Apply the change records in the log, stopping at the first erased or
+ * damaged header as U-Boot does, then erase the log
+ */
+static void fw_env_log_replay(void)
+{
+	char *log = (char *)environment.image + CUR_ENVSIZE - ENV_LOG_SIZE;
+	uint32_t hdr[2];		/* CRC32 over len and data, len */
+	uint32_t crc;
+	char *s, *end, *val;
+	int pos;
+
+	for (pos = 0; pos + sizeof(hdr) <= ENV_LOG_SIZE;
+	     pos += sizeof(hdr) + hdr[1]) {
+		memcpy(hdr, log + pos, sizeof(hdr));
+		if (hdr[0] == 0xffffffff && hdr[1] == 0xffffffff)
+			break;
+
+		s = log + pos + sizeof(hdr);
+		crc = crc32(0, (uint8_t *)&hdr[1], sizeof(hdr[1]));
+		if (hdr[1] > ENV_LOG_SIZE - sizeof(hdr) - pos ||
+		    hdr[1] % ENV_LOG_ALIGN ||
+		    crc32(crc, (uint8_t *)s, hdr[1]) != hdr[0]) {
+			fprintf(stderr, "Warning: damaged environment log, "
+				"dropping the changes after it\n");
+			break;
+		}
+
+		/* "name=value", or "name" for a deleted variable */
+		for (end = s + hdr[1]; s < end && *s; s += strlen(s) + 1) {
+			val = strchr(s, '=');
+			if (val)
+				*val++ = '\0';
+			fw_env_write(s, val);
+			if (val)
+				val[-1] = '=';
+		}
+	}
+
+	memset(log, 0xff, ENV_LOG_SIZE);
+}
+#endif
+
 /*
  * Prevent confusion if running from erased flash memory
  */
@@ -1208,6 +1268,14 @@ int fw_env_open(void)
 		fprintf(stderr, "Selected env in %s\n", DEVNAME(dev_current));
 #endif
 	}
+
+#ifdef CONFIG_ENV_LOG
+	if (crc0_ok || (HaveRedundEnv && crc1_ok))
+		fw_env_log_replay();
+	else
+		memset((char *)environment.image + CUR_ENVSIZE - ENV_LOG_SIZE,
+		       0xff, ENV_LOG_SIZE);
+#endif
 	return 0;
 }
 
@@ -47,6 +47,113 @@ static int fit_check_image_types (uint8_t type)
 		return EXIT_FAILURE;
 }
 
+/**
+ * fit_extract_data - move image data out of the FIT structure
+ *
+ * fit_extract_data() replaces the data property of every component image
+ * with data-offset and data-size properties, and appends the data after
+ * the (packed) FIT structure, aligned to 4 bytes. A loader can then read
+ * the small FIT structure first and fetch only the image data it needs.
+ * Hashes must already have been calculated over the data.
+ *
+ * fname - .itb file to convert in place
+ *
+ * returns:
+ *     0 on success, -1 on failure
+ */
+static int fit_extract_data (struct mkimage_params *params, const char *fname)
+{
+	void *fdt = NULL, *buf = NULL;
+	char *ext = NULL;
+	int images_noffset, noffset, ndepth;
+	int ext_size = 0, fdt_size;
+	struct stat sbuf;
+	uint32_t zero = 0;
+	int fd, ret = -1;
+
+	fd = open (fname, O_RDWR|O_BINARY);
+	if (fd < 0 || fstat (fd, &sbuf) < 0) {
+		fprintf (stderr, "%s: Can't open %s: %s\n",
+				params->cmdname, fname, strerror(errno));
+		goto err;
+	}
+
+	/* room for the new properties (and their names) */
+	fdt_size = sbuf.st_size + 1024;
+	buf = malloc (sbuf.st_size);
+	fdt = malloc (fdt_size);
+	ext = calloc (1, sbuf.st_size);	/* zero the alignment padding */
+	if (!buf || !fdt || !ext) {
+		fprintf (stderr, "%s: Out of memory\n", params->cmdname);
+		goto err;
+	}
+
+	if (read (fd, buf, sbuf.st_size) != sbuf.st_size ||
+	    fdt_open_into (buf, fdt, fdt_size)) {
+		fprintf (stderr, "%s: Can't read %s: %s\n",
+				params->cmdname, fname, strerror(errno));
+		goto err;
+	}
+
+	images_noffset = fdt_path_offset (fdt, FIT_IMAGES_PATH);
+	if (images_noffset < 0) {
+		fprintf (stderr, "%s: Can't find images parent node '%s' (%s)\n",
+				params->cmdname, FIT_IMAGES_PATH,
+				fdt_strerror (images_noffset));
+		goto err;
+	}
+
+	ndepth = 0;
+	for (noffset = fdt_next_node (fdt, images_noffset, &ndepth);
+			(noffset >= 0) && (ndepth > 0);
+			noffset = fdt_next_node (fdt, noffset, &ndepth)) {
+		const void *data;
+		int len;
+
+		if (ndepth != 1)
+			continue;
+
+		data = fdt_getprop (fdt, noffset, FIT_DATA_PROP, &len);
+		if (!data)
+			continue;
+
+		memcpy (ext + ext_size, data, len);
+		if (fdt_delprop (fdt, noffset, FIT_DATA_PROP) ||
+		    fdt_setprop_u32 (fdt, noffset, FIT_DATA_OFFSET_PROP,
+				     ext_size) ||
+		    fdt_setprop_u32 (fdt, noffset, FIT_DATA_SIZE_PROP, len)) {
+			fprintf (stderr, "%s: Can't move data of '%s'\n",
+					params->cmdname,
+					fit_get_name (fdt, noffset, NULL));
+			goto err;
+		}
+		ext_size += (len + 3) & ~3;
+	}
+
+	fdt_pack (fdt);
+	fdt_size = fdt_totalsize (fdt);
+
+	if (lseek (fd, 0, SEEK_SET) < 0 ||
+	    write (fd, fdt, fdt_size) != fdt_size ||
+	    write (fd, &zero, fit_get_ext_data (fdt) - fdt_size) !=
+			fit_get_ext_data (fdt) - fdt_size ||
+	    write (fd, ext, ext_size) != ext_size ||
+	    ftruncate (fd, fit_get_ext_data (fdt) + ext_size) < 0) {
+		fprintf (stderr, "%s: Write error on %s: %s\n",
+				params->cmdname, fname, strerror(errno));
+		goto err;
+	}
+	ret = 0;
+
+err:
+	if (fd >= 0)
+		close (fd);
+	free (ext);
+	free (fdt);
+	free (buf);
+	return ret;
+}
+
 /**
  * fit_handle_file - main FIT file processing function
  *
@@ -144,6 +251,11 @@ static int fit_handle_file (struct mkimage_params *params)
 	munmap ((void *)ptr, sbuf.st_size);
 	close (tfd);
 
+	if (params->external_data && fit_extract_data (params, tmpfile)) {
+		unlink (tmpfile);
+		return (EXIT_FAILURE);
+	}
+
 	if (rename (tmpfile, params->imagefile) == -1) {
 		fprintf (stderr, "%s: Can't rename %s to %s: %s\n",
 				params->cmdname, tmpfile, params->imagefile,
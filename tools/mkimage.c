@@ -194,6 +194,9 @@ main (int argc, char **argv)
 					usage ();
 				params.dtc = *++argv;
 				goto NXTARG;
+			case 'E':
+				params.external_data = 1;
+				break;
 
 			case 'O':
 				if ((--argc <= 0) ||
@@ -623,7 +626,8 @@ usage ()
 			 "          -d ==> use image data from 'datafile'\n"
 			 "          -x ==> set XIP (execute in place)\n",
 		params.cmdname);
-	fprintf (stderr, "       %s [-D dtc_options] -f fit-image.its fit-image\n",
+	fprintf (stderr, "       %s [-D dtc_options] [-E] -f fit-image.its fit-image\n"
+			 "          -E ==> place image data after the FIT structure\n",
 		params.cmdname);
 	fprintf (stderr, "       %s -V ==> print version information and exit\n",
 		params.cmdname);
@@ -61,6 +61,7 @@ struct mkimage_params {
 	int vflag;
 	int xflag;
 	int skipcpy;
+	int external_data;
 	int os;
 	int arch;
 	int type;